@@ -0,0 +1,210 @@
+/**
+ * @file prog01/app/inc/user/apiprof.h
+ * 公開関数ごとの処理時間のヒストグラム (API プロファイラ)
+ *
+ * APIPROF_ENABLE を 1 にしてビルドすると, Canvas_* の描画関数, Font_PrintWith() (Font_Print()),
+ * LCDDrv_* と SPIDrv_* の転送関数の入口と出口で時刻を取得し, 関数ごとに 呼び出し回数 / 最小 / 最大 / 合計 と
+ * 2のべき乗で区切ったヒストグラムを集計します. 初期化・設定の取得だけを行う関数は計測しません.
+ * 呼び出し元から見た時間 (内部で呼び出す計測対象の関数の時間を含む) を計測します.
+ *
+ * 時刻の単位 (tick) は, 実機では DWT のサイクルカウンタ (CYCCNT. clk_sys の 1サイクル),
+ * ホストビルドでは clock_gettime(CLOCK_MONOTONIC) の 1ns です. ApiProf_GetTicksPerUs() で換算できます.
+ * 実機の DWT はコアごとにあるため, 計測するコアごとに ApiProf_Init() を呼び出してください.
+ * 集計はコアごとに分けて行い, 取得時に合算します. 同じコアの割り込み処理が計測中の関数を呼び出すと,
+ * 割り込み処理の時間を含みます (集計自体が重なった場合は 1回分失うことがあります).
+ *
+ * APIPROF_ENABLE が 0 の場合, APIPROF_BEGIN() / APIPROF_END() は何もしません.
+ **/
+
+#if !defined(USER_APIPROF_H__)
+#define USER_APIPROF_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include <hardware/structs/m33.h>
+#else
+#include <time.h>
+#endif
+
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#if !defined(APIPROF_ENABLE)
+#define APIPROF_ENABLE (0)  //< 1: 公開関数の処理時間を集計する (計測用. 呼び出しごとに数十サイクル遅くなる)
+#endif
+
+#define APIPROF_BUCKETS (24)  //< ヒストグラムの区間数. [k] は 2^(k-1) 以上 2^k 未満 ([0] は 0, 最後の区間は上限なし)
+#define APIPROF_CORES (2)     //< 集計を分けるコアの数
+
+#if APIPROF_ENABLE
+#define APIPROF_BEGIN(id) const uint32_t apiProfStart = ApiProf_Now()
+#define APIPROF_END(id) ApiProf_Add((id), ApiProf_Now() - apiProfStart)
+#else
+#define APIPROF_BEGIN(id) ((void)0)
+#define APIPROF_END(id) ((void)0)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 計測対象の関数
+ */
+typedef enum tagApiProfId_t {
+  ApiProfCanvasExpandLine = 0,
+  ApiProfCanvasClear,
+  ApiProfCanvasDrawPixel,
+  ApiProfCanvasDrawLine,
+  ApiProfCanvasDrawCircle,
+  ApiProfCanvasDrawFillCircle,
+  ApiProfCanvasFillRect,
+  ApiProfCanvasBlit,
+  ApiProfCanvasScroll,
+  ApiProfFontPrintWith,  //< Font_Print() を含む
+  ApiProfLCDDrvSetWindow,
+  ApiProfLCDDrvClear,
+  ApiProfLCDDrvSetBrightness,
+  ApiProfLCDDrvSwapBuff,
+  ApiProfLCDDrvSwapCanvas,
+  ApiProfLCDDrvSetScrollArea,
+  ApiProfLCDDrvSetScrollStart,
+  ApiProfLCDDrvScroll,
+  ApiProfLCDDrvWaitForTransfer,
+  ApiProfSPIDrvSendByte,
+  ApiProfSPIDrvRecvByte,
+  ApiProfSPIDrvTransferByte,
+  ApiProfSPIDrvSendNBytes,
+  ApiProfSPIDrvRecvNBytes,
+  ApiProfSPIDrvTransferNBytes,
+  ApiProfSPIDrvAsyncSend,
+  ApiProfSPIDrvAsyncRecv,
+  ApiProfSPIDrvAsyncTransfer,
+  ApiProfSPIDrvWaitForAsync,
+  ApiProfSPIDrvSetDC,
+  ApiProfIdNum,  //< 計測対象の数
+} ApiProfId_t;
+
+/**
+ * 関数ごとの集計 (単位: tick)
+ */
+typedef struct tagApiProfStat_t {
+  uint32_t calls;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t buckets[APIPROF_BUCKETS];
+} ApiProfStat_t;
+
+/**
+ * @brief ApiProf_Dump() の書き出し先 (TraceRingWriteFn_t と同じ形式)
+ * @param [in] arg : ApiProf_Dump() で指定した引数
+ * @param [in] data : 書き出すデータ (1行分のテキスト)
+ * @param [in] size : データ長 (単位: byte)
+ * @return 処理結果
+ */
+typedef UError_t (*ApiProfWriteFn_t)(void* arg, const void* data, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 呼び出したコアの時刻の取得を開始します (実機: DWT のサイクルカウンタを有効にする).
+ *
+ * 集計は 0 で初期化された状態から始まるため, 集計を消去する場合は ApiProf_Reset() を使用してください.
+ * @return 処理結果
+ */
+UError_t ApiProf_Init(void);
+
+/**
+ * @brief 全てのコアの集計を消去します.
+ */
+void ApiProf_Reset(void);
+
+/**
+ * @brief 1回の呼び出しを集計します (APIPROF_END() から呼び出す).
+ * @param [in] id : 計測対象
+ * @param [in] ticks : 処理時間 (単位: tick)
+ */
+void ApiProf_Add(ApiProfId_t id, uint32_t ticks);
+
+/**
+ * @brief 全てのコアの集計を合算して取得します.
+ * @param [in] id : 計測対象
+ * @param [out] stat : 集計の格納先
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (範囲外の id)
+ */
+UError_t ApiProf_Get(ApiProfId_t id, ApiProfStat_t* stat);
+
+/**
+ * @brief 集計から q (単位: %) パーセンタイルの上限を求めます.
+ * @param [in] stat : 集計
+ * @param [in] q : 0 - 100
+ * @return q パーセンタイルを含む区間の上限 (単位: tick. 最後の区間の場合は最大値)
+ */
+uint32_t ApiProf_Percentile(const ApiProfStat_t* stat, uint32_t q);
+
+/**
+ * @brief 計測対象の関数名を返します.
+ * @return 関数名 (範囲外の id は NULL)
+ */
+const char* ApiProf_GetName(ApiProfId_t id);
+
+/**
+ * @brief 1us あたりの tick 数を返します (実機: clk_sys / 1MHz, ホストビルド: 1000).
+ */
+uint32_t ApiProf_GetTicksPerUs(void);
+
+/**
+ * @brief 呼び出しのあった関数の集計を 1行ずつテキストで書き出します.
+ *
+ * 以下の形式です. 時間の単位は tick で, p50 / p99 は区間の上限, hist は 区間番号:回数 の並びです.
+ *   # apiprof ticks_per_us=150
+ *   api,calls,min,avg,p50,p99,max,hist
+ *   Canvas_DrawLine,128,812,1105,1024,1998,1998,10:70 11:58
+ * @param [in] write : 書き出し先
+ * @param [in] arg : write へ渡す引数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (書き出し失敗)
+ */
+UError_t ApiProf_Dump(ApiProfWriteFn_t write, void* arg);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 現在の時刻を返します (単位: tick. 32bit で一周する).
+ */
+static inline uint32_t ApiProf_Now(void) {
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+  return m33_hw->dwt_cyccnt;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+#endif  // !defined(USER_APIPROF_H__)
@@ -0,0 +1,113 @@
+/**
+ * @file prog01/app/inc/user/bandrender.h
+ * 描画命令リストを 2つのコアで並行して再生する
+ *
+ * キャンバスの描画できる領域を上下 2つの帯に分け, 上の帯を呼び出し側 (core0),
+ * 下の帯をワーカー (core1) が DrawList_ExecuteBand() で再生します. 各帯は描画できる領域で
+ * 分離されるため, ピクセルの書き込みが重なることはなく, 描画中の排他制御は不要です.
+ *
+ * ワーカーの実装は構成により切り替わります.
+ *   pico_multicore をリンクした場合 (LIB_PICO_MULTICORE) : core1 と FIFO で同期
+ *   それ以外 (ホスト) : pthread のスレッドと条件変数で同期
+ * BandRender_Start() は core1 を専有するため, LCDPipe_Start() とは併用できません (後から起動した方が失敗します).
+ **/
+
+#if !defined(USER_BANDRENDER_H__)
+#define USER_BANDRENDER_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/drawlist.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagBandRender_t {
+  uint32_t split;  //< 帯の境界の行 (描画できる領域外の場合は中央で分割)
+  bool started;    //< ワーカー起動済み
+  // ワーカーへ渡す処理
+  const DrawList_t* list;
+  const Canvas_t* canvas;
+  size_t y;         //< ワーカーが担当する帯の先頭行
+  size_t h;         //< ワーカーが担当する帯の行数
+  UError_t result;  //< ワーカーの処理結果
+} BandRender_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 初期化します. ワーカーは起動しません.
+ * @param [out] ctx : 初期化対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t BandRender_Create(BandRender_t* ctx);
+
+/**
+ * @brief 帯の境界の行を指定します. 上下の帯の描画量が偏る場合に調整してください.
+ * @param [inout] ctx : 操作対象
+ * @param [in] split : 境界の行 (下の帯の先頭行. 0 の場合は中央)
+ * @return 処理結果
+ */
+UError_t BandRender_SetSplit(BandRender_t* ctx, uint32_t split);
+
+/**
+ * @brief ワーカー (core1 またはスレッド) を起動します. 起動できるワーカーは 1つだけです.
+ *
+ * core1 は Core1_Launch() で起動し, BandRender_Stop() まで専有します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (起動済み, core1 を他の処理が使用中, スレッド生成失敗)
+ */
+UError_t BandRender_Start(BandRender_t* ctx);
+
+/**
+ * @brief ワーカーを停止します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t BandRender_Stop(BandRender_t* ctx);
+
+/**
+ * @brief 命令リストを canvas へ再生し, 両方の帯の完了を待って戻ります.
+ *
+ * ワーカーが起動していない場合は, 呼び出し側で 2つの帯を順に再生します (1コアでの比較用).
+ * @param [inout] ctx : 操作対象
+ * @param [in] list : 命令リスト
+ * @param [in] canvas : 再生先
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (いずれかの帯で失敗)
+ */
+UError_t BandRender_Execute(BandRender_t* ctx, const DrawList_t* list, const Canvas_t* canvas);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_BANDRENDER_H__)
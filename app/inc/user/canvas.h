@@ -2,7 +2,16 @@
  * @file prog01/app/inc/user/canvas.h
  * 描画バッファ操作
  *
- * カラーフォーマット: RGB565
+ * カラーフォーマット: RGB565 または インデックスカラー (1/2/4/8 bpp)
+ *
+ * インデックスカラーのキャンバスでは, 描画関数の色引数はパレット番号として扱います.
+ * 1バイト内のピクセルは上位ビットが左です. パレットは LCD への転送時に参照します.
+ *
+ * CANVAS_OVERDRAW を 1 にしてビルドすると, 描画関数がピクセルを書き込むたびにピクセルごとの回数を数えます
+ * (Canvas_AttachOverdraw()). 描画関数の種類ごとの 書き込み数 / 初めて書き込んだピクセル数 を集計し,
+ * 回数をヒートマップとして描画できます. Canvas_t の大きさが変わるため, 全体を同じ設定でビルドしてください.
+ *
+ * CANVAS_RECORD を 1 にしてビルドすると, 描画関数の呼び出しを記録できます (user/drawrec.h).
  **/
 
 #if !defined(USER_CANVAS_H__)
@@ -21,15 +30,86 @@
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+#if !defined(CANVAS_OVERDRAW)
+#define CANVAS_OVERDRAW (0)  //< 1: ピクセルの書き込み回数を数える (計測用. 描画が遅くなる)
+#endif
+
+#if !defined(CANVAS_RECORD)
+#define CANVAS_RECORD (0)  //< 1: 描画関数の呼び出しを記録できる (DrawRec_Attach())
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * ピクセルの形式
+ */
+typedef enum tagCanvasFormat_t {
+  CanvasRGB565 = 0,  //< 16bit RGB565
+  CanvasIndexed1,    //< 1bit パレット (2色)
+  CanvasIndexed2,    //< 2bit パレット (4色)
+  CanvasIndexed4,    //< 4bit パレット (16色)
+  CanvasIndexed8,    //< 8bit パレット (256色)
+} CanvasFormat_t;
+
+/**
+ * 矩形領域 (単位: pixel)
+ */
+typedef struct tagCanvasRect_t {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+} CanvasRect_t;
+
+/**
+ * 書き込み回数を集計する描画の種類
+ */
+typedef enum tagCanvasPrim_t {
+  CanvasPrimClear = 0,   //< Canvas_Clear
+  CanvasPrimPixel,       //< Canvas_DrawPixel
+  CanvasPrimLine,        //< Canvas_DrawLine
+  CanvasPrimCircle,      //< Canvas_DrawCircle
+  CanvasPrimFillCircle,  //< Canvas_DrawFillCircle
+  CanvasPrimFillRect,    //< Canvas_FillRect
+  CanvasPrimBlit,        //< Canvas_Blit
+  CanvasPrimScroll,      //< Canvas_Scroll
+  CanvasPrimText,        //< 文字 (Canvas_BeginOverdraw() で指定した区間)
+  CanvasPrimTilemap,     //< Tilemap (キャンバスへ直接書き込む)
+  CanvasPrimNum,         //< 種類の数
+  CanvasPrimNone = -1,   //< 集計中の種類なし / 全体
+} CanvasPrim_t;
+
+/**
+ * 書き込み回数の集計
+ */
+typedef struct tagCanvasOverdrawStat_t {
+  uint32_t calls;    //< 呼び出し回数 (他の描画関数の内部からの呼び出しを除く)
+  uint32_t written;  //< 書き込んだピクセル数 (重複を含む)
+  uint32_t unique;   //< 初めて書き込んだピクセル数 (written / unique が重ね描きの倍率)
+} CanvasOverdrawStat_t;
+
+/**
+ * 書き込み回数の記録先. Canvas_AttachOverdraw() でキャンバスへ接続する
+ */
+typedef struct tagCanvasOverdraw_t {
+  uint8_t* counts;                            //< ピクセルごとの書き込み回数 (ストライド x 高さ. 255 で飽和)
+  CanvasPrim_t current;                       //< 集計中の種類 (最も外側の描画関数)
+  CanvasOverdrawStat_t stats[CanvasPrimNum];  //< 種類ごとの集計
+} CanvasOverdraw_t;
+
 typedef struct tagCanvas_t {
   size_t w;
   size_t h;
-  size_t s;
+  size_t s;  //< ストライド (単位: pixel)
   void* buf;
+  CanvasFormat_t fmt;       //< ピクセルの形式
+  const uint16_t* palette;  //< インデックスカラーのパレット (RGB565)
+  CanvasRect_t clip;        //< 描画できる領域 (Canvas_Create() 時はキャンバス全体)
+#if CANVAS_OVERDRAW
+  CanvasOverdraw_t* overdraw;  //< 書き込み回数の記録先 (NULL: 数えない)
+#endif
 } Canvas_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -42,6 +122,76 @@ extern "C" {
 
 UError_t Canvas_Create(Canvas_t* ctx, size_t w, size_t h, size_t s, void* const buf);
 
+/**
+ * @brief 描画できる領域を制限します.
+ *
+ * 以降の描画関数は領域外のピクセルを書き換えません (Canvas_Scroll() の移動を除く).
+ * Canvas_Clear() は領域内のみを塗りつぶします. 領域はキャンバスの範囲に切り詰めます.
+ * 同じバッファを共有し, 重ならない領域を設定したキャンバス同士は並行して描画できます.
+ * @param [inout] ctx : 操作対象
+ * @param [in] x : x座標
+ * @param [in] y : y座標
+ * @param [in] w : 幅 (単位: pixel. 0 の場合は何も描画しない)
+ * @param [in] h : 高さ (単位: pixel. 0 の場合は何も描画しない)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_SetClip(Canvas_t* ctx, size_t x, size_t y, size_t w, size_t h);
+
+/**
+ * @brief インデックスカラーのキャンバスを初期化します.
+ *
+ * buf には 1行あたり Canvas_GetRowBytes() byte x h 行の領域が必要です.
+ * 4bpp の 240x320 は 38,400 byte です.
+ * @param [out] ctx : 初期化対象
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [in] h : 高さ (単位: pixel)
+ * @param [in] s : ストライド (単位: pixel)
+ * @param [in] buf : 描画バッファ
+ * @param [in] fmt : ピクセルの形式
+ * @param [in] palette : パレット (RGB565. 2^bpp 色)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_CreateIndexed(Canvas_t* ctx, size_t w, size_t h, size_t s, void* const buf, CanvasFormat_t fmt, const uint16_t* palette);
+
+/**
+ * @brief パレットを変更します. 描画済みの内容は変化せず, 次回の転送から反映されます.
+ * @param [inout] ctx : 操作対象
+ * @param [in] palette : パレット (RGB565. 2^bpp 色)
+ * @return 処理結果
+ */
+UError_t Canvas_SetPalette(Canvas_t* ctx, const uint16_t* palette);
+
+/**
+ * @brief 1ピクセルあたりのビット数を取得します.
+ * @param [in] fmt : ピクセルの形式
+ * @return ビット数 (不正な形式の場合 0)
+ */
+uint32_t Canvas_GetBitsPerPixel(CanvasFormat_t fmt);
+
+/**
+ * @brief 1行あたりのバイト数を取得します.
+ * @param [in] ctx : 操作対象
+ * @return バイト数
+ */
+size_t Canvas_GetRowBytes(const Canvas_t* const ctx);
+
+/**
+ * @brief 1行の一部を RGB565 に展開します. インデックスカラーはパレットで変換します.
+ * @param [in] ctx : 操作対象
+ * @param [in] x : 先頭の x座標
+ * @param [in] y : y座標
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [out] out : 格納先 (w 個)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (範囲外, パレット未設定)
+ */
+UError_t Canvas_ExpandLine(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, uint16_t* out);
+
 const void* Canvas_GetBuf(const Canvas_t* const ctx);
 
 UError_t Canvas_Clear(const Canvas_t* const ctx, const uint16_t c);
@@ -54,6 +204,130 @@ UError_t Canvas_DrawCircle(const Canvas_t* const ctx, const size_t x, const size
 
 UError_t Canvas_DrawFillCircle(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t r, const uint16_t c);
 
+/**
+ * @brief (x, y) を左上とする矩形を塗りつぶします. 描画できる領域外にはみ出す部分はクリップされます.
+ * @param [in] ctx : 操作対象
+ * @param [in] x : x座標
+ * @param [in] y : y座標
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [in] h : 高さ (単位: pixel)
+ * @param [in] c : RGB565 形式の描画色
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_FillRect(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const uint16_t c);
+
+/**
+ * @brief RGB565 形式の矩形イメージを (x, y) を左上として転送します.
+ *
+ * 描画できる領域外にはみ出す部分はクリップされます. 行単位の memcpy で転送します.
+ * RGB565 のキャンバスのみ対応します.
+ * @param [in] ctx : 操作対象
+ * @param [in] x : 転送先 x座標
+ * @param [in] y : 転送先 y座標
+ * @param [in] w : イメージ幅 (単位: pixel)
+ * @param [in] h : イメージ高 (単位: pixel)
+ * @param [in] src : 転送元イメージ
+ * @param [in] ss : 転送元のストライド (単位: pixel)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_Blit(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const uint16_t* src, const size_t ss);
+
+/**
+ * @brief (x, y) を左上とする矩形内の画像を (dx, dy) だけ移動します.
+ *
+ * 矩形外へ出た部分は破棄し, 移動によって空いた部分は fill で塗りつぶします.
+ * 行単位の memmove で移動するため, 描画し直すより低コストです.
+ * 矩形がキャンバス外にはみ出す部分はクリップされます. 描画できる領域の制限は移動には適用されません.
+ * @param [in] ctx : 操作対象
+ * @param [in] x : 矩形の x座標
+ * @param [in] y : 矩形の y座標
+ * @param [in] w : 矩形の幅 (単位: pixel)
+ * @param [in] h : 矩形の高さ (単位: pixel)
+ * @param [in] dx : 水平方向の移動量 (正: 右)
+ * @param [in] dy : 垂直方向の移動量 (正: 下)
+ * @param [in] fill : RGB565 形式の塗りつぶし色
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_Scroll(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const int32_t dx, const int32_t dy,
+                       const uint16_t fill);
+
+#if CANVAS_OVERDRAW
+/**
+ * @brief 書き込み回数の記録先を接続し, 回数と集計を 0 にします.
+ *
+ * 同じバッファを共有するキャンバス (帯に分けた描画等) に同じ記録先を接続できますが, 集計は 1コアからの描画のみ正しく数えます.
+ * @param [inout] ctx : 操作対象
+ * @param [out] overdraw : 記録先 (NULL: 切断)
+ * @param [in] counts : ピクセルごとの回数の格納先 (ストライド x 高さ byte)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Canvas_AttachOverdraw(Canvas_t* ctx, CanvasOverdraw_t* overdraw, uint8_t* counts);
+
+/**
+ * @brief 書き込み回数と集計を 0 にします. フレームの先頭で呼び出してください.
+ * @param [in] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t Canvas_ResetOverdraw(const Canvas_t* const ctx);
+
+/**
+ * @brief 以降の書き込みを prim として集計します. 描画関数の組み合わせ (文字等) をまとめて数える場合に使用します.
+ *
+ * 既に集計中の種類がある場合は変更しません (外側の種類で数える).
+ * @param [in] ctx : 操作対象
+ * @param [in] prim : 種類
+ * @return 呼び出し前の種類 (Canvas_EndOverdraw() へ渡す)
+ */
+CanvasPrim_t Canvas_BeginOverdraw(const Canvas_t* const ctx, CanvasPrim_t prim);
+
+/**
+ * @brief Canvas_BeginOverdraw() の前の種類へ戻します.
+ * @param [in] ctx : 操作対象
+ * @param [in] prev : Canvas_BeginOverdraw() の戻り値
+ */
+void Canvas_EndOverdraw(const Canvas_t* const ctx, CanvasPrim_t prev);
+
+/**
+ * @brief キャンバスへ直接書き込んだ矩形の回数を数えます (描画関数を使用しないモジュール用).
+ * @param [in] ctx : 操作対象
+ * @param [in] x : x座標
+ * @param [in] y : y座標
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [in] h : 高さ (単位: pixel)
+ */
+void Canvas_CountOverdraw(const Canvas_t* const ctx, size_t x, size_t y, size_t w, size_t h);
+
+/**
+ * @brief 書き込み回数の集計を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [in] prim : 種類 (CanvasPrimNone: 全体)
+ * @param [out] stat : 集計
+ * @return 処理結果
+ */
+UError_t Canvas_GetOverdrawStat(const Canvas_t* const ctx, CanvasPrim_t prim, CanvasOverdrawStat_t* stat);
+
+/**
+ * @brief 書き込み回数をヒートマップとして dst へ描画します.
+ *
+ * 0回 は暗い灰色, 1回 は青, 以降 水色, 緑, 黄, 橙, 赤, 7回以上は白で表します.
+ * @param [in] ctx : 回数を記録したキャンバス
+ * @param [in] dst : 描画先 (RGB565. ctx と同じ大きさ)
+ * @param [out] maxCount : 最大の書き込み回数 (NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (記録先なし, 大きさの不一致)
+ */
+UError_t Canvas_DrawOverdrawHeatmap(const Canvas_t* const ctx, const Canvas_t* const dst, uint32_t* maxCount);
+#endif
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,186 @@
+/**
+ * @file prog01/app/inc/user/chart.h
+ * ストリーミング表示用チャート (オシロスコープのスイープ表示)
+ *
+ * 入力したサンプルは列ごとの最小値/最大値に間引いてリングバッファに保持します.
+ * 描画位置は左から右へ進み, 右端で左端に戻ります. 描画は新たに確定した列のみを
+ * 背景色で消去してから縦線で描くため, 全体を描き直す必要がありません.
+ * Chart_Flush() を使うと確定した列だけを細い LCD ウィンドウとして直接転送します.
+ **/
+
+#if !defined(USER_CHART_H__)
+#define USER_CHART_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/lcddrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 1列分のサンプル範囲 (前の列の最終値を含む)
+ */
+typedef struct tagChartColumn_t {
+  int32_t lo;  //< 最小値
+  int32_t hi;  //< 最大値
+} ChartColumn_t;
+
+typedef struct tagChart_t {
+  uint32_t x;              //< 左上 x座標 (単位: pixel)
+  uint32_t y;              //< 左上 y座標 (単位: pixel)
+  uint32_t w;              //< 幅 (単位: pixel = 列数)
+  uint32_t h;              //< 高さ (単位: pixel)
+  ChartColumn_t* columns;  //< w 個の列 (リングバッファ)
+  int32_t vmin;            //< 下端の値
+  int32_t vmax;            //< 上端の値
+  uint16_t fg;             //< 描画色
+  uint16_t bg;             //< 背景色
+  uint32_t decimation;     //< 1列あたりのサンプル数
+  uint32_t head;           //< 次に確定する列
+  uint32_t pending;        //< 確定済みで未描画の列数
+  // 確定前の列
+  int32_t accLo;
+  int32_t accHi;
+  uint32_t accCount;
+  int32_t last;  //< 直前のサンプル
+  bool hasLast;
+  // Chart_Flush() 用の転送バッファ (2面)
+  uint16_t* strip[2];
+  uint32_t stripCols;  //< 1面あたりの列数
+  uint32_t stripIndex;
+} Chart_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief チャートを初期化します.
+ *
+ * 値の範囲は 0 - (h - 1), 間引きなし, 色は 白/黒 で初期化します.
+ * 初回の描画では全列を描画します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] x : 左上 x座標 (単位: pixel)
+ * @param [in] y : 左上 y座標 (単位: pixel)
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [in] h : 高さ (単位: pixel)
+ * @param [in] columns : 列の管理領域 (w 個)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Chart_Create(Chart_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h, ChartColumn_t* columns);
+
+/**
+ * @brief 上端/下端に対応する値を指定します. 次回の描画で全列を再描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] vmin : 下端の値
+ * @param [in] vmax : 上端の値 (vmin より大きいこと)
+ * @return 処理結果
+ */
+UError_t Chart_SetRange(Chart_t* ctx, int32_t vmin, int32_t vmax);
+
+/**
+ * @brief 描画色を指定します. 次回の描画で全列を再描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] fg : 描画色 (RGB565)
+ * @param [in] bg : 背景色 (RGB565)
+ * @return 処理結果
+ */
+UError_t Chart_SetColor(Chart_t* ctx, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief 1列あたりのサンプル数を指定します.
+ *
+ * サンプルレートが表示の列送りより速い場合に, 列内の最小値/最大値を縦線で描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] n : 1列あたりのサンプル数 (1以上)
+ * @return 処理結果
+ */
+UError_t Chart_SetDecimation(Chart_t* ctx, uint32_t n);
+
+/**
+ * @brief Chart_Flush() で使用する転送バッファを指定します.
+ *
+ * バッファは 2面に分割し, 一方を DMA 転送中にもう一方へ描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] buf : 転送バッファ
+ * @param [in] size : buf の要素数 (単位: pixel. 2 * h 以上)
+ * @return 処理結果
+ */
+UError_t Chart_SetStripBuffer(Chart_t* ctx, uint16_t* buf, size_t size);
+
+/**
+ * @brief サンプルを追加します. 描画は行いません.
+ * @param [inout] ctx : 操作対象
+ * @param [in] v : サンプル値
+ * @return 処理結果
+ */
+UError_t Chart_Push(Chart_t* ctx, int32_t v);
+
+/**
+ * @brief 複数のサンプルを追加します. 描画は行いません.
+ * @param [inout] ctx : 操作対象
+ * @param [in] v : サンプル値
+ * @param [in] n : サンプル数
+ * @return 処理結果
+ */
+UError_t Chart_PushN(Chart_t* ctx, const int32_t* v, size_t n);
+
+/**
+ * @brief 次回の描画で全列を再描画させます.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t Chart_Invalidate(Chart_t* ctx);
+
+/**
+ * @brief 未描画の列をキャンバスへ描画します.
+ *
+ * 右端で折り返す場合, dirty には最大 2つの領域を格納します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] canvas : 描画先
+ * @param [out] dirty : 描画した領域の格納先 (NULL 可)
+ * @param [in] maxDirty : dirty の要素数
+ * @param [out] nDirty : 格納した領域の数 (NULL 可)
+ * @return 処理結果
+ */
+UError_t Chart_Render(Chart_t* ctx, const Canvas_t* canvas, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty);
+
+/**
+ * @brief 未描画の列を転送バッファへ描画し, 列の範囲だけを LCD へ転送します.
+ *
+ * LCDDrv_SwapBuff() による非同期転送のため, 完了を待たずに戻ります.
+ * @param [inout] ctx : 操作対象
+ * @param [in] lcd : 転送先
+ * @return 処理結果
+ */
+UError_t Chart_Flush(Chart_t* ctx, LCDDrvHandle_t lcd);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_CHART_H__)
@@ -0,0 +1,189 @@
+/**
+ * @file prog01/app/inc/user/console.h
+ * スクロールするログ表示用コンソール
+ *
+ * 文字はリングバッファ状のキャラクタグリッドに文字コードと属性(色)で保持します.
+ * 書き込みはグリッドの更新のみで, 描画は Console_Render() で変化した行だけを行います.
+ * スクロールはリングの先頭行を進めるだけで, 文字データの移動は発生しません.
+ * 描画時はキャンバス上の画像を Canvas_Scroll() で移動し, 新たに現れた行のみを描画します.
+ * Console_RenderScroll() を使用すると, LCD 側も垂直スクロールで送り, 新たに現れた行のみを転送できます.
+ **/
+
+#if !defined(USER_CONSOLE_H__)
+#define USER_CONSOLE_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/font.h>
+#include <user/glyphcache.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CONSOLE_MAX_ROWS (64)  //< 最大行数 (行ごとの更新フラグのビット数)
+#define CONSOLE_TAB_WIDTH (8)  //< タブ位置の間隔 (単位: キャラクタ)
+
+/**
+ * 属性値を作成します
+ * @param FG : 前景色のパレット番号 (0 - 15)
+ * @param BG : 背景色のパレット番号 (0 - 15)
+ */
+#define CONSOLE_ATTR(FG, BG) (uint8_t)((((BG) & 0x0f) << 4) | ((FG) & 0x0f))
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagConsoleCell_t {
+  uint8_t code;  //< 文字コード (ANK)
+  uint8_t attr;  //< 属性 (CONSOLE_ATTR)
+} ConsoleCell_t;
+
+typedef struct tagConsole_t {
+  const Canvas_t* canvas;  //< 描画先
+  uint32_t x;              //< 左上 x座標 (単位: pixel)
+  uint32_t y;              //< 左上 y座標 (単位: pixel)
+  uint32_t cols;           //< 桁数
+  uint32_t rows;           //< 行数
+  uint32_t cw;             //< セル幅 (単位: pixel)
+  uint32_t ch;             //< セル高 (単位: pixel)
+  ConsoleCell_t* cells;    //< cols * rows 個のセル (リングバッファ)
+  uint32_t top;            //< 表示先頭行のリング上の位置
+  uint32_t cx;             //< カーソル桁
+  uint32_t cy;             //< カーソル行 (表示上の位置)
+  uint8_t attr;            //< 書き込み時の属性
+  uint64_t dirty;          //< 再描画が必要な行 (表示上の位置)
+  uint32_t scrolled;       //< 前回の描画以降にスクロールした行数
+  FontId_t font;           //< 使用するフォント (1バイトコード)
+  GlyphCache_t* cache;     //< グリフキャッシュ (NULL: 使用しない)
+  uint16_t palette[16];    //< 属性のパレット (RGB565)
+} Console_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief コンソールを初期化します.
+ *
+ * フォントは FONT_ID_ANK, 属性は CONSOLE_ATTR(15, 0) (白/黒) で初期化します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] canvas : 描画先
+ * @param [in] x : 左上 x座標 (単位: pixel)
+ * @param [in] y : 左上 y座標 (単位: pixel)
+ * @param [in] cols : 桁数
+ * @param [in] rows : 行数 (CONSOLE_MAX_ROWS 以下)
+ * @param [in] cells : セル管理領域 (cols * rows 個)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Console_Create(Console_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t cols, uint32_t rows, ConsoleCell_t* cells);
+
+/**
+ * @brief 使用するフォントを指定します. 全行を再描画対象にします.
+ * @param [inout] ctx : 操作対象
+ * @param [in] font : 1バイトコードのフォント
+ * @return 処理結果
+ */
+UError_t Console_SetFont(Console_t* ctx, FontId_t font);
+
+/**
+ * @brief グリフの展開に使用するキャッシュを指定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] cache : グリフキャッシュ (NULL: 使用しない)
+ * @return 処理結果
+ */
+UError_t Console_SetGlyphCache(Console_t* ctx, GlyphCache_t* cache);
+
+/**
+ * @brief パレットの色を変更します. 全行を再描画対象にします.
+ * @param [inout] ctx : 操作対象
+ * @param [in] index : パレット番号 (0 - 15)
+ * @param [in] c : RGB565 形式の色
+ * @return 処理結果
+ */
+UError_t Console_SetPalette(Console_t* ctx, uint32_t index, uint16_t c);
+
+/**
+ * @brief 以降の書き込みに使用する属性を指定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] attr : 属性 (CONSOLE_ATTR)
+ * @return 処理結果
+ */
+UError_t Console_SetAttr(Console_t* ctx, uint8_t attr);
+
+/**
+ * @brief 全セルを空白にしてカーソルを左上に戻します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t Console_Clear(Console_t* ctx);
+
+/**
+ * @brief 文字列を書き込みます. 描画は行いません.
+ *
+ * 制御文字は以下のとおり処理します. それ以外の制御文字は無視します.
+ *   @arg \\n : 次の行の先頭へ移動 (最終行ではスクロール)
+ *   @arg \\r : 行の先頭へ移動
+ *   @arg \\t : 次のタブ位置まで空白で埋める
+ *   @arg \\b : 1桁戻る (行頭では何もしない)
+ * 行末を超えた場合は次の行へ折り返します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] s : 書き込むデータ
+ * @param [in] n : 書き込むデータのサイズ (単位: byte)
+ * @return 処理結果
+ */
+UError_t Console_Write(Console_t* ctx, const char* s, size_t n);
+
+/**
+ * @brief 前回の描画以降に変化した行をキャンバスへ描画します.
+ *
+ * スクロールが発生していた場合はコンソール全体を 1つの領域として報告します (キャンバスから全体を転送し直す場合).
+ * LCD の垂直スクロールで表示を送る場合は Console_RenderScroll() を使用してください.
+ * @param [inout] ctx : 操作対象
+ * @param [out] dirty : 描画した領域の格納先 (連続する行は 1つに連結. NULL 可)
+ * @param [in] maxDirty : dirty の要素数
+ * @param [out] nDirty : 格納した領域の数 (NULL 可)
+ * @return 処理結果
+ */
+UError_t Console_Render(Console_t* ctx, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty);
+
+/**
+ * @brief 前回の描画以降に変化した行をキャンバスへ描画し, スクロール量を別に返します (LCD の垂直スクロールと併用する).
+ *
+ * Console_Render() と同様に描画しますが, スクロールが発生していても再描画した行 (新たに現れた行を含む) のみを報告します.
+ * 呼び出し側は LCDDrv_Scroll() で表示を scroll 画素分 上へ送り, 報告された領域の各行を
+ * LCDDrv_ScrollMapRow() で求めた行へ転送します (転送量は新たに現れた行の分だけになります).
+ * LCD のスクロール領域はコンソールの行の範囲と一致させ, コンソールは画面の全幅とします.
+ * 全ての行がスクロールした場合は scroll を 0 とし, 全ての行を報告します.
+ * @param [inout] ctx : 操作対象
+ * @param [out] scroll : 表示を上へ送る量の格納先 (単位: pixel. 0: スクロールなし)
+ * @param [out] dirty : 描画した領域の格納先 (連続する行は 1つに連結. NULL 可)
+ * @param [in] maxDirty : dirty の要素数
+ * @param [out] nDirty : 格納した領域の数 (NULL 可)
+ * @return 処理結果
+ */
+UError_t Console_RenderScroll(Console_t* ctx, uint32_t* scroll, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_CONSOLE_H__)
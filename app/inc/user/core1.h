@@ -0,0 +1,61 @@
+/**
+ * @file prog01/app/inc/user/core1.h
+ * core1 の起動の管理
+ *
+ * core1 で動作する処理 (LCDPipe_Start(), BandRender_Start()) は同時に 1つだけです.
+ * multicore_launch_core1() を 2回呼び出すと先に起動した処理が置き換わるため,
+ * core1 を起動するモジュールは multicore_launch_core1() の代わりに Core1_Launch() を使用し,
+ * 起動済みの場合は失敗を返します.
+ **/
+
+#if !defined(USER_CORE1_H__)
+#define USER_CORE1_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief core1 で entry を実行します.
+ * @param [in] entry : core1 の処理
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (entry が NULL, core1 は起動済み)
+ */
+UError_t Core1_Launch(void (*entry)(void));
+
+/**
+ * @brief core1 を停止し, 再び Core1_Launch() できる状態にします.
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (core1 は起動していない)
+ */
+UError_t Core1_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_CORE1_H__)
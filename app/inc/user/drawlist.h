@@ -0,0 +1,165 @@
+/**
+ * @file prog01/app/inc/user/drawlist.h
+ * Canvas_* の描画命令の記録と再生
+ *
+ * 1フレーム分の描画命令を記録しておき, 後から任意のキャンバスへ再生します.
+ * 描画できる領域 (Canvas_SetClip()) を変えて再生すれば, 同じ命令列を帯状の領域ごとに
+ * 別々のコアで実行できます. 各命令は記録時に影響する行の範囲を求めておき,
+ * 再生先の領域と重ならない命令は実行しません.
+ **/
+
+#if !defined(USER_DRAWLIST_H__)
+#define USER_DRAWLIST_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 描画命令の種類
+ */
+typedef enum tagDrawCmdType_t {
+  DrawCmdClear = 0,   //< Canvas_Clear()
+  DrawCmdPixel,       //< Canvas_DrawPixel()
+  DrawCmdLine,        //< Canvas_DrawLine()
+  DrawCmdCircle,      //< Canvas_DrawCircle()
+  DrawCmdFillCircle,  //< Canvas_DrawFillCircle()
+  DrawCmdFillRect,    //< Canvas_FillRect()
+  DrawCmdBlit,        //< Canvas_Blit()
+  DrawCmdCall,        //< 任意の描画関数
+} DrawCmdType_t;
+
+/**
+ * @brief 任意の描画関数
+ *
+ * 帯ごとに並行して呼び出されるため, canvas を通してのみ描画し, 共有する状態を書き換えないでください.
+ * (GlyphCache_t は参照時に更新されるため, 帯ごとに別のキャッシュを使用してください)
+ * @param [in] canvas : 描画先 (描画できる領域が帯に制限されている)
+ * @param [in] arg : DrawList_Call() で指定した引数
+ * @return 処理結果
+ */
+typedef UError_t (*DrawListFunc_t)(const Canvas_t* canvas, void* arg);
+
+typedef struct tagDrawCmd_t {
+  DrawCmdType_t type;
+  uint16_t c;       //< 描画色
+  uint16_t top;     //< 影響する最初の行
+  uint16_t bottom;  //< 影響する最後の行の次
+  size_t p[4];      //< 引数 (座標, 半径, 幅, 高さ. 対応する Canvas_* の引数順)
+  union {
+    struct {
+      const uint16_t* src;
+      size_t ss;
+    } blit;
+    struct {
+      DrawListFunc_t func;
+      void* arg;
+    } call;
+  } u;
+} DrawCmd_t;
+
+typedef struct tagDrawList_t {
+  DrawCmd_t* cmds;  //< 命令の格納先
+  size_t cap;       //< 格納できる命令数
+  size_t n;         //< 記録済みの命令数
+} DrawList_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 命令リストを初期化します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] cmds : 命令の格納先 (cap 個)
+ * @param [in] cap : 格納できる命令数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t DrawList_Create(DrawList_t* ctx, DrawCmd_t* cmds, size_t cap);
+
+/**
+ * @brief 記録済みの命令を破棄します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t DrawList_Reset(DrawList_t* ctx);
+
+/**
+ * @brief 各命令を記録します. 引数は対応する Canvas_* と同じです.
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (格納先が満杯)
+ */
+UError_t DrawList_Clear(DrawList_t* ctx, uint16_t c);
+UError_t DrawList_DrawPixel(DrawList_t* ctx, size_t x, size_t y, uint16_t c);
+UError_t DrawList_DrawLine(DrawList_t* ctx, size_t x1, size_t y1, size_t x2, size_t y2, uint16_t c);
+UError_t DrawList_DrawCircle(DrawList_t* ctx, size_t x, size_t y, size_t r, uint16_t c);
+UError_t DrawList_DrawFillCircle(DrawList_t* ctx, size_t x, size_t y, size_t r, uint16_t c);
+UError_t DrawList_FillRect(DrawList_t* ctx, size_t x, size_t y, size_t w, size_t h, uint16_t c);
+
+/**
+ * @brief Canvas_Blit() を記録します. src は再生が終わるまで保持してください.
+ * @return 処理結果
+ */
+UError_t DrawList_Blit(DrawList_t* ctx, size_t x, size_t y, size_t w, size_t h, const uint16_t* src, size_t ss);
+
+/**
+ * @brief 任意の描画関数の呼び出しを記録します. 影響する行の範囲は画面全体として扱います.
+ * @param [inout] ctx : 操作対象
+ * @param [in] func : 描画関数
+ * @param [in] arg : func へ渡す引数 (再生が終わるまで保持してください)
+ * @return 処理結果
+ */
+UError_t DrawList_Call(DrawList_t* ctx, DrawListFunc_t func, void* arg);
+
+/**
+ * @brief 記録した命令を canvas へ順に再生します. canvas の描画できる領域の外は描画しません.
+ *
+ * 個々の命令が領域外で失敗しても再生は続けます.
+ * @param [in] ctx : 操作対象
+ * @param [in] canvas : 再生先
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (引数不正, 描画関数の失敗)
+ */
+UError_t DrawList_Execute(const DrawList_t* ctx, const Canvas_t* canvas);
+
+/**
+ * @brief canvas の y 行目から h 行の帯 (描画できる領域との交差部分) だけを再生します.
+ * @param [in] ctx : 操作対象
+ * @param [in] canvas : 再生先
+ * @param [in] y : 帯の先頭行
+ * @param [in] h : 帯の行数
+ * @return 処理結果
+ */
+UError_t DrawList_ExecuteBand(const DrawList_t* ctx, const Canvas_t* canvas, size_t y, size_t h);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_DRAWLIST_H__)
@@ -0,0 +1,175 @@
+/**
+ * @file prog01/app/inc/user/drawrec.h
+ * 描画関数の呼び出しの記録 (ドローコールレコーダ)
+ *
+ * CANVAS_RECORD を 1 にしてビルドすると, Canvas_* の描画関数と Font_PrintWith() (Font_Print()) の呼び出しを
+ * 引数ごと DrawRec_Attach() で指定した記録先へ可変長のバイト列で記録します. DrawRec_EndFrame() でフレームの区切りを記録します.
+ * 記録は DrawRec_Drain() で以下のチャンク形式で書き出し (リトルエンディアン), ホストの host/tools/drawreplay で
+ * 任意の Canvas の実装に対して再生・計測できます.
+ *   DrawRecChunk_t (magic "DRWR", version, size, dropped) + 記録 size byte
+ * 途中にテキスト (printf の出力等) が混在しても, 読み出し側は magic を探して再同期できます.
+ *
+ * 記録は [種類 1byte] [キャンバス番号 1byte (キャンバスの操作のみ)] [引数 (符号なし LEB128) ...] の並びです.
+ * 引数は対応する関数の引数順で, 負の値 (Canvas_Scroll() の移動量) は 32bit の 2の補数です.
+ * キャンバスはバッファのアドレスと大きさ・形式で区別し, チャンク内で最初に使用した時点と描画できる領域が変わった時点で
+ * DrawRecOpCanvas / DrawRecOpClip を記録します. 各チャンクは単独で再生できます.
+ * Canvas_Blit() の転送元の内容と, Font_Print() の描画関数は記録しません (描画関数が呼び出す Canvas_* は記録します).
+ *
+ * 記録先は 1つで排他制御を行わないため, 1コアからの描画のみ記録してください.
+ **/
+
+#if !defined(USER_DRAWREC_H__)
+#define USER_DRAWREC_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define DRAWREC_MAGIC "DRWR"  //< チャンクの先頭
+#define DRAWREC_VERSION (1)
+
+#define DRAWREC_CANVASES (8)  //< 1チャンクで区別できるキャンバスの数
+#define DRAWREC_MAX_ARGS (9)  //< 1つの記録の引数の最大数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 記録の種類 (引数の並び)
+ */
+typedef enum tagDrawRecOp_t {
+  DrawRecOpCanvas = 0x01,      //< キャンバスの定義: id, addr, w, h, s, fmt, clip.x, clip.y, clip.w, clip.h
+  DrawRecOpClip = 0x02,        //< 描画できる領域の変更: id, x, y, w, h
+  DrawRecOpClear = 0x10,       //< Canvas_Clear: id, c
+  DrawRecOpPixel = 0x11,       //< Canvas_DrawPixel: id, x, y, c
+  DrawRecOpLine = 0x12,        //< Canvas_DrawLine: id, x1, y1, x2, y2, c
+  DrawRecOpCircle = 0x13,      //< Canvas_DrawCircle: id, x, y, r, c
+  DrawRecOpFillCircle = 0x14,  //< Canvas_DrawFillCircle: id, x, y, r, c
+  DrawRecOpFillRect = 0x15,    //< Canvas_FillRect: id, x, y, w, h, c
+  DrawRecOpBlit = 0x16,        //< Canvas_Blit: id, x, y, w, h, ss
+  DrawRecOpScroll = 0x17,      //< Canvas_Scroll: id, x, y, w, h, dx, dy, fill
+  DrawRecOpText = 0x20,        //< Font_PrintWith: ank, kanji, len, 文字列 len byte (FONT_ID_NONE は 0xFFFFFFFF)
+  DrawRecOpFrame = 0x30,       //< フレームの区切り (引数なし)
+} DrawRecOp_t;
+
+/**
+ * DrawRec_Drain() が書き出すチャンクの先頭 (16byte)
+ */
+typedef struct tagDrawRecChunk_t {
+  char magic[4];     //< DRAWREC_MAGIC
+  uint16_t version;  //< DRAWREC_VERSION
+  uint16_t frames;   //< チャンク内のフレームの区切りの数
+  uint32_t size;     //< 続く記録のバイト数
+  uint32_t dropped;  //< 記録先が満杯で失った呼び出しの数
+} DrawRecChunk_t;
+
+typedef struct tagDrawRec_t {
+  uint8_t* buf;      //< 記録先
+  size_t cap;        //< 記録先の大きさ (単位: byte)
+  size_t len;        //< 記録済みのバイト数
+  uint16_t frames;   //< 記録済みのフレームの区切りの数
+  uint32_t dropped;  //< 失った呼び出しの数 (満杯になると DrawRec_Drain() まで記録しない)
+  // チャンク内で定義済みのキャンバス (描画できる領域は最後に記録したもの)
+  uint8_t nCanvases;
+  Canvas_t canvases[DRAWREC_CANVASES];
+} DrawRec_t;
+
+/**
+ * @brief DrawRec_Drain() の書き出し先 (TraceRingWriteFn_t と同じ形式)
+ * @param [in] arg : DrawRec_Drain() で指定した引数
+ * @param [in] data : 書き出すデータ
+ * @param [in] size : データ長 (単位: byte)
+ * @return 処理結果
+ */
+typedef UError_t (*DrawRecWriteFn_t)(void* arg, const void* data, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 記録先を初期化します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] buf : 記録の格納先 (cap byte)
+ * @param [in] cap : 格納先の大きさ (単位: byte)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t DrawRec_Create(DrawRec_t* ctx, void* buf, size_t cap);
+
+/**
+ * @brief 以降の描画関数の呼び出しを ctx へ記録します.
+ * @param [in] ctx : 記録先 (NULL: 記録を停止)
+ * @return 処理結果
+ */
+UError_t DrawRec_Attach(DrawRec_t* ctx);
+
+/**
+ * @brief フレームの区切りを記録します. フレームの描画が終わった時点で呼び出してください.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t DrawRec_EndFrame(DrawRec_t* ctx);
+
+/**
+ * @brief 記録をチャンク形式で書き出し, 空にします. フレームの区切りで呼び出してください.
+ *
+ * 記録がない場合も, 失った呼び出しがあればチャンクを書き出します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] write : 書き出し先
+ * @param [in] arg : write へ渡す引数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (書き出し失敗)
+ */
+UError_t DrawRec_Drain(DrawRec_t* ctx, DrawRecWriteFn_t write, void* arg);
+
+/**
+ * @brief キャンバスの操作を記録します (canvas.c から呼び出す).
+ * @param [inout] ctx : 記録先
+ * @param [in] canvas : 操作対象
+ * @param [in] op : 種類
+ * @param [in] args : キャンバス番号を除く引数
+ * @param [in] n : 引数の数
+ */
+void DrawRec_PutCanvas(DrawRec_t* ctx, const Canvas_t* canvas, DrawRecOp_t op, const uint32_t* args, size_t n);
+
+/**
+ * @brief 文字列の描画を記録します (font.c から呼び出す).
+ * @param [inout] ctx : 記録先
+ * @param [in] ank : 半角フォント (FontId_t)
+ * @param [in] kanji : 全角フォント (FontId_t)
+ * @param [in] sz : 文字列
+ */
+void DrawRec_PutText(DrawRec_t* ctx, int32_t ank, int32_t kanji, const char* sz);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 現在の記録先 (DrawRec_Attach() で設定. NULL: 記録しない)
+ */
+extern DrawRec_t* DrawRec_Current;
+
+#endif  // !defined(USER_DRAWREC_H__)
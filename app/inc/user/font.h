@@ -20,14 +20,75 @@
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * 登録可能なフォント数 (組み込みフォントを含む)
+ */
+#if !defined(FONT_REGISTRY_MAX)
+#define FONT_REGISTRY_MAX (8)
+#endif
+
+#define FONT_ID_NONE (-1)  //< フォント指定なし
+#define FONT_ID_ANK (0)    //< 組み込みの 4x8 ANK フォント
+
+/**
+ * FONTX2 ファイルを .rodata (XIP フラッシュ) に取り込みます.
+ *
+ * name にデータ先頭, name##_end にデータ末尾のシンボルが定義されます.
+ * path はコンパイラの作業ディレクトリからの相対パス, もしくは絶対パスです.
+ * @code
+ * FONT_INCBIN(jpnzn16x, "fonts/JPNZN16X.FNT");
+ * Font_Register(jpnzn16x, jpnzn16x_end - jpnzn16x, blocks, 255, &id);
+ * @endcode
+ */
+#define FONT_INCBIN(name, path)                     \
+  __asm__(".section .rodata." #name ", \"a\"\n"     \
+          ".balign 4\n"                             \
+          ".global " #name "\n" #name ":\n"         \
+          ".incbin \"" path "\"\n"                  \
+          ".global " #name "_end\n" #name "_end:\n" \
+          ".previous\n");                           \
+  extern const uint8_t name[];                      \
+  extern const uint8_t name##_end[]
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * 2バイトコード用 コードブロック索引
+ */
+typedef struct tagFontIndexBlock_t {
+  uint16_t sb;    //< ブロック先頭の文字コード
+  uint16_t eb;    //< ブロック末尾の文字コード
+  uint32_t base;  //< ブロック先頭のグリフ番号 (先行ブロックの文字数の累計)
+} FontIndexBlock_t;
+
+/**
+ * FONTX2 フォントの検索索引
+ *
+ * ヘッダを一度だけ解析し, 2バイトコードのフォントではコードブロックを
+ * 開始コード順に整列して保持します. 検索はブロックの二分探索で行います.
+ */
+typedef struct tagFontIndex_t {
+  const uint8_t* font;          //< FONTX2 データ
+  const uint8_t* glyphs;        //< グリフデータの先頭
+  uint32_t fw;                  //< フォント幅 (単位: pixel)
+  uint32_t fh;                  //< フォント高 (単位: pixel)
+  size_t fsz;                   //< 1グリフあたりのデータサイズ (単位: byte)
+  uint8_t type;                 //< 0: 1バイトコード(ANK) 1: 2バイトコード(SJIS)
+  size_t nblk;                  //< コードブロック数
+  const FontIndexBlock_t* blk;  //< 開始コード順に整列したコードブロック
+} FontIndex_t;
+
+/**
+ * Font_Register() で登録したフォントの識別子
+ */
+typedef int32_t FontId_t;
+
 /**
  * Font_Print() から呼び出される描画関数
  * @param [in] arg : パラメータパック
- * @param [in] x : x座標 (単位: キャラクタ)
+ * @param [in] x : x座標 (単位: 半角キャラクタ. 全角文字は 2キャラクタ分を占有します)
  * @param [in] y : y座標 (単位: キャラクタ)
  * @param [in] graph : フォントグラフ
  * @param [in] c : 文字コード (JIS(7bit) or SJIS(16bit))
@@ -38,7 +99,7 @@
  * @retval uSuccess : 処理完了
  * @retval uSuccess 以外 : 処理失敗. Font_Print() は以降の処理を終了します.
  */
-typedef UError_t (*Font_DrawFontFn_t)(void* arg, uint32_t x, uint32_t y, const void* graph, uint8_t c, uint32_t fw, uint32_t fh, size_t fsz);
+typedef UError_t (*Font_DrawFontFn_t)(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
 
 //////////////////////////////////////////////////////////////////////////////
 // prototype
@@ -50,6 +111,10 @@ extern "C" {
 
 /**
  * @brief 文字列リテラル sz を描画します.
+ *
+ * sz は UTF-8 として解釈します. ASCII 以外の文字は SJIS へ変換し,
+ * 半角カナは ANK フォント, それ以外は全角フォントで描画します.
+ * 使用するフォントは Font_SetDefault() で指定したものです.
  * @param [in] sz : 出力対象の文字列リテラル
  * @param [in] fn : 描画関数
  *   @arg FONTX2形式のグラフ情報とキャラクタ座標(x,y) および
@@ -62,6 +127,90 @@ extern "C" {
  */
 UError_t Font_Print(const char* sz, Font_DrawFontFn_t fn, void* arg);
 
+/**
+ * @brief 使用するフォントを指定して文字列リテラル sz を描画します.
+ * @param [in] ank : 半角文字に使用するフォント (1バイトコード)
+ * @param [in] kanji : 全角文字に使用するフォント (2バイトコード). FONT_ID_NONE の場合, 全角文字は描画しません.
+ * @param [in] sz : 出力対象の文字列リテラル
+ * @param [in] fn : 描画関数
+ * @param [in] arg : 描画関数に引き渡すパラメータパック
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Font_PrintWith(const FontId_t ank, const FontId_t kanji, const char* sz, Font_DrawFontFn_t fn, void* arg);
+
+/**
+ * @brief FONTX2 データをフォントとして登録します.
+ *
+ * ヘッダとコードブロックは登録時に一度だけ検証・索引化します.
+ * グリフは image から直接参照するため, image (および blocks) は登録後も保持してください.
+ * フラッシュ上のデータをそのまま登録でき, RAM へのコピーは行いません.
+ * @param [in] image : FONTX2 データ
+ * @param [in] size : image のサイズ (単位: byte)
+ * @param [out] blocks : コードブロック索引の格納先 (2バイトコードのフォントのみ使用. NULL 可)
+ * @param [in] nblocks : blocks の要素数
+ * @param [out] id : 登録したフォントの識別子
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (登録数の上限, FONTX2 形式として不正等)
+ */
+UError_t Font_Register(const void* image, size_t size, FontIndexBlock_t* blocks, size_t nblocks, FontId_t* id);
+
+/**
+ * @brief 登録済みフォントの検索索引を取得します.
+ * @param [in] id : フォントの識別子
+ * @return 検索索引
+ * @retval NULL : 該当なし
+ */
+const FontIndex_t* Font_Get(const FontId_t id);
+
+/**
+ * @brief Font_Print() が使用するフォントを指定します.
+ * @param [in] ank : 半角文字に使用するフォント (1バイトコード)
+ * @param [in] kanji : 全角文字に使用するフォント (2バイトコード). FONT_ID_NONE の場合, 全角文字は描画しません.
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (未登録のフォント, コード種別の不一致)
+ */
+UError_t Font_SetDefault(const FontId_t ank, const FontId_t kanji);
+
+/**
+ * @brief Unicode のコードポイントを SJIS の文字コードへ変換します.
+ *
+ * JIS X 0208 の全文字と半角カナ(1バイトコード) を収録したフラッシュ上のテーブルを引きます.
+ * @param [in] cp : コードポイント
+ * @return SJIS 文字コード
+ * @retval 0 : 該当なし
+ */
+uint16_t Font_UnicodeToSJIS(const uint32_t cp);
+
+/**
+ * @brief FONTX2 データの検索索引を作成します.
+ * @param [out] idx : 初期化対象
+ * @param [in] font : FONTX2 データ
+ * @param [in] size : font のサイズ (単位: byte)
+ * @param [out] blocks : コードブロック索引の格納先 (2バイトコードのフォントのみ使用)
+ * @param [in] nblocks : blocks の要素数 (FONTX2 のコードブロック数以上が必要)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (FONTX2 形式ではない, size が不足する, blocks が不足する等)
+ */
+UError_t Font_BuildIndex(FontIndex_t* idx, const void* font, size_t size, FontIndexBlock_t* blocks, size_t nblocks);
+
+/**
+ * @brief 検索索引から code に該当するグリフの先頭を指すポインタを取得します.
+ * @param [in] idx : 検索索引
+ * @param [in] code : 文字コード JIS(7bit) or SJIS(16bit)
+ * @param [out] pw : フォントデータの幅 (ドット)
+ * @param [out] ph : フォントデータの高さ (ドット)
+ * @param [out] pfsz : フォントデータサイズ(バイト)
+ * @return フォントデータの先頭を指すポインタ
+ * @retval NULL 以外 : フォントデータの先頭を指すポインタ
+ * @retval NULL : 該当データなし
+ */
+const uint8_t* Font_FindGlyph(const FontIndex_t* idx, const uint16_t code, uint32_t* const pw, uint32_t* const ph, size_t* const pfsz);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,103 @@
+/**
+ * @file prog01/app/inc/user/frameq.h
+ * 単一生産者/単一消費者 (SPSC) のロックフリーキュー
+ *
+ * 生産者と消費者がそれぞれ 1つの場合に限り, ロックなしでコア間/スレッド間の受け渡しができます.
+ * head は消費者のみ, tail は生産者のみが更新し, C11 atomics の acquire/release で
+ * 要素の書き込みと読み出しの順序を保証します. MCU 固有の機能には依存しません.
+ **/
+
+#if !defined(USER_FRAMEQ_H__)
+#define USER_FRAMEQ_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define FRAMEQ_CAPACITY (16)  //< キューの要素数 (2のべき乗)
+
+#define FRAMEQ_FLAG_LAST (0x0001u)  //< フレームの最後の要素 (転送後にバッファを返却する)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * キューの要素
+ */
+typedef struct tagFrameQueueItem_t {
+  uint16_t buffer;    //< バッファ番号
+  uint16_t flags;     //< FRAMEQ_FLAG_*
+  CanvasRect_t rect;  //< 転送する領域
+} FrameQueueItem_t;
+
+typedef struct tagFrameQueue_t {
+  _Atomic uint32_t head;  //< 次に取り出す位置 (消費者が更新)
+  _Atomic uint32_t tail;  //< 次に格納する位置 (生産者が更新)
+  FrameQueueItem_t items[FRAMEQ_CAPACITY];
+} FrameQueue_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief キューを空の状態に初期化します. 生産者/消費者の開始前に呼び出してください.
+ * @param [out] ctx : 初期化対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t FrameQueue_Init(FrameQueue_t* ctx);
+
+/**
+ * @brief 要素を格納します. 生産者のみが呼び出せます. 待ち合わせは行いません.
+ * @param [inout] ctx : 操作対象
+ * @param [in] item : 格納する要素
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (キューが満杯)
+ */
+UError_t FrameQueue_Push(FrameQueue_t* ctx, const FrameQueueItem_t* item);
+
+/**
+ * @brief 要素を取り出します. 消費者のみが呼び出せます. 待ち合わせは行いません.
+ * @param [inout] ctx : 操作対象
+ * @param [out] item : 取り出した要素
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (キューが空)
+ */
+UError_t FrameQueue_Pop(FrameQueue_t* ctx, FrameQueueItem_t* item);
+
+/**
+ * @brief 格納されている要素数を取得します. 他方が操作中の場合は概算値です.
+ * @param [in] ctx : 操作対象
+ * @return 要素数
+ */
+uint32_t FrameQueue_Count(FrameQueue_t* ctx);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_FRAMEQ_H__)
@@ -0,0 +1,156 @@
+/**
+ * @file prog01/app/inc/user/glyphcache.h
+ * RGB565 展開済みグリフのキャッシュ
+ *
+ * FONTX2 のビットマップを (前景色, 背景色, 倍率) ごとに RGB565 へ展開した結果を
+ * 固定サイズのアリーナに保持し, LRU で入れ替えます.
+ * ヒット時はキャンバスへの行単位コピーのみで描画できます.
+ *
+ * キー: グリフの先頭アドレス + 前景色 + 背景色 + 倍率
+ *   FONTX2 のグリフはフォントデータ内で固定の位置にあるため,
+ *   グリフの先頭アドレスは (フォント, 文字コード) の組に一意に対応します.
+ **/
+
+#if !defined(USER_GLYPHCACHE_H__)
+#define USER_GLYPHCACHE_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 無効なエントリ番号
+ */
+#define GLYPHCACHE_NONE (0xffffu)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagGlyphCacheEntry_t {
+  const void* graph;  //< キー: グリフの先頭アドレス (NULL: 未使用)
+  uint16_t fg;        //< キー: 前景色
+  uint16_t bg;        //< キー: 背景色
+  uint16_t scale;     //< キー: 倍率
+  uint16_t w;         //< 展開後の幅 (単位: pixel)
+  uint16_t h;         //< 展開後の高さ (単位: pixel)
+  uint16_t prev;      //< LRU リスト (MRU 側)
+  uint16_t next;      //< LRU リスト (LRU 側)
+  uint16_t hnext;     //< ハッシュチェイン
+  uint16_t* pix;      //< 展開済みイメージ (ストライド = w)
+} GlyphCacheEntry_t;
+
+typedef struct tagGlyphCacheStats_t {
+  uint32_t hit;    //< ヒット回数
+  uint32_t miss;   //< ミス回数
+  uint32_t evict;  //< 追い出し回数
+} GlyphCacheStats_t;
+
+typedef struct tagGlyphCache_t {
+  GlyphCacheEntry_t* entries;
+  uint16_t* buckets;
+  size_t nEntries;    //< エントリ数
+  size_t mask;        //< バケット数 - 1
+  size_t slotPixels;  //< 1エントリあたりの最大ピクセル数
+  uint16_t head;      //< MRU
+  uint16_t tail;      //< LRU
+  GlyphCacheStats_t stats;
+} GlyphCache_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief アリーナを分割してグリフキャッシュを初期化します.
+ *
+ * エントリ管理領域, ハッシュテーブル, 展開イメージ領域はすべて arena から確保します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] arena : キャッシュに使用するメモリ
+ * @param [in] size : arena のサイズ (単位: byte)
+ * @param [in] slotPixels : 1グリフあたりの最大ピクセル数 (fw * scale * fh * scale)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (1エントリも確保できない)
+ */
+UError_t GlyphCache_Create(GlyphCache_t* ctx, void* arena, size_t size, size_t slotPixels);
+
+/**
+ * @brief すべてのエントリを破棄します. 統計情報は保持されます.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t GlyphCache_Flush(GlyphCache_t* ctx);
+
+/**
+ * @brief 展開済みグリフを取得します. キャッシュに無い場合は LRU エントリを再利用して展開します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] graph : FONTX2 形式のグリフ (Font_DrawFontFn_t の graph)
+ * @param [in] fw : フォント幅 (単位: pixel)
+ * @param [in] fh : フォント高 (単位: pixel)
+ * @param [in] fg : 前景色 (RGB565)
+ * @param [in] bg : 背景色 (RGB565)
+ * @param [in] scale : 倍率 (1以上)
+ * @param [out] entry : 展開済みグリフ
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (展開後のサイズが slotPixels を超える等)
+ */
+UError_t GlyphCache_Get(GlyphCache_t* ctx, const void* graph, uint32_t fw, uint32_t fh, uint16_t fg, uint16_t bg, uint32_t scale,
+                        const GlyphCacheEntry_t** entry);
+
+/**
+ * @brief 展開済みグリフを (x, y) を左上としてキャンバスへ描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] canvas : 描画先 (RGB565 形式のみ)
+ * @param [in] x : x座標 (単位: pixel)
+ * @param [in] y : y座標 (単位: pixel)
+ * @param [in] graph : FONTX2 形式のグリフ
+ * @param [in] fw : フォント幅 (単位: pixel)
+ * @param [in] fh : フォント高 (単位: pixel)
+ * @param [in] fg : 前景色 (RGB565)
+ * @param [in] bg : 背景色 (RGB565)
+ * @param [in] scale : 倍率 (1以上)
+ * @return 処理結果
+ */
+UError_t GlyphCache_Draw(GlyphCache_t* ctx, const Canvas_t* canvas, size_t x, size_t y, const void* graph, uint32_t fw, uint32_t fh, uint16_t fg,
+                         uint16_t bg, uint32_t scale);
+
+/**
+ * @brief ヒット/ミス回数を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [out] stats : 統計情報
+ * @return 処理結果
+ */
+UError_t GlyphCache_GetStats(const GlyphCache_t* ctx, GlyphCacheStats_t* stats);
+
+/**
+ * @brief ヒット/ミス回数をクリアします.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t GlyphCache_ResetStats(GlyphCache_t* ctx);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_GLYPHCACHE_H__)
@@ -14,8 +14,10 @@
 // includes
 //////////////////////////////////////////////////////////////////////////////
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <user/canvas.h>
 #include <user/spidrv.h>
 #include <user/types.h>
 
@@ -23,9 +25,44 @@
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * LCDDrv_SwapCanvas() で RGB565 に展開するバッファ 1面あたりのピクセル数 (幅 240 で 4 line, 幅 320 で 3 line)
+ */
+#define LCDDRV_EXPAND_PIXELS (240 * 4)
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
+
+/**
+ * SPI 転送時のピクセル形式
+ */
+typedef enum tagLCDDrvPixelFormat_t {
+  LCDDrvRGB565 = 0,  //< 16bit/pixel (COLMOD 0x05). 240x320 で 153,600 byte
+  LCDDrvRGB444,      //< 12bit/pixel (COLMOD 0x03). 2pixel を 3byte に詰める. 240x320 で 115,200 byte
+} LCDDrvPixelFormat_t;
+
+/**
+ * 画面の向き (時計回りの回転角)
+ */
+typedef enum tagLCDDrvRotation_t {
+  LCDDrvRotate0 = 0,  //< 縦 240 x 320 (初期値)
+  LCDDrvRotate90,     //< 横 320 x 240
+  LCDDrvRotate180,    //< 縦 240 x 320
+  LCDDrvRotate270,    //< 横 320 x 240
+} LCDDrvRotation_t;
+
+/**
+ * 転送処理の計測値 (LCDDrv_GetTiming() で取得)
+ */
+typedef struct tagLCDDrvTiming_t {
+  uint64_t waitUs;     //< 非同期転送の完了待ち (CPU が停止していた時間)
+  uint64_t windowUs;   //< LCDDrv_SetWindow() のコマンド送信
+  uint64_t dmaUs;      //< 非同期転送の実行時間 (SPIDrv_GetAsyncTime())
+  uint64_t bytes;      //< 非同期転送で送信したバイト数
+  uint32_t transfers;  //< 非同期転送の回数
+} LCDDrvTiming_t;
+
 typedef struct tagLCDDrvContext_t {
   SPIDrvHandle_t spi;
   uint32_t dc;
@@ -34,6 +71,22 @@ typedef struct tagLCDDrvContext_t {
   uint32_t pwmSlice;
 
   bool bBusy;
+  LCDDrvPixelFormat_t pixfmt;  //< 転送時のピクセル形式
+
+  // 画面の向き
+  uint8_t madctl;   //< Memory Data Access Control の設定値
+  uint16_t width;   //< 論理的な幅 (単位: pixel)
+  uint16_t height;  //< 論理的な高さ (単位: pixel)
+
+  // 垂直スクロール (単位: line, フレームメモリの行)
+  uint16_t scrollTop;     //< 固定領域(上端)の行数 (TFA)
+  uint16_t scrollHeight;  //< スクロール領域の行数 (VSA)
+  uint16_t scrollStart;   //< スクロール領域の先頭に表示するメモリ行 (VSP)
+
+  // LCDDrv_SwapCanvas() の展開バッファ (一方を DMA 転送中にもう一方へ展開する)
+  uint16_t expand[2][LCDDRV_EXPAND_PIXELS];
+
+  LCDDrvTiming_t timing;  //< 計測値 (完了した非同期転送ごとに加算)
 } LCDDrvContext_t;
 
 typedef void* LCDDrvHandle_t;
@@ -71,8 +124,37 @@ UError_t LCDDrv_Init(LCDDrvHandle_t handle);
  */
 UError_t LCDDrv_InitalizeHW(LCDDrvHandle_t handle);
 
+/**
+ * @brief 画面の向きを設定します. (Memory Data Access Control: 0x36)
+ *
+ * コントローラの走査方向を変更するため, キャンバスは回転後の向きでそのまま転送できます.
+ * 以降の LCDDrv_SetWindow() 等は回転後の幅と高さを基準とします.
+ * フレームメモリの内容は変化しないため, 設定後に全画面を描画し直してください.
+ * 垂直スクロールは解除します (全画面をスクロール領域とし, 表示開始位置を戻します).
+ * 垂直スクロールはパネルの行に対して働くため, 90/270度では LCDDrv_SetScrollArea() 等のスクロール操作は失敗します.
+ * スクロールの代わりに全画面を描画し直してください.
+ * @param [in] handle : 操作対象
+ * @param [in] rotation : 時計回りの回転角
+ * @param [in] mirror : true の場合 左右反転
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t LCDDrv_SetRotation(LCDDrvHandle_t handle, LCDDrvRotation_t rotation, bool mirror);
+
+/**
+ * @brief 現在の向きでの画面の幅と高さを取得します.
+ * @param [in] handle : 操作対象
+ * @param [out] width : 幅 (単位: pixel. NULL 可)
+ * @param [out] height : 高さ (単位: pixel. NULL 可)
+ * @return 処理結果
+ */
+UError_t LCDDrv_GetSize(LCDDrvHandle_t handle, uint16_t* width, uint16_t* height);
+
 /**
  * @brief データ転送を行う際の描画範囲を指定します.
+ *
+ * 非同期転送の途中で呼び出した場合は, 転送の完了を待ってからコマンドを送信します.
  * @param [in] lcd : 操作対象
  * @param [in] x : x位置
  * @param [in] y : y位置
@@ -96,8 +178,139 @@ UError_t LCDDrv_Clear(LCDDrvHandle_t handle, const uint8_t r, const uint8_t g, c
 
 UError_t LCDDrv_SetBrightness(LCDDrvHandle_t handle, uint16_t b);
 
+/**
+ * @brief RGB565 のフレームを転送します.
+ *
+ * LCDDrvRGB565 の場合は frame をそのまま DMA で転送し, 完了を待たずに戻ります.
+ * LCDDrvRGB444 の場合は展開バッファへ 12bit 形式に詰めながら転送します.
+ * @param [in] handle : 操作対象
+ * @param [in] frame : RGB565 のフレーム (w * h pixel)
+ * @param [in] x : x位置
+ * @param [in] y : y位置
+ * @param [in] w : 幅
+ * @param [in] h : 高さ
+ * @return 処理結果
+ */
 UError_t LCDDrv_SwapBuff(LCDDrvHandle_t handle, const void* frame, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
+/**
+ * @brief SPI 転送時のピクセル形式を設定します. (Interface Pixel Format: 0x3A)
+ *
+ * 以降の LCDDrv_Clear(), LCDDrv_SwapBuff(), LCDDrv_SwapCanvas() は指定した形式で転送します.
+ * @param [in] handle : 操作対象
+ * @param [in] fmt : ピクセル形式
+ * @return 処理結果
+ */
+UError_t LCDDrv_SetPixelFormat(LCDDrvHandle_t handle, LCDDrvPixelFormat_t fmt);
+
+/**
+ * @brief RGB565 のピクセル列を 12bit/pixel (RGB444) の転送データに変換します.
+ *
+ * 各色の上位 4bit を使用し, 2pixel を 3byte (R1G1 B1R2 G2B2) に詰めます.
+ * n が奇数の場合, 最後の 4bit は 0 で埋めます.
+ * src と dst は同じ領域を指定できます (前方から詰めるため).
+ * @param [in] src : RGB565 のピクセル列 (Canvas と同じバイト順)
+ * @param [in] n : ピクセル数
+ * @param [out] dst : 格納先 ((n * 3 + 1) / 2 byte)
+ * @return 格納したバイト数
+ */
+size_t LCDDrv_PackRGB444(const uint16_t* src, size_t n, uint8_t* dst);
+
+/**
+ * @brief キャンバスの矩形領域を, 画面上の同じ位置へ転送します.
+ *
+ * 行単位で RGB565 に展開しながら転送するため, インデックスカラーのキャンバスや
+ * ストライドが幅と異なる領域も転送できます. 展開は 2面のバッファを交互に使用し,
+ * 一方の DMA 転送中にもう一方へ次の行を展開します.
+ * 最後の転送は完了を待たずに戻ります.
+ * @param [in] handle : 操作対象
+ * @param [in] canvas : 転送元 (インデックスカラーの場合はパレットを設定済みであること)
+ * @param [in] x : x位置
+ * @param [in] y : y位置
+ * @param [in] w : 幅
+ * @param [in] h : 高さ
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t LCDDrv_SwapCanvas(LCDDrvHandle_t handle, const Canvas_t* canvas, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/**
+ * @brief 垂直スクロール領域を設定します. (Vertical Scrolling Definition: 0x33)
+ *
+ * 画面の行を 上端の固定領域 / スクロール領域 / 下端の固定領域 に分割します.
+ * 下端の固定領域は残りの行数です. 表示開始位置はスクロール領域の先頭に戻ります.
+ * スクロール領域を 0行にするとスクロールを無効にします.
+ * 180度回転ではパネルの行と逆順になるため, パネルへは上下を入れ替えて設定します.
+ * 90/270度回転ではパネルの行が画面の列になるため, 失敗します (全画面を描画し直してください).
+ * @param [in] handle : 操作対象
+ * @param [in] top : 上端の固定領域の行数
+ * @param [in] height : スクロール領域の行数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (パネルの行数を超える, 90/270度回転)
+ */
+UError_t LCDDrv_SetScrollArea(LCDDrvHandle_t handle, uint16_t top, uint16_t height);
+
+/**
+ * @brief スクロール領域の先頭に表示するメモリ行を設定します. (Vertical Scroll Start Address: 0x37)
+ *
+ * start はパネルの行の順 (回転の影響を受けない) で指定します. 通常は LCDDrv_Scroll() を使用してください.
+ * @param [in] handle : 操作対象
+ * @param [in] start : メモリ行 (パネル上のスクロール領域の先頭以上, 終端未満)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (スクロール領域外, 90/270度回転)
+ */
+UError_t LCDDrv_SetScrollStart(LCDDrvHandle_t handle, uint16_t start);
+
+/**
+ * @brief スクロール領域の表示内容を lines 行分 上へ送ります. 負数の場合は下へ送ります.
+ *
+ * 表示開始位置を領域内で周回させるだけで, フレームメモリの転送は発生しません.
+ * 新たに見えるようになった行は LCDDrv_ScrollMapRow() で求めた行へ転送します.
+ * 0/180度回転の画面の上下を基準とします. 90/270度回転では失敗します.
+ * @param [in] handle : 操作対象
+ * @param [in] lines : スクロール量 (単位: line)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (スクロール領域なし, 90/270度回転)
+ */
+UError_t LCDDrv_Scroll(LCDDrvHandle_t handle, int32_t lines);
+
+/**
+ * @brief 画面上の行に現在表示されているフレームメモリの行を取得します.
+ *
+ * 戻り値は LCDDrv_SetWindow() 等の y座標としてそのまま使用できます (180度回転の上下の反転を含みます).
+ * 固定領域の行, および 90/270度回転ではそのまま返します.
+ * @param [in] handle : 操作対象
+ * @param [in] row : 画面上の行
+ * @return 転送先の行 (handle 不正時は row)
+ */
+uint16_t LCDDrv_ScrollMapRow(LCDDrvHandle_t handle, uint16_t row);
+
+/**
+ * @brief 非同期転送が実行中であれば完了を待ちます.
+ *
+ * 転送完了までの時間を計測する場合や, 転送元のバッファを書き換える前に使用します.
+ * @param [in] handle : 操作対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t LCDDrv_WaitForTransfer(LCDDrvHandle_t handle);
+
+/**
+ * @brief 転送処理の計測値を取得します.
+ *
+ * 非同期転送の値は完了待ちの時点で加算するため, 最後の転送は次の完了待ちまで含まれません.
+ * @param [in] handle : 操作対象
+ * @param [out] timing : 計測値
+ * @param [in] reset : true: 取得後に 0 にする
+ * @return 処理結果
+ */
+UError_t LCDDrv_GetTiming(LCDDrvHandle_t handle, LCDDrvTiming_t* timing, bool reset);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
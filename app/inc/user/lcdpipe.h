@@ -0,0 +1,126 @@
+/**
+ * @file prog01/app/inc/user/lcdpipe.h
+ * 描画(core0) と LCD 転送(core1) を分離するパイプライン
+ *
+ * LCDPipe_Start() 以降は core1 が LCDDrv / SPIDrv を専有し, core0 から投入されたフレームを転送します.
+ * パイプラインは core1 を専有するため, core1 を使用する他の処理 (BandRender_Start()) とは併用できません.
+ * core0 は LCDPipe_Acquire() で空いた面を取得して描画し, LCDPipe_Submit() で転送領域とともに投入します.
+ * 転送を終えた面は返却キューを通じて core0 へ戻ります. 面を 3つ登録すると, 1面を転送中でも
+ * 描画済みの 1面を待機させたまま次の面へ描画できます (トリプルバッファ).
+ *
+ * キューはどちらも FrameQueue_t (SPSC) で, core0 が投入キューの生産者/返却キューの消費者,
+ * core1 がその逆になります. LCDPipe_Service() を別スレッドから呼び出せば, コア無しでも同じ動作になります.
+ **/
+
+#if !defined(USER_LCDPIPE_H__)
+#define USER_LCDPIPE_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/frameq.h>
+#include <user/lcddrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define LCDPIPE_MAX_BUFFERS (3)  //< 登録できる面の数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagLCDPipe_t {
+  LCDDrvHandle_t lcd;
+  const Canvas_t* canvas[LCDPIPE_MAX_BUFFERS];  //< 面
+  uint32_t nbuf;                                //< 面の数
+  FrameQueue_t submit;                          //< 転送待ちの領域 (core0 -> core1)
+  FrameQueue_t release;                         //< 転送を終えた面 (core1 -> core0)
+} LCDPipe_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief パイプラインを初期化します. すべての面は空き(返却済み)の状態になります.
+ * @param [out] ctx : 初期化対象
+ * @param [in] lcd : 転送先 (初期化済みであること)
+ * @param [in] canvases : 面 (n 個. 転送元として参照し続ける)
+ * @param [in] n : 面の数 (1 以上 LCDPIPE_MAX_BUFFERS 以下)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t LCDPipe_Create(LCDPipe_t* ctx, LCDDrvHandle_t lcd, const Canvas_t* const* canvases, uint32_t n);
+
+/**
+ * @brief 描画に使用できる面を取得します. 待ち合わせは行いません.
+ *
+ * 取得した面の内容は, 以前その面に描画したままです. 差分のみを投入する場合は,
+ * 他の面で更新した領域を呼び出し側で反映してください.
+ * @param [inout] ctx : 操作対象
+ * @param [out] index : 面の番号
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (空いている面が無い)
+ */
+UError_t LCDPipe_Acquire(LCDPipe_t* ctx, uint32_t* index);
+
+/**
+ * @brief 描画を終えた面を転送領域とともに投入します. 待ち合わせは行いません.
+ *
+ * 面は最後の領域の転送後に返却され, 再び LCDPipe_Acquire() で取得できるようになります.
+ * 投入キューに n 個分の空きが無い場合は何も投入せずに失敗します. この場合, 面は呼び出し側が保持したままです.
+ * @param [inout] ctx : 操作対象
+ * @param [in] index : LCDPipe_Acquire() で取得した面の番号
+ * @param [in] rects : 転送する領域 (n 個). NULL の場合は面全体
+ * @param [in] n : 領域の数 (rects が NULL の場合は無視)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t LCDPipe_Submit(LCDPipe_t* ctx, uint32_t index, const CanvasRect_t* rects, size_t n);
+
+/**
+ * @brief 投入済みの領域をすべて転送し, 転送を終えた面を返却します. 転送側 (core1) から呼び出します.
+ * @param [inout] ctx : 操作対象
+ * @param [out] count : 転送した領域の数 (NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (LCD への転送失敗. 該当の面は返却済み)
+ */
+UError_t LCDPipe_Service(LCDPipe_t* ctx, uint32_t* count);
+
+/**
+ * @brief core1 で LCDPipe_Service() を繰り返し実行します.
+ *
+ * 以降, core0 から LCDDrv / SPIDrv の関数を呼び出さないでください.
+ * 起動できるパイプラインは 1つだけです. core1 は Core1_Launch() で起動し, 停止しません.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (起動済み, core1 を他の処理が使用中)
+ */
+UError_t LCDPipe_Start(LCDPipe_t* ctx);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_LCDPIPE_H__)
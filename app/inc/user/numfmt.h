@@ -0,0 +1,91 @@
+/**
+ * @file prog01/app/inc/user/numfmt.h
+ * 数値の文字列変換
+ *
+ * sprintf を使用せず, 呼び出し元のバッファへ直接書き込みます. (ヒープ/大きなスタックを使用しません)
+ **/
+
+#if !defined(USER_NUMFMT_H__)
+#define USER_NUMFMT_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 符号なし整数を10進文字列へ変換します.
+ * @param [out] buf : 格納先 (終端文字を付加します)
+ * @param [in] size : buf のサイズ (単位: byte)
+ * @param [in] v : 変換対象
+ * @param [in] width : 最小桁数. 不足分は pad で左側を埋めます.
+ * @param [in] pad : 埋め文字 (' ' or '0')
+ * @param [out] plen : 書き込んだ文字数 (終端文字を除く. NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (buf が不足する)
+ */
+UError_t NumFmt_U32(char* buf, size_t size, uint32_t v, uint32_t width, char pad, size_t* plen);
+
+/**
+ * @brief 符号付き整数を10進文字列へ変換します.
+ *
+ * pad が '0' の場合, 符号は埋め文字の前に出力します. (例: -0042)
+ * @param [out] buf : 格納先 (終端文字を付加します)
+ * @param [in] size : buf のサイズ (単位: byte)
+ * @param [in] v : 変換対象
+ * @param [in] width : 最小桁数 (符号を含む)
+ * @param [in] pad : 埋め文字 (' ' or '0')
+ * @param [out] plen : 書き込んだ文字数 (終端文字を除く. NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (buf が不足する)
+ */
+UError_t NumFmt_I32(char* buf, size_t size, int32_t v, uint32_t width, char pad, size_t* plen);
+
+/**
+ * @brief 固定小数点数を10進文字列へ変換します.
+ *
+ * v を 10^frac で割った値を小数点以下 frac 桁で出力します. (例: v=-1234, frac=2 -> "-12.34")
+ * @param [out] buf : 格納先 (終端文字を付加します)
+ * @param [in] size : buf のサイズ (単位: byte)
+ * @param [in] v : 変換対象
+ * @param [in] frac : 小数部の桁数 (0 - 9)
+ * @param [in] width : 最小桁数 (符号, 小数点を含む)
+ * @param [in] pad : 埋め文字 (' ' or '0')
+ * @param [out] plen : 書き込んだ文字数 (終端文字を除く. NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (buf が不足する, frac が範囲外)
+ */
+UError_t NumFmt_Fixed(char* buf, size_t size, int32_t v, uint32_t frac, uint32_t width, char pad, size_t* plen);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_NUMFMT_H__)
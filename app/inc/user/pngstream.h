@@ -0,0 +1,219 @@
+/**
+ * @file prog01/app/inc/user/pngstream.h
+ * PNG の逐次デコード (1行ずつ RGB565 へ変換して出力する)
+ *
+ * 画像全体を展開せず, 読み出し関数から少しずつ入力し, 1行展開するごとに RGB565 (キャンバスと同じ格納順) へ変換して
+ * 行の出力関数へ渡します. 出力先として Canvas_t の矩形 (PngStream_RowToCanvas()) と
+ * LCD のウィンドウ (PngStream_RowToLCD()) を用意しています. 入力はメモリ上のデータ (XIP のフラッシュを含む) から
+ * PngStream_ReadMemory() で読み出せます.
+ *
+ * 展開には zlib の inflate を使用し, 必要なメモリは全て PngStream_Create() で渡す作業領域から確保します (malloc を使用しない).
+ * 作業領域は zlib の状態とスライド窓 (画像の zlib ヘッダが示す大きさ. 最大 32KB), 入力バッファ,
+ * フィルタの復元に必要な 2行分 (現在の行と前の行), 出力する RGB565 の 2行分です (PNGSTREAM_WORK_SIZE()).
+ * 出力は 2行を交互に使用するため, 出力関数へ渡した行は次の行の出力関数から戻るまで有効です (非同期の転送に使用できます).
+ *
+ * 対応形式: グレースケール / RGB / パレット / グレースケール+アルファ / RGBA の全てのビット深度 (1/2/4/8/16bit).
+ * インターレース (Adam7) は行単位で出力できないため対応しません.
+ * アルファ (tRNS を含む) は PngStream_SetBackground() で指定した背景色と合成します.
+ * PngStream_SetDither() で 4x4 の組織的ディザを有効にすると, 8bit の色を 5/6/5bit へ減らす際の階調の段差を目立たなくします.
+ * チャンクの CRC は検査しません (圧縮データは zlib の Adler-32 で検査します). 補助チャンクは読み飛ばします.
+ **/
+
+#if !defined(USER_PNGSTREAM_H__)
+#define USER_PNGSTREAM_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/lcddrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define PNGSTREAM_INPUT_SIZE (512)  //< 入力バッファの大きさ (単位: byte)
+
+/**
+ * zlib の inflate が確保する領域の上限 (状態 約7KB + スライド窓 32KB + 管理用の余裕)
+ */
+#define PNGSTREAM_ZLIB_SIZE ((32 * 1024) + (8 * 1024) + 512)
+
+/**
+ * 幅 w の画像のデコードに必要な作業領域の大きさ (単位: byte)
+ * 2行分の展開データ (最大 8byte/pixel + フィルタ種別 1byte) と 2行分の RGB565 を含みます.
+ */
+#define PNGSTREAM_WORK_SIZE(w) (PNGSTREAM_ZLIB_SIZE + PNGSTREAM_INPUT_SIZE + (2 * (((size_t)(w) * 8) + 1)) + (2 * (size_t)(w) * 2) + 64)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 入力の読み出し関数
+ * @param [in] arg : PngStream_Decode() で指定した引数
+ * @param [out] buf : 読み出したデータの格納先
+ * @param [in] size : 読み出す大きさ (単位: byte)
+ * @param [out] read : 読み出した大きさ (size 未満の場合は入力の終端)
+ * @return 処理結果
+ */
+typedef UError_t (*PngStreamReadFn_t)(void* arg, void* buf, size_t size, size_t* read);
+
+/**
+ * @brief 行の出力関数
+ * @param [in] arg : PngStream_Decode() で指定した引数
+ * @param [in] y : 行番号 (0 から順に呼び出す)
+ * @param [in] row : RGB565 (キャンバスと同じ格納順) の 1行 (w pixel). 次の行の出力関数から戻るまで有効
+ * @param [in] w : 画像の幅 (単位: pixel)
+ * @return 処理結果 (uSuccess 以外の場合, デコードを中止する)
+ */
+typedef UError_t (*PngStreamRowFn_t)(void* arg, uint32_t y, const uint16_t* row, uint32_t w);
+
+/**
+ * 画像の情報 (IHDR)
+ */
+typedef struct tagPngInfo_t {
+  uint32_t w;
+  uint32_t h;
+  uint8_t depth;      //< ビット深度 (1/2/4/8/16)
+  uint8_t colorType;  //< 0: グレースケール, 2: RGB, 3: パレット, 4: グレースケール+アルファ, 6: RGBA
+  uint8_t interlace;  //< 0: なし, 1: Adam7 (非対応)
+} PngInfo_t;
+
+typedef struct tagPngStream_t {
+  // 作業領域
+  uint8_t* work;
+  size_t workSize;
+  size_t workUsed;
+  // 設定
+  bool dither;
+  uint8_t background[3];  //< アルファと合成する背景色 (R, G, B)
+  // デコード中の状態
+  PngInfo_t info;
+  uint32_t channels;        //< 1ピクセルのサンプル数
+  uint32_t bpp;             //< フィルタの単位 (1ピクセルのバイト数. 1byte 未満の場合は 1)
+  size_t rowBytes;          //< 1行のバイト数 (フィルタ種別を除く)
+  uint8_t palette[256][4];  //< パレット (R, G, B, A)
+  uint32_t paletteSize;
+  bool hasKey;      //< tRNS の透過色あり (グレースケール / RGB)
+  uint16_t key[3];  //< 透過色 (グレースケールは [0] のみ)
+} PngStream_t;
+
+/**
+ * PngStream_ReadMemory() の入力
+ */
+typedef struct tagPngStreamMemory_t {
+  const uint8_t* data;
+  size_t size;
+  size_t pos;  //< 読み出し位置 (0 で初期化する)
+} PngStreamMemory_t;
+
+/**
+ * PngStream_RowToCanvas() の出力先
+ */
+typedef struct tagPngStreamCanvas_t {
+  const Canvas_t* canvas;  //< RGB565 のキャンバス
+  int32_t x;               //< 画像の左上の位置 (キャンバスの座標. 負の値は画像の途中から描画する)
+  int32_t y;
+} PngStreamCanvas_t;
+
+/**
+ * PngStream_RowToLCD() の出力先
+ */
+typedef struct tagPngStreamLCD_t {
+  LCDDrvHandle_t lcd;
+  uint16_t x;  //< 画像の左上の位置 (LCD の座標)
+  uint16_t y;
+} PngStreamLCD_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief デコーダを初期化します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] work : 作業領域 (PNGSTREAM_WORK_SIZE(画像の幅) byte 以上. 8byte 境界を推奨)
+ * @param [in] size : 作業領域の大きさ (単位: byte)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t PngStream_Create(PngStream_t* ctx, void* work, size_t size);
+
+/**
+ * @brief アルファと合成する背景色を設定します (初期値: 黒).
+ * @param [inout] ctx : 操作対象
+ * @param [in] r : 赤
+ * @param [in] g : 緑
+ * @param [in] b : 青
+ * @return 処理結果
+ */
+UError_t PngStream_SetBackground(PngStream_t* ctx, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * @brief RGB565 へ変換する際の組織的ディザの有無を設定します (初期値: 無効).
+ * @param [inout] ctx : 操作対象
+ * @param [in] enable : true: 有効
+ * @return 処理結果
+ */
+UError_t PngStream_SetDither(PngStream_t* ctx, bool enable);
+
+/**
+ * @brief PNG を先頭から終端 (IEND) までデコードし, 1行ずつ row へ出力します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] read : 入力の読み出し関数
+ * @param [in] readArg : read へ渡す引数
+ * @param [in] row : 行の出力関数
+ * @param [in] rowArg : row へ渡す引数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (不正な形式, 非対応の形式, 作業領域の不足, 入力の途中終了, 出力関数の失敗)
+ */
+UError_t PngStream_Decode(PngStream_t* ctx, PngStreamReadFn_t read, void* readArg, PngStreamRowFn_t row, void* rowArg);
+
+/**
+ * @brief デコード中 / デコード後の画像の情報を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [out] info : 情報の格納先
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (IHDR を読み出していない)
+ */
+UError_t PngStream_GetInfo(const PngStream_t* ctx, PngInfo_t* info);
+
+/**
+ * @brief メモリ上のデータを読み出します (PngStreamReadFn_t. arg は PngStreamMemory_t).
+ */
+UError_t PngStream_ReadMemory(void* arg, void* buf, size_t size, size_t* read);
+
+/**
+ * @brief 行をキャンバスへ書き込みます (PngStreamRowFn_t. arg は PngStreamCanvas_t).
+ *
+ * キャンバスの外の部分は書き込みません. 帯状のキャンバス (同じ画像を位置をずらして複数回デコードする) にも使用できます.
+ */
+UError_t PngStream_RowToCanvas(void* arg, uint32_t y, const uint16_t* row, uint32_t w);
+
+/**
+ * @brief 行を LCD のウィンドウへ転送します (PngStreamRowFn_t. arg は PngStreamLCD_t).
+ *
+ * LCDDrv_SwapBuff() で 1行ずつ転送し, 転送の完了を待たずに戻ります.
+ * デコード後, 転送元を解放する前に LCDDrv_WaitForTransfer() で完了を待ってください.
+ */
+UError_t PngStream_RowToLCD(void* arg, uint32_t y, const uint16_t* row, uint32_t w);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(USER_PNGSTREAM_H__)
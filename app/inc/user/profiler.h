@@ -0,0 +1,198 @@
+/**
+ * @file prog01/app/inc/user/profiler.h
+ * フレーム単位の処理時間の計測と HUD 表示
+ *
+ * 1フレームを段階 (クリア, 描画, 文字, DMA 完了待ち, ウィンドウ設定, DMA 転送) に分けて時間を計測し,
+ * 直近 PROFILER_WINDOW フレームの 最小/平均/最大/99パーセンタイル を求めます.
+ * 送信バイト数とボーレートから SPI の使用率を求め, CPU 側と転送側のどちらが律速しているかを判定します.
+ * Profiler_DrawHUD() は計測結果を棒グラフと 1行の文字列でキャンバスへ重ねて描画します.
+ *
+ * 時刻は get_absolute_time() (単位: us) で取得します. 1コアからのみ呼び出してください.
+ **/
+
+#if !defined(USER_PROFILER_H__)
+#define USER_PROFILER_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/stdlib.h>
+
+#include <user/canvas.h>
+#include <user/lcddrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define PROFILER_WINDOW (128)  //< 統計に使用するフレーム数
+
+#define PROFILER_HUD_W (120)  //< HUD の幅 (単位: pixel)
+#define PROFILER_HUD_H (48)   //< HUD の高さ (単位: pixel)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 計測する段階
+ */
+typedef enum tagProfilerStage_t {
+  ProfilerClear = 0,  //< 画面のクリア
+  ProfilerRender,     //< 図形の描画
+  ProfilerText,       //< 文字の描画
+  ProfilerWaitDMA,    //< 前の転送の完了待ち (CPU の停止)
+  ProfilerSetWindow,  //< 転送先ウィンドウの設定 (コマンド送信)
+  ProfilerDMA,        //< DMA の転送時間 (CPU の処理と並行)
+  ProfilerFrame,      //< フレーム全体 (Profiler_EndFrame() の間隔)
+  ProfilerStageNum,   //< 段階の数
+  ProfilerNone = -1,  //< Profiler_Switch() で計測中の段階を終了する
+} ProfilerStage_t;
+
+/**
+ * 統計値 (単位: us)
+ */
+typedef struct tagProfilerStat_t {
+  uint32_t min;
+  uint32_t avg;
+  uint32_t max;
+  uint32_t p99;
+} ProfilerStat_t;
+
+/**
+ * SPI の使用状況
+ */
+typedef struct tagProfilerSpiStat_t {
+  uint32_t bytesPerSec;  //< 実際の転送量 (単位: byte/s)
+  uint32_t utilization;  //< 転送量 / ボーレート (単位: 0.1%)
+  uint32_t dmaBusy;      //< DMA の転送時間 / フレーム時間 (単位: 0.1%)
+  bool wireBound;        //< true: 転送側が律速 (DMA の転送時間が CPU の処理時間を上回る)
+} ProfilerSpiStat_t;
+
+typedef struct tagProfiler_t {
+  uint32_t baudrate;  //< SPI のボーレート (使用率の基準)
+  // 直近のフレーム (リングバッファ)
+  uint32_t samples[ProfilerStageNum][PROFILER_WINDOW];  //< 段階ごとの時間 (単位: us)
+  uint32_t bytes[PROFILER_WINDOW];                      //< 送信バイト数
+  uint32_t head;                                        //< 次に格納する位置
+  uint32_t count;                                       //< 格納済みのフレーム数 (最大 PROFILER_WINDOW)
+  // 計測中のフレーム
+  uint32_t cur[ProfilerStageNum];  //< 段階ごとの合計時間 (単位: us)
+  uint32_t curBytes;               //< 送信バイト数
+  ProfilerStage_t running;         //< Profiler_Switch() で計測中の段階
+  absolute_time_t begin[ProfilerStageNum];
+  absolute_time_t frameBegin;
+} Profiler_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 計測を初期化し, 最初のフレームの計測を開始します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] baudrate : SPI のボーレート (SPIDrvContext_t.baudrate)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Profiler_Create(Profiler_t* ctx, uint32_t baudrate);
+
+/**
+ * @brief 段階の計測を開始します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] stage : 段階
+ * @return 処理結果
+ */
+UError_t Profiler_Begin(Profiler_t* ctx, ProfilerStage_t stage);
+
+/**
+ * @brief 段階の計測を終了し, 開始からの時間を加算します. 1フレームに複数回計測できます.
+ * @param [inout] ctx : 操作対象
+ * @param [in] stage : 段階
+ * @return 処理結果
+ */
+UError_t Profiler_End(Profiler_t* ctx, ProfilerStage_t stage);
+
+/**
+ * @brief 計測中の段階を終了し, 次の段階を開始します. 描画命令の間に挟んで連続した段階を計測します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] stage : 次の段階 (ProfilerNone: 終了のみ)
+ * @return 処理結果
+ */
+UError_t Profiler_Switch(Profiler_t* ctx, ProfilerStage_t stage);
+
+/**
+ * @brief 別の方法で計測した時間を加算します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] stage : 段階
+ * @param [in] us : 時間 (単位: us)
+ * @return 処理結果
+ */
+UError_t Profiler_Add(Profiler_t* ctx, ProfilerStage_t stage, uint32_t us);
+
+/**
+ * @brief LCDDrv_GetTiming() の計測値 (完了待ち, ウィンドウ設定, DMA 転送, 送信バイト数) を加算します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] timing : LCDDrv の計測値
+ * @return 処理結果
+ */
+UError_t Profiler_AddLCDTiming(Profiler_t* ctx, const LCDDrvTiming_t* timing);
+
+/**
+ * @brief フレームの計測を終了して統計に加え, 次のフレームの計測を開始します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t Profiler_EndFrame(Profiler_t* ctx);
+
+/**
+ * @brief 直近のフレームの統計値を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [in] stage : 段階
+ * @param [out] stat : 統計値 (フレームがない場合は 0)
+ * @return 処理結果
+ */
+UError_t Profiler_GetStat(const Profiler_t* ctx, ProfilerStage_t stage, ProfilerStat_t* stat);
+
+/**
+ * @brief 直近のフレームの SPI の使用状況を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [out] stat : 使用状況
+ * @return 処理結果
+ */
+UError_t Profiler_GetSpiStat(const Profiler_t* ctx, ProfilerSpiStat_t* stat);
+
+/**
+ * @brief 計測結果を (x, y) を左上とする PROFILER_HUD_W x PROFILER_HUD_H の領域へ描画します.
+ *
+ * 1行目はフレーム時間の平均, SPI 使用率, 律速している側 (C: CPU, W: 転送) を文字で表示します.
+ * 続いて段階ごとの平均時間の棒 (最大フレーム時間を全幅とし, 99パーセンタイルの位置に目盛り),
+ * 最後に SPI 使用率の棒を描画します. 文字は Font_Print() の既定のフォントを使用します.
+ * @param [in] ctx : 操作対象
+ * @param [in] canvas : 描画先
+ * @param [in] x : x座標
+ * @param [in] y : y座標
+ * @return 処理結果
+ */
+UError_t Profiler_DrawHUD(const Profiler_t* ctx, const Canvas_t* canvas, size_t x, size_t y);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_PROFILER_H__)
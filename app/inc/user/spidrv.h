@@ -1,6 +1,11 @@
 /**
  * @file prog01/app/inc/user/spidrv.h
  * Raspberry PI PICO C-SDK 用 SPI ラッパドライバ
+ *
+ * 送信 (同期/非同期), 完了待ち, D/C 信号の操作はトランスポート (SPIDrvTransport_t) を経由します.
+ * 初期値は SPI ハードウェアと DMA を使用する SPIDrv_HardwareTransport です.
+ * SPIDrv_SetTransport() で差し替えることで, 送信内容の記録 (spitrace.h) 等を挟むことができます.
+ * 受信を伴う関数 (Recv, Transfer) はトランスポートを経由せず, 常にハードウェアを使用します.
  **/
 
 #if !defined(USER_SPIDRV_H__)
@@ -10,6 +15,8 @@
 // includes
 //////////////////////////////////////////////////////////////////////////////
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <hardware/spi.h>
@@ -20,6 +27,8 @@
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+#define SPIDRV_PIN_NONE (0xffffffffu)  //< 未接続の信号線
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
@@ -27,9 +36,27 @@
 typedef struct tagSPIDrvAsyncContext_t {
   uint32_t tx;
   uint32_t rx;
-  absolute_time_t begin;
+  absolute_time_t begin;  //< 送信の開始時刻
+  absolute_time_t end;    //< 完了を確認した時刻
+  size_t size;            //< 送信サイズ (単位: byte)
+  bool busyOnWait;        //< 完了待ちの開始時に転送中だった (end - begin が転送時間と一致する)
 } SPIDrvAsyncContext_t;
 
+struct tagSPIDrvContext_t;
+
+/**
+ * SPI の送信処理 (トランスポート)
+ *
+ * send は CS のアサートから解除までを 1回で行います.
+ * asyncSend は CS をアサートして送信を開始した時点で戻り, wait で完了を待って CS を解除します.
+ */
+typedef struct tagSPIDrvTransport_t {
+  UError_t (*send)(struct tagSPIDrvContext_t* ctx, const void* data, size_t size);       //< 同期送信
+  UError_t (*asyncSend)(struct tagSPIDrvContext_t* ctx, const void* data, size_t size);  //< 非同期送信の開始
+  UError_t (*wait)(struct tagSPIDrvContext_t* ctx);                                      //< 非同期送信の完了待ち
+  void (*setDC)(struct tagSPIDrvContext_t* ctx, bool level);                             //< D/C 信号の設定
+} SPIDrvTransport_t;
+
 typedef struct tagSPIDrvContext_t {
   spi_inst_t* hw;     //< PICO SPIハードウェア
   uint32_t baudrate;  //< ボーレート
@@ -38,8 +65,12 @@ typedef struct tagSPIDrvContext_t {
   uint32_t rx;
   uint32_t tx;
   uint32_t csn;
+  uint32_t dc;  //< D/C (SPIDRV_PIN_NONE: 未使用)
   //
   SPIDrvAsyncContext_t async;
+  //
+  const SPIDrvTransport_t* transport;  //< 送信処理
+  void* transportArg;                  //< トランスポート固有の情報
 } SPIDrvContext_t;
 
 typedef void* SPIDrvHandle_t;
@@ -133,6 +164,51 @@ UError_t SPIDrv_AsyncTransfer(SPIDrvHandle_t handle, const void* tx, void* rx, s
  */
 UError_t SPIDrv_WaitForAsync(SPIDrvHandle_t handle);
 
+/**
+ * @brief 最後に完了した非同期送信の転送時間と送信サイズを取得する
+ *
+ * 完了待ちの開始時に転送が終わっていた場合は完了時刻が分からないため,
+ * ボーレートから求めた転送時間を上限とする.
+ * @param [in] handle : 操作対象
+ * @param [out] us : 転送時間 (単位: us)
+ * @param [out] size : 送信サイズ (単位: byte. NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理完了
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t SPIDrv_GetAsyncTime(SPIDrvHandle_t handle, uint32_t* us, size_t* size);
+
+/**
+ * @brief 送信処理を差し替える
+ * @param [inout] handle : 操作対象
+ * @param [in] transport : 送信処理 (NULL: SPIDrv_HardwareTransport)
+ * @param [in] arg : トランスポート固有の情報 (transportArg に設定)
+ * @return 処理結果
+ * @retval uSuccess : 処理完了
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t SPIDrv_SetTransport(SPIDrvHandle_t handle, const SPIDrvTransport_t* transport, void* arg);
+
+/**
+ * @brief D/C 信号の GPIO 番号を設定する. GPIO の初期化は呼び出し側で行う.
+ * @param [inout] handle : 操作対象
+ * @param [in] dc : GPIO 番号 (SPIDRV_PIN_NONE: 未使用)
+ * @return 処理結果
+ * @retval uSuccess : 処理完了
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t SPIDrv_SetDCPin(SPIDrvHandle_t handle, uint32_t dc);
+
+/**
+ * @brief D/C 信号を設定する
+ * @param [in] handle : 操作対象
+ * @param [in] level : 出力値 (false: コマンド, true: データ)
+ * @return 処理結果
+ * @retval uSuccess : 処理完了
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t SPIDrv_SetDC(SPIDrvHandle_t handle, bool level);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -141,4 +217,9 @@ UError_t SPIDrv_WaitForAsync(SPIDrvHandle_t handle);
 // variable
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * SPI ハードウェアと DMA による送信処理 (SPIDrv_Create() 時の初期値)
+ */
+extern const SPIDrvTransport_t SPIDrv_HardwareTransport;
+
 #endif  // !defined(USER_SPIDRV_H__)
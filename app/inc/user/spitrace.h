@@ -0,0 +1,171 @@
+/**
+ * @file prog01/app/inc/user/spitrace.h
+ * SPIDrv の送信内容の記録
+ *
+ * SPIDrv のトランスポートを差し替え, 送信データ, D/C 信号, CS の区切り, 時刻を
+ * バイナリ形式で記録します. 記録後は元のトランスポートへ処理を渡すため, LCD の表示はそのまま動作します.
+ * 書き出し先は関数で指定します (ファイル, RAM バッファ, USB 等).
+ *
+ * 形式
+ *   先頭に SPITRACE_MAGIC (8 byte), 続いてレコードを並べます.
+ *   レコード = 種別 (1 byte) + 前のレコードからの経過時間 (単位: us, LEB128) + 種別ごとのデータ
+ *     SPITraceDC        : レベル (1 byte). 変化したときだけ記録します.
+ *     SPITraceSend      : サイズ (LEB128) + データ. CS のアサートから解除まで (1トランザクション).
+ *     SPITraceAsyncSend : サイズ (LEB128) + データ. CS をアサートして送信を開始.
+ *     SPITraceWait      : なし. 非同期送信の完了 (CS の解除).
+ *     SPITraceMark      : 番号 (LEB128). フレームの区切り等, 呼び出し側が任意に挿入します.
+ *   数値は LEB128 (下位から 7bit ずつ, 最上位 bit が継続フラグ) で格納します.
+ *
+ * 区切りの番号は SPITRACE_MARK() で作成し, 上位 16bit をグループ (計測の種類等), 下位 16bit をフレーム番号とします.
+ * フレーム番号 SPITRACE_FRAME_SETUP はフレームに含めない準備の送信を表します.
+ **/
+
+#if !defined(USER_SPITRACE_H__)
+#define USER_SPITRACE_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/stdlib.h>
+
+#include <user/spidrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SPITRACE_MAGIC "SPITRC01"  //< ファイル先頭の識別子
+#define SPITRACE_MAGIC_SIZE (8)    //< SPITRACE_MAGIC のバイト数
+
+#define SPITRACE_FRAME_SETUP (0xffffu)                                                   //< 準備 (フレームに含めない)
+#define SPITRACE_MARK(group, frame) ((((uint32_t)(group)) << 16) | ((frame) & 0xffffu))  //< 区切りの番号
+#define SPITRACE_MARK_GROUP(id) ((uint32_t)(id) >> 16)                                   //< 区切りの番号からグループを取り出す
+#define SPITRACE_MARK_FRAME(id) ((uint32_t)(id) & 0xffffu)                               //< 区切りの番号からフレーム番号を取り出す
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef enum tagSPITraceEvent_t {
+  SPITraceDC = 1,     //< D/C 信号の変化
+  SPITraceSend,       //< 同期送信
+  SPITraceAsyncSend,  //< 非同期送信の開始
+  SPITraceWait,       //< 非同期送信の完了
+  SPITraceMark,       //< 区切り
+} SPITraceEvent_t;
+
+/**
+ * 読み出したレコード
+ */
+typedef struct tagSPITraceRecord_t {
+  SPITraceEvent_t type;
+  uint64_t time;        //< 記録開始からの時刻 (単位: us)
+  uint32_t value;       //< SPITraceDC: レベル, SPITraceMark: 番号
+  const uint8_t* data;  //< SPITraceSend, SPITraceAsyncSend: 送信データ
+  size_t size;          //< SPITraceSend, SPITraceAsyncSend: 送信サイズ (単位: byte)
+} SPITraceRecord_t;
+
+/**
+ * @brief 記録の書き出し先
+ * @param [in] arg : SPITrace_Create() で指定した引数
+ * @param [in] data : 書き出すデータ
+ * @param [in] size : データ長 (単位: byte)
+ * @return 処理結果 (uSuccess 以外を返すと, 以降の記録を停止します)
+ */
+typedef UError_t (*SPITraceWriteFn_t)(void* arg, const void* data, size_t size);
+
+/**
+ * @brief SPITrace_Decode() が各レコードに対して呼び出す関数
+ * @param [in] arg : SPITrace_Decode() で指定した引数
+ * @param [in] rec : レコード (data は入力データを指します)
+ * @return 処理結果 (uSuccess 以外を返すと, 読み出しを中断します)
+ */
+typedef UError_t (*SPITraceVisitFn_t)(void* arg, const SPITraceRecord_t* rec);
+
+typedef struct tagSPITrace_t {
+  SPITraceWriteFn_t write;  //< 書き出し先
+  void* arg;                //< write へ渡す引数
+  UError_t err;             //< 書き出しの結果 (uSuccess 以外: 記録を停止)
+  // 記録
+  absolute_time_t last;  //< 前のレコードの時刻
+  int32_t dc;            //< 記録済みの D/C レベル (-1: 未記録)
+  uint64_t records;      //< 記録したレコード数
+  // 記録後に処理を渡すトランスポート
+  SPIDrvContext_t* spi;                //< 接続先 (NULL: 未接続)
+  const SPIDrvTransport_t* transport;  //< 元のトランスポート
+  void* transportArg;                  //< 元のトランスポート固有の情報
+} SPITrace_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 記録を初期化し, 先頭の識別子を書き出します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] write : 書き出し先
+ * @param [in] arg : write へ渡す引数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t SPITrace_Create(SPITrace_t* ctx, SPITraceWriteFn_t write, void* arg);
+
+/**
+ * @brief SPIDrv のトランスポートを差し替えて記録を開始します.
+ *
+ * 記録したあと, 差し替え前のトランスポートへ処理を渡します.
+ * @param [inout] ctx : 操作対象
+ * @param [inout] spi : 記録する SPIDrv
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (既に接続済み)
+ */
+UError_t SPITrace_Attach(SPITrace_t* ctx, SPIDrvHandle_t spi);
+
+/**
+ * @brief SPIDrv のトランスポートを元に戻し, 記録を終了します. 非同期送信の完了後に呼び出してください.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t SPITrace_Detach(SPITrace_t* ctx);
+
+/**
+ * @brief 区切りを記録します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] id : 番号 (フレーム番号等)
+ * @return 処理結果
+ */
+UError_t SPITrace_Mark(SPITrace_t* ctx, uint32_t id);
+
+/**
+ * @brief 記録を先頭から読み出し, レコードごとに fn を呼び出します.
+ * @param [in] data : 記録 (先頭の識別子を含む)
+ * @param [in] size : データ長 (単位: byte)
+ * @param [in] fn : 各レコードに対して呼び出す関数
+ * @param [in] arg : fn へ渡す引数
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (識別子の不一致, 途中で途切れている, fn が失敗を返した)
+ */
+UError_t SPITrace_Decode(const void* data, size_t size, SPITraceVisitFn_t fn, void* arg);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_SPITRACE_H__)
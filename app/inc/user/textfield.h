@@ -0,0 +1,155 @@
+/**
+ * @file prog01/app/inc/user/textfield.h
+ * 差分描画を行うテキストフィールド
+ *
+ * 前回描画した文字をキャラクタセル単位で保持し, 更新時は内容が変化したセルのみを
+ * 背景色で塗りつぶしてから再描画します. 再描画した領域は dirty 矩形として報告します.
+ * キャラクタセルの大きさは半角フォントの幅と高さです. 全角文字は 2セルを占有します.
+ **/
+
+#if !defined(USER_TEXTFIELD_H__)
+#define USER_TEXTFIELD_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/font.h>
+#include <user/glyphcache.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 全角文字の 2セル目を表す文字コード
+ */
+#define TEXTFIELD_CODE_CONT (0xffffu)
+
+/**
+ * 描画内容が不明なセルを表す文字コード (TextField_Invalidate() 直後)
+ */
+#define TEXTFIELD_CODE_UNKNOWN (0xfffeu)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagTextFieldCell_t {
+  const void* graph;  //< 描画済みグリフ (NULL: 空白)
+  uint16_t code;      //< 描画済み文字コード
+  uint16_t gen;       //< 最後に参照された更新世代
+} TextFieldCell_t;
+
+typedef struct tagTextField_t {
+  const Canvas_t* canvas;  //< 描画先
+  uint32_t x;              //< 左上 x座標 (単位: pixel)
+  uint32_t y;              //< 左上 y座標 (単位: pixel)
+  uint32_t cols;           //< 桁数 (単位: 半角キャラクタ)
+  uint32_t rows;           //< 行数
+  uint32_t cw;             //< セル幅 (単位: pixel)
+  uint32_t ch;             //< セル高 (単位: pixel)
+  TextFieldCell_t* cells;  //< cols * rows 個のセル
+  FontId_t ank;            //< 半角フォント
+  FontId_t kanji;          //< 全角フォント
+  uint16_t fg;             //< 前景色
+  uint16_t bg;             //< 背景色
+  uint16_t gen;            //< 更新世代
+  GlyphCache_t* cache;     //< グリフキャッシュ (NULL: 使用しない)
+  // TextField_Update() 実行中のみ有効
+  CanvasRect_t* dirty;
+  size_t maxDirty;
+  size_t nDirty;
+} TextField_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief テキストフィールドを初期化します.
+ *
+ * フォントは FONT_ID_ANK (全角なし), 色は 白/黒 で初期化します.
+ * 初回の TextField_Update() では全セルを描画します.
+ * @param [out] ctx : 初期化対象
+ * @param [in] canvas : 描画先
+ * @param [in] x : 左上 x座標 (単位: pixel)
+ * @param [in] y : 左上 y座標 (単位: pixel)
+ * @param [in] cols : 桁数 (単位: 半角キャラクタ)
+ * @param [in] rows : 行数
+ * @param [in] cells : セル管理領域 (cols * rows 個)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t TextField_Create(TextField_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t cols, uint32_t rows, TextFieldCell_t* cells);
+
+/**
+ * @brief 描画に使用するフォントを指定します. 次回の更新で全セルを再描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] ank : 半角フォント
+ * @param [in] kanji : 全角フォント (FONT_ID_NONE 可)
+ * @return 処理結果
+ */
+UError_t TextField_SetFont(TextField_t* ctx, FontId_t ank, FontId_t kanji);
+
+/**
+ * @brief 描画色を指定します. 次回の更新で全セルを再描画します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] fg : 前景色 (RGB565)
+ * @param [in] bg : 背景色 (RGB565)
+ * @return 処理結果
+ */
+UError_t TextField_SetColor(TextField_t* ctx, uint16_t fg, uint16_t bg);
+
+/**
+ * @brief グリフの展開に使用するキャッシュを指定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] cache : グリフキャッシュ (NULL: 使用しない)
+ * @return 処理結果
+ */
+UError_t TextField_SetGlyphCache(TextField_t* ctx, GlyphCache_t* cache);
+
+/**
+ * @brief 描画済みの内容を破棄し, 次回の更新で全セルを再描画させます.
+ *
+ * キャンバスをクリアした場合などに呼び出します.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t TextField_Invalidate(TextField_t* ctx);
+
+/**
+ * @brief 文字列を描画します. 前回から変化したセルのみ再描画します.
+ *
+ * dirty には再描画した領域を行ごとに連結して格納します.
+ * maxDirty を超える場合, 最後の矩形を拡張して全体を包含します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] sz : 文字列 (UTF-8). フィールド外にはみ出す文字は描画しません.
+ * @param [out] dirty : 再描画した領域の格納先 (NULL 可)
+ * @param [in] maxDirty : dirty の要素数
+ * @param [out] nDirty : 格納した領域の数 (NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t TextField_Update(TextField_t* ctx, const char* sz, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_TEXTFIELD_H__)
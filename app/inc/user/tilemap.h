@@ -0,0 +1,188 @@
+/**
+ * @file prog01/app/inc/user/tilemap.h
+ * 8x8 タイルによる背景描画
+ *
+ * タイル画像(アトラス)とタイル番号のマップから背景を生成します.
+ * マップは上下左右に周回し, 任意のピクセル単位のスクロール位置で描画できます.
+ * タイル画像は RGB565 または 4bpp (16色パレット) 形式です.
+ *
+ * マップの要素 (16bit)
+ *   bit  0 -  9 : タイル番号
+ *   bit 10      : 左右反転
+ *   bit 11      : 上下反転
+ *   bit 12 - 15 : パレット番号 (4bpp のみ)
+ **/
+
+#if !defined(USER_TILEMAP_H__)
+#define USER_TILEMAP_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define TILEMAP_TILE_SIZE (8)        //< タイルの幅/高さ (単位: pixel)
+#define TILEMAP_TILE_MASK (0x03ffu)  //< タイル番号
+#define TILEMAP_HFLIP (0x0400u)      //< 左右反転
+#define TILEMAP_VFLIP (0x0800u)      //< 上下反転
+#define TILEMAP_PALETTE_SHIFT (12)   //< パレット番号の位置
+#define TILEMAP_PALETTE_COLORS (16)  //< 1パレットあたりの色数
+
+/**
+ * マップの要素を作成します
+ * @param TILE : タイル番号
+ * @param PAL : パレット番号
+ * @param FLAGS : TILEMAP_HFLIP / TILEMAP_VFLIP の組み合わせ
+ */
+#define TILEMAP_ENTRY(TILE, PAL, FLAGS) (uint16_t)(((TILE) & TILEMAP_TILE_MASK) | (FLAGS) | (((PAL) & 0x0f) << TILEMAP_PALETTE_SHIFT))
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * タイル画像の形式
+ */
+typedef enum tagTilemapFormat_t {
+  TilemapRGB565 = 0,  //< 1タイル 64pixel x 2byte. RGB565 (Canvas と同じバイト順)
+  Tilemap4bpp,        //< 1タイル 32byte. 上位ニブルが左のピクセル
+} TilemapFormat_t;
+
+typedef struct tagTilemap_t {
+  const uint16_t* map;      //< マップ (mw * mh 個)
+  uint32_t mw;              //< マップの幅 (単位: タイル)
+  uint32_t mh;              //< マップの高さ (単位: タイル)
+  const void* tiles;        //< タイル画像
+  uint32_t ntiles;          //< タイル数
+  TilemapFormat_t fmt;      //< タイル画像の形式
+  const uint16_t* palette;  //< パレット (RGB565. 16色 x npalette)
+  uint32_t npalette;        //< パレット数
+  // 表示領域 (単位: pixel)
+  uint32_t vx;
+  uint32_t vy;
+  uint32_t vw;
+  uint32_t vh;
+  // スクロール位置 (表示領域左上のマップ上の座標)
+  uint32_t sx;
+  uint32_t sy;
+} Tilemap_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief タイルマップを初期化します.
+ *
+ * 表示領域は (0, 0) から マップ全体の大きさ, スクロール位置は (0, 0) で初期化します.
+ * マップはコピーせず参照します. マップを書き換えた場合は Tilemap_RenderRect() で
+ * 該当範囲を描画し直してください.
+ * @param [out] ctx : 初期化対象
+ * @param [in] map : マップ (mw * mh 個)
+ * @param [in] mw : マップの幅 (単位: タイル)
+ * @param [in] mh : マップの高さ (単位: タイル)
+ * @param [in] tiles : タイル画像
+ * @param [in] ntiles : タイル数 (範囲外のタイル番号は 0 番として描画)
+ * @param [in] fmt : タイル画像の形式
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t Tilemap_Create(Tilemap_t* ctx, const uint16_t* map, uint32_t mw, uint32_t mh, const void* tiles, uint32_t ntiles, TilemapFormat_t fmt);
+
+/**
+ * @brief 4bpp 形式で使用するパレットを指定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] palette : パレット (RGB565. 16色 x npalette)
+ * @param [in] npalette : パレット数 (範囲外のパレット番号は 0 番として描画)
+ * @return 処理結果
+ */
+UError_t Tilemap_SetPalette(Tilemap_t* ctx, const uint16_t* palette, uint32_t npalette);
+
+/**
+ * @brief 描画先の領域を指定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] x : 左上 x座標 (単位: pixel)
+ * @param [in] y : 左上 y座標 (単位: pixel)
+ * @param [in] w : 幅 (単位: pixel)
+ * @param [in] h : 高さ (単位: pixel)
+ * @return 処理結果
+ */
+UError_t Tilemap_SetViewport(Tilemap_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * @brief スクロール位置を指定します. 描画は行いません.
+ * @param [inout] ctx : 操作対象
+ * @param [in] sx : 表示領域左上のマップ上の x座標 (単位: pixel. マップの幅で周回)
+ * @param [in] sy : 表示領域左上のマップ上の y座標 (単位: pixel. マップの高さで周回)
+ * @return 処理結果
+ */
+UError_t Tilemap_SetScroll(Tilemap_t* ctx, uint32_t sx, uint32_t sy);
+
+/**
+ * @brief 表示領域全体をキャンバスへ描画します.
+ * @param [in] ctx : 操作対象
+ * @param [in] canvas : 描画先 (RGB565 形式. 表示領域を包含すること)
+ * @return 処理結果
+ */
+UError_t Tilemap_Render(const Tilemap_t* ctx, const Canvas_t* canvas);
+
+/**
+ * @brief 表示領域の一部をキャンバスへ描画します.
+ * @param [in] ctx : 操作対象
+ * @param [in] canvas : 描画先 (RGB565 形式. 表示領域を包含すること)
+ * @param [in] x : 表示領域内の x座標 (単位: pixel)
+ * @param [in] y : 表示領域内の y座標 (単位: pixel)
+ * @param [in] w : 幅 (単位: pixel. 表示領域外は描画しない)
+ * @param [in] h : 高さ (単位: pixel. 表示領域外は描画しない)
+ * @return 処理結果
+ */
+UError_t Tilemap_RenderRect(const Tilemap_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * @brief 表示領域の line 行目から n 行を, 幅 vw の連続したバッファへ描画します.
+ *
+ * フレームバッファを持たずに, 行単位で生成して LCD へ転送する場合に使用します.
+ * @param [in] ctx : 操作対象
+ * @param [in] line : 表示領域内の先頭行
+ * @param [in] n : 行数
+ * @param [out] out : 格納先 (vw * n 個)
+ * @return 処理結果
+ */
+UError_t Tilemap_RenderLines(const Tilemap_t* ctx, uint32_t line, uint32_t n, uint16_t* out);
+
+/**
+ * @brief スクロール位置を (dx, dy) だけ進め, キャンバスを更新します.
+ *
+ * 描画済みの画像を Canvas_Scroll() で移動し, 新たに現れた端の行/列のみを描画します.
+ * 表示内容は (-dx, -dy) 方向へ移動します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] canvas : 描画先 (前回描画した内容を保持していること)
+ * @param [in] dx : x方向のスクロール量 (単位: pixel)
+ * @param [in] dy : y方向のスクロール量 (単位: pixel)
+ * @return 処理結果
+ */
+UError_t Tilemap_Scroll(Tilemap_t* ctx, const Canvas_t* canvas, int32_t dx, int32_t dy);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(USER_TILEMAP_H__)
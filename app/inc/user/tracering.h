@@ -0,0 +1,204 @@
+/**
+ * @file prog01/app/inc/user/tracering.h
+ * 固定長のイベント記録 (トレースリング)
+ *
+ * 時刻, イベント番号, 引数 2つの 16byte のイベントをリングバッファへ記録します.
+ * 書き込み位置は C11 atomics の fetch_add で確保するため, 両コアと割り込み処理から同時に記録できます.
+ * 書き込みはロックを使わず, 読み出しが追いつかない場合は古いイベントから上書きします (上書き数は lost に数えます).
+ *
+ * 読み出しは 1か所 (1コア) から TraceRing_Drain() で行い, 以下のチャンク形式で書き出します (リトルエンディアン).
+ *   TraceRingChunk_t (magic "TRCR", version, count, lost) + TraceEvent_t * count
+ * 途中にテキスト (printf の出力等) が混在しても, 読み出し側は magic を探して再同期できます.
+ * ホストの host/tools/trace2chrome で Chrome のトレース形式 (JSON) へ変換できます.
+ *
+ * TRACERING_ENABLE が 0 (既定) の場合, TRACE_*() マクロは何もしません. 有効にするとリング (TraceRing_Default) の
+ * 約 20KB の RAM を使用し, SPIDrv / LCDDrv の呼び出しごとにイベントを記録します (トレース用のビルドのみで有効にする).
+ **/
+
+#if !defined(USER_TRACERING_H__)
+#define USER_TRACERING_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/stdlib.h>
+
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#if !defined(TRACERING_ENABLE)
+#define TRACERING_ENABLE (0)  //< 1: TRACE_*() マクロで TraceRing_Default へ記録する (計測用)
+#endif
+
+#define TRACERING_CAPACITY (1024)  //< 記録できるイベント数 (2のべき乗)
+#define TRACERING_CHUNK (32)       //< TraceRing_Drain() が 1チャンクに書き出す最大イベント数
+
+#define TRACERING_MAGIC "TRCR"  //< チャンクの先頭
+#define TRACERING_VERSION (1)
+
+#define TRACE_TRACK_DMA (0x80u)  //< DMA の転送を表すトラック (コア番号の代わりに指定)
+
+#if TRACERING_ENABLE
+#define TRACE_BEGIN(id, a0, a1) TraceRing_Put(&TraceRing_Default, (uint8_t)get_core_num(), TracePhaseBegin, (id), (a0), (a1))
+#define TRACE_END(id, a0, a1) TraceRing_Put(&TraceRing_Default, (uint8_t)get_core_num(), TracePhaseEnd, (id), (a0), (a1))
+#define TRACE_INSTANT(id, a0, a1) TraceRing_Put(&TraceRing_Default, (uint8_t)get_core_num(), TracePhaseInstant, (id), (a0), (a1))
+#define TRACE_COUNTER(id, value) TraceRing_Put(&TraceRing_Default, (uint8_t)get_core_num(), TracePhaseCounter, (id), (value), 0)
+#define TRACE_BEGIN_ON(track, id, a0, a1) TraceRing_Put(&TraceRing_Default, (track), TracePhaseBegin, (id), (a0), (a1))
+#define TRACE_END_ON(track, id, a0, a1) TraceRing_Put(&TraceRing_Default, (track), TracePhaseEnd, (id), (a0), (a1))
+#else
+#define TRACE_BEGIN(id, a0, a1) ((void)0)
+#define TRACE_END(id, a0, a1) ((void)0)
+#define TRACE_INSTANT(id, a0, a1) ((void)0)
+#define TRACE_COUNTER(id, value) ((void)0)
+#define TRACE_BEGIN_ON(track, id, a0, a1) ((void)0)
+#define TRACE_END_ON(track, id, a0, a1) ((void)0)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * イベントの種類 (Chrome のトレース形式の ph に対応)
+ */
+typedef enum tagTracePhase_t {
+  TracePhaseBegin = 0,  //< 区間の開始 (B)
+  TracePhaseEnd,        //< 区間の終了 (E)
+  TracePhaseInstant,    //< 瞬間 (i)
+  TracePhaseCounter,    //< 値の変化 (C). arg0 が値
+} TracePhase_t;
+
+/**
+ * イベント番号. 名前は host/tools/trace2chrome.c の表と合わせる
+ */
+typedef enum tagTraceId_t {
+  TraceIdFrame = 1,   //< 1フレームの処理 (main)
+  TraceIdRender,      //< 描画命令の再生 (BandRender_Execute)
+  TraceIdBand,        //< 帯の描画 (arg0: 先頭行, arg1: 行数)
+  TraceIdLcdSwap,     //< LCDDrv_SwapBuff / LCDDrv_SwapCanvas (arg0: 幅, arg1: 高さ)
+  TraceIdLcdWait,     //< 非同期転送の完了待ち
+  TraceIdSetWindow,   //< LCDDrv_SetWindow
+  TraceIdDMA,         //< 非同期転送 (arg0: サイズ). 終了は完了待ちで確認した時刻
+  TraceIdUser = 256,  //< 以降はアプリケーションで自由に使用する
+} TraceId_t;
+
+/**
+ * イベント (16byte)
+ */
+typedef struct tagTraceEvent_t {
+  uint32_t time;  //< 時刻 (time_us_32(). 単位: us)
+  uint16_t id;    //< イベント番号 (TraceId_t)
+  uint8_t track;  //< コア番号 または TRACE_TRACK_DMA
+  uint8_t phase;  //< TracePhase_t
+  uint32_t arg0;
+  uint32_t arg1;
+} TraceEvent_t;
+
+/**
+ * TraceRing_Drain() が書き出すチャンクの先頭 (12byte)
+ */
+typedef struct tagTraceRingChunk_t {
+  char magic[4];     //< TRACERING_MAGIC
+  uint16_t version;  //< TRACERING_VERSION
+  uint16_t count;    //< 続くイベント数
+  uint32_t lost;     //< 前のチャンクから失ったイベント数 (上書き)
+} TraceRingChunk_t;
+
+typedef struct tagTraceRing_t {
+  _Atomic uint32_t head;                        //< 次に確保する通し番号 (書き込み側が更新)
+  uint32_t tail;                                //< 次に読み出す通し番号 (読み出し側が更新)
+  _Atomic uint32_t commit[TRACERING_CAPACITY];  //< 各要素に書き込み済みの通し番号 + 1 (0: 書き込み中)
+  TraceEvent_t events[TRACERING_CAPACITY];
+} TraceRing_t;
+
+/**
+ * @brief TraceRing_Drain() の書き出し先
+ * @param [in] arg : TraceRing_Drain() で指定した引数
+ * @param [in] data : 書き出すデータ
+ * @param [in] size : データ長 (単位: byte)
+ * @return 処理結果
+ */
+typedef UError_t (*TraceRingWriteFn_t)(void* arg, const void* data, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief リングを空の状態に初期化します. 記録の開始前に呼び出してください.
+ * @param [out] ctx : 初期化対象
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t TraceRing_Init(TraceRing_t* ctx);
+
+/**
+ * @brief 記録済みのイベントを読み出し, チャンク形式で書き出します. 読み出しは 1か所からのみ行えます.
+ *
+ * 書き込み中の要素に達した場合はそこで終了します (次回の呼び出しで読み出します).
+ * @param [inout] ctx : 操作対象
+ * @param [in] write : 書き出し先
+ * @param [in] arg : write へ渡す引数
+ * @param [out] count : 書き出したイベント数 (NULL 可)
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (書き出し失敗)
+ */
+UError_t TraceRing_Drain(TraceRing_t* ctx, TraceRingWriteFn_t write, void* arg, size_t* count);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+/**
+ * @brief イベントを記録します. 両コアと割り込み処理から呼び出せます.
+ *
+ * 通し番号を fetch_add で確保し, 要素を書き込み中 (0) にしてから内容を書き込み, 最後に通し番号を公開します.
+ * @param [inout] ctx : 記録先
+ * @param [in] track : コア番号 または TRACE_TRACK_DMA
+ * @param [in] phase : 種類
+ * @param [in] id : イベント番号
+ * @param [in] a0 : 引数
+ * @param [in] a1 : 引数
+ */
+static inline void TraceRing_Put(TraceRing_t* ctx, uint8_t track, TracePhase_t phase, uint16_t id, uint32_t a0, uint32_t a1) {
+  const uint32_t seq = atomic_fetch_add_explicit(&ctx->head, 1u, memory_order_relaxed);
+  const uint32_t slot = seq & (TRACERING_CAPACITY - 1u);
+  TraceEvent_t* const ev = &ctx->events[slot];
+
+  atomic_store_explicit(&ctx->commit[slot], 0u, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  ev->time = time_us_32();
+  ev->id = id;
+  ev->track = track;
+  ev->phase = (uint8_t)phase;
+  ev->arg0 = a0;
+  ev->arg1 = a1;
+  atomic_store_explicit(&ctx->commit[slot], seq + 1u, memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#if TRACERING_ENABLE
+/**
+ * TRACE_*() マクロの記録先
+ */
+extern TraceRing_t TraceRing_Default;
+#endif
+
+#endif  // !defined(USER_TRACERING_H__)
@@ -0,0 +1,235 @@
+/**
+ * @file prog01/app/src/apiprof.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include <hardware/clocks.h>
+#include <hardware/structs/m33.h>
+#endif
+
+#include <user/apiprof.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define DUMP_LINE (512)  //< ApiProf_Dump() の 1行の最大長
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 処理時間の区間番号を返す (ビット長. 最後の区間で飽和する)
+ */
+inline static uint32_t bucketOf(uint32_t ticks);
+
+/**
+ * @brief 区間の上限を返す (最後の区間は UINT32_MAX)
+ */
+inline static uint32_t bucketLimit(uint32_t k);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * コアごとの集計 (0 で初期化された状態は空)
+ */
+static ApiProfStat_t stats[APIPROF_CORES][ApiProfIdNum];
+
+/**
+ * ApiProfId_t ごとの関数名
+ */
+static const char* const names[ApiProfIdNum] = {
+    "Canvas_ExpandLine",
+    "Canvas_Clear",
+    "Canvas_DrawPixel",
+    "Canvas_DrawLine",
+    "Canvas_DrawCircle",
+    "Canvas_DrawFillCircle",
+    "Canvas_FillRect",
+    "Canvas_Blit",
+    "Canvas_Scroll",
+    "Font_PrintWith",
+    "LCDDrv_SetWindow",
+    "LCDDrv_Clear",
+    "LCDDrv_SetBrightness",
+    "LCDDrv_SwapBuff",
+    "LCDDrv_SwapCanvas",
+    "LCDDrv_SetScrollArea",
+    "LCDDrv_SetScrollStart",
+    "LCDDrv_Scroll",
+    "LCDDrv_WaitForTransfer",
+    "SPIDrv_SendByte",
+    "SPIDrv_RecvByte",
+    "SPIDrv_TransferByte",
+    "SPIDrv_SendNBytes",
+    "SPIDrv_RecvNBytes",
+    "SPIDrv_TransferNBytes",
+    "SPIDrv_AsyncSend",
+    "SPIDrv_AsyncRecv",
+    "SPIDrv_AsyncTransfer",
+    "SPIDrv_WaitForAsync",
+    "SPIDrv_SetDC",
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+inline static uint32_t bucketOf(uint32_t ticks) {
+  const uint32_t k = (0 == ticks) ? 0 : 32u - (uint32_t)__builtin_clz(ticks);
+  return (APIPROF_BUCKETS - 1 < k) ? APIPROF_BUCKETS - 1 : k;
+}
+
+inline static uint32_t bucketLimit(uint32_t k) { return (APIPROF_BUCKETS - 1 <= k) ? UINT32_MAX : (1u << k); }
+
+UError_t ApiProf_Init(void) {
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+  // DWT はトレースを有効にした状態でのみ動作する
+  m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+  m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+  return uSuccess;
+}
+
+void ApiProf_Reset(void) { memset(stats, 0, sizeof(stats)); }
+
+void ApiProf_Add(ApiProfId_t id, uint32_t ticks) {
+  const uint32_t core = get_core_num();
+  if ((uint32_t)ApiProfIdNum <= (uint32_t)id || APIPROF_CORES <= core) {
+    return;
+  }
+
+  ApiProfStat_t* const st = &stats[core][id];
+  if (0 == st->calls || ticks < st->min) {
+    st->min = ticks;
+  }
+  if (st->max < ticks) {
+    st->max = ticks;
+  }
+  ++st->calls;
+  st->total += ticks;
+  ++st->buckets[bucketOf(ticks)];
+}
+
+UError_t ApiProf_Get(ApiProfId_t id, ApiProfStat_t* stat) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if ((uint32_t)ApiProfIdNum <= (uint32_t)id || NULL == stat) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(stat, 0, sizeof(ApiProfStat_t));
+    for (uint32_t core = 0; core < APIPROF_CORES; ++core) {
+      const ApiProfStat_t* const st = &stats[core][id];
+      if (0 == st->calls) {
+        continue;
+      }
+      if (0 == stat->calls || st->min < stat->min) {
+        stat->min = st->min;
+      }
+      if (stat->max < st->max) {
+        stat->max = st->max;
+      }
+      stat->calls += st->calls;
+      stat->total += st->total;
+      for (uint32_t k = 0; k < APIPROF_BUCKETS; ++k) {
+        stat->buckets[k] += st->buckets[k];
+      }
+    }
+  }
+
+  return err;
+}
+
+uint32_t ApiProf_Percentile(const ApiProfStat_t* stat, uint32_t q) {
+  if (NULL == stat || 0 == stat->calls) {
+    return 0;
+  }
+
+  // q パーセンタイルに相当する回数に達する区間を探す (切り上げ)
+  const uint64_t rank = (((uint64_t)stat->calls * ((100 < q) ? 100 : q)) + 99) / 100;
+  uint64_t seen = 0;
+  for (uint32_t k = 0; k < APIPROF_BUCKETS; ++k) {
+    seen += stat->buckets[k];
+    if (0 < seen && rank <= seen) {
+      const uint32_t limit = bucketLimit(k);
+      return (stat->max < limit) ? stat->max : limit;
+    }
+  }
+  return stat->max;
+}
+
+const char* ApiProf_GetName(ApiProfId_t id) { return ((uint32_t)id < (uint32_t)ApiProfIdNum) ? names[id] : NULL; }
+
+uint32_t ApiProf_GetTicksPerUs(void) {
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+  return clock_get_hz(clk_sys) / 1000000u;
+#else
+  return 1000u;
+#endif
+}
+
+UError_t ApiProf_Dump(ApiProfWriteFn_t write, void* arg) {
+  UError_t err = uSuccess;
+  char line[DUMP_LINE];
+  int n = 0;
+
+  if (uSuccess == err) {
+    if (NULL == write) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    n = snprintf(line, sizeof(line), "# apiprof ticks_per_us=%lu\napi,calls,min,avg,p50,p99,max,hist\n", (unsigned long)ApiProf_GetTicksPerUs());
+    err = write(arg, line, (size_t)n);
+  }
+
+  for (uint32_t id = 0; uSuccess == err && id < ApiProfIdNum; ++id) {
+    ApiProfStat_t st;
+    (void)ApiProf_Get((ApiProfId_t)id, &st);
+    if (0 == st.calls) {
+      continue;
+    }
+
+    n = snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu,%lu,%lu,", names[id], (unsigned long)st.calls, (unsigned long)st.min,
+                 (unsigned long)(st.total / st.calls), (unsigned long)ApiProf_Percentile(&st, 50), (unsigned long)ApiProf_Percentile(&st, 99),
+                 (unsigned long)st.max);
+    bool first = true;
+    for (uint32_t k = 0; k < APIPROF_BUCKETS && 0 < n && n < (int)sizeof(line); ++k) {
+      if (0 < st.buckets[k]) {
+        n += snprintf(&line[n], sizeof(line) - (size_t)n, "%s%lu:%lu", first ? "" : " ", (unsigned long)k, (unsigned long)st.buckets[k]);
+        first = false;
+      }
+    }
+    if (0 < n && n < (int)sizeof(line) - 1) {
+      line[n++] = '\n';
+      err = write(arg, line, (size_t)n);
+    }
+  }
+
+  return err;
+}
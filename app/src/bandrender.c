@@ -0,0 +1,284 @@
+/**
+ * @file prog01/app/src/bandrender.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(LIB_PICO_MULTICORE)
+#include <pico/multicore.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <user/apiprof.h>
+#include <user/bandrender.h>
+#include <user/canvas.h>
+#include <user/core1.h>
+#include <user/drawlist.h>
+#include <user/tracering.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 帯を再生する (トレースに帯の区間を記録する)
+ */
+static UError_t executeBand(const DrawList_t* list, const Canvas_t* canvas, size_t y, size_t h);
+
+/**
+ * @brief ワーカーの担当する帯を再生する
+ */
+static void runWorkerBand(BandRender_t* ctx);
+
+#if defined(LIB_PICO_MULTICORE)
+/**
+ * @brief core1 の処理. FIFO で受け取った処理を実行し, 結果を FIFO で返す
+ */
+static void core1Entry(void);
+#else
+/**
+ * @brief ワーカースレッドの処理
+ */
+static void* workerEntry(void* arg);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static bool workerStarted = false;  //< ワーカー起動済み (プロセスで 1つ)
+
+#if !defined(LIB_PICO_MULTICORE)
+static pthread_t worker;
+static pthread_mutex_t workerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workerCond = PTHREAD_COND_INITIALIZER;
+static BandRender_t* workerJob = NULL;  //< 実行待ちの処理
+static bool workerDone = false;         //< 処理完了
+static bool workerQuit = false;         //< 停止要求
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t executeBand(const DrawList_t* list, const Canvas_t* canvas, size_t y, size_t h) {
+  TRACE_BEGIN(TraceIdBand, (uint32_t)y, (uint32_t)h);
+  const UError_t err = DrawList_ExecuteBand(list, canvas, y, h);
+  TRACE_END(TraceIdBand, (uint32_t)y, (uint32_t)h);
+  return err;
+}
+
+static void runWorkerBand(BandRender_t* ctx) { ctx->result = executeBand(ctx->list, ctx->canvas, ctx->y, ctx->h); }
+
+#if defined(LIB_PICO_MULTICORE)
+static void core1Entry(void) {
+#if APIPROF_ENABLE
+  (void)ApiProf_Init();  // core1 の DWT を有効にする
+#endif
+  while (true) {
+    BandRender_t* const ctx = (BandRender_t*)(uintptr_t)multicore_fifo_pop_blocking();
+    atomic_thread_fence(memory_order_acquire);
+    runWorkerBand(ctx);
+    // 描画結果を書き終えてから完了を通知する
+    atomic_thread_fence(memory_order_release);
+    multicore_fifo_push_blocking((uint32_t)ctx->result);
+  }
+}
+#else
+static void* workerEntry(void* arg) {
+  (void)arg;
+  pthread_mutex_lock(&workerLock);
+  while (true) {
+    while (NULL == workerJob && !workerQuit) {
+      pthread_cond_wait(&workerCond, &workerLock);
+    }
+    if (workerQuit) {
+      break;
+    }
+    BandRender_t* const ctx = workerJob;
+    pthread_mutex_unlock(&workerLock);
+
+    runWorkerBand(ctx);
+
+    pthread_mutex_lock(&workerLock);
+    workerJob = NULL;
+    workerDone = true;
+    pthread_cond_broadcast(&workerCond);
+  }
+  pthread_mutex_unlock(&workerLock);
+  return NULL;
+}
+#endif
+
+UError_t BandRender_Create(BandRender_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->split = 0;
+    ctx->started = false;
+    ctx->list = NULL;
+    ctx->canvas = NULL;
+    ctx->y = 0;
+    ctx->h = 0;
+    ctx->result = uSuccess;
+  }
+
+  return err;
+}
+
+UError_t BandRender_SetSplit(BandRender_t* ctx, uint32_t split) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->split = split;
+  }
+
+  return err;
+}
+
+UError_t BandRender_Start(BandRender_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || workerStarted) {
+      err = uFailure;
+    }
+  }
+
+#if defined(LIB_PICO_MULTICORE)
+  if (uSuccess == err) {
+    // core1 を他の処理 (LCDPipe_Start() 等) が使用中の場合は失敗する
+    err = Core1_Launch(core1Entry);
+  }
+#else
+  if (uSuccess == err) {
+    workerJob = NULL;
+    workerQuit = false;
+    if (0 != pthread_create(&worker, NULL, workerEntry, NULL)) {
+      err = uFailure;
+    }
+  }
+#endif
+
+  if (uSuccess == err) {
+    workerStarted = true;
+    ctx->started = true;
+  }
+
+  return err;
+}
+
+UError_t BandRender_Stop(BandRender_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || !ctx->started) {
+      err = uFailure;
+    }
+  }
+
+#if defined(LIB_PICO_MULTICORE)
+  if (uSuccess == err) {
+    err = Core1_Reset();
+  }
+#else
+  if (uSuccess == err) {
+    pthread_mutex_lock(&workerLock);
+    workerQuit = true;
+    pthread_cond_broadcast(&workerCond);
+    pthread_mutex_unlock(&workerLock);
+    pthread_join(worker, NULL);
+  }
+#endif
+
+  if (uSuccess == err) {
+    workerStarted = false;
+    ctx->started = false;
+  }
+
+  return err;
+}
+
+UError_t BandRender_Execute(BandRender_t* ctx, const DrawList_t* list, const Canvas_t* canvas) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == list || NULL == canvas) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    TRACE_BEGIN(TraceIdRender, 0, 0);
+    // 描画できる領域を split で上下に分ける
+    const size_t top = canvas->clip.y;
+    const size_t bottom = (size_t)canvas->clip.y + canvas->clip.h;
+    const size_t split = (top < ctx->split && ctx->split < bottom) ? ctx->split : top + (canvas->clip.h / 2);
+
+    ctx->list = list;
+    ctx->canvas = canvas;
+    ctx->y = split;
+    ctx->h = bottom - split;
+
+    if (!ctx->started) {
+      err = executeBand(list, canvas, top, split - top);
+      runWorkerBand(ctx);
+    } else {
+#if defined(LIB_PICO_MULTICORE)
+      atomic_thread_fence(memory_order_release);
+      multicore_fifo_push_blocking((uint32_t)(uintptr_t)ctx);
+      err = executeBand(list, canvas, top, split - top);
+      (void)multicore_fifo_pop_blocking();
+      atomic_thread_fence(memory_order_acquire);
+#else
+      pthread_mutex_lock(&workerLock);
+      workerJob = ctx;
+      workerDone = false;
+      pthread_cond_broadcast(&workerCond);
+      pthread_mutex_unlock(&workerLock);
+
+      err = executeBand(list, canvas, top, split - top);
+
+      pthread_mutex_lock(&workerLock);
+      while (!workerDone) {
+        pthread_cond_wait(&workerCond, &workerLock);
+      }
+      pthread_mutex_unlock(&workerLock);
+#endif
+    }
+
+    err = (uSuccess == err) ? ctx->result : err;
+    TRACE_END(TraceIdRender, 0, 0);
+  }
+
+  return err;
+}
@@ -6,16 +6,48 @@
 // includes
 //////////////////////////////////////////////////////////////////////////////
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <user/apiprof.h>
 #include <user/canvas.h>
+#include <user/drawrec.h>
+#include <user/macros.h>
 #include <user/types.h>
 
 //////////////////////////////////////////////////////////////////////////////
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+#if CANVAS_OVERDRAW
+// 描画関数の開始/終了で集計する種類を設定し, 書き込んだピクセルを数える
+#define OVERDRAW_BEGIN(ctx, prim) const CanvasPrim_t overdrawPrev = Canvas_BeginOverdraw((ctx), (prim))
+#define OVERDRAW_END(ctx) Canvas_EndOverdraw((ctx), overdrawPrev)
+#define OVERDRAW_SPAN(ctx, x, y, n) countSpan((ctx), (x), (y), (n))
+#else
+#define OVERDRAW_BEGIN(ctx, prim) ((void)0)
+#define OVERDRAW_END(ctx) ((void)0)
+#define OVERDRAW_SPAN(ctx, x, y, n) ((void)0)
+#endif
+
+#if CANVAS_RECORD
+// 描画関数の呼び出しを記録する. 内部で呼び出す描画関数 (Canvas_Scroll() の Canvas_FillRect() 等) は記録しない
+#define RECORD_BEGIN(ctx, op, ...)                                                                             \
+  do {                                                                                                         \
+    if (NULL != DrawRec_Current && 0 == recordDepth) {                                                         \
+      const uint32_t recordArgs[] = {__VA_ARGS__};                                                             \
+      DrawRec_PutCanvas(DrawRec_Current, (ctx), (op), recordArgs, sizeof(recordArgs) / sizeof(recordArgs[0])); \
+    }                                                                                                          \
+    ++recordDepth;                                                                                             \
+  } while (0)
+#define RECORD_END() (--recordDepth)
+#else
+#define RECORD_BEGIN(ctx, op, ...) ((void)0)
+#define RECORD_END() ((void)0)
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
@@ -26,8 +58,35 @@
 
 inline static UError_t clear(const Canvas_t* const ctx, const uint16_t c);
 
+/**
+ * @brief (x, y) のピクセル値を取得する. 範囲の確認は行わない.
+ * @return RGB565 の色 または パレット番号
+ */
+inline static uint16_t getPixel(const Canvas_t* const ctx, const size_t x, const size_t y);
+
+/**
+ * @brief (x, y) へピクセル値を書き込む. 範囲の確認は行わない.
+ */
+inline static void putPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c);
+
 inline static UError_t setPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c);
 
+/**
+ * @brief (x, y) が描画できる領域内か判定する
+ */
+inline static bool inClip(const Canvas_t* const ctx, const size_t x, const size_t y);
+
+/**
+ * @brief 矩形を描画できる領域と交差させる
+ * @param [in] ctx : 操作対象
+ * @param [inout] x : x座標
+ * @param [inout] y : y座標
+ * @param [inout] w : 幅
+ * @param [inout] h : 高さ
+ * @return 交差する部分がある場合 true
+ */
+inline static bool clipRect(const Canvas_t* const ctx, size_t* x, size_t* y, size_t* w, size_t* h);
+
 /**
  * @brief 端点1 端点2 を結ぶ 線分を描画する.
  *
@@ -42,10 +101,39 @@ inline static UError_t setPixel(const Canvas_t* const ctx, const size_t x, const
  */
 inline static UError_t setLine(const Canvas_t* const ctx, const size_t x1, const size_t y1, const size_t x2, const size_t y2, const uint16_t c);
 
+#if CANVAS_OVERDRAW
+/**
+ * @brief (x, y) から右へ n ピクセルの書き込み回数を数える. 範囲の確認は行わない.
+ */
+inline static void countSpan(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t n);
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // variable
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * CanvasFormat_t ごとのビット数
+ */
+static const uint8_t bitsPerPixel[] = {16, 1, 2, 4, 8};
+
+#if CANVAS_OVERDRAW
+/**
+ * ヒートマップの色 (書き込み回数 0..7 以上)
+ */
+static const uint16_t heatmapColors[] = {
+    RGB888toRGB565(0x20, 0x20, 0x20), RGB888toRGB565(0x00, 0x00, 0xff), RGB888toRGB565(0x00, 0xc0, 0xff), RGB888toRGB565(0x00, 0xff, 0x00),
+    RGB888toRGB565(0xff, 0xff, 0x00), RGB888toRGB565(0xff, 0x80, 0x00), RGB888toRGB565(0xff, 0x00, 0x00), RGB888toRGB565(0xff, 0xff, 0xff),
+};
+#endif
+
+#if CANVAS_RECORD
+/**
+ * 実行中の描画関数の入れ子の深さ (最も外側の呼び出しだけを記録する)
+ */
+static uint32_t recordDepth = 0;
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // function
 //////////////////////////////////////////////////////////////////////////////
@@ -59,18 +147,72 @@ inline static UError_t clear(const Canvas_t* const ctx, const uint16_t c) {
     }
   }
 
+  bool whole = false;
   if (uSuccess == err) {
+    const CanvasRect_t* const r = &ctx->clip;
+    whole = (0 == r->x && 0 == r->y && ctx->w == r->w && ctx->h == r->h);
+    if (!whole && 0 < r->w && 0 < r->h) {
+      // 描画できる領域が制限されている場合は, その範囲だけを塗りつぶす
+      err = Canvas_FillRect(ctx, r->x, r->y, r->w, r->h, c);
+    }
+  }
+
+  if (uSuccess == err && whole && CanvasRGB565 == ctx->fmt) {
     uint16_t* addr = (uint16_t*)ctx->buf;
     for (size_t y = 0; y < ctx->h; ++y) {
       for (size_t x = 0; x < ctx->w; ++x) {
         *(addr + x) = c;
       }
+      OVERDRAW_SPAN(ctx, 0, y, ctx->w);
       addr += ctx->s;
     }
+  } else if (uSuccess == err && whole) {
+    // パレット番号を 1バイト分に複製し, バイト単位で埋める. 端数のピクセルは個別に書く
+    const uint32_t bpp = bitsPerPixel[ctx->fmt];
+    const size_t rb = Canvas_GetRowBytes(ctx);
+    const size_t full = (ctx->w * bpp) / 8;
+    uint8_t pattern = (uint8_t)(c & ((1u << bpp) - 1));
+    for (uint32_t i = bpp; i < 8; i *= 2) {
+      pattern |= (uint8_t)(pattern << i);
+    }
+    for (size_t y = 0; y < ctx->h; ++y) {
+      memset((uint8_t*)ctx->buf + (y * rb), pattern, full);
+      OVERDRAW_SPAN(ctx, 0, y, (full * 8) / bpp);
+      for (size_t x = (full * 8) / bpp; x < ctx->w; ++x) {
+        putPixel(ctx, x, y, c);
+      }
+    }
   }
   return err;
 }
 
+inline static uint16_t getPixel(const Canvas_t* const ctx, const size_t x, const size_t y) {
+  if (CanvasRGB565 == ctx->fmt) {
+    return *((const uint16_t*)ctx->buf + (y * ctx->s) + x);
+  }
+
+  const uint32_t bpp = bitsPerPixel[ctx->fmt];
+  const size_t bit = x * bpp;
+  const uint8_t b = *((const uint8_t*)ctx->buf + (y * Canvas_GetRowBytes(ctx)) + (bit / 8));
+  const uint32_t shift = 8 - bpp - (bit % 8);
+  return (uint16_t)((b >> shift) & ((1u << bpp) - 1));
+}
+
+inline static void putPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c) {
+  OVERDRAW_SPAN(ctx, x, y, 1);
+  if (CanvasRGB565 == ctx->fmt) {
+    *((uint16_t*)ctx->buf + (y * ctx->s) + x) = c;
+    return;
+  }
+
+  const uint32_t bpp = bitsPerPixel[ctx->fmt];
+  const size_t bit = x * bpp;
+  uint8_t* const addr = (uint8_t*)ctx->buf + (y * Canvas_GetRowBytes(ctx)) + (bit / 8);
+  const uint32_t shift = 8 - bpp - (bit % 8);
+  const uint8_t mask = (uint8_t)(((1u << bpp) - 1) << shift);
+  *addr = (uint8_t)((*addr & ~mask) | ((c << shift) & mask));
+}
+
 inline static UError_t setPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c) {
   UError_t err = uSuccess;
 
@@ -81,20 +223,42 @@ inline static UError_t setPixel(const Canvas_t* const ctx, const size_t x, const
   }
 
   if (uSuccess == err) {
-    if (ctx->w <= x || ctx->h <= y) {
+    if (!inClip(ctx, x, y)) {
       err = uFailure;
     }
   }
 
   if (uSuccess == err) {
-    const size_t offset = (y * ctx->s) + x;
-    uint16_t* const addr = (uint16_t*)ctx->buf;
-    *(addr + offset) = c;
+    putPixel(ctx, x, y, c);
   }
 
   return err;
 }
 
+inline static bool inClip(const Canvas_t* const ctx, const size_t x, const size_t y) {
+  // 領域の左/上にある場合は減算が桁あふれして大きな値になる
+  return (x - ctx->clip.x < ctx->clip.w) && (y - ctx->clip.y < ctx->clip.h);
+}
+
+inline static bool clipRect(const Canvas_t* const ctx, size_t* x, size_t* y, size_t* w, size_t* h) {
+  const CanvasRect_t* const r = &ctx->clip;
+  const size_t x2 = (SIZE_MAX - *x < *w) ? SIZE_MAX : *x + *w;
+  const size_t y2 = (SIZE_MAX - *y < *h) ? SIZE_MAX : *y + *h;
+  const size_t cx1 = (*x > r->x) ? *x : r->x;
+  const size_t cy1 = (*y > r->y) ? *y : r->y;
+  const size_t cx2 = (x2 < (size_t)r->x + r->w) ? x2 : (size_t)r->x + r->w;
+  const size_t cy2 = (y2 < (size_t)r->y + r->h) ? y2 : (size_t)r->y + r->h;
+
+  if (cx2 <= cx1 || cy2 <= cy1) {
+    return false;
+  }
+  *x = cx1;
+  *y = cy1;
+  *w = cx2 - cx1;
+  *h = cy2 - cy1;
+  return true;
+}
+
 inline static UError_t setLine(const Canvas_t* const ctx, const size_t x1, const size_t y1, const size_t x2, const size_t y2, const uint16_t c) {
   UError_t err = uSuccess;
 
@@ -104,7 +268,16 @@ inline static UError_t setLine(const Canvas_t* const ctx, const size_t x1, const
     }
   }
 
-  if (uSuccess == err) {
+  bool visible = (uSuccess == err);
+  if (visible) {
+    // 両端点が描画できる領域の同じ側の外にある場合は, 線分全体が領域外
+    const CanvasRect_t* const r = &ctx->clip;
+    const size_t right = (size_t)r->x + r->w;
+    const size_t bottom = (size_t)r->y + r->h;
+    visible = !((x1 < r->x && x2 < r->x) || (y1 < r->y && y2 < r->y) || (right <= x1 && right <= x2) || (bottom <= y1 && bottom <= y2));
+  }
+
+  if (visible) {
     const int32_t dx = (x2 > x1) ? x2 - x1 : x1 - x2;
     const int32_t dy = (y2 > y1) ? y2 - y1 : y1 - y2;
 
@@ -155,11 +328,140 @@ UError_t Canvas_Create(Canvas_t* ctx, size_t w, size_t h, size_t s, void* const
     ctx->h = h;
     ctx->s = s;
     ctx->buf = buf;
+    ctx->fmt = CanvasRGB565;
+    ctx->palette = NULL;
+    ctx->clip.x = 0;
+    ctx->clip.y = 0;
+    ctx->clip.w = (uint16_t)w;
+    ctx->clip.h = (uint16_t)h;
+#if CANVAS_OVERDRAW
+    ctx->overdraw = NULL;
+#endif
   }
 
   return err;
 }
 
+UError_t Canvas_SetClip(Canvas_t* ctx, size_t x, size_t y, size_t w, size_t h) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // キャンバスの範囲に切り詰める
+    x = (x < ctx->w) ? x : ctx->w;
+    y = (y < ctx->h) ? y : ctx->h;
+    w = (ctx->w - x < w) ? ctx->w - x : w;
+    h = (ctx->h - y < h) ? ctx->h - y : h;
+    ctx->clip.x = (uint16_t)x;
+    ctx->clip.y = (uint16_t)y;
+    ctx->clip.w = (uint16_t)w;
+    ctx->clip.h = (uint16_t)h;
+  }
+
+  return err;
+}
+
+UError_t Canvas_CreateIndexed(Canvas_t* ctx, size_t w, size_t h, size_t s, void* const buf, CanvasFormat_t fmt, const uint16_t* palette) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (CanvasIndexed1 > fmt || CanvasIndexed8 < fmt || s < w) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = Canvas_Create(ctx, w, h, s, buf);
+  }
+
+  if (uSuccess == err) {
+    ctx->fmt = fmt;
+    ctx->palette = palette;
+  }
+
+  return err;
+}
+
+UError_t Canvas_SetPalette(Canvas_t* ctx, const uint16_t* palette) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->palette = palette;
+  }
+
+  return err;
+}
+
+uint32_t Canvas_GetBitsPerPixel(CanvasFormat_t fmt) {
+  if (CanvasRGB565 > fmt || CanvasIndexed8 < fmt) {
+    return 0;
+  }
+  return bitsPerPixel[fmt];
+}
+
+size_t Canvas_GetRowBytes(const Canvas_t* const ctx) {
+  if (NULL == ctx) {
+    return 0;
+  }
+  return ((ctx->s * Canvas_GetBitsPerPixel(ctx->fmt)) + 7) / 8;
+}
+
+UError_t Canvas_ExpandLine(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, uint16_t* out) {
+  APIPROF_BEGIN(ApiProfCanvasExpandLine);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->buf || NULL == out) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->w < x + w || ctx->h <= y || (CanvasRGB565 != ctx->fmt && NULL == ctx->palette)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err && CanvasRGB565 == ctx->fmt) {
+    memcpy(out, (const uint16_t*)ctx->buf + (y * ctx->s) + x, w * sizeof(uint16_t));
+  } else if (uSuccess == err && CanvasIndexed8 == ctx->fmt) {
+    const uint8_t* const src = (const uint8_t*)ctx->buf + (y * Canvas_GetRowBytes(ctx)) + x;
+    for (size_t i = 0; i < w; ++i) {
+      out[i] = ctx->palette[src[i]];
+    }
+  } else if (uSuccess == err) {
+    // 1バイトずつ読み出し, 上位ビットから順に取り出す
+    const uint32_t bpp = bitsPerPixel[ctx->fmt];
+    const uint32_t mask = (1u << bpp) - 1;
+    const uint8_t* src = (const uint8_t*)ctx->buf + (y * Canvas_GetRowBytes(ctx)) + ((x * bpp) / 8);
+    uint32_t b = *src++;
+    uint32_t shift = 8 - bpp - ((x * bpp) % 8);
+    for (size_t i = 0; i < w; ++i) {
+      out[i] = ctx->palette[(b >> shift) & mask];
+      if (0 == shift && i + 1 < w) {
+        b = *src++;
+        shift = 8 - bpp;
+      } else {
+        shift -= bpp;
+      }
+    }
+  }
+
+  APIPROF_END(ApiProfCanvasExpandLine);
+  return err;
+}
+
 const void* Canvas_GetBuf(const Canvas_t* const ctx) {
   if (NULL == ctx) {
     return NULL;
@@ -167,16 +469,44 @@ const void* Canvas_GetBuf(const Canvas_t* const ctx) {
   return ctx->buf;
 }
 
-UError_t Canvas_Clear(const Canvas_t* const ctx, const uint16_t c) { return clear(ctx, c); }
+UError_t Canvas_Clear(const Canvas_t* const ctx, const uint16_t c) {
+  APIPROF_BEGIN(ApiProfCanvasClear);
+  RECORD_BEGIN(ctx, DrawRecOpClear, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimClear);
+  const UError_t err = clear(ctx, c);
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasClear);
+  return err;
+}
 
-UError_t Canvas_DrawPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c) { return setPixel(ctx, x, y, c); }
+UError_t Canvas_DrawPixel(const Canvas_t* const ctx, const size_t x, const size_t y, const uint16_t c) {
+  APIPROF_BEGIN(ApiProfCanvasDrawPixel);
+  RECORD_BEGIN(ctx, DrawRecOpPixel, (uint32_t)x, (uint32_t)y, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimPixel);
+  const UError_t err = setPixel(ctx, x, y, c);
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasDrawPixel);
+  return err;
+}
 
 UError_t Canvas_DrawLine(const Canvas_t* const ctx, const size_t x1, const size_t y1, const size_t x2, const size_t y2, const uint16_t c) {
-  return setLine(ctx, x1, y1, x2, y2, c);
+  APIPROF_BEGIN(ApiProfCanvasDrawLine);
+  RECORD_BEGIN(ctx, DrawRecOpLine, (uint32_t)x1, (uint32_t)y1, (uint32_t)x2, (uint32_t)y2, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimLine);
+  const UError_t err = setLine(ctx, x1, y1, x2, y2, c);
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasDrawLine);
+  return err;
 }
 
 UError_t Canvas_DrawCircle(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t r, const uint16_t c) {
+  APIPROF_BEGIN(ApiProfCanvasDrawCircle);
   UError_t err = uSuccess;
+  RECORD_BEGIN(ctx, DrawRecOpCircle, (uint32_t)x, (uint32_t)y, (uint32_t)r, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimCircle);
 
   if (uSuccess == err) {
     if (NULL == ctx) {
@@ -212,11 +542,17 @@ UError_t Canvas_DrawCircle(const Canvas_t* const ctx, const size_t x, const size
       (void)setPixel(ctx, x - cy, y + cx, c);
     }  // while(cx >= ...
   }
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasDrawCircle);
   return err;
 }
 
 UError_t Canvas_DrawFillCircle(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t r, const uint16_t c) {
+  APIPROF_BEGIN(ApiProfCanvasDrawFillCircle);
   UError_t err = uSuccess;
+  RECORD_BEGIN(ctx, DrawRecOpFillCircle, (uint32_t)x, (uint32_t)y, (uint32_t)r, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimFillCircle);
 
   if (uSuccess == err) {
     if (NULL == ctx) {
@@ -250,5 +586,324 @@ UError_t Canvas_DrawFillCircle(const Canvas_t* const ctx, const size_t x, const
 
     }  // while(cx >= ...
   }
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasDrawFillCircle);
+  return err;
+}
+
+UError_t Canvas_FillRect(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const uint16_t c) {
+  APIPROF_BEGIN(ApiProfCanvasFillRect);
+  UError_t err = uSuccess;
+  RECORD_BEGIN(ctx, DrawRecOpFillRect, (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h, c);
+  OVERDRAW_BEGIN(ctx, CanvasPrimFillRect);
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->buf) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->w <= x || ctx->h <= y) {
+      err = uFailure;
+    }
+  }
+
+  // 描画できる領域外の場合は何もしない
+  size_t cx = x;
+  size_t cy = y;
+  size_t cw = w;
+  size_t ch = h;
+  const bool visible = (uSuccess == err) && clipRect(ctx, &cx, &cy, &cw, &ch);
+
+  if (visible && CanvasRGB565 == ctx->fmt) {
+    uint16_t* addr = (uint16_t*)ctx->buf + (cy * ctx->s) + cx;
+    for (size_t j = 0; j < ch; ++j) {
+      for (size_t i = 0; i < cw; ++i) {
+        *(addr + i) = c;
+      }
+      OVERDRAW_SPAN(ctx, cx, cy + j, cw);
+      addr += ctx->s;
+    }
+  } else if (visible) {
+    for (size_t j = 0; j < ch; ++j) {
+      if (CanvasIndexed8 == ctx->fmt) {
+        memset((uint8_t*)ctx->buf + ((cy + j) * Canvas_GetRowBytes(ctx)) + cx, c, cw);
+        OVERDRAW_SPAN(ctx, cx, cy + j, cw);
+        continue;
+      }
+      for (size_t i = 0; i < cw; ++i) {
+        putPixel(ctx, cx + i, cy + j, c);
+      }
+    }
+  }
+
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasFillRect);
+  return err;
+}
+
+UError_t Canvas_Blit(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const uint16_t* src, const size_t ss) {
+  APIPROF_BEGIN(ApiProfCanvasBlit);
+  UError_t err = uSuccess;
+  RECORD_BEGIN(ctx, DrawRecOpBlit, (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h, (uint32_t)ss);
+  OVERDRAW_BEGIN(ctx, CanvasPrimBlit);
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->buf || NULL == src || CanvasRGB565 != ctx->fmt) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->w <= x || ctx->h <= y) {
+      err = uFailure;
+    }
+  }
+
+  // 描画できる領域外の場合は何もしない
+  size_t cx = x;
+  size_t cy = y;
+  size_t cw = w;
+  size_t ch = h;
+  const bool visible = (uSuccess == err) && clipRect(ctx, &cx, &cy, &cw, &ch);
+
+  if (visible) {
+    uint16_t* addr = (uint16_t*)ctx->buf + (cy * ctx->s) + cx;
+    src += ((cy - y) * ss) + (cx - x);
+    for (size_t j = 0; j < ch; ++j) {
+      memcpy(addr, src, cw * sizeof(uint16_t));
+      OVERDRAW_SPAN(ctx, cx, cy + j, cw);
+      addr += ctx->s;
+      src += ss;
+    }
+  }
+
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasBlit);
+  return err;
+}
+
+UError_t Canvas_Scroll(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t w, const size_t h, const int32_t dx, const int32_t dy,
+                       const uint16_t fill) {
+  APIPROF_BEGIN(ApiProfCanvasScroll);
+  UError_t err = uSuccess;
+  RECORD_BEGIN(ctx, DrawRecOpScroll, (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h, (uint32_t)dx, (uint32_t)dy, fill);
+  OVERDRAW_BEGIN(ctx, CanvasPrimScroll);
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->buf) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->w <= x || ctx->h <= y) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t cw = (ctx->w - x < w) ? ctx->w - x : w;
+    const size_t ch = (ctx->h - y < h) ? ctx->h - y : h;
+    const size_t ax = (0 > dx) ? (size_t)-dx : (size_t)dx;
+    const size_t ay = (0 > dy) ? (size_t)-dy : (size_t)dy;
+
+    if (cw <= ax || ch <= ay) {
+      // 全体が矩形外へ出る
+      err = Canvas_FillRect(ctx, x, y, cw, ch, fill);
+    } else {
+      const size_t mw = cw - ax;  // 移動する幅
+      const size_t mh = ch - ay;  // 移動する行数
+      const size_t sx = (0 > dx) ? ax : 0;
+      const size_t tx = (0 > dx) ? 0 : ax;
+
+      // 重なりを壊さないよう, 下へ移動する場合は下の行から処理する
+      for (size_t j = 0; j < mh; ++j) {
+        const size_t row = (0 < dy) ? mh - 1 - j : j;
+        const size_t sy = (0 > dy) ? row + ay : row;
+        const size_t ty = (0 > dy) ? row : row + ay;
+        if (CanvasRGB565 == ctx->fmt) {
+          uint16_t* const base = (uint16_t*)ctx->buf + (y * ctx->s) + x;
+          memmove(base + (ty * ctx->s) + tx, base + (sy * ctx->s) + sx, mw * sizeof(uint16_t));
+          OVERDRAW_SPAN(ctx, x + tx, y + ty, mw);
+        } else if (CanvasIndexed8 == ctx->fmt) {
+          uint8_t* const base = (uint8_t*)ctx->buf + (y * Canvas_GetRowBytes(ctx)) + x;
+          memmove(base + (ty * Canvas_GetRowBytes(ctx)) + tx, base + (sy * Canvas_GetRowBytes(ctx)) + sx, mw);
+          OVERDRAW_SPAN(ctx, x + tx, y + ty, mw);
+        } else {
+          // バイト境界に揃わないため 1ピクセルずつ移動する. 右へ移動する場合は右から処理する
+          for (size_t i = 0; i < mw; ++i) {
+            const size_t col = (0 < dx) ? mw - 1 - i : i;
+            putPixel(ctx, x + tx + col, y + ty, getPixel(ctx, x + sx + col, y + sy));
+          }
+        }
+      }
+
+      // 空いた部分を塗りつぶす
+      if (0 < ay) {
+        (void)Canvas_FillRect(ctx, x, (0 > dy) ? y + mh : y, cw, ay, fill);
+      }
+      if (0 < ax) {
+        (void)Canvas_FillRect(ctx, (0 > dx) ? x + mw : x, (0 > dy) ? y : y + ay, ax, mh, fill);
+      }
+    }
+  }
+
+  OVERDRAW_END(ctx);
+  RECORD_END();
+  APIPROF_END(ApiProfCanvasScroll);
+  return err;
+}
+
+#if CANVAS_OVERDRAW
+inline static void countSpan(const Canvas_t* const ctx, const size_t x, const size_t y, const size_t n) {
+  CanvasOverdraw_t* const od = ctx->overdraw;
+  if (NULL == od) {
+    return;
+  }
+
+  uint8_t* const counts = od->counts + (y * ctx->s) + x;
+  uint32_t fresh = 0;
+  for (size_t i = 0; i < n; ++i) {
+    fresh += (0 == counts[i]) ? 1 : 0;
+    counts[i] += (UINT8_MAX != counts[i]) ? 1 : 0;
+  }
+  if (CanvasPrimNone != od->current) {
+    od->stats[od->current].written += (uint32_t)n;
+    od->stats[od->current].unique += fresh;
+  }
+}
+
+UError_t Canvas_AttachOverdraw(Canvas_t* ctx, CanvasOverdraw_t* overdraw, uint8_t* counts) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || (NULL != overdraw && NULL == counts)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->overdraw = overdraw;
+    if (NULL != overdraw) {
+      overdraw->counts = counts;
+      err = Canvas_ResetOverdraw(ctx);
+    }
+  }
+
+  return err;
+}
+
+UError_t Canvas_ResetOverdraw(const Canvas_t* const ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->overdraw) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    CanvasOverdraw_t* const od = ctx->overdraw;
+    memset(od->counts, 0, ctx->s * ctx->h);
+    memset(od->stats, 0, sizeof(od->stats));
+    od->current = CanvasPrimNone;
+  }
+
+  return err;
+}
+
+CanvasPrim_t Canvas_BeginOverdraw(const Canvas_t* const ctx, CanvasPrim_t prim) {
+  if (NULL == ctx || NULL == ctx->overdraw) {
+    return CanvasPrimNone;
+  }
+
+  CanvasOverdraw_t* const od = ctx->overdraw;
+  const CanvasPrim_t prev = od->current;
+  if (CanvasPrimNone == prev && CanvasPrimClear <= prim && prim < CanvasPrimNum) {
+    od->current = prim;
+    ++od->stats[prim].calls;
+  }
+  return prev;
+}
+
+void Canvas_EndOverdraw(const Canvas_t* const ctx, CanvasPrim_t prev) {
+  if (NULL != ctx && NULL != ctx->overdraw) {
+    ctx->overdraw->current = prev;
+  }
+}
+
+void Canvas_CountOverdraw(const Canvas_t* const ctx, size_t x, size_t y, size_t w, size_t h) {
+  if (NULL == ctx || NULL == ctx->overdraw || ctx->w <= x || ctx->h <= y) {
+    return;
+  }
+
+  w = (ctx->w - x < w) ? ctx->w - x : w;
+  h = (ctx->h - y < h) ? ctx->h - y : h;
+  for (size_t j = 0; j < h; ++j) {
+    countSpan(ctx, x, y + j, w);
+  }
+}
+
+UError_t Canvas_GetOverdrawStat(const Canvas_t* const ctx, CanvasPrim_t prim, CanvasOverdrawStat_t* stat) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->overdraw || NULL == stat || CanvasPrimNum <= prim || (CanvasPrimNone != prim && CanvasPrimClear > prim)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err && CanvasPrimNone != prim) {
+    *stat = ctx->overdraw->stats[prim];
+  } else if (uSuccess == err) {
+    memset(stat, 0, sizeof(*stat));
+    for (uint32_t i = 0; i < CanvasPrimNum; ++i) {
+      stat->calls += ctx->overdraw->stats[i].calls;
+      stat->written += ctx->overdraw->stats[i].written;
+      stat->unique += ctx->overdraw->stats[i].unique;
+    }
+  }
+
+  return err;
+}
+
+UError_t Canvas_DrawOverdrawHeatmap(const Canvas_t* const ctx, const Canvas_t* const dst, uint32_t* maxCount) {
+  UError_t err = uSuccess;
+  uint32_t most = 0;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->overdraw || NULL == dst || NULL == dst->buf || CanvasRGB565 != dst->fmt) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->w != dst->w || ctx->h != dst->h) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t last = sizeof(heatmapColors) / sizeof(heatmapColors[0]) - 1;
+    for (size_t y = 0; y < ctx->h; ++y) {
+      const uint8_t* const counts = ctx->overdraw->counts + (y * ctx->s);
+      uint16_t* const out = (uint16_t*)dst->buf + (y * dst->s);
+      for (size_t x = 0; x < ctx->w; ++x) {
+        most = (most < counts[x]) ? counts[x] : most;
+        out[x] = heatmapColors[(counts[x] < last) ? counts[x] : last];
+      }
+    }
+  }
+
+  if (NULL != maxCount) {
+    *maxCount = most;
+  }
+
   return err;
 }
+#endif
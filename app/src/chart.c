@@ -0,0 +1,323 @@
+/**
+ * @file prog01/app/src/chart.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/chart.h>
+#include <user/lcddrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 値を表示領域内の y座標 (上端 0) に変換する
+ */
+inline static uint32_t valueToY(const Chart_t* ctx, int32_t v);
+
+/**
+ * @brief 確定前の列を確定し, リングバッファへ格納する
+ */
+static void commitColumn(Chart_t* ctx);
+
+/**
+ * @brief 列 col0 から n 列を canvas の (ox, oy) を左上として描画する
+ */
+static void drawColumns(const Chart_t* ctx, const Canvas_t* canvas, uint32_t ox, uint32_t oy, uint32_t col0, uint32_t n);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+inline static uint32_t valueToY(const Chart_t* ctx, int32_t v) {
+  if (v <= ctx->vmin) {
+    return ctx->h - 1;
+  }
+  if (v >= ctx->vmax) {
+    return 0;
+  }
+  const int64_t num = (int64_t)(v - ctx->vmin) * (ctx->h - 1);
+  return (ctx->h - 1) - (uint32_t)(num / ((int64_t)ctx->vmax - ctx->vmin));
+}
+
+static void commitColumn(Chart_t* ctx) {
+  ChartColumn_t* const col = &ctx->columns[ctx->head];
+  col->lo = ctx->accLo;
+  col->hi = ctx->accHi;
+
+  ctx->head = (ctx->head + 1 < ctx->w) ? ctx->head + 1 : 0;
+  if (ctx->pending < ctx->w) {
+    ctx->pending++;
+  }
+  ctx->accCount = 0;
+}
+
+static void drawColumns(const Chart_t* ctx, const Canvas_t* canvas, uint32_t ox, uint32_t oy, uint32_t col0, uint32_t n) {
+  for (uint32_t i = 0; i < n; ++i) {
+    const ChartColumn_t* const col = &ctx->columns[col0 + i];
+    const uint32_t top = valueToY(ctx, col->hi);
+    const uint32_t bottom = valueToY(ctx, col->lo);
+
+    // 背景で消去してから縦線を描く
+    if (0 < top) {
+      (void)Canvas_FillRect(canvas, ox + i, oy, 1, top, ctx->bg);
+    }
+    (void)Canvas_FillRect(canvas, ox + i, oy + top, 1, bottom - top + 1, ctx->fg);
+    if (bottom + 1 < ctx->h) {
+      (void)Canvas_FillRect(canvas, ox + i, oy + bottom + 1, 1, ctx->h - bottom - 1, ctx->bg);
+    }
+  }
+}
+
+UError_t Chart_Create(Chart_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h, ChartColumn_t* columns) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == columns || 0 == w || 0 == h) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->x = x;
+    ctx->y = y;
+    ctx->w = w;
+    ctx->h = h;
+    ctx->columns = columns;
+    ctx->vmin = 0;
+    ctx->vmax = (1 < h) ? (int32_t)h - 1 : 1;
+    ctx->fg = 0xffff;
+    ctx->bg = 0x0000;
+    ctx->decimation = 1;
+    ctx->head = 0;
+    ctx->accCount = 0;
+    ctx->hasLast = false;
+    ctx->strip[0] = NULL;
+    ctx->strip[1] = NULL;
+    ctx->stripCols = 0;
+    ctx->stripIndex = 0;
+    for (uint32_t i = 0; i < w; ++i) {
+      ctx->columns[i].lo = ctx->vmin;
+      ctx->columns[i].hi = ctx->vmin;
+    }
+    err = Chart_Invalidate(ctx);
+  }
+
+  return err;
+}
+
+UError_t Chart_SetRange(Chart_t* ctx, int32_t vmin, int32_t vmax) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || vmin >= vmax) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->vmin = vmin;
+    ctx->vmax = vmax;
+    err = Chart_Invalidate(ctx);
+  }
+
+  return err;
+}
+
+UError_t Chart_SetColor(Chart_t* ctx, uint16_t fg, uint16_t bg) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->fg = fg;
+    ctx->bg = bg;
+    err = Chart_Invalidate(ctx);
+  }
+
+  return err;
+}
+
+UError_t Chart_SetDecimation(Chart_t* ctx, uint32_t n) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || 0 == n) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->decimation = n;
+    ctx->accCount = 0;
+  }
+
+  return err;
+}
+
+UError_t Chart_SetStripBuffer(Chart_t* ctx, uint16_t* buf, size_t size) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == buf || size < (size_t)2 * ctx->h) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t cols = size / 2 / ctx->h;
+    ctx->stripCols = (cols < ctx->w) ? (uint32_t)cols : ctx->w;
+    ctx->strip[0] = buf;
+    ctx->strip[1] = buf + ((size_t)ctx->stripCols * ctx->h);
+    ctx->stripIndex = 0;
+  }
+
+  return err;
+}
+
+UError_t Chart_Push(Chart_t* ctx, int32_t v) { return Chart_PushN(ctx, &v, 1); }
+
+UError_t Chart_PushN(Chart_t* ctx, const int32_t* v, size_t n) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == v) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (size_t i = 0; i < n; ++i) {
+      const int32_t s = v[i];
+      if (0 == ctx->accCount) {
+        // 前の列の最終値から繋がるように範囲を始める
+        const int32_t from = ctx->hasLast ? ctx->last : s;
+        ctx->accLo = (from < s) ? from : s;
+        ctx->accHi = (from > s) ? from : s;
+      } else {
+        ctx->accLo = (ctx->accLo < s) ? ctx->accLo : s;
+        ctx->accHi = (ctx->accHi > s) ? ctx->accHi : s;
+      }
+      ctx->last = s;
+      ctx->hasLast = true;
+
+      if (ctx->decimation <= ++ctx->accCount) {
+        commitColumn(ctx);
+      }
+    }
+  }
+
+  return err;
+}
+
+UError_t Chart_Invalidate(Chart_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->pending = ctx->w;
+  }
+
+  return err;
+}
+
+UError_t Chart_Render(Chart_t* ctx, const Canvas_t* canvas, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty) {
+  UError_t err = uSuccess;
+  size_t nd = 0;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 未描画の列は head の直前の pending 列. 右端で折り返す場合は 2回に分ける
+    uint32_t col = (ctx->pending <= ctx->head) ? ctx->head - ctx->pending : ctx->head + ctx->w - ctx->pending;
+    uint32_t remain = ctx->pending;
+    while (0 < remain) {
+      const uint32_t n = (ctx->w - col < remain) ? ctx->w - col : remain;
+      drawColumns(ctx, canvas, ctx->x + col, ctx->y, col, n);
+      if (NULL != dirty && nd < maxDirty) {
+        dirty[nd].x = ctx->x + col;
+        dirty[nd].y = ctx->y;
+        dirty[nd].w = n;
+        dirty[nd].h = ctx->h;
+        nd++;
+      }
+      remain -= n;
+      col = 0;
+    }
+    ctx->pending = 0;
+
+    if (NULL != nDirty) {
+      *nDirty = nd;
+    }
+  }
+
+  return err;
+}
+
+UError_t Chart_Flush(Chart_t* ctx, LCDDrvHandle_t lcd) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == lcd || 0 == ctx->stripCols) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    uint32_t col = (ctx->pending <= ctx->head) ? ctx->head - ctx->pending : ctx->head + ctx->w - ctx->pending;
+    while (0 < ctx->pending) {
+      uint32_t n = ctx->w - col;
+      n = (n < ctx->pending) ? n : ctx->pending;
+      n = (n < ctx->stripCols) ? n : ctx->stripCols;
+
+      // 転送中でない面へ n 列分の細長い画像を描画する
+      Canvas_t strip;
+      (void)Canvas_Create(&strip, n, ctx->h, n, ctx->strip[ctx->stripIndex]);
+      drawColumns(ctx, &strip, 0, 0, col, n);
+
+      err = LCDDrv_SwapBuff(lcd, strip.buf, ctx->x + col, ctx->y, n, ctx->h);
+      if (uSuccess != err) {
+        break;
+      }
+      ctx->stripIndex ^= 1;
+      ctx->pending -= n;
+      col = (col + n < ctx->w) ? col + n : 0;
+    }
+  }
+
+  return err;
+}
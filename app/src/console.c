@@ -0,0 +1,401 @@
+/**
+ * @file prog01/app/src/console.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/console.h>
+#include <user/font.h>
+#include <user/glyphcache.h>
+#include <user/macros.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CONSOLE_ALL_ROWS(ROWS) ((CONSOLE_MAX_ROWS <= (ROWS)) ? ~(uint64_t)0 : (((uint64_t)1 << (ROWS)) - 1))
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 表示上の行 row に対応するリング上の行の先頭セルを取得する
+ */
+inline static ConsoleCell_t* rowCells(const Console_t* ctx, uint32_t row);
+
+/**
+ * @brief 表示上の行 row を空白で埋める
+ */
+inline static void blankRow(Console_t* ctx, uint32_t row);
+
+/**
+ * @brief カーソルを次の行の先頭へ移動する. 最終行の場合はスクロールする.
+ */
+static void newLine(Console_t* ctx);
+
+/**
+ * @brief 1セルを描画する
+ */
+static void drawCell(const Console_t* ctx, const FontIndex_t* font, uint32_t px, uint32_t py, const ConsoleCell_t* cell);
+
+/**
+ * @brief Console_Render() / Console_RenderScroll() の本体
+ * @param [out] scroll : スクロール量の格納先 (NULL: スクロールした場合は全ての行を報告する)
+ */
+static UError_t render(Console_t* ctx, uint32_t* scroll, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 初期パレット (CGA 16色)
+ */
+static const uint16_t defaultPalette[16] = {
+    RGB888toRGB565(0x00, 0x00, 0x00), RGB888toRGB565(0x00, 0x00, 0xaa), RGB888toRGB565(0x00, 0xaa, 0x00), RGB888toRGB565(0x00, 0xaa, 0xaa),
+    RGB888toRGB565(0xaa, 0x00, 0x00), RGB888toRGB565(0xaa, 0x00, 0xaa), RGB888toRGB565(0xaa, 0x55, 0x00), RGB888toRGB565(0xaa, 0xaa, 0xaa),
+    RGB888toRGB565(0x55, 0x55, 0x55), RGB888toRGB565(0x55, 0x55, 0xff), RGB888toRGB565(0x55, 0xff, 0x55), RGB888toRGB565(0x55, 0xff, 0xff),
+    RGB888toRGB565(0xff, 0x55, 0x55), RGB888toRGB565(0xff, 0x55, 0xff), RGB888toRGB565(0xff, 0xff, 0x55), RGB888toRGB565(0xff, 0xff, 0xff),
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+inline static ConsoleCell_t* rowCells(const Console_t* ctx, uint32_t row) {
+  uint32_t r = ctx->top + row;
+  if (ctx->rows <= r) {
+    r -= ctx->rows;
+  }
+  return &ctx->cells[r * ctx->cols];
+}
+
+inline static void blankRow(Console_t* ctx, uint32_t row) {
+  ConsoleCell_t* const cells = rowCells(ctx, row);
+  for (uint32_t i = 0; i < ctx->cols; ++i) {
+    cells[i].code = ' ';
+    cells[i].attr = ctx->attr;
+  }
+  ctx->dirty |= (uint64_t)1 << row;
+}
+
+static void newLine(Console_t* ctx) {
+  ctx->cx = 0;
+  if (ctx->cy + 1 < ctx->rows) {
+    ctx->cy++;
+  } else {
+    // リングの先頭を進め, 新しい最終行を空白にする. 描画済みの行は Render 時に画像ごと移動する
+    ctx->top = (ctx->top + 1 < ctx->rows) ? ctx->top + 1 : 0;
+    ctx->dirty >>= 1;
+    if (ctx->scrolled < ctx->rows) {
+      ctx->scrolled++;
+    }
+    blankRow(ctx, ctx->rows - 1);
+  }
+}
+
+static void drawCell(const Console_t* ctx, const FontIndex_t* font, uint32_t px, uint32_t py, const ConsoleCell_t* cell) {
+  const uint16_t fg = ctx->palette[cell->attr & 0x0f];
+  const uint16_t bg = ctx->palette[cell->attr >> 4];
+  uint32_t fw = 0;
+  uint32_t fh = 0;
+  const uint8_t* graph = Font_FindGlyph(font, cell->code, &fw, &fh, NULL);
+
+  if (NULL == graph) {
+    (void)Canvas_FillRect(ctx->canvas, px, py, ctx->cw, ctx->ch, bg);
+    return;
+  }
+
+  if (NULL != ctx->cache) {
+    if (uSuccess == GlyphCache_Draw(ctx->cache, ctx->canvas, px, py, graph, fw, fh, fg, bg, 1)) {
+      return;
+    }
+  }
+
+  const size_t bpr = (fw + 7) / 8;  // 1ラインあたりのバイト数
+  for (uint32_t h = 0; h < fh; ++h) {
+    for (uint32_t w = 0; w < fw; ++w) {
+      const uint16_t c = (graph[w / 8] & (0x80u >> (w % 8))) ? fg : bg;
+      (void)Canvas_DrawPixel(ctx->canvas, px + w, py + h, c);
+    }
+    graph += bpr;
+  }
+}
+
+UError_t Console_Create(Console_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t cols, uint32_t rows, ConsoleCell_t* cells) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas || NULL == cells || 0 == cols || 0 == rows || CONSOLE_MAX_ROWS < rows) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->canvas = canvas;
+    ctx->x = x;
+    ctx->y = y;
+    ctx->cols = cols;
+    ctx->rows = rows;
+    ctx->cells = cells;
+    ctx->attr = CONSOLE_ATTR(15, 0);
+    ctx->cache = NULL;
+    for (size_t i = 0; i < 16; ++i) {
+      ctx->palette[i] = defaultPalette[i];
+    }
+    err = Console_SetFont(ctx, FONT_ID_ANK);
+  }
+
+  if (uSuccess == err) {
+    err = Console_Clear(ctx);
+  }
+
+  return err;
+}
+
+UError_t Console_SetFont(Console_t* ctx, FontId_t font) {
+  UError_t err = uSuccess;
+  const FontIndex_t* idx = NULL;
+
+  if (uSuccess == err) {
+    idx = Font_Get(font);
+    if (NULL == ctx || NULL == idx || 0 != idx->type) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->font = font;
+    ctx->cw = idx->fw;
+    ctx->ch = idx->fh;
+    ctx->dirty = CONSOLE_ALL_ROWS(ctx->rows);
+    ctx->scrolled = 0;
+  }
+
+  return err;
+}
+
+UError_t Console_SetGlyphCache(Console_t* ctx, GlyphCache_t* cache) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cache = cache;
+  }
+
+  return err;
+}
+
+UError_t Console_SetPalette(Console_t* ctx, uint32_t index, uint16_t c) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || 16 <= index) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->palette[index] = c;
+    ctx->dirty = CONSOLE_ALL_ROWS(ctx->rows);
+  }
+
+  return err;
+}
+
+UError_t Console_SetAttr(Console_t* ctx, uint8_t attr) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->attr = attr;
+  }
+
+  return err;
+}
+
+UError_t Console_Clear(Console_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->cells) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->top = 0;
+    ctx->cx = 0;
+    ctx->cy = 0;
+    ctx->scrolled = 0;
+    for (uint32_t r = 0; r < ctx->rows; ++r) {
+      blankRow(ctx, r);
+    }
+  }
+
+  return err;
+}
+
+UError_t Console_Write(Console_t* ctx, const char* s, size_t n) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->cells || NULL == s) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (size_t i = 0; i < n; ++i) {
+      const uint8_t c = (uint8_t)s[i];
+      if (0x20 <= c && 0x7f != c) {
+        if (ctx->cols <= ctx->cx) {
+          // 行末を超える文字は次の行へ折り返す
+          newLine(ctx);
+        }
+        ConsoleCell_t* const cell = &rowCells(ctx, ctx->cy)[ctx->cx];
+        cell->code = c;
+        cell->attr = ctx->attr;
+        ctx->dirty |= (uint64_t)1 << ctx->cy;
+        ctx->cx++;
+      } else if ('\n' == c) {
+        newLine(ctx);
+      } else if ('\r' == c) {
+        ctx->cx = 0;
+      } else if ('\t' == c) {
+        const uint32_t next = ((ctx->cx / CONSOLE_TAB_WIDTH) + 1) * CONSOLE_TAB_WIDTH;
+        ConsoleCell_t* const cells = rowCells(ctx, ctx->cy);
+        while (ctx->cx < next && ctx->cx < ctx->cols) {
+          cells[ctx->cx].code = ' ';
+          cells[ctx->cx].attr = ctx->attr;
+          ctx->cx++;
+        }
+        ctx->dirty |= (uint64_t)1 << ctx->cy;
+      } else if ('\b' == c) {
+        if (0 < ctx->cx) {
+          // 折り返し待ちの状態からは最終桁へ戻る
+          ctx->cx = (ctx->cols <= ctx->cx) ? ctx->cols - 1 : ctx->cx - 1;
+        }
+      } else {
+        // その他の制御文字は無視する
+      }
+    }
+  }
+
+  return err;
+}
+
+static UError_t render(Console_t* ctx, uint32_t* scroll, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty) {
+  UError_t err = uSuccess;
+  const FontIndex_t* font = NULL;
+  size_t nd = 0;
+
+  if (uSuccess == err) {
+    font = (NULL != ctx) ? Font_Get(ctx->font) : NULL;
+    if (NULL == ctx || NULL == ctx->canvas || NULL == font) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const uint32_t w = ctx->cols * ctx->cw;
+    uint32_t moved = 0;
+    if (0 < ctx->scrolled) {
+      if (ctx->scrolled < ctx->rows) {
+        // 描画済みの行を画像ごと上へ移動する
+        (void)Canvas_Scroll(ctx->canvas, ctx->x, ctx->y, w, ctx->rows * ctx->ch, 0, -(int32_t)(ctx->scrolled * ctx->ch), ctx->palette[ctx->attr >> 4]);
+        moved = ctx->scrolled * ctx->ch;
+      } else {
+        ctx->dirty = CONSOLE_ALL_ROWS(ctx->rows);
+      }
+      ctx->scrolled = 0;
+    }
+
+    // 表示側でもスクロールする場合は再描画した行 (新たに現れた行を含む) のみ, それ以外はスクロールした全ての行を報告する
+    const uint64_t report = (NULL != scroll || 0 == moved) ? ctx->dirty : CONSOLE_ALL_ROWS(ctx->rows);
+    if (NULL != scroll) {
+      *scroll = moved;
+    }
+
+    for (uint32_t r = 0; r < ctx->rows; ++r) {
+      const uint32_t py = ctx->y + (r * ctx->ch);
+      if (0 != (ctx->dirty & ((uint64_t)1 << r))) {
+        const ConsoleCell_t* const cells = rowCells(ctx, r);
+#if CANVAS_OVERDRAW
+        const CanvasPrim_t prev = Canvas_BeginOverdraw(ctx->canvas, CanvasPrimText);
+#endif
+        for (uint32_t i = 0; i < ctx->cols; ++i) {
+          drawCell(ctx, font, ctx->x + (i * ctx->cw), py, &cells[i]);
+        }
+#if CANVAS_OVERDRAW
+        Canvas_EndOverdraw(ctx->canvas, prev);
+#endif
+      }
+
+      if (0 != (report & ((uint64_t)1 << r)) && NULL != dirty && 0 < maxDirty) {
+        CanvasRect_t* const last = (0 < nd) ? &dirty[nd - 1] : NULL;
+        if (NULL != last && (uint32_t)(last->y + last->h) == py) {
+          last->h += ctx->ch;
+        } else if (nd < maxDirty) {
+          dirty[nd].x = ctx->x;
+          dirty[nd].y = py;
+          dirty[nd].w = w;
+          dirty[nd].h = ctx->ch;
+          nd++;
+        } else {
+          // 格納先が不足する場合は最後の矩形を拡張する
+          last->h = py + ctx->ch - last->y;
+        }
+      }
+    }
+    ctx->dirty = 0;
+
+    if (NULL != nDirty) {
+      *nDirty = nd;
+    }
+  }
+
+  return err;
+}
+
+UError_t Console_Render(Console_t* ctx, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty) {
+  return render(ctx, NULL, dirty, maxDirty, nDirty);
+}
+
+UError_t Console_RenderScroll(Console_t* ctx, uint32_t* scroll, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == scroll) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = render(ctx, scroll, dirty, maxDirty, nDirty);
+  }
+
+  return err;
+}
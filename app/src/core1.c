@@ -0,0 +1,78 @@
+/**
+ * @file prog01/app/src/core1.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pico/multicore.h>
+
+#include <user/core1.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static atomic_bool launched = false;  //< core1 を起動済み
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+UError_t Core1_Launch(void (*entry)(void)) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == entry) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 起動済みの判定と設定を 1回の操作で行う
+    if (atomic_exchange(&launched, true)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    multicore_launch_core1(entry);
+  }
+
+  return err;
+}
+
+UError_t Core1_Reset(void) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (!atomic_load(&launched)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    multicore_reset_core1();
+    atomic_store(&launched, false);
+  }
+
+  return err;
+}
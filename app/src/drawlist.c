@@ -0,0 +1,292 @@
+/**
+ * @file prog01/app/src/drawlist.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/drawlist.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define DRAWLIST_ALL_ROWS (0xffffu)  //< 影響する行の範囲が不明 (画面全体)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 命令を 1つ追加する
+ * @param [inout] ctx : 操作対象
+ * @param [in] type : 命令の種類
+ * @param [in] top : 影響する最初の行
+ * @param [in] bottom : 影響する最後の行の次
+ * @param [out] cmd : 追加した命令 (引数は呼び出し側で設定する)
+ * @return 処理結果
+ */
+static UError_t append(DrawList_t* ctx, DrawCmdType_t type, size_t top, size_t bottom, DrawCmd_t** cmd);
+
+/**
+ * @brief 1命令を実行する
+ */
+static UError_t execute(const DrawCmd_t* cmd, const Canvas_t* canvas);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t append(DrawList_t* ctx, DrawCmdType_t type, size_t top, size_t bottom, DrawCmd_t** cmd) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || ctx->cap <= ctx->n) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (bottom < top) {
+      // 負の座標を size_t で表した結果, 範囲が周回した場合は画面全体とみなす
+      top = 0;
+      bottom = DRAWLIST_ALL_ROWS;
+    }
+    DrawCmd_t* const e = &ctx->cmds[ctx->n++];
+    e->type = type;
+    e->c = 0;
+    e->top = (uint16_t)((DRAWLIST_ALL_ROWS < top) ? DRAWLIST_ALL_ROWS : top);
+    e->bottom = (uint16_t)((DRAWLIST_ALL_ROWS < bottom) ? DRAWLIST_ALL_ROWS : bottom);
+    *cmd = e;
+  }
+
+  return err;
+}
+
+static UError_t execute(const DrawCmd_t* cmd, const Canvas_t* canvas) {
+  const size_t* const p = cmd->p;
+
+  switch (cmd->type) {
+    case DrawCmdClear:
+      return Canvas_Clear(canvas, cmd->c);
+    case DrawCmdPixel:
+      (void)Canvas_DrawPixel(canvas, p[0], p[1], cmd->c);
+      break;
+    case DrawCmdLine:
+      (void)Canvas_DrawLine(canvas, p[0], p[1], p[2], p[3], cmd->c);
+      break;
+    case DrawCmdCircle:
+      (void)Canvas_DrawCircle(canvas, p[0], p[1], p[2], cmd->c);
+      break;
+    case DrawCmdFillCircle:
+      (void)Canvas_DrawFillCircle(canvas, p[0], p[1], p[2], cmd->c);
+      break;
+    case DrawCmdFillRect:
+      (void)Canvas_FillRect(canvas, p[0], p[1], p[2], p[3], cmd->c);
+      break;
+    case DrawCmdBlit:
+      (void)Canvas_Blit(canvas, p[0], p[1], p[2], p[3], cmd->u.blit.src, cmd->u.blit.ss);
+      break;
+    case DrawCmdCall:
+      return cmd->u.call.func(canvas, cmd->u.call.arg);
+    default:
+      return uFailure;
+  }
+
+  // 領域外による失敗は, クリップされたものとして扱う
+  return uSuccess;
+}
+
+UError_t DrawList_Create(DrawList_t* ctx, DrawCmd_t* cmds, size_t cap) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == cmds || 0 == cap) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cmds = cmds;
+    ctx->cap = cap;
+    ctx->n = 0;
+  }
+
+  return err;
+}
+
+UError_t DrawList_Reset(DrawList_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->n = 0;
+  }
+
+  return err;
+}
+
+UError_t DrawList_Clear(DrawList_t* ctx, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdClear, 0, DRAWLIST_ALL_ROWS, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+  }
+  return err;
+}
+
+UError_t DrawList_DrawPixel(DrawList_t* ctx, size_t x, size_t y, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdPixel, y, y + 1, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+    cmd->p[0] = x;
+    cmd->p[1] = y;
+  }
+  return err;
+}
+
+UError_t DrawList_DrawLine(DrawList_t* ctx, size_t x1, size_t y1, size_t x2, size_t y2, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdLine, (y1 < y2) ? y1 : y2, ((y1 < y2) ? y2 : y1) + 1, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+    cmd->p[0] = x1;
+    cmd->p[1] = y1;
+    cmd->p[2] = x2;
+    cmd->p[3] = y2;
+  }
+  return err;
+}
+
+UError_t DrawList_DrawCircle(DrawList_t* ctx, size_t x, size_t y, size_t r, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdCircle, (r < y) ? y - r : 0, y + r + 1, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+    cmd->p[0] = x;
+    cmd->p[1] = y;
+    cmd->p[2] = r;
+  }
+  return err;
+}
+
+UError_t DrawList_DrawFillCircle(DrawList_t* ctx, size_t x, size_t y, size_t r, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdFillCircle, (r < y) ? y - r : 0, y + r + 1, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+    cmd->p[0] = x;
+    cmd->p[1] = y;
+    cmd->p[2] = r;
+  }
+  return err;
+}
+
+UError_t DrawList_FillRect(DrawList_t* ctx, size_t x, size_t y, size_t w, size_t h, uint16_t c) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = append(ctx, DrawCmdFillRect, y, y + h, &cmd);
+  if (uSuccess == err) {
+    cmd->c = c;
+    cmd->p[0] = x;
+    cmd->p[1] = y;
+    cmd->p[2] = w;
+    cmd->p[3] = h;
+  }
+  return err;
+}
+
+UError_t DrawList_Blit(DrawList_t* ctx, size_t x, size_t y, size_t w, size_t h, const uint16_t* src, size_t ss) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = (NULL == src) ? uFailure : append(ctx, DrawCmdBlit, y, y + h, &cmd);
+  if (uSuccess == err) {
+    cmd->p[0] = x;
+    cmd->p[1] = y;
+    cmd->p[2] = w;
+    cmd->p[3] = h;
+    cmd->u.blit.src = src;
+    cmd->u.blit.ss = ss;
+  }
+  return err;
+}
+
+UError_t DrawList_Call(DrawList_t* ctx, DrawListFunc_t func, void* arg) {
+  DrawCmd_t* cmd = NULL;
+  UError_t err = (NULL == func) ? uFailure : append(ctx, DrawCmdCall, 0, DRAWLIST_ALL_ROWS, &cmd);
+  if (uSuccess == err) {
+    cmd->u.call.func = func;
+    cmd->u.call.arg = arg;
+  }
+  return err;
+}
+
+UError_t DrawList_Execute(const DrawList_t* ctx, const Canvas_t* canvas) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t top = canvas->clip.y;
+    const size_t bottom = (size_t)canvas->clip.y + canvas->clip.h;
+    for (size_t i = 0; i < ctx->n; ++i) {
+      const DrawCmd_t* const cmd = &ctx->cmds[i];
+      // 描画できる領域と行が重ならない命令は実行しない
+      if (bottom <= cmd->top || cmd->bottom <= top) {
+        continue;
+      }
+      const UError_t e = execute(cmd, canvas);
+      err = (uSuccess == err) ? e : err;
+    }
+  }
+
+  return err;
+}
+
+UError_t DrawList_ExecuteBand(const DrawList_t* ctx, const Canvas_t* canvas, size_t y, size_t h) {
+  UError_t err = uSuccess;
+  Canvas_t band;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 同じバッファを指し, 描画できる領域だけを帯に狭めたキャンバスへ再生する
+    const size_t top = (y > canvas->clip.y) ? y : canvas->clip.y;
+    size_t bottom = (SIZE_MAX - y < h) ? SIZE_MAX : y + h;
+    bottom = (bottom < (size_t)canvas->clip.y + canvas->clip.h) ? bottom : (size_t)canvas->clip.y + canvas->clip.h;
+    band = *canvas;
+    err = Canvas_SetClip(&band, canvas->clip.x, top, canvas->clip.w, (top < bottom) ? bottom - top : 0);
+  }
+
+  if (uSuccess == err && 0 < band.clip.h) {
+    err = DrawList_Execute(ctx, &band);
+  }
+
+  return err;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file prog01/app/src/drawrec.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <user/canvas.h>
+#include <user/drawrec.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define VARINT_MAX (5)  //< uint32_t の符号なし LEB128 の最大バイト数
+
+// キャンバスの定義 + 描画できる領域の変更 + 操作 (それぞれ 種類 + 番号 + 引数)
+#define RECORD_MAX ((2 + (10 * VARINT_MAX)) + (2 + (4 * VARINT_MAX)) + (2 + (DRAWREC_MAX_ARGS * VARINT_MAX)))
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief v を符号なし LEB128 で out へ書き込む
+ * @return 書き込んだバイト数
+ */
+inline static size_t putVarint(uint8_t* out, uint32_t v);
+
+/**
+ * @brief 記録をまとめて追加する. 入りきらない場合は DrawRec_Drain() まで記録を止める.
+ * @return 追加できた場合 true
+ */
+static bool append(DrawRec_t* ctx, const uint8_t* rec, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+DrawRec_t* DrawRec_Current = NULL;
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+inline static size_t putVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (0x80u <= v) {
+    out[n++] = (uint8_t)(0x80u | (v & 0x7fu));
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+static bool append(DrawRec_t* ctx, const uint8_t* rec, size_t size) {
+  // 一度失ったら, 再生できない途中からの記録を残さないよう DrawRec_Drain() まで止める
+  if (0 < ctx->dropped || ctx->cap - ctx->len < size) {
+    ++ctx->dropped;
+    return false;
+  }
+  memcpy(ctx->buf + ctx->len, rec, size);
+  ctx->len += size;
+  return true;
+}
+
+UError_t DrawRec_Create(DrawRec_t* ctx, void* buf, size_t cap) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == buf || 0 == cap) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(ctx, 0, sizeof(DrawRec_t));
+    ctx->buf = (uint8_t*)buf;
+    ctx->cap = cap;
+  }
+
+  return err;
+}
+
+UError_t DrawRec_Attach(DrawRec_t* ctx) {
+  DrawRec_Current = ctx;
+  return uSuccess;
+}
+
+UError_t DrawRec_EndFrame(DrawRec_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const uint8_t rec = DrawRecOpFrame;
+    if (0 == ctx->dropped && append(ctx, &rec, sizeof(rec))) {
+      ++ctx->frames;
+    }
+  }
+
+  return err;
+}
+
+UError_t DrawRec_Drain(DrawRec_t* ctx, DrawRecWriteFn_t write, void* arg) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == write) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err && (0 < ctx->len || 0 < ctx->dropped)) {
+    DrawRecChunk_t chunk;
+    memcpy(chunk.magic, DRAWREC_MAGIC, sizeof(chunk.magic));
+    chunk.version = DRAWREC_VERSION;
+    chunk.frames = ctx->frames;
+    chunk.size = (uint32_t)ctx->len;
+    chunk.dropped = ctx->dropped;
+
+    err = write(arg, &chunk, sizeof(chunk));
+    if (uSuccess == err && 0 < ctx->len) {
+      err = write(arg, ctx->buf, ctx->len);
+    }
+
+    // 書き出しに失敗した場合も空にする (次のチャンクを単独で再生できるようにする)
+    ctx->len = 0;
+    ctx->frames = 0;
+    ctx->dropped = 0;
+    ctx->nCanvases = 0;
+  }
+
+  return err;
+}
+
+void DrawRec_PutCanvas(DrawRec_t* ctx, const Canvas_t* canvas, DrawRecOp_t op, const uint32_t* args, size_t n) {
+  if (NULL == ctx || NULL == canvas || NULL == canvas->buf || DRAWREC_MAX_ARGS < n) {
+    // 何も描画しない呼び出し
+    return;
+  }
+  if (0 < ctx->dropped) {
+    ++ctx->dropped;
+    return;
+  }
+
+  uint8_t rec[RECORD_MAX];
+  size_t size = 0;
+
+  // 定義済みのキャンバスを探す
+  size_t id = 0;
+  while (id < ctx->nCanvases) {
+    const Canvas_t* const known = &ctx->canvases[id];
+    if (known->buf == canvas->buf && known->w == canvas->w && known->h == canvas->h && known->s == canvas->s && known->fmt == canvas->fmt) {
+      break;
+    }
+    ++id;
+  }
+
+  const CanvasRect_t* const clip = &canvas->clip;
+  if (id == ctx->nCanvases) {
+    if (DRAWREC_CANVASES <= id) {
+      ++ctx->dropped;
+      return;
+    }
+    const uint32_t def[] = {(uint32_t)(uintptr_t)canvas->buf, (uint32_t)canvas->w, (uint32_t)canvas->h, (uint32_t)canvas->s, (uint32_t)canvas->fmt,
+                            clip->x, clip->y, clip->w, clip->h};
+    rec[size++] = DrawRecOpCanvas;
+    rec[size++] = (uint8_t)id;
+    for (size_t i = 0; i < sizeof(def) / sizeof(def[0]); ++i) {
+      size += putVarint(rec + size, def[i]);
+    }
+  } else {
+    const CanvasRect_t* const known = &ctx->canvases[id].clip;
+    if (known->x != clip->x || known->y != clip->y || known->w != clip->w || known->h != clip->h) {
+      rec[size++] = DrawRecOpClip;
+      rec[size++] = (uint8_t)id;
+      size += putVarint(rec + size, clip->x);
+      size += putVarint(rec + size, clip->y);
+      size += putVarint(rec + size, clip->w);
+      size += putVarint(rec + size, clip->h);
+    }
+  }
+
+  rec[size++] = (uint8_t)op;
+  rec[size++] = (uint8_t)id;
+  for (size_t i = 0; i < n; ++i) {
+    size += putVarint(rec + size, args[i]);
+  }
+
+  if (append(ctx, rec, size)) {
+    if (id == ctx->nCanvases) {
+      ++ctx->nCanvases;
+    }
+    ctx->canvases[id] = *canvas;
+  }
+}
+
+void DrawRec_PutText(DrawRec_t* ctx, int32_t ank, int32_t kanji, const char* sz) {
+  if (NULL == ctx || NULL == sz) {
+    return;
+  }
+  if (0 < ctx->dropped) {
+    ++ctx->dropped;
+    return;
+  }
+
+  const size_t len = strlen(sz);
+  uint8_t head[1 + (3 * VARINT_MAX)];
+  size_t size = 0;
+  head[size++] = DrawRecOpText;
+  size += putVarint(head + size, (uint32_t)ank);
+  size += putVarint(head + size, (uint32_t)kanji);
+  size += putVarint(head + size, (uint32_t)len);
+
+  // 文字列はまとめて追加する (途中で切れた記録を残さない)
+  if (ctx->cap - ctx->len < size + len) {
+    ++ctx->dropped;
+    return;
+  }
+  (void)append(ctx, head, size);
+  (void)append(ctx, (const uint8_t*)sz, len);
+}
@@ -8,8 +8,10 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <string.h>
 
+#include <user/apiprof.h>
+#include <user/drawrec.h>
 #include <user/font.h>
 #include <user/types.h>
 
@@ -17,6 +19,10 @@
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+#define FONTX2_HEADER_SIZE (17)  //< 識別子(6) + フォント名(8) + 幅(1) + 高さ(1) + コード種別(1)
+#define ANK_FW (4)               //< 組み込み ANK フォントの幅 (font/4X8.h のヘッダと一致させる)
+#define ANK_FH (8)               //< 組み込み ANK フォントの高さ
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
@@ -25,84 +31,185 @@
 // prototype
 //////////////////////////////////////////////////////////////////////////////
 /**
- * @brief FONTX2 データからcodeに該当するフォントイメージの先頭を指すポインタを取得します.
- * @param [in] font : 対象とするフォントデータ
- * @param [in] code : 文字コード JIS(7bit) or SJIS(16bit)
- * @param [out] pw : フォントデータの幅 (ドット)
- * @param [out] ph : フォントデータの高さ (ドット)
- * @param [out] pfsz : フォントデータサイズ(バイト)
- * @return フォントデータの先頭を指すポインタ
- * @retval NULL 以外 : フォントデータの先頭を指すポインタ
- * @retval NULL : 該当データなし
+ * @brief UTF-8 の 1文字を復号します.
+ * @param [in] s : 復号対象 (先頭バイトは 0xc2 - 0xf4)
+ * @param [out] cp : コードポイント
+ * @return 消費したバイト数
+ * @retval 0 : 不正なシーケンス (途中の終端, 冗長表現, サロゲート, 範囲外)
  */
-inline static const uint8_t* getFont(const uint8_t* font, const uint16_t code, uint32_t* const pw, uint32_t* const ph, size_t* const pfsz);
+inline static size_t utf8Decode(const uint8_t* s, uint32_t* const cp);
 
 //////////////////////////////////////////////////////////////////////////////
 // variable
 //////////////////////////////////////////////////////////////////////////////
 #include "font/4X8.h"
+#include "font/uni2sjis.h"
+
+/**
+ * 登録済みフォント
+ *
+ * [FONT_ID_ANK] の組み込み ANK フォントは静的に初期化し, 実行時の登録処理を行いません.
+ * (両コアから同時に Font_Get() を呼び出しても書き込みが発生しない)
+ */
+static FontIndex_t registry[FONT_REGISTRY_MAX] = {
+    [FONT_ID_ANK] =
+        {
+            .font = ank,
+            .glyphs = &ank[FONTX2_HEADER_SIZE],
+            .fw = ANK_FW,
+            .fh = ANK_FH,
+            .fsz = (ANK_FW + 7) / 8 * ANK_FH,
+            .type = 0,
+            .nblk = 0,
+            .blk = NULL,
+        },
+};
+static size_t registered = 1;                    //< 登録数 (組み込みフォントを含む)
+static FontId_t defaultAnk = FONT_ID_ANK;        //< Font_Print() が半角文字に使用するフォント
+static FontId_t defaultKanji = FONT_ID_NONE;     //< Font_Print() が全角文字に使用するフォント
 
 //////////////////////////////////////////////////////////////////////////////
 // function
 //////////////////////////////////////////////////////////////////////////////
 
-inline static const uint8_t* getFont(const uint8_t* font, const uint16_t code, uint32_t* const pw, uint32_t* const ph, size_t* const pfsz) {
+inline static size_t utf8Decode(const uint8_t* s, uint32_t* const cp) {
+  size_t len = 0;
+  uint32_t v = 0;
+  uint32_t min = 0;
+
+  if (0xdf >= s[0]) {
+    len = 2;
+    v = s[0] & 0x1f;
+    min = 0x80;
+  } else if (0xef >= s[0]) {
+    len = 3;
+    v = s[0] & 0x0f;
+    min = 0x800;
+  } else {
+    len = 4;
+    v = s[0] & 0x07;
+    min = 0x10000;
+  }
+
+  // 継続バイトは 0x80 - 0xbf. 終端(0x00) もここで弾かれる
+  for (size_t n = 1; n < len; ++n) {
+    if (0x80 != (s[n] & 0xc0)) {
+      return 0;
+    }
+    v = (v << 6) | (s[n] & 0x3f);
+  }
+
+  if (v < min || 0x10ffff < v || (0xd800 <= v && 0xdfff >= v)) {
+    return 0;
+  }
+
+  *cp = v;
+  return len;
+}
+
+uint16_t Font_UnicodeToSJIS(const uint32_t cp) {
+  if (0xffff < cp) {
+    return 0;
+  }
+
+  const uint8_t p = uni2sjisIndex[cp >> 8];
+  if (0 == p) {
+    return 0;
+  }
+
+  const Uni2SjisPage_t* const page = &uni2sjisPage[p - 1];
+  const uint32_t w = (cp >> 5) & 0x07;
+  const uint32_t bit = cp & 0x1f;
+  const uint32_t bits = page->bits[w];
+  if (0 == (bits & (1u << bit))) {
+    return 0;
+  }
+
+  return uni2sjisCode[page->base + page->rank[w] + __builtin_popcount(bits & ((1u << bit) - 1))];
+}
+
+UError_t Font_Register(const void* image, size_t size, FontIndexBlock_t* blocks, size_t nblocks, FontId_t* id) {
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
-    if (NULL == font) {
+    if (NULL == image || NULL == id) {
       err = uFailure;
     }
   }
 
   if (uSuccess == err) {
-    size_t fsz = (font[14] + 7) / 8 * font[15];  // フォントサイズの取得
-
-    if (NULL != pw) {
-      *pw = font[14];
+    if (FONT_REGISTRY_MAX <= registered) {
+      err = uFailure;
     }
+  }
 
-    if (NULL != ph) {
-      *ph = font[15];
-    }
+  if (uSuccess == err) {
+    err = Font_BuildIndex(&registry[registered], image, size, blocks, nblocks);
+  }
+
+  if (uSuccess == err) {
+    *id = (FontId_t)registered;
+    registered++;
+  }
+
+  return err;
+}
+
+const FontIndex_t* Font_Get(const FontId_t id) {
+  if (0 > id || (FontId_t)registered <= id) {
+    return NULL;
+  }
+  return &registry[id];
+}
+
+UError_t Font_SetDefault(const FontId_t ank, const FontId_t kanji) {
+  UError_t err = uSuccess;
 
-    if (NULL != pfsz) {
-      *pfsz = fsz;
+  if (uSuccess == err) {
+    const FontIndex_t* const a = Font_Get(ank);
+    if (NULL == a || 0 != a->type) {
+      err = uFailure;
     }
+  }
 
-    if (0 == font[16]) {
-      if (code < 0x100) {
-        return &font[17 + code * fsz];
-      }
-    } else {
-      const uint8_t* cblk = &font[18];
-      size_t nc = 0;
-      size_t bc = font[17];
-      while (bc--) {
-        size_t sb = cblk[0] + cblk[1] * 0x100;
-        size_t eb = cblk[2] + cblk[3] * 0x100;
-        if (code >= sb && code <= eb) {
-          nc += code - sb;
-          return &font[18 + 4 + font[17] + nc * fsz];
-        }
-        nc += eb - sb + 1;
-        cblk += 4;
+  if (uSuccess == err) {
+    if (FONT_ID_NONE != kanji) {
+      const FontIndex_t* const k = Font_Get(kanji);
+      if (NULL == k || 0 == k->type) {
+        err = uFailure;
       }
-    }  // if(0 == font[16])...
+    }
   }
 
-  return NULL;
+  if (uSuccess == err) {
+    defaultAnk = ank;
+    defaultKanji = kanji;
+  }
+
+  return err;
 }
 
-UError_t Font_Print(const char* sz, Font_DrawFontFn_t fn, void* arg) {
+UError_t Font_Print(const char* sz, Font_DrawFontFn_t fn, void* arg) { return Font_PrintWith(defaultAnk, defaultKanji, sz, fn, arg); }
+
+UError_t Font_PrintWith(const FontId_t ank, const FontId_t kanji, const char* sz, Font_DrawFontFn_t fn, void* arg) {
+  APIPROF_BEGIN(ApiProfFontPrintWith);
   UError_t err = uSuccess;
+  const FontIndex_t* const ankFont = Font_Get(ank);
+  const FontIndex_t* const kanjiFont = Font_Get(kanji);
 
   if (uSuccess == err) {
-    if (NULL == sz || NULL == fn) {
+    if (NULL == sz || NULL == fn || NULL == ankFont) {
       err = uFailure;
     }
   }
 
+#if CANVAS_RECORD
+  if (uSuccess == err && NULL != DrawRec_Current) {
+    // 描画関数が呼び出す Canvas_* とは別に, 文字列の解釈を再生できるよう記録する
+    DrawRec_PutText(DrawRec_Current, ank, kanji, sz);
+  }
+#endif
+
   if (uSuccess == err) {
     int32_t px = 0;  // 水平位置
     int32_t py = 0;  // 垂直位置
@@ -116,15 +223,12 @@ UError_t Font_Print(const char* sz, Font_DrawFontFn_t fn, void* arg) {
         // ANK文字
         if ((0x20 <= c) && (0x7e >= c)) {
           // printable
-          pgraph = getFont(ank, c, &w, &h, &fsz);
+          pgraph = Font_FindGlyph(ankFont, c, &w, &h, &fsz);
           if (NULL != pgraph) {
             err = fn(arg, px, py, pgraph, c, w, h, fsz);
             if (uSuccess != err) {
               break;
             }
-          } else {
-            printf("[WARN] %s(): pgraph is null\n", __FUNCTION__);
-            printf("[WARN] ank[0x%08lx] c[%c] w[%lu] h[%lu] fsz[%lu]", (uint32_t)ank, c, w, h, fsz);
           }
           px += 1;
         } else if (0x7f == c) {
@@ -134,45 +238,184 @@ UError_t Font_Print(const char* sz, Font_DrawFontFn_t fn, void* arg) {
           px += 2;
         } else if (0x08 == c) {
           // bs : 何もしない
-        } else if (0x10 == c) {
-          // CR 改行
+        } else if (0x0a == c) {
+          // LF 改行
           px = 0;
           py++;
+        } else if (0x0d == c) {
+          // CR 行頭へ戻る
+          px = 0;
         } else {
           // 上記以外 1キャラクタ進める
           px += 1;
         }
-      } else if ((0xc2 <= c) && (0xdf >= c)) {
-        // UTF8 2byte
-        if (0 == *(sz + i)) {
-          break;
-        }
-        i += 1;
-        px += 2;
-      } else if ((0xe0 <= c) && (0xef >= c)) {
-        // UTF8 3byte
-        if ((0 == *(sz + i + 1)) || (0 == *(sz + i + 2))) {
-          break;
+      } else if ((0xc2 <= c) && (0xf4 >= c)) {
+        // UTF8 2-4byte
+        uint32_t cp = 0;
+        const size_t len = utf8Decode((const uint8_t*)(sz + i), &cp);
+        if (0 == len) {
+          // 不正なシーケンス : 先頭バイトを読み捨てて 1キャラクタ進める
+          px += 1;
+          continue;
         }
-        i += 2;
-        px += 2;
-      } else if ((0xf0 <= c) && (0xf4 >= c)) {
-        // UTF8 4byte
-        if ((0 == *(sz + i + 1)) || (0 == *(sz + i + 2))) {
-          break;
+        i += len - 1;
+
+        const uint16_t code = Font_UnicodeToSJIS(cp);
+        if (0 != code && 0x100 > code) {
+          // 半角カナ
+          pgraph = Font_FindGlyph(ankFont, code, &w, &h, &fsz);
+          if (NULL != pgraph) {
+            err = fn(arg, px, py, pgraph, code, w, h, fsz);
+            if (uSuccess != err) {
+              break;
+            }
+          }
+          px += 1;
+        } else {
+          // 全角文字 : 2キャラクタ分を占有する
+          pgraph = (0 != code) ? Font_FindGlyph(kanjiFont, code, &w, &h, &fsz) : NULL;
+          if (NULL != pgraph) {
+            err = fn(arg, px, py, pgraph, code, w, h, fsz);
+            if (uSuccess != err) {
+              break;
+            }
+          }
+          px += 2;
         }
-        i += 3;
-        px += 2;
       } else {
-        // unknown 2byte とする.
-        if (0 == *(sz + i)) {
-          break;
-        }
-        i += 1;
-        px += 2;
+        // UTF-8 の先頭になれないバイト (0x80 - 0xc1, 0xf5 - 0xff) : 1バイトを読み捨てて 1キャラクタ進める
+        px += 1;
       }
     }  // for(...
   }
 
+  APIPROF_END(ApiProfFontPrintWith);
+  return err;
+}
+
+UError_t Font_BuildIndex(FontIndex_t* idx, const void* font, size_t size, FontIndexBlock_t* blocks, size_t nblocks) {
+  UError_t err = uSuccess;
+  const uint8_t* const f = (const uint8_t*)font;
+
+  if (uSuccess == err) {
+    if (NULL == idx || NULL == f) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (FONTX2_HEADER_SIZE + 1 > size || 0 != memcmp(f, "FONTX2", 6)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (0 == f[14] || 0 == f[15] || 1 < f[16]) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    idx->font = f;
+    idx->fw = f[14];
+    idx->fh = f[15];
+    idx->fsz = (f[14] + 7) / 8 * f[15];
+    idx->type = f[16];
+    idx->nblk = 0;
+    idx->blk = NULL;
+
+    if (0 == idx->type) {
+      // 1バイトコード : 256文字分のグリフが必要
+      idx->glyphs = &f[FONTX2_HEADER_SIZE];
+      if (size < FONTX2_HEADER_SIZE + (0x100 * idx->fsz)) {
+        err = uFailure;
+      }
+    } else {
+      const size_t nb = f[17];
+      if (NULL == blocks || nblocks < nb || size < FONTX2_HEADER_SIZE + 1 + (4 * nb)) {
+        err = uFailure;
+      } else {
+        // グリフ番号の累計はファイル上のブロック順で求める
+        const uint8_t* cblk = &f[FONTX2_HEADER_SIZE + 1];
+        uint32_t nc = 0;
+        for (size_t i = 0; i < nb; ++i) {
+          blocks[i].sb = cblk[0] + cblk[1] * 0x100;
+          blocks[i].eb = cblk[2] + cblk[3] * 0x100;
+          blocks[i].base = nc;
+          if (blocks[i].sb > blocks[i].eb) {
+            err = uFailure;
+            break;
+          }
+          nc += blocks[i].eb - blocks[i].sb + 1;
+          cblk += 4;
+        }
+        if (uSuccess == err) {
+          if (size < FONTX2_HEADER_SIZE + 1 + (4 * nb) + (nc * idx->fsz)) {
+            err = uFailure;
+          }
+        }
+        if (uSuccess == err) {
+          // 開始コード順に整列 (ブロック数は高々 255 のため挿入ソート)
+          for (size_t i = 1; i < nb; ++i) {
+            const FontIndexBlock_t t = blocks[i];
+            size_t j = i;
+            while (0 < j && blocks[j - 1].sb > t.sb) {
+              blocks[j] = blocks[j - 1];
+              --j;
+            }
+            blocks[j] = t;
+          }
+          idx->glyphs = cblk;
+          idx->nblk = nb;
+          idx->blk = blocks;
+        }
+      }
+    }
+  }
+
   return err;
 }
+
+const uint8_t* Font_FindGlyph(const FontIndex_t* idx, const uint16_t code, uint32_t* const pw, uint32_t* const ph, size_t* const pfsz) {
+  if (NULL == idx || NULL == idx->font) {
+    return NULL;
+  }
+
+  if (NULL != pw) {
+    *pw = idx->fw;
+  }
+
+  if (NULL != ph) {
+    *ph = idx->fh;
+  }
+
+  if (NULL != pfsz) {
+    *pfsz = idx->fsz;
+  }
+
+  if (0 == idx->type) {
+    if (code < 0x100) {
+      return &idx->glyphs[code * idx->fsz];
+    }
+  } else {
+    // code 以下の開始コードを持つ最後のブロックを二分探索
+    size_t lo = 0;
+    size_t hi = idx->nblk;
+    while (lo < hi) {
+      const size_t mid = (lo + hi) / 2;
+      if (idx->blk[mid].sb <= code) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (0 < lo) {
+      const FontIndexBlock_t* const b = &idx->blk[lo - 1];
+      if (code <= b->eb) {
+        return &idx->glyphs[(b->base + (code - b->sb)) * idx->fsz];
+      }
+    }
+  }
+
+  return NULL;
+}
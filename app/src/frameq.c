@@ -0,0 +1,119 @@
+/**
+ * @file prog01/app/src/frameq.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/frameq.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define FRAMEQ_MASK (FRAMEQ_CAPACITY - 1)
+
+_Static_assert(0 == (FRAMEQ_CAPACITY & FRAMEQ_MASK), "FRAMEQ_CAPACITY must be a power of 2");
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+UError_t FrameQueue_Init(FrameQueue_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    atomic_init(&ctx->head, 0);
+    atomic_init(&ctx->tail, 0);
+  }
+
+  return err;
+}
+
+UError_t FrameQueue_Push(FrameQueue_t* ctx, const FrameQueueItem_t* item) {
+  UError_t err = uSuccess;
+  uint32_t tail = 0;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == item) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // tail は自身のみが更新するため relaxed. head は消費者の取り出し完了を acquire で確認する
+    tail = atomic_load_explicit(&ctx->tail, memory_order_relaxed);
+    const uint32_t head = atomic_load_explicit(&ctx->head, memory_order_acquire);
+    if (FRAMEQ_CAPACITY <= tail - head) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->items[tail & FRAMEQ_MASK] = *item;
+    // 要素の書き込みを tail の公開より前に完了させる
+    atomic_store_explicit(&ctx->tail, tail + 1, memory_order_release);
+  }
+
+  return err;
+}
+
+UError_t FrameQueue_Pop(FrameQueue_t* ctx, FrameQueueItem_t* item) {
+  UError_t err = uSuccess;
+  uint32_t head = 0;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == item) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    head = atomic_load_explicit(&ctx->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&ctx->tail, memory_order_acquire);
+    if (head == tail) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    *item = ctx->items[head & FRAMEQ_MASK];
+    // 要素の読み出しを head の公開より前に完了させる
+    atomic_store_explicit(&ctx->head, head + 1, memory_order_release);
+  }
+
+  return err;
+}
+
+uint32_t FrameQueue_Count(FrameQueue_t* ctx) {
+  if (NULL == ctx) {
+    return 0;
+  }
+  const uint32_t tail = atomic_load_explicit(&ctx->tail, memory_order_acquire);
+  const uint32_t head = atomic_load_explicit(&ctx->head, memory_order_acquire);
+  return tail - head;
+}
@@ -0,0 +1,328 @@
+/**
+ * @file prog01/app/src/glyphcache.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/glyphcache.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define GLYPHCACHE_MAX_ENTRIES (0xfffeu)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+inline static size_t hashKey(const GlyphCache_t* ctx, const void* graph, uint16_t fg, uint16_t bg, uint32_t scale);
+
+/**
+ * @brief エントリを LRU リストから外す
+ */
+inline static void lruUnlink(GlyphCache_t* ctx, uint16_t i);
+
+/**
+ * @brief エントリを LRU リストの先頭 (MRU) に繋ぐ
+ */
+inline static void lruPushFront(GlyphCache_t* ctx, uint16_t i);
+
+/**
+ * @brief エントリをハッシュチェインから外す
+ */
+inline static void unhash(GlyphCache_t* ctx, uint16_t i);
+
+/**
+ * @brief FONTX2 のビットマップを RGB565 へ展開する
+ */
+inline static void expand(uint16_t* dst, const uint8_t* graph, uint32_t fw, uint32_t fh, uint16_t fg, uint16_t bg, uint32_t scale);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+inline static size_t hashKey(const GlyphCache_t* ctx, const void* graph, uint16_t fg, uint16_t bg, uint32_t scale) {
+  uint32_t k = (uint32_t)(uintptr_t)graph;
+  k ^= ((uint32_t)fg << 16) | bg;
+  k ^= scale << 7;
+  k *= 2654435761u;
+  return (k >> 16) & ctx->mask;
+}
+
+inline static void lruUnlink(GlyphCache_t* ctx, uint16_t i) {
+  GlyphCacheEntry_t* const e = &ctx->entries[i];
+  if (GLYPHCACHE_NONE != e->prev) {
+    ctx->entries[e->prev].next = e->next;
+  } else {
+    ctx->head = e->next;
+  }
+  if (GLYPHCACHE_NONE != e->next) {
+    ctx->entries[e->next].prev = e->prev;
+  } else {
+    ctx->tail = e->prev;
+  }
+  e->prev = GLYPHCACHE_NONE;
+  e->next = GLYPHCACHE_NONE;
+}
+
+inline static void lruPushFront(GlyphCache_t* ctx, uint16_t i) {
+  GlyphCacheEntry_t* const e = &ctx->entries[i];
+  e->prev = GLYPHCACHE_NONE;
+  e->next = ctx->head;
+  if (GLYPHCACHE_NONE != ctx->head) {
+    ctx->entries[ctx->head].prev = i;
+  } else {
+    ctx->tail = i;
+  }
+  ctx->head = i;
+}
+
+inline static void unhash(GlyphCache_t* ctx, uint16_t i) {
+  GlyphCacheEntry_t* const e = &ctx->entries[i];
+  uint16_t* link = &ctx->buckets[hashKey(ctx, e->graph, e->fg, e->bg, e->scale)];
+  while (GLYPHCACHE_NONE != *link) {
+    if (i == *link) {
+      *link = e->hnext;
+      break;
+    }
+    link = &ctx->entries[*link].hnext;
+  }
+  e->hnext = GLYPHCACHE_NONE;
+}
+
+inline static void expand(uint16_t* dst, const uint8_t* graph, uint32_t fw, uint32_t fh, uint16_t fg, uint16_t bg, uint32_t scale) {
+  const uint32_t stride = fw * scale;
+  const size_t bpr = (fw + 7) / 8;  // 1ラインあたりのバイト数
+  for (uint32_t h = 0; h < fh; ++h) {
+    uint16_t* const row = dst;
+    for (uint32_t w = 0; w < fw; ++w) {
+      const uint16_t c = (graph[w / 8] & (0x80u >> (w % 8))) ? fg : bg;
+      for (uint32_t s = 0; s < scale; ++s) {
+        *dst++ = c;
+      }
+    }
+    // 縦方向の拡大は展開済みラインの複製
+    for (uint32_t s = 1; s < scale; ++s) {
+      for (uint32_t i = 0; i < stride; ++i) {
+        *dst++ = row[i];
+      }
+    }
+    graph += bpr;
+  }
+}
+
+UError_t GlyphCache_Create(GlyphCache_t* ctx, void* arena, size_t size, size_t slotPixels) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == arena || 0 == slotPixels) {
+      err = uFailure;
+    }
+  }
+
+  size_t n = 0;
+  size_t nb = 1;
+  uint8_t* base = (uint8_t*)arena;
+  if (uSuccess == err) {
+    // エントリ管理領域の先頭をポインタ境界に合わせる
+    const size_t pad = (sizeof(void*) - ((uintptr_t)base % sizeof(void*))) % sizeof(void*);
+    if (size <= pad) {
+      err = uFailure;
+    } else {
+      base += pad;
+      size -= pad;
+      // バケットは エントリ数の2倍未満 に収まるため 1エントリあたり 2個分を見込む
+      n = size / (sizeof(GlyphCacheEntry_t) + (slotPixels * sizeof(uint16_t)) + (2 * sizeof(uint16_t)));
+      if (GLYPHCACHE_MAX_ENTRIES < n) {
+        n = GLYPHCACHE_MAX_ENTRIES;
+      }
+      if (0 == n) {
+        err = uFailure;
+      }
+    }
+  }
+
+  if (uSuccess == err) {
+    while (nb < n) {
+      nb <<= 1;
+    }
+
+    ctx->entries = (GlyphCacheEntry_t*)base;
+    ctx->buckets = (uint16_t*)(base + (n * sizeof(GlyphCacheEntry_t)));
+    uint16_t* const pixels = ctx->buckets + nb;
+
+    ctx->nEntries = n;
+    ctx->mask = nb - 1;
+    ctx->slotPixels = slotPixels;
+    for (size_t i = 0; i < n; ++i) {
+      ctx->entries[i].pix = pixels + (i * slotPixels);
+    }
+    ctx->stats.hit = 0;
+    ctx->stats.miss = 0;
+    ctx->stats.evict = 0;
+    err = GlyphCache_Flush(ctx);
+  }
+
+  return err;
+}
+
+UError_t GlyphCache_Flush(GlyphCache_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->entries) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (size_t i = 0; i <= ctx->mask; ++i) {
+      ctx->buckets[i] = GLYPHCACHE_NONE;
+    }
+    // 空きエントリも LRU リストに並べておき, 末尾から順に使用する
+    ctx->head = GLYPHCACHE_NONE;
+    ctx->tail = GLYPHCACHE_NONE;
+    for (size_t i = 0; i < ctx->nEntries; ++i) {
+      GlyphCacheEntry_t* const e = &ctx->entries[i];
+      e->graph = NULL;
+      e->hnext = GLYPHCACHE_NONE;
+      lruPushFront(ctx, (uint16_t)i);
+    }
+  }
+
+  return err;
+}
+
+UError_t GlyphCache_Get(GlyphCache_t* ctx, const void* graph, uint32_t fw, uint32_t fh, uint16_t fg, uint16_t bg, uint32_t scale,
+                        const GlyphCacheEntry_t** entry) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->entries || NULL == graph || NULL == entry || 0 == scale) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->slotPixels < (size_t)fw * fh * scale * scale) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t b = hashKey(ctx, graph, fg, bg, scale);
+    uint16_t i = ctx->buckets[b];
+    while (GLYPHCACHE_NONE != i) {
+      const GlyphCacheEntry_t* const e = &ctx->entries[i];
+      if (graph == e->graph && fg == e->fg && bg == e->bg && scale == e->scale) {
+        break;
+      }
+      i = e->hnext;
+    }
+
+    if (GLYPHCACHE_NONE != i) {
+      ctx->stats.hit++;
+      if (ctx->head != i) {
+        lruUnlink(ctx, i);
+        lruPushFront(ctx, i);
+      }
+    } else {
+      ctx->stats.miss++;
+      i = ctx->tail;
+      GlyphCacheEntry_t* const e = &ctx->entries[i];
+      if (NULL != e->graph) {
+        ctx->stats.evict++;
+        unhash(ctx, i);
+      }
+      lruUnlink(ctx, i);
+
+      e->graph = graph;
+      e->fg = fg;
+      e->bg = bg;
+      e->scale = (uint16_t)scale;
+      e->w = (uint16_t)(fw * scale);
+      e->h = (uint16_t)(fh * scale);
+      expand(e->pix, (const uint8_t*)graph, fw, fh, fg, bg, scale);
+
+      e->hnext = ctx->buckets[b];
+      ctx->buckets[b] = i;
+      lruPushFront(ctx, i);
+    }
+    *entry = &ctx->entries[i];
+  }
+
+  return err;
+}
+
+UError_t GlyphCache_Draw(GlyphCache_t* ctx, const Canvas_t* canvas, size_t x, size_t y, const void* graph, uint32_t fw, uint32_t fh, uint16_t fg,
+                         uint16_t bg, uint32_t scale) {
+  UError_t err = uSuccess;
+  const GlyphCacheEntry_t* e = NULL;
+
+  if (uSuccess == err) {
+    // 展開済みグリフは RGB565 のため, インデックスカラーのキャンバスには使用できない
+    if (NULL == canvas || CanvasRGB565 != canvas->fmt) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = GlyphCache_Get(ctx, graph, fw, fh, fg, bg, scale, &e);
+  }
+
+  if (uSuccess == err) {
+    err = Canvas_Blit(canvas, x, y, e->w, e->h, e->pix, e->w);
+  }
+
+  return err;
+}
+
+UError_t GlyphCache_GetStats(const GlyphCache_t* ctx, GlyphCacheStats_t* stats) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == stats) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    *stats = ctx->stats;
+  }
+
+  return err;
+}
+
+UError_t GlyphCache_ResetStats(GlyphCache_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->stats.hit = 0;
+    ctx->stats.miss = 0;
+    ctx->stats.evict = 0;
+  }
+
+  return err;
+}
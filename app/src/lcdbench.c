@@ -0,0 +1,249 @@
+/**
+ * @file prog01/app/src/lcdbench.c
+ * LCD 転送性能の計測ファームウェア (lcdbench)
+ *
+ * 固定の組み合わせ (SPI ボーレート x 転送方法 x 矩形の大きさ) で LCDDrv / SPIDrv を実行し,
+ * 1回あたりの処理時間, 転送速度, CPU の空き時間の割合を UART へ CSV で出力します.
+ * ドライバ変更の前後で同じパネルに書き込み, 出力を比較してください.
+ *
+ * 出力 (1行 1項目):
+ *   case,pixfmt,baud_req,baud,w,h,iters,bytes,us_per_frame,mb_per_s,cpu_idle_pct
+ * bytes は 1回あたりの送信バイト数, cpu_idle_pct は非同期転送の完了待ちに費やした (他の処理に使える) 時間の割合です.
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+
+#include <user/lcddrv.h>
+#include <user/macros.h>
+#include <user/spidrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SCREEN_W (240)
+#define SCREEN_H (320)
+
+#define LCDBENCH_MIN_US (200 * 1000)  //< 1項目あたりの最小計測時間 (単位: us)
+#define LCDBENCH_MIN_ITERS (8)        //< 1項目あたりの最小実行回数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 計測する処理
+ */
+typedef enum tagLcdBenchMode_t {
+  LcdBenchSwapAsync = 0,  //< LCDDrv_SwapBuff() (DMA) + 完了待ち
+  LcdBenchSwapBlocking,   //< LCDDrv_SetWindow() + SPIDrv_SendNBytes() (CPU で送信)
+  LcdBenchClear,          //< LCDDrv_Clear() (1行ずつ同期送信)
+  LcdBenchWindowPerByte,  //< LCDDrv_SetWindow() (パラメータを 1byte ごとに CS を切り替えて送信)
+  LcdBenchWindowBurst,    //< 同じコマンド列のパラメータを 1回の CS で送信
+} LcdBenchMode_t;
+
+typedef struct tagLcdBenchCase_t {
+  const char* name;
+  LcdBenchMode_t mode;
+  LCDDrvPixelFormat_t pixfmt;
+  uint16_t w;
+  uint16_t h;
+} LcdBenchCase_t;
+
+typedef struct tagLcdBenchResult_t {
+  uint32_t iters;   //< 実行回数
+  uint64_t us;      //< 合計時間 (単位: us)
+  uint64_t idleUs;  //< 完了待ちの合計時間 (単位: us)
+  uint32_t bytes;   //< 1回あたりの送信バイト数
+} LcdBenchResult_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 1回分の処理を実行する
+ * @param [out] idleUs : 完了待ちの時間 (単位: us)
+ * @return 送信したバイト数
+ */
+static uint32_t runOnce(LCDDrvHandle_t hLcd, SPIDrvHandle_t hSpi, const LcdBenchCase_t* c, uint64_t* idleUs);
+
+/**
+ * @brief 1項目を計測する
+ */
+static void runCase(LCDDrvHandle_t hLcd, SPIDrvHandle_t hSpi, const LcdBenchCase_t* c, LcdBenchResult_t* result);
+
+/**
+ * @brief コマンドとパラメータを 1回の CS で送信する (LCDDrv_SetWindow() の比較用)
+ */
+static void sendCommandBurst(SPIDrvHandle_t hSpi, uint8_t cmd, const uint8_t* param, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static uint16_t framebuf[SCREEN_W * SCREEN_H];  //< 転送元 (縦縞のグラデーション)
+
+/**
+ * 計測する SPI ボーレート (ST7789 の書き込みサイクルの下限 16ns = 62.5MHz まで)
+ */
+static const uint32_t baudrates[] = {10 * 1000 * 1000, 25 * 1000 * 1000, 40 * 1000 * 1000, 62500 * 1000};
+
+/**
+ * 計測項目 (ボーレートごとに全て実行する)
+ */
+static const LcdBenchCase_t cases[] = {
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 240, 320},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 240, 160},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 120, 160},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 64, 64},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 32, 32},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 16, 16},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB565, 8, 8},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB444, 240, 320},
+    {"swap_async", LcdBenchSwapAsync, LCDDrvRGB444, 64, 64},
+    {"swap_blocking", LcdBenchSwapBlocking, LCDDrvRGB565, 240, 320},
+    {"swap_blocking", LcdBenchSwapBlocking, LCDDrvRGB565, 64, 64},
+    {"swap_blocking", LcdBenchSwapBlocking, LCDDrvRGB565, 8, 8},
+    {"clear", LcdBenchClear, LCDDrvRGB565, 240, 320},
+    {"clear", LcdBenchClear, LCDDrvRGB444, 240, 320},
+    {"window_per_byte", LcdBenchWindowPerByte, LCDDrvRGB565, 8, 8},
+    {"window_burst", LcdBenchWindowBurst, LCDDrvRGB565, 8, 8},
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void sendCommandBurst(SPIDrvHandle_t hSpi, uint8_t cmd, const uint8_t* param, size_t size) {
+  SPIDrv_SetDC(hSpi, false);
+  SPIDrv_SendByte(hSpi, cmd);
+  if (0 < size) {
+    SPIDrv_SetDC(hSpi, true);
+    SPIDrv_SendNBytes(hSpi, param, size);
+  }
+}
+
+static uint32_t runOnce(LCDDrvHandle_t hLcd, SPIDrvHandle_t hSpi, const LcdBenchCase_t* c, uint64_t* idleUs) {
+  const uint16_t x = (SCREEN_W - c->w) / 2;
+  const uint16_t y = (SCREEN_H - c->h) / 2;
+  const uint32_t pixels = (uint32_t)c->w * c->h;
+  const uint32_t window = 11;  // 0x2A + 4byte, 0x2B + 4byte, 0x2C
+  *idleUs = 0;
+
+  switch (c->mode) {
+    case LcdBenchSwapAsync: {
+      LCDDrv_SwapBuff(hLcd, framebuf, x, y, c->w, c->h);
+      const absolute_time_t begin = get_absolute_time();
+      LCDDrv_WaitForTransfer(hLcd);
+      *idleUs = (uint64_t)absolute_time_diff_us(begin, get_absolute_time());
+      return window + ((LCDDrvRGB444 == c->pixfmt) ? ((pixels * 3) + 1) / 2 : pixels * 2);
+    }
+    case LcdBenchSwapBlocking:
+      LCDDrv_SetWindow(hLcd, x, y, c->w, c->h);
+      SPIDrv_SetDC(hSpi, true);
+      SPIDrv_SendNBytes(hSpi, framebuf, pixels * 2);
+      return window + (pixels * 2);
+    case LcdBenchClear:
+      LCDDrv_Clear(hLcd, 0x00, 0x00, 0x80);
+      return window + ((LCDDrvRGB444 == c->pixfmt) ? ((SCREEN_W * 3) + 1) / 2 * SCREEN_H : SCREEN_W * SCREEN_H * 2);
+    case LcdBenchWindowPerByte:
+      LCDDrv_SetWindow(hLcd, x, y, c->w, c->h);
+      return window;
+    case LcdBenchWindowBurst: {
+      const uint16_t xe = x + c->w - 1;
+      const uint16_t ye = y + c->h - 1;
+      const uint8_t col[4] = {(uint8_t)(x >> 8), (uint8_t)x, (uint8_t)(xe >> 8), (uint8_t)xe};
+      const uint8_t row[4] = {(uint8_t)(y >> 8), (uint8_t)y, (uint8_t)(ye >> 8), (uint8_t)ye};
+      sendCommandBurst(hSpi, 0x2A, col, sizeof(col));  // Column address set
+      sendCommandBurst(hSpi, 0x2B, row, sizeof(row));  // Raw address set
+      sendCommandBurst(hSpi, 0x2C, NULL, 0);           // Memory write
+      return window;
+    }
+    default:
+      return 0;
+  }
+}
+
+static void runCase(LCDDrvHandle_t hLcd, SPIDrvHandle_t hSpi, const LcdBenchCase_t* c, LcdBenchResult_t* result) {
+  uint64_t idle = 0;
+
+  memset(result, 0, sizeof(*result));
+  LCDDrv_SetPixelFormat(hLcd, c->pixfmt);
+  (void)runOnce(hLcd, hSpi, c, &idle);  // 空実行 (キャッシュ, DMA チャネルの確保)
+
+  const absolute_time_t begin = get_absolute_time();
+  while (result->iters < LCDBENCH_MIN_ITERS || result->us < LCDBENCH_MIN_US) {
+    result->bytes = runOnce(hLcd, hSpi, c, &idle);
+    result->idleUs += idle;
+    ++result->iters;
+    result->us = (uint64_t)absolute_time_diff_us(begin, get_absolute_time());
+  }
+  LCDDrv_WaitForTransfer(hLcd);
+}
+
+/**
+ * エントリポイント
+ */
+int main(void) {
+  stdio_init_all();
+
+  SPIDrvContext_t spi;
+  LCDDrvContext_t lcd;
+
+  SPIDrv_Create(&spi);
+  SPIDrvHandle_t hSpi = (SPIDrvHandle_t)&spi;
+  LCDDrv_Create(&lcd, hSpi);
+  LCDDrvHandle_t hLcd = (LCDDrvHandle_t)&lcd;
+
+  for (size_t i = 0; i < SCREEN_W * SCREEN_H; ++i) {
+    const uint32_t r = (i % SCREEN_W) * 255 / (SCREEN_W - 1);
+    const uint32_t g = 0xff - r;
+    const uint32_t b = (i / SCREEN_W) * 255 / (SCREEN_H - 1);
+    framebuf[i] = RGB888toRGB565(r, g, b);
+  }
+
+  SPIDrv_Init(hSpi, baudrates[0]);
+  LCDDrv_Init(hLcd);
+  LCDDrv_InitalizeHW(hLcd);
+  LCDDrv_Clear(hLcd, 0u, 0u, 0u);
+  LCDDrv_SetBrightness(hLcd, 0x7fff);
+
+  sleep_ms(1000);  // UART の受信側の準備を待つ
+  printf("# lcdbench %ux%u\n", SCREEN_W, SCREEN_H);
+  printf("case,pixfmt,baud_req,baud,w,h,iters,bytes,us_per_frame,mb_per_s,cpu_idle_pct\n");
+
+  for (size_t b = 0; b < sizeof(baudrates) / sizeof(baudrates[0]); ++b) {
+    SPIDrv_Init(hSpi, baudrates[b]);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+      const LcdBenchCase_t* const c = &cases[i];
+      LcdBenchResult_t r;
+      runCase(hLcd, hSpi, c, &r);
+
+      // 小数点以下は固定小数点で出力する
+      const uint64_t usPerFrame100 = (r.us * 100) / r.iters;
+      const uint64_t mbps100 = ((uint64_t)r.bytes * r.iters * 100) / ((0 < r.us) ? r.us : 1);
+      const uint64_t idle10 = (r.idleUs * 1000) / ((0 < r.us) ? r.us : 1);
+      printf("%s,%s,%lu,%lu,%u,%u,%lu,%lu,%lu.%02lu,%lu.%02lu,%lu.%lu\n", c->name, (LCDDrvRGB444 == c->pixfmt) ? "rgb444" : "rgb565",
+             (unsigned long)baudrates[b], (unsigned long)spi.baudrate, c->w, c->h, (unsigned long)r.iters, (unsigned long)r.bytes,
+             (unsigned long)(usPerFrame100 / 100), (unsigned long)(usPerFrame100 % 100), (unsigned long)(mbps100 / 100), (unsigned long)(mbps100 % 100),
+             (unsigned long)(idle10 / 10), (unsigned long)(idle10 % 10));
+    }
+  }
+  LCDDrv_SetPixelFormat(hLcd, LCDDrvRGB565);
+  printf("# done\n");
+
+  while (true) {
+    sleep_ms(1000);
+  }
+  return 0;
+}
@@ -47,15 +47,19 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <pico/stdlib.h>
 
 #include <hardware/gpio.h>
 #include <hardware/pwm.h>
 
+#include <user/apiprof.h>
+#include <user/canvas.h>
 #include <user/macros.h>
 #include <user/lcddrv.h>
 #include <user/spidrv.h>
+#include <user/tracering.h>
 #include <user/types.h>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -67,6 +71,14 @@
 #define LCD_RST_PIN (7)
 #define LCD_BL_PIN (8)
 
+#define LCD_PANEL_WIDTH (240)  //< パネルの幅 (回転なし)
+#define LCD_PANEL_LINES (320)  //< フレームメモリの行数 (垂直スクロールの単位)
+
+// Memory Data Access Control (0x36) のビット
+#define LCD_MADCTL_MY (0x80)  //< 行アドレス順 反転
+#define LCD_MADCTL_MX (0x40)  //< 列アドレス順 反転
+#define LCD_MADCTL_MV (0x20)  //< 行/列 交換
+
 #define HANDLE_TO_CONTEXTP(p) (LCDDrvContext_t*)(p)
 
 //////////////////////////////////////////////////////////////////////////////
@@ -92,7 +104,33 @@ static UError_t LCDDrv_SendDataByte(LCDDrvContext_t* lcd, const uint8_t data);
 
 static UError_t LCDDrv_HWReset(LCDDrvContext_t* lcd);
 static UError_t LCDDrv_InitRegister(LCDDrvContext_t* lcd);
-static UError_t LCDDrv_SetAttributes(LCDDrvContext_t* lcd);
+
+/**
+ * @brief 非同期転送中であれば完了を待つ. コマンド送信前に呼び出す.
+ */
+static void LCDDrv_WaitIdle(LCDDrvContext_t* lcd);
+
+/**
+ * @brief RGB565 の値から R, G, B の上位 4bit を取り出し 12bit にまとめる (0xRGB)
+ */
+static inline uint32_t LCDDrv_ToRGB444(uint16_t c);
+
+/**
+ * @brief 垂直スクロール領域を送信し, 状態を更新する (表示開始位置は送信しない)
+ * @param [in] top : 上端の固定領域の行数 (パネルの行)
+ */
+static void LCDDrv_SendScrollArea(LCDDrvContext_t* lcd, uint16_t top, uint16_t height);
+
+/**
+ * @brief 表示開始位置を送信し, 状態を更新する
+ * @param [in] start : メモリ行 (パネルの行)
+ */
+static void LCDDrv_SendScrollStart(LCDDrvContext_t* lcd, uint16_t start);
+
+/**
+ * @brief 画面の上下がパネルの行と逆順か (行アドレス順の反転のみ: 180度回転 等)
+ */
+static inline bool LCDDrv_IsRowFlipped(const LCDDrvContext_t* lcd);
 
 //////////////////////////////////////////////////////////////////////////////
 // variable
@@ -103,15 +141,68 @@ static UError_t LCDDrv_SetAttributes(LCDDrvContext_t* lcd);
 //////////////////////////////////////////////////////////////////////////////
 
 static inline void LCDDrv_DC0(LCDDrvContext_t* lcd) {
-  NOP3();
-  gpio_put(lcd->dc, 0);
-  NOP3();
+  SPIDrv_SetDC(lcd->spi, false);
 }
 
 static inline void LCDDrv_DC1(LCDDrvContext_t* lcd) {
-  NOP3();
-  gpio_put(lcd->dc, 1);
-  NOP3();
+  SPIDrv_SetDC(lcd->spi, true);
+}
+
+static void LCDDrv_WaitIdle(LCDDrvContext_t* lcd) {
+  if (lcd->bBusy) {
+    const absolute_time_t begin = get_absolute_time();
+    TRACE_BEGIN(TraceIdLcdWait, 0, 0);
+    SPIDrv_WaitForAsync(lcd->spi);
+    TRACE_END(TraceIdLcdWait, 0, 0);
+    lcd->bBusy = false;
+
+    uint32_t us = 0;
+    size_t size = 0;
+    (void)SPIDrv_GetAsyncTime(lcd->spi, &us, &size);
+    lcd->timing.waitUs += (uint64_t)absolute_time_diff_us(begin, get_absolute_time());
+    lcd->timing.dmaUs += us;
+    lcd->timing.bytes += size;
+    ++lcd->timing.transfers;
+  }
+}
+
+static inline uint32_t LCDDrv_ToRGB444(uint16_t c) {
+  // 格納順は 下位バイト RRRRRGGG, 上位バイト GGGBBBBB
+  const uint32_t r = (c >> 4) & 0x0f;
+  const uint32_t g = ((c << 1) & 0x0e) | ((c >> 15) & 0x01);
+  const uint32_t b = (c >> 9) & 0x0f;
+  return (r << 8) | (g << 4) | b;
+}
+
+static void LCDDrv_SendScrollArea(LCDDrvContext_t* lcd, uint16_t top, uint16_t height) {
+  const uint16_t bottom = LCD_PANEL_LINES - top - height;
+  LCDDrv_WaitIdle(lcd);
+
+  LCDDrv_SendCommand(lcd, 0x33);  // Vertical Scrolling Definition
+  LCDDrv_SendDataByte(lcd, top >> 8);
+  LCDDrv_SendDataByte(lcd, top);
+  LCDDrv_SendDataByte(lcd, height >> 8);
+  LCDDrv_SendDataByte(lcd, height);
+  LCDDrv_SendDataByte(lcd, bottom >> 8);
+  LCDDrv_SendDataByte(lcd, bottom);
+
+  lcd->scrollTop = top;
+  lcd->scrollHeight = height;
+  lcd->scrollStart = top;
+}
+
+static void LCDDrv_SendScrollStart(LCDDrvContext_t* lcd, uint16_t start) {
+  LCDDrv_WaitIdle(lcd);
+
+  LCDDrv_SendCommand(lcd, 0x37);  // Vertical Scroll Start Address of RAM
+  LCDDrv_SendDataByte(lcd, start >> 8);
+  LCDDrv_SendDataByte(lcd, start);
+
+  lcd->scrollStart = start;
+}
+
+static inline bool LCDDrv_IsRowFlipped(const LCDDrvContext_t* lcd) {
+  return LCD_MADCTL_MY == (lcd->madctl & (LCD_MADCTL_MY | LCD_MADCTL_MV));
 }
 
 static UError_t LCDDrv_SendCommand(LCDDrvContext_t* lcd, const uint8_t cmd) {
@@ -171,10 +262,10 @@ static UError_t LCDDrv_InitRegister(LCDDrvContext_t* lcd) {
 
   if (uSuccess == err) {
     LCDDrv_SendCommand(lcd, 0x36);  // Memory data Access Control
-    LCDDrv_SendDataByte(lcd, 0x00);
+    LCDDrv_SendDataByte(lcd, lcd->madctl);
 
-    LCDDrv_SendCommand(lcd, 0x3A);   // Interface Pixel format
-    LCDDrv_SendDataByte(lcd, 0x05);  // 16bit/pixel
+    LCDDrv_SendCommand(lcd, 0x3A);                                          // Interface Pixel format
+    LCDDrv_SendDataByte(lcd, (LCDDrvRGB444 == lcd->pixfmt) ? 0x03 : 0x05);  // 12bit/pixel : 16bit/pixel
     // LCDDrv_SendDataByte(0x06);  // 18bit/pixel
 
     // ディスプレイタイミングパラメータ
@@ -260,27 +351,6 @@ static UError_t LCDDrv_InitRegister(LCDDrvContext_t* lcd) {
   return err;
 }
 
-static UError_t LCDDrv_SetAttributes(LCDDrvContext_t* lcd) {
-  UError_t err = uSuccess;
-
-  if (uSuccess == err) {
-    if (NULL == lcd) {
-      err = uFailure;
-    }
-  }
-
-  // 一旦 320 x 240 だけ考える
-  if (uSuccess == err) {
-    err = LCDDrv_SendCommand(lcd, 0x36);
-  }
-
-  if (uSuccess == err) {
-    err = LCDDrv_SendDataByte(lcd, 0x78);
-  }
-
-  return err;
-}
-
 UError_t LCDDrv_Create(LCDDrvContext_t* ctx, SPIDrvHandle_t spi) {
   UError_t err = uSuccess;
 
@@ -297,6 +367,14 @@ UError_t LCDDrv_Create(LCDDrvContext_t* ctx, SPIDrvHandle_t spi) {
     ctx->bl = LCD_BL_PIN;
     ctx->pwmSlice = 0;
     ctx->bBusy = false;
+    ctx->pixfmt = LCDDrvRGB565;
+    ctx->madctl = 0x00;
+    ctx->width = LCD_PANEL_WIDTH;
+    ctx->height = LCD_PANEL_LINES;
+    ctx->scrollTop = 0;
+    ctx->scrollHeight = LCD_PANEL_LINES;
+    ctx->scrollStart = 0;
+    memset(&ctx->timing, 0, sizeof(ctx->timing));
   }
 
   return err;
@@ -320,6 +398,7 @@ UError_t LCDDrv_Init(LCDDrvHandle_t handle) {
     gpio_init(lcd->dc);
     gpio_put(lcd->dc, 1);
     gpio_set_dir(lcd->dc, GPIO_OUT);
+    err = SPIDrv_SetDCPin(lcd->spi, lcd->dc);
   }
 
   // リセット
@@ -364,7 +443,85 @@ UError_t LCDDrv_InitalizeHW(LCDDrvHandle_t handle) {
   return err;
 }
 
+UError_t LCDDrv_SetRotation(LCDDrvHandle_t handle, LCDDrvRotation_t rotation, bool mirror) {
+  UError_t err = uSuccess;
+  uint8_t madctl = 0;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    switch (rotation) {
+      case LCDDrvRotate0:
+        madctl = 0x00;
+        break;
+      case LCDDrvRotate90:
+        madctl = LCD_MADCTL_MX | LCD_MADCTL_MV;
+        break;
+      case LCDDrvRotate180:
+        madctl = LCD_MADCTL_MX | LCD_MADCTL_MY;
+        break;
+      case LCDDrvRotate270:
+        madctl = LCD_MADCTL_MY | LCD_MADCTL_MV;
+        break;
+      default:
+        err = uFailure;
+        break;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (mirror) {
+      // 論理的な x方向を反転する. 行/列 交換時は行アドレス側が x方向になる
+      madctl ^= (madctl & LCD_MADCTL_MV) ? LCD_MADCTL_MY : LCD_MADCTL_MX;
+    }
+
+    LCDDrv_WaitIdle(lcd);
+    LCDDrv_SendCommand(lcd, 0x36);  // Memory data Access Control
+    LCDDrv_SendDataByte(lcd, madctl);
+
+    lcd->madctl = madctl;
+    lcd->width = (madctl & LCD_MADCTL_MV) ? LCD_PANEL_LINES : LCD_PANEL_WIDTH;
+    lcd->height = (madctl & LCD_MADCTL_MV) ? LCD_PANEL_WIDTH : LCD_PANEL_LINES;
+
+    // 画面の上下とスクロール方向の対応が変わるため, スクロールを解除する (全画面をスクロール領域とし, 開始位置を 0 に戻す)
+    LCDDrv_SendScrollArea(lcd, 0, LCD_PANEL_LINES);
+    LCDDrv_SendScrollStart(lcd, 0);
+  }
+
+  return err;
+}
+
+UError_t LCDDrv_GetSize(LCDDrvHandle_t handle, uint16_t* width, uint16_t* height) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  const LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    if (NULL != width) {
+      *width = lcd->width;
+    }
+    if (NULL != height) {
+      *height = lcd->height;
+    }
+  }
+
+  return err;
+}
+
 UError_t LCDDrv_SetWindow(LCDDrvHandle_t handle, const uint16_t x, const uint16_t y, const uint16_t width, const uint16_t height) {
+  APIPROF_BEGIN(ApiProfLCDDrvSetWindow);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -376,12 +533,19 @@ UError_t LCDDrv_SetWindow(LCDDrvHandle_t handle, const uint16_t x, const uint16_
   LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
 
   if (uSuccess == err) {
-    if ((320 <= y) || (240 <= x) || (320 < (y + height)) || (240 < (x + width))) {
+    if ((lcd->height <= y) || (lcd->width <= x) || (lcd->height < (y + height)) || (lcd->width < (x + width))) {
       err = uFailure;
     }
   }
 
   if (uSuccess == err) {
+    // 転送中の DMA がある間は D/C を切り替えられないため, 完了を待つ (待ち時間は windowUs に含めない)
+    LCDDrv_WaitIdle(lcd);
+  }
+
+  const absolute_time_t begin = get_absolute_time();
+  if (uSuccess == err) {
+    TRACE_BEGIN(TraceIdSetWindow, x, y);
     const uint16_t xe = x + width - 1;
     const uint16_t ye = y + height - 1;
 
@@ -400,14 +564,18 @@ UError_t LCDDrv_SetWindow(LCDDrvHandle_t handle, const uint16_t x, const uint16_
 
   if (uSuccess == err) {
     LCDDrv_SendCommand(lcd, 0x2C);  // Memory write. prepare send framedata
+    TRACE_END(TraceIdSetWindow, width, height);
+    lcd->timing.windowUs += (uint64_t)absolute_time_diff_us(begin, get_absolute_time());
   }
 
+  APIPROF_END(ApiProfLCDDrvSetWindow);
   return err;
 }
 
 UError_t LCDDrv_Clear(LCDDrvHandle_t handle, const uint8_t r, const uint8_t g, const uint8_t b) {
+  APIPROF_BEGIN(ApiProfLCDDrvClear);
   UError_t err = uSuccess;
-  uint16_t buf[240];
+  uint16_t buf[LCD_PANEL_LINES];  // 回転後の幅の最大値
   uint16_t color = RGB888toRGB565(r, g, b);
 
   if (uSuccess == err) {
@@ -419,13 +587,14 @@ UError_t LCDDrv_Clear(LCDDrvHandle_t handle, const uint8_t r, const uint8_t g, c
   LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
 
   if (uSuccess == err) {
-    for (size_t j = 0; j < 240; ++j) {
+    for (size_t j = 0; j < lcd->width; ++j) {
       buf[j] = color;
     }
   }
 
   if (uSuccess == err) {
-    err = LCDDrv_SetWindow(lcd, 0, 0, 240, 320);
+    LCDDrv_WaitIdle(lcd);
+    err = LCDDrv_SetWindow(lcd, 0, 0, lcd->width, lcd->height);
   }
 
   if (uSuccess == err) {
@@ -434,18 +603,24 @@ UError_t LCDDrv_Clear(LCDDrvHandle_t handle, const uint8_t r, const uint8_t g, c
   }
 
   if (uSuccess == err) {
-    for (size_t j = 0; j < 320; ++j) {
-      err = SPIDrv_SendNBytes(lcd->spi, buf, 240 * 2);
+    size_t size = (size_t)lcd->width * 2;
+    if (LCDDrvRGB444 == lcd->pixfmt) {
+      size = LCDDrv_PackRGB444(buf, lcd->width, (uint8_t*)buf);
+    }
+    for (size_t j = 0; j < lcd->height; ++j) {
+      err = SPIDrv_SendNBytes(lcd->spi, buf, size);
       if (uSuccess != err) {
         break;
       }
     }
   }
 
+  APIPROF_END(ApiProfLCDDrvClear);
   return err;
 }
 
 UError_t LCDDrv_SetBrightness(LCDDrvHandle_t handle, uint16_t b) {
+  APIPROF_BEGIN(ApiProfLCDDrvSetBrightness);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -460,12 +635,16 @@ UError_t LCDDrv_SetBrightness(LCDDrvHandle_t handle, uint16_t b) {
     pwm_set_gpio_level(lcd->bl, b);
   }
 
+  APIPROF_END(ApiProfLCDDrvSetBrightness);
   return err;
 }
 
 UError_t LCDDrv_SwapBuff(LCDDrvHandle_t handle, const void* frame, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  APIPROF_BEGIN(ApiProfLCDDrvSwapBuff);
   UError_t err = uSuccess;
 
+  TRACE_BEGIN(TraceIdLcdSwap, w, h);
+
   if (uSuccess == err) {
     if (NULL == handle || NULL == frame) {
       err = uFailure;
@@ -475,21 +654,307 @@ UError_t LCDDrv_SwapBuff(LCDDrvHandle_t handle, const void* frame, uint16_t x, u
   LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
 
   if (uSuccess == err) {
-    if (lcd->bBusy) {
-      SPIDrv_WaitForAsync(lcd->spi);
-      // printf("[DEBUG] %s()\n", "SPIDrv_WaitForAsync");
-    }
+    LCDDrv_WaitIdle(lcd);
+    // printf("[DEBUG] %s()\n", "SPIDrv_WaitForAsync");
     err = LCDDrv_SetWindow(lcd, x, y, w, h);
     // printf("[DEBUG] %s(%d, %d, %d, %d)\n", "LCDDrv_SetWindow", x, y, w, h);
   }
 
-  if (uSuccess == err) {
+  if (uSuccess == err && LCDDrvRGB565 == lcd->pixfmt) {
     LCDDrv_DC1(lcd);
     err = SPIDrv_AsyncSend(lcd->spi, frame, w * h * 2);
     // printf("[DEBUG] %s(0x%08lx, %d)\n", "SPIDrv_AsyncSend",frame, w * h * 2);
+    if (uSuccess == err) {
+      lcd->bBusy = true;
+    }
+  } else if (uSuccess == err) {
+    // 12bit 形式 : 展開バッファへ詰めながら, 2面を交互に転送する
+    LCDDrv_DC1(lcd);
+    const uint16_t* src = (const uint16_t*)frame;
+    size_t remain = (size_t)w * h;
+    uint32_t index = 0;
+    while (0 < remain) {
+      const size_t n = (remain < LCDDRV_EXPAND_PIXELS) ? remain : LCDDRV_EXPAND_PIXELS;
+      uint8_t* const buf = (uint8_t*)lcd->expand[index];
+      const size_t size = LCDDrv_PackRGB444(src, n, buf);
+
+      LCDDrv_WaitIdle(lcd);
+      err = SPIDrv_AsyncSend(lcd->spi, buf, size);
+      if (uSuccess != err) {
+        break;
+      }
+      lcd->bBusy = true;
+      index ^= 1;
+      src += n;
+      remain -= n;
+    }
+  }
+
+  TRACE_END(TraceIdLcdSwap, w, h);
+  APIPROF_END(ApiProfLCDDrvSwapBuff);
+  return err;
+}
+
+UError_t LCDDrv_SetPixelFormat(LCDDrvHandle_t handle, LCDDrvPixelFormat_t fmt) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle || (LCDDrvRGB565 != fmt && LCDDrvRGB444 != fmt)) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    LCDDrv_WaitIdle(lcd);
+    LCDDrv_SendCommand(lcd, 0x3A);                                  // Interface Pixel format
+    LCDDrv_SendDataByte(lcd, (LCDDrvRGB444 == fmt) ? 0x03 : 0x05);  // 12bit/pixel : 16bit/pixel
+    lcd->pixfmt = fmt;
+  }
+
+  return err;
+}
+
+size_t LCDDrv_PackRGB444(const uint16_t* src, size_t n, uint8_t* dst) {
+  uint8_t* const top = dst;
+
+  // 2pixel (4byte) を読み出してから 3byte を書き込むため, src == dst でも壊れない
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    const uint32_t p = (LCDDrv_ToRGB444(src[i]) << 12) | LCDDrv_ToRGB444(src[i + 1]);
+    dst[0] = (uint8_t)(p >> 16);
+    dst[1] = (uint8_t)(p >> 8);
+    dst[2] = (uint8_t)p;
+    dst += 3;
+  }
+  if (n & 1) {
+    const uint32_t p = LCDDrv_ToRGB444(src[n - 1]) << 12;
+    dst[0] = (uint8_t)(p >> 16);
+    dst[1] = (uint8_t)(p >> 8);
+    dst += 2;
+  }
+
+  return (size_t)(dst - top);
+}
+
+UError_t LCDDrv_SwapCanvas(LCDDrvHandle_t handle, const Canvas_t* canvas, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  APIPROF_BEGIN(ApiProfLCDDrvSwapCanvas);
+  UError_t err = uSuccess;
+
+  TRACE_BEGIN(TraceIdLcdSwap, w, h);
+
+  if (uSuccess == err) {
+    if (NULL == handle || NULL == canvas || 0 == w || 0 == h) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    if (canvas->w < (size_t)x + w || canvas->h < (size_t)y + h || LCDDRV_EXPAND_PIXELS < w) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    LCDDrv_WaitIdle(lcd);
+    err = LCDDrv_SetWindow(lcd, x, y, w, h);
   }
+
   if (uSuccess == err) {
-    lcd->bBusy = true;
+    LCDDrv_DC1(lcd);
+    uint16_t lines = LCDDRV_EXPAND_PIXELS / w;  // 1回の転送で送る行数
+    if (LCDDrvRGB444 == lcd->pixfmt && (w & 1) && 1 < lines) {
+      // 12bit 形式は 2pixel 単位で詰めるため, 途中の転送は偶数ピクセルにする
+      lines &= ~1u;
+    }
+    uint32_t index = 0;
+    for (uint16_t row = 0; row < h; row += lines) {
+      const uint16_t n = (h - row < lines) ? h - row : lines;
+      uint16_t* const buf = lcd->expand[index];
+      for (uint16_t j = 0; j < n; ++j) {
+        err = Canvas_ExpandLine(canvas, x, y + row + j, w, buf + (j * w));
+        if (uSuccess != err) {
+          break;
+        }
+      }
+      if (uSuccess != err) {
+        break;
+      }
+
+      size_t size = (size_t)n * w * 2;
+      if (LCDDrvRGB444 == lcd->pixfmt) {
+        size = LCDDrv_PackRGB444(buf, (size_t)n * w, (uint8_t*)buf);
+      }
+
+      // 前の面の転送完了を待ってから, 展開済みの面を送る
+      LCDDrv_WaitIdle(lcd);
+      err = SPIDrv_AsyncSend(lcd->spi, buf, size);
+      if (uSuccess != err) {
+        break;
+      }
+      lcd->bBusy = true;
+      index ^= 1;
+    }
+  }
+
+  TRACE_END(TraceIdLcdSwap, w, h);
+  APIPROF_END(ApiProfLCDDrvSwapCanvas);
+  return err;
+}
+
+UError_t LCDDrv_SetScrollArea(LCDDrvHandle_t handle, uint16_t top, uint16_t height) {
+  APIPROF_BEGIN(ApiProfLCDDrvSetScrollArea);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    // 行/列 交換時 (90/270度) はパネルの行が画面の列になり, 垂直スクロールが水平方向に働くため受け付けない
+    if (LCD_PANEL_LINES < (uint32_t)top + height || (lcd->madctl & LCD_MADCTL_MV)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 画面の上下が逆の場合, 画面の上端の固定領域はパネルの下端になる
+    const uint16_t panelTop = LCDDrv_IsRowFlipped(lcd) ? (LCD_PANEL_LINES - top - height) : top;
+    LCDDrv_SendScrollArea(lcd, panelTop, height);
+    if (0 < height) {
+      LCDDrv_SendScrollStart(lcd, panelTop);
+    }
+  }
+
+  APIPROF_END(ApiProfLCDDrvSetScrollArea);
+  return err;
+}
+
+UError_t LCDDrv_SetScrollStart(LCDDrvHandle_t handle, uint16_t start) {
+  APIPROF_BEGIN(ApiProfLCDDrvSetScrollStart);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    if (start < lcd->scrollTop || (uint32_t)lcd->scrollTop + lcd->scrollHeight <= start || (lcd->madctl & LCD_MADCTL_MV)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    LCDDrv_SendScrollStart(lcd, start);
+  }
+
+  APIPROF_END(ApiProfLCDDrvSetScrollStart);
+  return err;
+}
+
+UError_t LCDDrv_Scroll(LCDDrvHandle_t handle, int32_t lines) {
+  APIPROF_BEGIN(ApiProfLCDDrvScroll);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+
+  if (uSuccess == err) {
+    if (0 == lcd->scrollHeight || (lcd->madctl & LCD_MADCTL_MV)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const int32_t height = lcd->scrollHeight;
+    // 画面の上下が逆の場合, 画面の上方向はパネルの行の増加方向になる
+    const int32_t panelLines = LCDDrv_IsRowFlipped(lcd) ? -(lines % height) : (lines % height);
+    int32_t offset = ((int32_t)(lcd->scrollStart - lcd->scrollTop) + panelLines) % height;
+    if (0 > offset) {
+      offset += height;
+    }
+    LCDDrv_SendScrollStart(lcd, (uint16_t)(lcd->scrollTop + offset));
+  }
+
+  APIPROF_END(ApiProfLCDDrvScroll);
+  return err;
+}
+
+uint16_t LCDDrv_ScrollMapRow(LCDDrvHandle_t handle, uint16_t row) {
+  if (NULL == handle) {
+    return row;
+  }
+
+  const LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+  if (lcd->madctl & LCD_MADCTL_MV) {
+    // 90/270度ではスクロールしない
+    return row;
+  }
+
+  // 画面の上下が逆の場合, 画面の行 r はパネルの行 (LINES - 1 - r) に表示され, メモリ行 m には画面の行 (LINES - 1 - m) として書き込む
+  const bool flipped = LCDDrv_IsRowFlipped(lcd);
+  const uint32_t line = flipped ? (LCD_PANEL_LINES - 1u - row) : row;
+  const uint32_t top = lcd->scrollTop;
+  const uint32_t height = lcd->scrollHeight;
+  if (LCD_PANEL_LINES <= row || line < top || top + height <= line) {
+    return row;
+  }
+
+  uint32_t mem = line + (lcd->scrollStart - top);
+  if (top + height <= mem) {
+    mem -= height;
+  }
+  return (uint16_t)(flipped ? (LCD_PANEL_LINES - 1u - mem) : mem);
+}
+
+UError_t LCDDrv_WaitForTransfer(LCDDrvHandle_t handle) {
+  APIPROF_BEGIN(ApiProfLCDDrvWaitForTransfer);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    LCDDrv_WaitIdle(HANDLE_TO_CONTEXTP(handle));
+  }
+
+  APIPROF_END(ApiProfLCDDrvWaitForTransfer);
+  return err;
+}
+
+UError_t LCDDrv_GetTiming(LCDDrvHandle_t handle, LCDDrvTiming_t* timing, bool reset) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle || NULL == timing) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    LCDDrvContext_t* const lcd = HANDLE_TO_CONTEXTP(handle);
+    *timing = lcd->timing;
+    if (reset) {
+      memset(&lcd->timing, 0, sizeof(lcd->timing));
+    }
   }
 
   return err;
@@ -0,0 +1,214 @@
+/**
+ * @file prog01/app/src/lcdpipe.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/stdlib.h>
+
+#include <user/apiprof.h>
+#include <user/canvas.h>
+#include <user/core1.h>
+#include <user/frameq.h>
+#include <user/lcddrv.h>
+#include <user/lcdpipe.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 面を返却キューへ戻す
+ */
+static void releaseBuffer(LCDPipe_t* ctx, uint32_t index);
+
+/**
+ * @brief core1 の処理 (LCDPipe_Service() を繰り返す)
+ */
+static void core1Entry(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static LCDPipe_t* core1Pipe = NULL;  //< core1 が処理するパイプライン
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void releaseBuffer(LCDPipe_t* ctx, uint32_t index) {
+  const FrameQueueItem_t item = {.buffer = (uint16_t)index, .flags = FRAMEQ_FLAG_LAST};
+  // 返却キューの容量は面の数以上のため, 失敗しない
+  (void)FrameQueue_Push(&ctx->release, &item);
+}
+
+static void core1Entry(void) {
+  LCDPipe_t* const ctx = core1Pipe;
+#if APIPROF_ENABLE
+  (void)ApiProf_Init();  // core1 の DWT を有効にする
+#endif
+  while (true) {
+    (void)LCDPipe_Service(ctx, NULL);
+    tight_loop_contents();
+  }
+}
+
+UError_t LCDPipe_Create(LCDPipe_t* ctx, LCDDrvHandle_t lcd, const Canvas_t* const* canvases, uint32_t n) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == lcd || NULL == canvases || 0 == n || LCDPIPE_MAX_BUFFERS < n) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (uint32_t i = 0; i < n; ++i) {
+      if (NULL == canvases[i] || NULL == canvases[i]->buf) {
+        err = uFailure;
+        break;
+      }
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->lcd = lcd;
+    ctx->nbuf = n;
+    for (uint32_t i = 0; i < n; ++i) {
+      ctx->canvas[i] = canvases[i];
+    }
+    (void)FrameQueue_Init(&ctx->submit);
+    (void)FrameQueue_Init(&ctx->release);
+    for (uint32_t i = 0; i < n; ++i) {
+      releaseBuffer(ctx, i);
+    }
+  }
+
+  return err;
+}
+
+UError_t LCDPipe_Acquire(LCDPipe_t* ctx, uint32_t* index) {
+  UError_t err = uSuccess;
+  FrameQueueItem_t item;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == index) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = FrameQueue_Pop(&ctx->release, &item);
+  }
+
+  if (uSuccess == err) {
+    *index = item.buffer;
+  }
+
+  return err;
+}
+
+UError_t LCDPipe_Submit(LCDPipe_t* ctx, uint32_t index, const CanvasRect_t* rects, size_t n) {
+  UError_t err = uSuccess;
+  CanvasRect_t whole;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || ctx->nbuf <= index) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (NULL == rects) {
+      const Canvas_t* const canvas = ctx->canvas[index];
+      whole.x = 0;
+      whole.y = 0;
+      whole.w = (uint16_t)canvas->w;
+      whole.h = (uint16_t)canvas->h;
+      rects = &whole;
+      n = 1;
+    }
+    // 空きは消費者が取り出すことでしか増えないため, 事前に確認すれば途中で満杯にならない
+    if (0 == n || FRAMEQ_CAPACITY - FrameQueue_Count(&ctx->submit) < n) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (size_t i = 0; i < n; ++i) {
+      const FrameQueueItem_t item = {.buffer = (uint16_t)index, .flags = (i + 1 == n) ? FRAMEQ_FLAG_LAST : 0, .rect = rects[i]};
+      (void)FrameQueue_Push(&ctx->submit, &item);
+    }
+  }
+
+  return err;
+}
+
+UError_t LCDPipe_Service(LCDPipe_t* ctx, uint32_t* count) {
+  UError_t err = uSuccess;
+  uint32_t done = 0;
+  FrameQueueItem_t item;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    while (uSuccess == FrameQueue_Pop(&ctx->submit, &item)) {
+      const CanvasRect_t* const r = &item.rect;
+      if (0 < r->w && 0 < r->h) {
+        const UError_t e = LCDDrv_SwapCanvas(ctx->lcd, ctx->canvas[item.buffer], r->x, r->y, r->w, r->h);
+        err = (uSuccess == err) ? e : err;
+        done++;
+      }
+      // LCDDrv_SwapCanvas() は展開バッファから転送するため, 戻った時点で面を返却できる
+      if (item.flags & FRAMEQ_FLAG_LAST) {
+        releaseBuffer(ctx, item.buffer);
+      }
+    }
+  }
+
+  if (NULL != count) {
+    *count = done;
+  }
+
+  return err;
+}
+
+UError_t LCDPipe_Start(LCDPipe_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL != core1Pipe) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    core1Pipe = ctx;
+    err = Core1_Launch(core1Entry);
+    if (uSuccess != err) {
+      // core1 は他の処理 (BandRender_Start() 等) が使用中
+      core1Pipe = NULL;
+    }
+  }
+
+  return err;
+}
@@ -7,22 +7,64 @@
 // includes
 //////////////////////////////////////////////////////////////////////////////
 
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <pico/binary_info.h>
 #include <pico/stdlib.h>
 
+#include <hardware/uart.h>
+
+#include <user/apiprof.h>
+#include <user/bandrender.h>
 #include <user/canvas.h>
+#include <user/drawlist.h>
+#include <user/drawrec.h>
 #include <user/font.h>
 #include <user/lcddrv.h>
 #include <user/macros.h>
+#include <user/numfmt.h>
+#include <user/profiler.h>
 #include <user/spidrv.h>
+#include <user/tracering.h>
 #include <user/types.h>
 
 //////////////////////////////////////////////////////////////////////////////
 // defines
 //////////////////////////////////////////////////////////////////////////////
 
+#if !defined(APP_BAND_RENDER)
+#define APP_BAND_RENDER (0)  //< 1: 描画命令を上下の帯に分けて 2コアで再生する
+#endif
+
+#if !defined(APP_PROFILER_HUD)
+#define APP_PROFILER_HUD (0)  //< 1: 処理時間の計測結果を画面右下に重ねて表示する (app/CMakeLists.txt の APP_PROFILER_HUD)
+#endif
+
+#if !defined(APP_TRACE_DRAIN)
+#define APP_TRACE_DRAIN (0)  //< 1以上: このフレーム数ごとにトレースを UART へバイナリで書き出す (host/tools/trace2chrome で変換)
+#endif
+
+#if !defined(APP_OVERDRAW_HEATMAP)
+#define APP_OVERDRAW_HEATMAP (0)  //< 1: (CANVAS_OVERDRAW 有効時) 描画結果の代わりに書き込み回数のヒートマップを表示する
+#endif
+
+#if !defined(APP_DRAWREC_DRAIN)
+#define APP_DRAWREC_DRAIN (0)  //< 1以上: (CANVAS_RECORD 有効時) このフレーム数ごとに描画関数の記録を UART へ書き出す (host/tools/drawreplay で再生)
+#endif
+
+#if APP_TRACE_DRAIN && !TRACERING_ENABLE
+#error "APP_TRACE_DRAIN にはトレースリングが必要です (cmake -DTRACERING_ENABLE=ON)"
+#endif
+
+#if APP_DRAWREC_DRAIN && CANVAS_RECORD && APP_BAND_RENDER
+#error "APP_DRAWREC_DRAIN は 1コアの描画のみ記録できます (APP_BAND_RENDER を 0 にしてください)"
+#endif
+
+#define APP_DRAWLIST_CMDS (40)         //< 1フレームの描画命令数の上限
+#define APP_DRAWREC_BYTES (16 * 1024)  //< 描画関数の記録の格納先の大きさ
+
 //////////////////////////////////////////////////////////////////////////////
 // typedef
 //////////////////////////////////////////////////////////////////////////////
@@ -45,6 +87,16 @@ typedef struct tagStringContext_t {
 //////////////////////////////////////////////////////////////////////////////
 
 static uint16_t framebuf[240 * 320 * 2] = {0};  //< フレームバッファメモリ
+static DrawCmd_t drawCmds[APP_DRAWLIST_CMDS];   //< 描画命令の格納先
+static Profiler_t profiler;                     //< 処理時間の計測
+#if CANVAS_OVERDRAW
+static uint8_t overdrawCounts[240 * 320];  //< ピクセルごとの書き込み回数
+static CanvasOverdraw_t overdraw;          //< 書き込み回数の集計 (直近のフレーム)
+#endif
+#if APP_DRAWREC_DRAIN && CANVAS_RECORD
+static uint8_t drawRecBuf[APP_DRAWREC_BYTES];  //< 描画関数の記録の格納先
+static DrawRec_t drawRec;                      //< 描画関数の記録
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // function
@@ -62,7 +114,7 @@ static uint16_t framebuf[240 * 320 * 2] = {0};  //< フレームバッファメ
  * @param fsz
  * @return
  */
-static UError_t drawCharactor(void* arg, uint32_t x, uint32_t y, const void* fp, uint8_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+static UError_t drawCharactor(void* arg, uint32_t x, uint32_t y, const void* fp, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
   // printf("[DEBUG] x[%lu] y[%lu] fp[0x%08lx] c[%c] w[%lu] h[%lu] fsz[%lu]\n",
   // x, y,
   //        (uint32_t)fp, c, fw, fh, fsz);
@@ -70,18 +122,18 @@ static UError_t drawCharactor(void* arg, uint32_t x, uint32_t y, const void* fp,
     StringContext_t* ctx = (StringContext_t*)arg;
     if (NULL != fp) {
       const uint8_t* addr = fp;
-      const uint32_t posx = ctx->curX + (x * fw);
+      const uint32_t cw = (0xff < c) ? (fw / 2) : fw;  // 全角文字は 2キャラクタ分の幅
+      const uint32_t posx = ctx->curX + (x * cw);
       const uint32_t posy = ctx->curY + (y * fh);
+      const size_t bpr = (fw + 7) / 8;  // 1ラインあたりのバイト数
       for (uint32_t h = 0; h < fh; ++h) {
-        uint8_t c = *addr;
         for (uint32_t w = 0; w < fw; ++w) {
-          if ((c & 0b10000000)) {
+          if ((addr[w / 8] & (0b10000000 >> (w % 8)))) {
             Canvas_DrawPixel(ctx->canvas, posx + w, posy + h, ctx->color);
           } else {
           }
-          c = c << 1;
         }  // for(w...)
-        addr++;
+        addr += bpr;
       }  // for(h...)
     }
   }
@@ -90,35 +142,145 @@ static UError_t drawCharactor(void* arg, uint32_t x, uint32_t y, const void* fp,
 }
 
 /**
- * @brief レンダリング処理
- * @param canvas
+ * @brief 文字列描画処理 (描画命令リストから帯ごとに呼び出される)
+ * @param canvas : 描画先
+ * @param arg : 描画する文字列
+ * @return
+ */
+static UError_t drawText(const Canvas_t* canvas, void* arg) {
+  StringContext_t printCtx = {
+      .canvas = canvas,
+      .orgX = 0,
+      .orgY = 0,
+      .curX = 10,
+      .curY = 10,
+      .color = 0xffff,
+  };
+#if CANVAS_OVERDRAW
+  const CanvasPrim_t prev = Canvas_BeginOverdraw(canvas, CanvasPrimText);
+  const UError_t err = Font_Print((const char*)arg, &drawCharactor, &printCtx);
+  Canvas_EndOverdraw(canvas, prev);
+  return err;
+#else
+  return Font_Print((const char*)arg, &drawCharactor, &printCtx);
+#endif
+}
+
+/**
+ * @brief 計測する段階を切り替える (描画命令の間に挟んで再生時に呼び出される)
+ * @param canvas : 描画先 (未使用)
+ * @param arg : 次の段階 (ProfilerStage_t)
+ * @return
+ */
+static UError_t switchStage(const Canvas_t* canvas, void* arg) {
+  (void)canvas;
+  return Profiler_Switch(&profiler, (ProfilerStage_t)(intptr_t)arg);
+}
+
+#if APP_PROFILER_HUD
+/**
+ * @brief 計測結果の表示 (描画命令リストから帯ごとに呼び出される)
+ * @param canvas : 描画先
+ * @param arg : 未使用
+ * @return
+ */
+static UError_t drawHUD(const Canvas_t* canvas, void* arg) {
+  (void)arg;
+  return Profiler_DrawHUD(&profiler, canvas, 240 - PROFILER_HUD_W, 320 - PROFILER_HUD_H);
+}
+#endif
+
+/**
+ * @brief 計測する段階の区切りを記録する. 2コアで再生する場合は両方のコアから呼ばれるため記録しない
+ * @param list
+ * @param stage
+ */
+static void markStage(DrawList_t* list, ProfilerStage_t stage) {
+#if !APP_BAND_RENDER
+  DrawList_Call(list, &switchStage, (void*)(intptr_t)stage);
+#else
+  (void)list;
+  (void)stage;
+#endif
+}
+
+/**
+ * @brief 直近の計測結果を出力する
+ */
+static void printProfile(void) {
+  static const char* const names[ProfilerStageNum] = {"clear", "render", "text", "wait_dma", "set_window", "dma", "frame"};
+  ProfilerSpiStat_t spi;
+
+  for (uint32_t s = 0; s < ProfilerStageNum; ++s) {
+    ProfilerStat_t st;
+    Profiler_GetStat(&profiler, (ProfilerStage_t)s, &st);
+    printf("%-10s min %6lu avg %6lu max %6lu p99 %6lu us\n", names[s], (unsigned long)st.min, (unsigned long)st.avg, (unsigned long)st.max,
+           (unsigned long)st.p99);
+  }
+  Profiler_GetSpiStat(&profiler, &spi);
+  printf("spi %lu byte/s, utilization %lu.%lu%%, dma busy %lu.%lu%%, %s-bound\n", (unsigned long)spi.bytesPerSec, (unsigned long)(spi.utilization / 10),
+         (unsigned long)(spi.utilization % 10), (unsigned long)(spi.dmaBusy / 10), (unsigned long)(spi.dmaBusy % 10), spi.wireBound ? "wire" : "cpu");
+}
+
+#if CANVAS_OVERDRAW
+/**
+ * @brief 直近のフレームの書き込み回数を描画の種類ごとに出力する
+ */
+static void printOverdraw(const Canvas_t* canvas) {
+  static const char* const names[CanvasPrimNum] = {"clear", "pixel", "line", "circle", "fill_circle", "fill_rect", "blit", "scroll", "text", "tilemap"};
+  CanvasOverdrawStat_t st;
+
+  for (int32_t p = CanvasPrimNone; p < CanvasPrimNum; ++p) {
+    if (uSuccess == Canvas_GetOverdrawStat(canvas, (CanvasPrim_t)p, &st) && 0 < st.calls) {
+      printf("%-11s calls %5lu written %7lu unique %7lu\n", (CanvasPrimNone == p) ? "total" : names[p], (unsigned long)st.calls, (unsigned long)st.written,
+             (unsigned long)st.unique);
+    }
+  }
+}
+#endif
+
+#if (APP_TRACE_DRAIN && TRACERING_ENABLE) || (APP_DRAWREC_DRAIN && CANVAS_RECORD) || APIPROF_ENABLE
+/**
+ * @brief トレース / 描画関数の記録 / API プロファイラの書き出し先 (TraceRingWriteFn_t, DrawRecWriteFn_t, ApiProfWriteFn_t).
+ * stdio と同じ UART へ直接書き込む
+ */
+static UError_t writeUart(void* arg, const void* data, size_t size) {
+  (void)arg;
+  uart_write_blocking(uart0, (const uint8_t*)data, size);
+  return uSuccess;
+}
+#endif
+
+/**
+ * @brief レンダリング処理 (描画命令を記録する)
+ * @param list
  * @param f
  * @return
  */
-static UError_t Render(Canvas_t const* canvas, const uint32_t f) {
+static UError_t Render(DrawList_t* list, const uint32_t f) {
   UError_t err = uSuccess;
-  if (NULL == canvas) {
+  if (NULL == list) {
     err = uFailure;
   }
   if (uSuccess == err) {
     // 罫線描画
-    Canvas_DrawLine(canvas, 0, 0, 239, 319, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 239, 0, 0, 319, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 0, 239, 319, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 239, 0, 0, 319, RGB888toRGB565(0xff, 0, 0));
 
-    Canvas_DrawLine(canvas, 0, 0, 0, 319, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 100, 0, 100, 319, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 200, 0, 200, 319, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 0, 0, 319, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 100, 0, 100, 319, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 200, 0, 200, 319, RGB888toRGB565(0xff, 0, 0));
 
-    Canvas_DrawLine(canvas, 0, 0, 239, 0, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 0, 100, 239, 100, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 0, 200, 239, 200, RGB888toRGB565(0xff, 0, 0));
-    Canvas_DrawLine(canvas, 0, 300, 239, 300, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 0, 239, 0, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 100, 239, 100, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 200, 239, 200, RGB888toRGB565(0xff, 0, 0));
+    DrawList_DrawLine(list, 0, 300, 239, 300, RGB888toRGB565(0xff, 0, 0));
 
     // サークル描画
-    Canvas_DrawCircle(canvas, 100, 100, (f % 30) + 1, RGB888toRGB565(0, 0xff, 0));
+    DrawList_DrawCircle(list, 100, 100, (f % 30) + 1, RGB888toRGB565(0, 0xff, 0));
 
     // サークル描画2
-    Canvas_DrawFillCircle(canvas, 200, 200, (f % 20) + 1, RGB888toRGB565(0x0f, 0x0f, 0xff));
+    DrawList_DrawFillCircle(list, 200, 200, (f % 20) + 1, RGB888toRGB565(0x0f, 0x0f, 0xff));
   }
   return err;
 }
@@ -133,7 +295,12 @@ int main(void) {
   SPIDrvContext_t spi;
   LCDDrvContext_t lcd;
   Canvas_t frame[2] = {0};
+  DrawList_t list;
+  BandRender_t bands;
 
+#if APIPROF_ENABLE
+  ApiProf_Init();
+#endif
   SPIDrv_Create(&spi);
   SPIDrvHandle_t hSpi = (SPIDrvHandle_t)&spi;
   LCDDrv_Create(&lcd, hSpi);
@@ -141,6 +308,20 @@ int main(void) {
 
   Canvas_Create(&frame[0], 240, 320, 240, &framebuf[0]);
   Canvas_Create(&frame[1], 240, 320, 240, &framebuf[240 * 320]);
+#if CANVAS_OVERDRAW
+  // 2面で記録先を共有し, フレームごとに 0 に戻す
+  Canvas_AttachOverdraw(&frame[0], &overdraw, overdrawCounts);
+  Canvas_AttachOverdraw(&frame[1], &overdraw, overdrawCounts);
+#endif
+  DrawList_Create(&list, drawCmds, APP_DRAWLIST_CMDS);
+  BandRender_Create(&bands);
+#if APP_DRAWREC_DRAIN && CANVAS_RECORD
+  DrawRec_Create(&drawRec, drawRecBuf, sizeof(drawRecBuf));
+  DrawRec_Attach(&drawRec);
+#endif
+#if APP_BAND_RENDER
+  BandRender_Start(&bands);
+#endif
 
   SPIDrv_Init(hSpi, 25 * 1000 * 1000);
   LCDDrv_Init(hLcd);
@@ -151,6 +332,7 @@ int main(void) {
 
   LCDDrv_Clear(hLcd, 0u, 0u, 0u);
   LCDDrv_SetBrightness(hLcd, 0x7fff);
+  Profiler_Create(&profiler, spi.baudrate);
 
   printf("[DEBUG] Enter EventLoop\n");
 
@@ -165,30 +347,78 @@ int main(void) {
     // printf("LCDDrv_Clear():%lld %lld %lld\n", b, e, absolute_time_diff_us(b,
     // e));
 
+    TRACE_BEGIN(TraceIdFrame, f, 0);
     Canvas_t* canvas = (f % 2) ? &frame[0] : &frame[1];  // フレームバッファ切替
 
-    Canvas_Clear(canvas, RGB888toRGB565(0x90, 0x90, 0x90));  // クリア
-    Render(canvas, f);
+    DrawList_Reset(&list);
+    markStage(&list, ProfilerClear);
+    DrawList_Clear(&list, RGB888toRGB565(0x90, 0x90, 0x90));  // クリア
+    markStage(&list, ProfilerRender);
+    Render(&list, f);
 
     // 文字列描画
-    {
-      StringContext_t printCtx = {
-          .canvas = canvas,
-          .orgX = 0,
-          .orgY = 0,
-          .curX = 10,
-          .curY = 10,
-          .color = 0xffff,
-      };
-      char sbuf[1024];
-      sprintf(sbuf, "Frametime: %9lld us\n", difftime);
-      Font_Print(sbuf, &drawCharactor, &printCtx);
-    }
+    char sbuf[32] = "Frametime: ";
+    size_t len = strlen(sbuf);
+    size_t n = 0;
+    NumFmt_I32(&sbuf[len], sizeof(sbuf) - len, (int32_t)difftime, 9, ' ', &n);
+    len += n;
+    strncpy(&sbuf[len], " us\n", sizeof(sbuf) - len);
+    markStage(&list, ProfilerText);
+    DrawList_Call(&list, &drawText, sbuf);
+    markStage(&list, ProfilerNone);
+#if APP_PROFILER_HUD
+    DrawList_Call(&list, &drawHUD, NULL);
+#endif
+
+#if CANVAS_OVERDRAW
+    Canvas_ResetOverdraw(canvas);
+#endif
+#if APP_BAND_RENDER
+    Profiler_Begin(&profiler, ProfilerRender);
+#endif
+    BandRender_Execute(&bands, &list, canvas);  // 記録した命令を再生 (APP_BAND_RENDER 無効時は 1コアで順に再生)
+#if APP_BAND_RENDER
+    Profiler_End(&profiler, ProfilerRender);
+#endif
+#if APP_DRAWREC_DRAIN && CANVAS_RECORD
+    DrawRec_EndFrame(&drawRec);
+#endif
+#if CANVAS_OVERDRAW && APP_OVERDRAW_HEATMAP
+    Canvas_DrawOverdrawHeatmap(canvas, canvas, NULL);
+#endif
     etime = get_absolute_time();
     difftime = absolute_time_diff_us(btime, etime);
     btime = etime;
     LCDDrv_SwapBuff(hLcd, Canvas_GetBuf(canvas), 0, 0, 240, 320);
+
+    // 完了待ち, ウィンドウ設定, DMA 転送の時間は LCDDrv の計測値を使用する
+    LCDDrvTiming_t timing;
+    LCDDrv_GetTiming(hLcd, &timing, true);
+    Profiler_AddLCDTiming(&profiler, &timing);
+    Profiler_EndFrame(&profiler);
+    TRACE_END(TraceIdFrame, f, 0);
     f++;
+    if (0 == (f % PROFILER_WINDOW)) {
+      printProfile();
+#if CANVAS_OVERDRAW
+      printOverdraw(canvas);
+#endif
+#if APIPROF_ENABLE
+      // 直近 PROFILER_WINDOW フレームの公開関数ごとのヒストグラム
+      ApiProf_Dump(&writeUart, NULL);
+      ApiProf_Reset();
+#endif
+    }
+#if APP_TRACE_DRAIN && TRACERING_ENABLE
+    if (0 == (f % APP_TRACE_DRAIN)) {
+      TraceRing_Drain(&TraceRing_Default, &writeUart, NULL, NULL);
+    }
+#endif
+#if APP_DRAWREC_DRAIN && CANVAS_RECORD
+    if (0 == (f % APP_DRAWREC_DRAIN)) {
+      DrawRec_Drain(&drawRec, &writeUart, NULL);
+    }
+#endif
   }
   return 0;
 }
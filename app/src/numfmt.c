@@ -0,0 +1,124 @@
+/**
+ * @file prog01/app/src/numfmt.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/numfmt.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define NUMFMT_MAX_DIGITS (10)  //< uint32_t の最大桁数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 符号, 数字列, 埋め文字を組み立てて buf へ出力する
+ * @param [out] buf : 格納先
+ * @param [in] size : buf のサイズ
+ * @param [in] neg : 負数の場合 true
+ * @param [in] v : 絶対値
+ * @param [in] frac : 小数部の桁数 (0: 整数)
+ * @param [in] width : 最小桁数
+ * @param [in] pad : 埋め文字
+ * @param [out] plen : 書き込んだ文字数
+ * @return 処理結果
+ */
+static UError_t format(char* buf, size_t size, bool neg, uint32_t v, uint32_t frac, uint32_t width, char pad, size_t* plen);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t format(char* buf, size_t size, bool neg, uint32_t v, uint32_t frac, uint32_t width, char pad, size_t* plen) {
+  UError_t err = uSuccess;
+  char digits[(NUMFMT_MAX_DIGITS * 2) + 1];  // 小数部 + 小数点 + 整数部
+  size_t nd = 0;
+
+  if (uSuccess == err) {
+    if (NULL == buf || NUMFMT_MAX_DIGITS <= frac) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 下位桁から格納する. 小数部は 0 埋めで frac 桁, 整数部は最低 1桁
+    for (uint32_t i = 0; i < frac; ++i) {
+      digits[nd++] = (char)('0' + (v % 10));
+      v /= 10;
+    }
+    if (0 != frac) {
+      digits[nd++] = '.';
+    }
+    do {
+      digits[nd++] = (char)('0' + (v % 10));
+      v /= 10;
+    } while (0 != v);
+
+    const size_t sign = neg ? 1 : 0;
+    const size_t body = nd + sign;
+    const size_t npad = (width > body) ? width - body : 0;
+    if (size < body + npad + 1) {
+      err = uFailure;
+    } else {
+      char* p = buf;
+      if ('0' == pad) {
+        if (neg) {
+          *p++ = '-';
+        }
+        for (size_t i = 0; i < npad; ++i) {
+          *p++ = '0';
+        }
+      } else {
+        for (size_t i = 0; i < npad; ++i) {
+          *p++ = pad;
+        }
+        if (neg) {
+          *p++ = '-';
+        }
+      }
+      while (0 < nd) {
+        *p++ = digits[--nd];
+      }
+      *p = 0;
+      if (NULL != plen) {
+        *plen = (size_t)(p - buf);
+      }
+    }
+  }
+
+  return err;
+}
+
+UError_t NumFmt_U32(char* buf, size_t size, uint32_t v, uint32_t width, char pad, size_t* plen) { return format(buf, size, false, v, 0, width, pad, plen); }
+
+UError_t NumFmt_I32(char* buf, size_t size, int32_t v, uint32_t width, char pad, size_t* plen) {
+  const bool neg = (0 > v);
+  const uint32_t a = neg ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+  return format(buf, size, neg, a, 0, width, pad, plen);
+}
+
+UError_t NumFmt_Fixed(char* buf, size_t size, int32_t v, uint32_t frac, uint32_t width, char pad, size_t* plen) {
+  const bool neg = (0 > v);
+  const uint32_t a = neg ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+  return format(buf, size, neg, a, frac, width, pad, plen);
+}
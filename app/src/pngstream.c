@@ -0,0 +1,900 @@
+/**
+ * @file prog01/app/src/pngstream.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include <user/canvas.h>
+#include <user/lcddrv.h>
+#include <user/pngstream.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define ALIGN (8)  //< 作業領域から確保する単位 (単位: byte)
+
+#define CHUNK(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+#define CHUNK_IHDR CHUNK('I', 'H', 'D', 'R')
+#define CHUNK_PLTE CHUNK('P', 'L', 'T', 'E')
+#define CHUNK_TRNS CHUNK('t', 'R', 'N', 'S')
+#define CHUNK_IDAT CHUNK('I', 'D', 'A', 'T')
+#define CHUNK_IEND CHUNK('I', 'E', 'N', 'D')
+
+#define CRC_SIZE (4)  //< チャンク末尾の CRC (検査せず読み飛ばす)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 1回の PngStream_Decode() の状態
+ */
+typedef struct tagDecoder_t {
+  PngStream_t* ctx;
+  PngStreamReadFn_t read;
+  void* readArg;
+  // 入力バッファ
+  uint8_t* in;
+  size_t inPos;
+  size_t inLen;
+  // 現在のチャンク
+  uint32_t chunkType;
+  uint32_t chunkRemain;  //< 読み残したデータ (CRC を除く)
+  // 展開
+  z_stream z;
+  bool streamEnd;
+} Decoder_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 作業領域から確保する (zlib の zalloc. 解放しない)
+ */
+static voidpf workAlloc(voidpf opaque, uInt items, uInt size);
+
+/**
+ * @brief 何もしない (zlib の zfree. 作業領域は PngStream_Decode() ごとに先頭から使用する)
+ */
+static void workFree(voidpf opaque, voidpf address);
+
+/**
+ * @brief 入力バッファへ読み出す
+ */
+static UError_t refill(Decoder_t* dec);
+
+/**
+ * @brief 入力から n byte を dst へ読み出す (dst が NULL の場合は読み飛ばす)
+ */
+static UError_t readBytes(Decoder_t* dec, uint8_t* dst, size_t n);
+
+/**
+ * @brief チャンクの先頭 (長さ, 種類) を読み出す
+ */
+static UError_t readChunkHeader(Decoder_t* dec);
+
+/**
+ * @brief IHDR を読み出し, 形式を検査する
+ */
+static UError_t readHeader(Decoder_t* dec);
+
+/**
+ * @brief PLTE / tRNS を読み出す
+ */
+static UError_t readPalette(Decoder_t* dec);
+static UError_t readTransparency(Decoder_t* dec);
+
+/**
+ * @brief 圧縮データを展開して out を埋める (IDAT をまたいで入力する. 圧縮データの終端では途中で戻る)
+ */
+static UError_t inflateTo(Decoder_t* dec, uint8_t* out, size_t size);
+
+/**
+ * @brief 最初の IDAT から全ての行を展開し, 圧縮データの終端まで読み出す
+ */
+static UError_t decodeImage(Decoder_t* dec, PngStreamRowFn_t row, void* rowArg);
+
+/**
+ * @brief 行のフィルタを戻す
+ * @param [inout] cur : フィルタ種別 + 1行分のデータ
+ * @param [in] prev : 前の行 (フィルタ種別を除く)
+ */
+static UError_t unfilter(uint8_t* cur, const uint8_t* prev, size_t rowBytes, uint32_t bpp);
+
+/**
+ * @brief 1行を RGB565 へ変換する
+ */
+static void convertRow(const PngStream_t* ctx, const uint8_t* raw, uint16_t* out, uint32_t y);
+
+/**
+ * @brief 8bit の RGB を RGB565 (キャンバスと同じ格納順) へ変換する
+ */
+inline static uint16_t toRGB565(bool dither, uint32_t r, uint32_t g, uint32_t b, uint32_t x, uint32_t y);
+
+/**
+ * @brief 背景色と合成する
+ */
+inline static uint32_t blend(uint32_t c, uint32_t a, uint32_t bg);
+
+/**
+ * @brief i 番目のサンプルを取り出す
+ */
+inline static uint32_t sampleAt(const uint8_t* raw, uint32_t i, uint32_t depth);
+
+/**
+ * @brief サンプルを 8bit へ変換する
+ */
+inline static uint32_t to8(uint32_t v, uint32_t depth);
+
+inline static uint32_t loadBE32(const uint8_t* p);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+/**
+ * 4x4 の組織的ディザの閾値 (Bayer 行列. 0 - 15)
+ */
+static const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static voidpf workAlloc(voidpf opaque, uInt items, uInt size) {
+  PngStream_t* const ctx = (PngStream_t*)opaque;
+  const size_t bytes = (((size_t)items * size) + (ALIGN - 1)) & ~(size_t)(ALIGN - 1);
+  if (ctx->workSize - ctx->workUsed < bytes) {
+    return Z_NULL;
+  }
+  voidpf p = ctx->work + ctx->workUsed;
+  ctx->workUsed += bytes;
+  return p;
+}
+
+static void workFree(voidpf opaque, voidpf address) {
+  (void)opaque;
+  (void)address;
+}
+
+inline static uint32_t loadBE32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+
+static UError_t refill(Decoder_t* dec) {
+  size_t n = 0;
+  UError_t err = dec->read(dec->readArg, dec->in, PNGSTREAM_INPUT_SIZE, &n);
+  if (uSuccess == err && (0 == n || PNGSTREAM_INPUT_SIZE < n)) {
+    // 入力の途中終了
+    err = uFailure;
+  }
+  dec->inPos = 0;
+  dec->inLen = (uSuccess == err) ? n : 0;
+  return err;
+}
+
+static UError_t readBytes(Decoder_t* dec, uint8_t* dst, size_t n) {
+  UError_t err = uSuccess;
+  while (uSuccess == err && 0 < n) {
+    if (dec->inPos == dec->inLen) {
+      err = refill(dec);
+      continue;
+    }
+    size_t m = dec->inLen - dec->inPos;
+    m = (n < m) ? n : m;
+    if (NULL != dst) {
+      memcpy(dst, dec->in + dec->inPos, m);
+      dst += m;
+    }
+    dec->inPos += m;
+    n -= m;
+  }
+  return err;
+}
+
+static UError_t readChunkHeader(Decoder_t* dec) {
+  uint8_t head[8];
+  UError_t err = readBytes(dec, head, sizeof(head));
+  if (uSuccess == err) {
+    dec->chunkRemain = loadBE32(&head[0]);
+    dec->chunkType = loadBE32(&head[4]);
+    if (0x7fffffffu < dec->chunkRemain) {
+      err = uFailure;
+    }
+  }
+  return err;
+}
+
+static UError_t readHeader(Decoder_t* dec) {
+  PngStream_t* const ctx = dec->ctx;
+  UError_t err = uSuccess;
+  uint8_t ihdr[13];
+
+  if (uSuccess == err) {
+    if (sizeof(ihdr) != dec->chunkRemain) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = readBytes(dec, ihdr, sizeof(ihdr));
+    dec->chunkRemain = 0;
+  }
+
+  if (uSuccess == err) {
+    PngInfo_t* const info = &ctx->info;
+    info->w = loadBE32(&ihdr[0]);
+    info->h = loadBE32(&ihdr[4]);
+    info->depth = ihdr[8];
+    info->colorType = ihdr[9];
+    info->interlace = ihdr[12];
+
+    // 形式ごとに許されるビット深度 (bit n: 深度 n)
+    uint32_t depths = 0;
+    switch (info->colorType) {
+      case 0:
+        ctx->channels = 1;
+        depths = (1u << 1) | (1u << 2) | (1u << 4) | (1u << 8) | (1u << 16);
+        break;
+      case 2:
+        ctx->channels = 3;
+        depths = (1u << 8) | (1u << 16);
+        break;
+      case 3:
+        ctx->channels = 1;
+        depths = (1u << 1) | (1u << 2) | (1u << 4) | (1u << 8);
+        break;
+      case 4:
+        ctx->channels = 2;
+        depths = (1u << 8) | (1u << 16);
+        break;
+      case 6:
+        ctx->channels = 4;
+        depths = (1u << 8) | (1u << 16);
+        break;
+      default:
+        break;
+    }
+    if (0 == info->w || 0 == info->h || 0x7fffffffu < info->w || 0x7fffffffu < info->h || 16 < info->depth || 0 == (depths & (1u << info->depth))) {
+      err = uFailure;
+    }
+    // 圧縮方式 / フィルタ方式は 0 のみ定義されている. インターレースは行単位で出力できない
+    if (0 != ihdr[10] || 0 != ihdr[11] || 0 != info->interlace) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const uint64_t bits = (uint64_t)ctx->info.w * ctx->channels * ctx->info.depth;
+    if ((uint64_t)(SIZE_MAX / 4) < (bits + 7) / 8) {
+      err = uFailure;
+    } else {
+      ctx->rowBytes = (size_t)((bits + 7) / 8);
+      const uint32_t bytes = (ctx->channels * ctx->info.depth) / 8;
+      ctx->bpp = (0 == bytes) ? 1 : bytes;
+    }
+  }
+
+  return err;
+}
+
+static UError_t readPalette(Decoder_t* dec) {
+  PngStream_t* const ctx = dec->ctx;
+  UError_t err = uSuccess;
+  uint8_t rgb[256 * 3];
+
+  if (uSuccess == err) {
+    if (0 == dec->chunkRemain || sizeof(rgb) < dec->chunkRemain || 0 != dec->chunkRemain % 3) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = readBytes(dec, rgb, dec->chunkRemain);
+  }
+
+  if (uSuccess == err) {
+    ctx->paletteSize = dec->chunkRemain / 3;
+    for (uint32_t i = 0; i < ctx->paletteSize; ++i) {
+      ctx->palette[i][0] = rgb[(i * 3) + 0];
+      ctx->palette[i][1] = rgb[(i * 3) + 1];
+      ctx->palette[i][2] = rgb[(i * 3) + 2];
+      ctx->palette[i][3] = 0xff;
+    }
+    dec->chunkRemain = 0;
+  }
+
+  return err;
+}
+
+static UError_t readTransparency(Decoder_t* dec) {
+  PngStream_t* const ctx = dec->ctx;
+  UError_t err = uSuccess;
+  uint8_t trns[256];
+
+  if (uSuccess == err) {
+    if (sizeof(trns) < dec->chunkRemain) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = readBytes(dec, trns, dec->chunkRemain);
+  }
+
+  if (uSuccess == err) {
+    switch (ctx->info.colorType) {
+      case 0:
+        if (2 == dec->chunkRemain) {
+          ctx->hasKey = true;
+          ctx->key[0] = (uint16_t)((trns[0] << 8) | trns[1]);
+        }
+        break;
+      case 2:
+        if (6 == dec->chunkRemain) {
+          ctx->hasKey = true;
+          for (uint32_t i = 0; i < 3; ++i) {
+            ctx->key[i] = (uint16_t)((trns[i * 2] << 8) | trns[(i * 2) + 1]);
+          }
+        }
+        break;
+      case 3:
+        for (uint32_t i = 0; i < dec->chunkRemain && i < ctx->paletteSize; ++i) {
+          ctx->palette[i][3] = trns[i];
+        }
+        break;
+      default:
+        // アルファを持つ形式では使用しない
+        break;
+    }
+    dec->chunkRemain = 0;
+  }
+
+  return err;
+}
+
+static UError_t inflateTo(Decoder_t* dec, uint8_t* out, size_t size) {
+  UError_t err = uSuccess;
+  z_stream* const z = &dec->z;
+
+  z->next_out = out;
+  z->avail_out = (uInt)size;
+  while (uSuccess == err && 0 < z->avail_out && !dec->streamEnd) {
+    // 入力バッファを IDAT のデータの範囲だけ渡す
+    if (0 == z->avail_in) {
+      if (0 == dec->chunkRemain) {
+        err = readBytes(dec, NULL, CRC_SIZE);
+        if (uSuccess == err) {
+          err = readChunkHeader(dec);
+        }
+        if (uSuccess == err && CHUNK_IDAT != dec->chunkType) {
+          err = uFailure;
+        }
+        continue;
+      }
+      if (dec->inPos == dec->inLen) {
+        err = refill(dec);
+        continue;
+      }
+      const size_t avail = dec->inLen - dec->inPos;
+      z->next_in = dec->in + dec->inPos;
+      z->avail_in = (uInt)((dec->chunkRemain < avail) ? dec->chunkRemain : avail);
+    }
+
+    const uInt before = z->avail_in;
+    const int ret = inflate(z, Z_NO_FLUSH);
+    const uInt used = before - z->avail_in;
+    dec->inPos += used;
+    dec->chunkRemain -= used;
+    if (Z_STREAM_END == ret) {
+      dec->streamEnd = true;
+    } else if (Z_OK != ret) {
+      // 不正なデータ, Adler-32 の不一致, 作業領域の不足
+      err = uFailure;
+    }
+  }
+
+  return err;
+}
+
+static UError_t decodeImage(Decoder_t* dec, PngStreamRowFn_t row, void* rowArg) {
+  PngStream_t* const ctx = dec->ctx;
+  UError_t err = uSuccess;
+  uint8_t* raw[2] = {NULL, NULL};
+  uint16_t* out[2] = {NULL, NULL};
+  bool zInit = false;
+
+  if (uSuccess == err) {
+    if (3 == ctx->info.colorType && 0 == ctx->paletteSize) {
+      err = uFailure;
+    }
+  }
+
+  // 2行分の展開データ (フィルタ種別 + 1行) と出力を確保する. 前の行の初期値は 0
+  if (uSuccess == err) {
+    const size_t rawSize = ctx->rowBytes + 1;
+    for (uint32_t i = 0; uSuccess == err && i < 2; ++i) {
+      raw[i] = (uint8_t*)workAlloc(ctx, 1, (uInt)rawSize);
+      out[i] = (uint16_t*)workAlloc(ctx, ctx->info.w, sizeof(uint16_t));
+      if (NULL == raw[i] || NULL == out[i]) {
+        err = uFailure;
+      }
+    }
+    if (uSuccess == err) {
+      memset(raw[0], 0, rawSize);
+      memset(raw[1], 0, rawSize);
+    }
+  }
+
+  // パレットは背景色と合成しておく (行の変換ではアルファを扱わない)
+  if (uSuccess == err && 3 == ctx->info.colorType) {
+    for (uint32_t i = 0; i < ctx->paletteSize; ++i) {
+      const uint32_t a = ctx->palette[i][3];
+      for (uint32_t c = 0; c < 3; ++c) {
+        ctx->palette[i][c] = (uint8_t)blend(ctx->palette[i][c], a, ctx->background[c]);
+      }
+      ctx->palette[i][3] = 0xff;
+    }
+  }
+
+  // 窓の大きさは zlib ヘッダに従う (windowBits = 0)
+  if (uSuccess == err) {
+    memset(&dec->z, 0, sizeof(dec->z));
+    dec->z.zalloc = workAlloc;
+    dec->z.zfree = workFree;
+    dec->z.opaque = ctx;
+    if (Z_OK != inflateInit2(&dec->z, 0)) {
+      err = uFailure;
+    } else {
+      zInit = true;
+    }
+  }
+
+  for (uint32_t y = 0; uSuccess == err && y < ctx->info.h; ++y) {
+    uint8_t* const cur = raw[y & 1];
+    const uint8_t* const prev = raw[(y & 1) ^ 1];
+    err = inflateTo(dec, cur, ctx->rowBytes + 1);
+    if (uSuccess == err && 0 < dec->z.avail_out) {
+      // 圧縮データが行の途中で終わっている
+      err = uFailure;
+    }
+    if (uSuccess == err) {
+      err = unfilter(cur, prev + 1, ctx->rowBytes, ctx->bpp);
+    }
+    if (uSuccess == err) {
+      convertRow(ctx, cur + 1, out[y & 1], y);
+      err = row(rowArg, y, out[y & 1], ctx->info.w);
+    }
+  }
+
+  // 残りの圧縮データを展開して Adler-32 を検査する (行の後の余分なデータは捨てる)
+  while (uSuccess == err && !dec->streamEnd) {
+    uint8_t scratch[64];
+    err = inflateTo(dec, scratch, sizeof(scratch));
+  }
+
+  // IDAT の残り (CRC を含む) を読み飛ばし, 次のチャンクの先頭へ進める
+  if (uSuccess == err) {
+    err = readBytes(dec, NULL, (size_t)dec->chunkRemain + CRC_SIZE);
+    dec->chunkRemain = 0;
+  }
+
+  if (zInit) {
+    (void)inflateEnd(&dec->z);
+  }
+
+  return err;
+}
+
+static UError_t unfilter(uint8_t* cur, const uint8_t* prev, size_t rowBytes, uint32_t bpp) {
+  UError_t err = uSuccess;
+  const uint8_t type = cur[0];
+  uint8_t* const p = cur + 1;
+
+  switch (type) {
+    case 0:  // None
+      break;
+    case 1:  // Sub
+      for (size_t i = bpp; i < rowBytes; ++i) {
+        p[i] = (uint8_t)(p[i] + p[i - bpp]);
+      }
+      break;
+    case 2:  // Up
+      for (size_t i = 0; i < rowBytes; ++i) {
+        p[i] = (uint8_t)(p[i] + prev[i]);
+      }
+      break;
+    case 3:  // Average
+      for (size_t i = 0; i < bpp && i < rowBytes; ++i) {
+        p[i] = (uint8_t)(p[i] + (prev[i] >> 1));
+      }
+      for (size_t i = bpp; i < rowBytes; ++i) {
+        p[i] = (uint8_t)(p[i] + (((uint32_t)p[i - bpp] + prev[i]) >> 1));
+      }
+      break;
+    case 4:  // Paeth
+      for (size_t i = 0; i < bpp && i < rowBytes; ++i) {
+        p[i] = (uint8_t)(p[i] + prev[i]);
+      }
+      for (size_t i = bpp; i < rowBytes; ++i) {
+        const int32_t a = p[i - bpp];
+        const int32_t b = prev[i];
+        const int32_t c = prev[i - bpp];
+        const int32_t pa = (b - c < 0) ? c - b : b - c;
+        const int32_t pb = (a - c < 0) ? c - a : a - c;
+        const int32_t pc = (a + b - c - c < 0) ? c + c - a - b : a + b - c - c;
+        const int32_t pred = (pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c);
+        p[i] = (uint8_t)(p[i] + pred);
+      }
+      break;
+    default:
+      err = uFailure;
+      break;
+  }
+
+  return err;
+}
+
+inline static uint16_t toRGB565(bool dither, uint32_t r, uint32_t g, uint32_t b, uint32_t x, uint32_t y) {
+  uint32_t r5, g6, b5;
+  if (dither) {
+    // v * 31 / 255 に閾値 (t + 0.5) / 16 を加えて切り捨てる (255 でも 31 を超えない)
+    const uint32_t t = (bayer4[y & 3][x & 3] * 255u) + 127u;
+    r5 = ((r * 496u) + t) / 4080u;
+    g6 = ((g * 1008u) + t) / 4080u;
+    b5 = ((b * 496u) + t) / 4080u;
+  } else {
+    r5 = r >> 3;
+    g6 = g >> 2;
+    b5 = b >> 3;
+  }
+  // RGB888toRGB565() と同じ格納順 (上位バイトと下位バイトを入れ替えた RGB565)
+  return (uint16_t)(((g6 & 0x07u) << 13) | (b5 << 8) | (r5 << 3) | (g6 >> 3));
+}
+
+inline static uint32_t blend(uint32_t c, uint32_t a, uint32_t bg) { return ((c * a) + (bg * (255u - a)) + 127u) / 255u; }
+
+inline static uint32_t sampleAt(const uint8_t* raw, uint32_t i, uint32_t depth) {
+  switch (depth) {
+    case 8:
+      return raw[i];
+    case 16:
+      return ((uint32_t)raw[i * 2] << 8) | raw[(i * 2) + 1];
+    default: {
+      const uint32_t bit = i * depth;
+      return (raw[bit >> 3] >> (8u - depth - (bit & 7u))) & ((1u << depth) - 1u);
+    }
+  }
+}
+
+inline static uint32_t to8(uint32_t v, uint32_t depth) {
+  switch (depth) {
+    case 8:
+      return v;
+    case 16:
+      return v >> 8;
+    default:
+      return (v * 255u) / ((1u << depth) - 1u);
+  }
+}
+
+static void convertRow(const PngStream_t* ctx, const uint8_t* raw, uint16_t* out, uint32_t y) {
+  const uint32_t w = ctx->info.w;
+  const uint32_t depth = ctx->info.depth;
+  const bool dither = ctx->dither;
+  const uint8_t* const bg = ctx->background;
+
+  // よく使う 8bit の形式
+  if (8 == depth) {
+    if (2 == ctx->info.colorType && !ctx->hasKey) {
+      for (uint32_t x = 0; x < w; ++x, raw += 3) {
+        out[x] = toRGB565(dither, raw[0], raw[1], raw[2], x, y);
+      }
+      return;
+    }
+    if (6 == ctx->info.colorType) {
+      for (uint32_t x = 0; x < w; ++x, raw += 4) {
+        const uint32_t a = raw[3];
+        if (0xff == a) {
+          out[x] = toRGB565(dither, raw[0], raw[1], raw[2], x, y);
+        } else {
+          out[x] = toRGB565(dither, blend(raw[0], a, bg[0]), blend(raw[1], a, bg[1]), blend(raw[2], a, bg[2]), x, y);
+        }
+      }
+      return;
+    }
+    if (3 == ctx->info.colorType) {
+      for (uint32_t x = 0; x < w; ++x) {
+        // 範囲外のインデックスは 0 番として扱う
+        const uint8_t* const c = ctx->palette[(raw[x] < ctx->paletteSize) ? raw[x] : 0];
+        out[x] = toRGB565(dither, c[0], c[1], c[2], x, y);
+      }
+      return;
+    }
+  }
+
+  for (uint32_t x = 0; x < w; ++x) {
+    uint32_t r = 0, g = 0, b = 0, a = 0xff;
+    switch (ctx->info.colorType) {
+      case 0: {
+        const uint32_t v = sampleAt(raw, x, depth);
+        r = g = b = to8(v, depth);
+        if (ctx->hasKey && v == ctx->key[0]) {
+          a = 0;
+        }
+      } break;
+      case 2: {
+        const uint32_t rv = sampleAt(raw, (x * 3) + 0, depth);
+        const uint32_t gv = sampleAt(raw, (x * 3) + 1, depth);
+        const uint32_t bv = sampleAt(raw, (x * 3) + 2, depth);
+        r = to8(rv, depth);
+        g = to8(gv, depth);
+        b = to8(bv, depth);
+        if (ctx->hasKey && rv == ctx->key[0] && gv == ctx->key[1] && bv == ctx->key[2]) {
+          a = 0;
+        }
+      } break;
+      case 3: {
+        const uint32_t i = sampleAt(raw, x, depth);
+        const uint8_t* const c = ctx->palette[(i < ctx->paletteSize) ? i : 0];
+        r = c[0];
+        g = c[1];
+        b = c[2];
+      } break;
+      case 4:
+        r = g = b = to8(sampleAt(raw, (x * 2) + 0, depth), depth);
+        a = to8(sampleAt(raw, (x * 2) + 1, depth), depth);
+        break;
+      case 6:
+        r = to8(sampleAt(raw, (x * 4) + 0, depth), depth);
+        g = to8(sampleAt(raw, (x * 4) + 1, depth), depth);
+        b = to8(sampleAt(raw, (x * 4) + 2, depth), depth);
+        a = to8(sampleAt(raw, (x * 4) + 3, depth), depth);
+        break;
+      default:
+        break;
+    }
+    if (0xff != a) {
+      r = blend(r, a, bg[0]);
+      g = blend(g, a, bg[1]);
+      b = blend(b, a, bg[2]);
+    }
+    out[x] = toRGB565(dither, r, g, b, x, y);
+  }
+}
+
+UError_t PngStream_Create(PngStream_t* ctx, void* work, size_t size) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == work || 0 == size) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(ctx, 0, sizeof(PngStream_t));
+    // 作業領域の先頭を ALIGN 境界に合わせる
+    const size_t pad = (ALIGN - ((uintptr_t)work & (ALIGN - 1))) & (ALIGN - 1);
+    if (size <= pad) {
+      err = uFailure;
+    } else {
+      ctx->work = (uint8_t*)work + pad;
+      ctx->workSize = size - pad;
+    }
+  }
+
+  return err;
+}
+
+UError_t PngStream_SetBackground(PngStream_t* ctx, uint8_t r, uint8_t g, uint8_t b) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->background[0] = r;
+    ctx->background[1] = g;
+    ctx->background[2] = b;
+  }
+
+  return err;
+}
+
+UError_t PngStream_SetDither(PngStream_t* ctx, bool enable) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->dither = enable;
+  }
+
+  return err;
+}
+
+UError_t PngStream_Decode(PngStream_t* ctx, PngStreamReadFn_t read, void* readArg, PngStreamRowFn_t row, void* rowArg) {
+  UError_t err = uSuccess;
+  Decoder_t dec;
+  bool header = false;
+  bool image = false;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->work || NULL == read || NULL == row) {
+      err = uFailure;
+    }
+  }
+
+  // 前回のデコードの状態を消去し, 作業領域を先頭から使用する
+  if (uSuccess == err) {
+    memset(&ctx->info, 0, sizeof(ctx->info));
+    ctx->paletteSize = 0;
+    ctx->hasKey = false;
+    ctx->workUsed = 0;
+
+    memset(&dec, 0, sizeof(dec));
+    dec.ctx = ctx;
+    dec.read = read;
+    dec.readArg = readArg;
+    dec.in = (uint8_t*)workAlloc(ctx, 1, PNGSTREAM_INPUT_SIZE);
+    if (NULL == dec.in) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    uint8_t sig[sizeof(signature)];
+    err = readBytes(&dec, sig, sizeof(sig));
+    if (uSuccess == err && 0 != memcmp(sig, signature, sizeof(sig))) {
+      err = uFailure;
+    }
+  }
+
+  // IEND までチャンクを順に処理する
+  while (uSuccess == err) {
+    err = readChunkHeader(&dec);
+    if (uSuccess != err) {
+      break;
+    }
+    if (!header && CHUNK_IHDR != dec.chunkType) {
+      err = uFailure;
+      break;
+    }
+
+    if (CHUNK_IEND == dec.chunkType) {
+      if (!image) {
+        err = uFailure;
+      }
+      break;
+    } else if (CHUNK_IHDR == dec.chunkType) {
+      err = header ? uFailure : readHeader(&dec);
+      header = true;
+    } else if (CHUNK_PLTE == dec.chunkType && !image) {
+      err = readPalette(&dec);
+    } else if (CHUNK_TRNS == dec.chunkType && !image) {
+      err = readTransparency(&dec);
+    } else if (CHUNK_IDAT == dec.chunkType && !image) {
+      err = decodeImage(&dec, row, rowArg);
+      image = true;
+      continue;
+    }
+
+    // 未対応のチャンク (と読み残し) と CRC を読み飛ばす
+    if (uSuccess == err) {
+      err = readBytes(&dec, NULL, (size_t)dec.chunkRemain + CRC_SIZE);
+      dec.chunkRemain = 0;
+    }
+  }
+
+  return err;
+}
+
+UError_t PngStream_GetInfo(const PngStream_t* ctx, PngInfo_t* info) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == info || 0 == ctx->info.w) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    *info = ctx->info;
+  }
+
+  return err;
+}
+
+UError_t PngStream_ReadMemory(void* arg, void* buf, size_t size, size_t* read) {
+  UError_t err = uSuccess;
+  PngStreamMemory_t* const src = (PngStreamMemory_t*)arg;
+
+  if (uSuccess == err) {
+    if (NULL == src || NULL == src->data || NULL == buf || NULL == read || src->size < src->pos) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t rest = src->size - src->pos;
+    const size_t n = (size < rest) ? size : rest;
+    memcpy(buf, src->data + src->pos, n);
+    src->pos += n;
+    *read = n;
+  }
+
+  return err;
+}
+
+UError_t PngStream_RowToCanvas(void* arg, uint32_t y, const uint16_t* row, uint32_t w) {
+  UError_t err = uSuccess;
+  const PngStreamCanvas_t* const dst = (const PngStreamCanvas_t*)arg;
+
+  if (uSuccess == err) {
+    if (NULL == dst || NULL == dst->canvas || NULL == row) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const Canvas_t* const canvas = dst->canvas;
+    const int64_t cy = (int64_t)dst->y + y;
+    int64_t cx = dst->x;
+    int64_t sx = 0;
+    if (cx < 0) {
+      sx = -cx;
+      cx = 0;
+    }
+    // キャンバス (帯) の外の行, 列は書き込まない
+    if (0 <= cy && cy < (int64_t)canvas->h && cx < (int64_t)canvas->w && sx < (int64_t)w) {
+      const int64_t rest = (int64_t)canvas->w - cx;
+      const int64_t cw = ((int64_t)w - sx < rest) ? (int64_t)w - sx : rest;
+      err = Canvas_Blit(canvas, (size_t)cx, (size_t)cy, (size_t)cw, 1, row + sx, w);
+    }
+  }
+
+  return err;
+}
+
+UError_t PngStream_RowToLCD(void* arg, uint32_t y, const uint16_t* row, uint32_t w) {
+  UError_t err = uSuccess;
+  const PngStreamLCD_t* const dst = (const PngStreamLCD_t*)arg;
+
+  if (uSuccess == err) {
+    if (NULL == dst || NULL == row || UINT16_MAX < w || UINT16_MAX < (uint32_t)dst->y + y) {
+      err = uFailure;
+    }
+  }
+
+  // 前の行の転送完了は LCDDrv_SwapBuff() が待つ (出力する行は 2行を交互に使用している)
+  if (uSuccess == err) {
+    err = LCDDrv_SwapBuff(dst->lcd, row, dst->x, (uint16_t)(dst->y + y), (uint16_t)w, 1);
+  }
+
+  return err;
+}
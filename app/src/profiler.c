@@ -0,0 +1,395 @@
+/**
+ * @file prog01/app/src/profiler.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+
+#include <user/canvas.h>
+#include <user/font.h>
+#include <user/lcddrv.h>
+#include <user/macros.h>
+#include <user/numfmt.h>
+#include <user/profiler.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define PROFILER_HUD_TEXT_H (16)  //< 文字の行の高さ (単位: pixel)
+#define PROFILER_HUD_BAR_H (3)    //< 棒の高さ (単位: pixel)
+#define PROFILER_HUD_BAR_GAP (1)  //< 棒の間隔 (単位: pixel)
+#define PROFILER_HUD_MARGIN (2)   //< 棒の左右の余白 (単位: pixel)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * HUD の文字描画先 (Font_Print() の描画関数へ渡す)
+ */
+typedef struct tagProfilerText_t {
+  const Canvas_t* canvas;
+  size_t x;
+  size_t y;
+  uint16_t color;
+} ProfilerText_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 段階が計測対象か判定する
+ */
+static inline bool Profiler_IsStage(ProfilerStage_t stage);
+
+/**
+ * @brief 経過時間を求める (単位: us, 負の値は 0)
+ */
+static inline uint32_t Profiler_Elapsed(absolute_time_t from, absolute_time_t to);
+
+/**
+ * @brief HUD の文字を 1文字描画する (Font_DrawFontFn_t)
+ */
+static UError_t Profiler_DrawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * HUD の棒の色 (ProfilerClear - ProfilerDMA)
+ */
+static const uint16_t Profiler_StageColor[ProfilerFrame] = {
+    RGB888toRGB565(0x80, 0x80, 0x80),  // Clear
+    RGB888toRGB565(0x40, 0xc0, 0x40),  // Render
+    RGB888toRGB565(0x40, 0xc0, 0xc0),  // Text
+    RGB888toRGB565(0xe0, 0x40, 0x40),  // WaitDMA
+    RGB888toRGB565(0xe0, 0xa0, 0x40),  // SetWindow
+    RGB888toRGB565(0x40, 0x80, 0xff),  // DMA
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static inline bool Profiler_IsStage(ProfilerStage_t stage) {
+  return (ProfilerClear <= stage && stage < ProfilerStageNum);
+}
+
+static inline uint32_t Profiler_Elapsed(absolute_time_t from, absolute_time_t to) {
+  const int64_t diff = absolute_time_diff_us(from, to);
+  return (0 < diff) ? (uint32_t)diff : 0u;
+}
+
+static UError_t Profiler_DrawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  const ProfilerText_t* const text = (const ProfilerText_t*)arg;
+  (void)fsz;
+
+  if (NULL != graph) {
+    const uint8_t* line = (const uint8_t*)graph;
+    const uint32_t cw = (0xff < c) ? (fw / 2) : fw;  // 全角文字は 2キャラクタ分の幅
+    const size_t px = text->x + (x * cw);
+    const size_t py = text->y + (y * fh);
+    const size_t bpr = (fw + 7) / 8;
+    for (uint32_t h = 0; h < fh; ++h) {
+      for (uint32_t w = 0; w < fw; ++w) {
+        if (line[w / 8] & (0x80u >> (w % 8))) {
+          (void)Canvas_DrawPixel(text->canvas, px + w, py + h, text->color);
+        }
+      }
+      line += bpr;
+    }
+  }
+
+  return uSuccess;
+}
+
+UError_t Profiler_Create(Profiler_t* ctx, uint32_t baudrate) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->baudrate = baudrate;
+    ctx->running = ProfilerNone;
+    ctx->frameBegin = get_absolute_time();
+  }
+
+  return err;
+}
+
+UError_t Profiler_Begin(Profiler_t* ctx, ProfilerStage_t stage) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || !Profiler_IsStage(stage)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->begin[stage] = get_absolute_time();
+  }
+
+  return err;
+}
+
+UError_t Profiler_End(Profiler_t* ctx, ProfilerStage_t stage) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || !Profiler_IsStage(stage)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cur[stage] += Profiler_Elapsed(ctx->begin[stage], get_absolute_time());
+  }
+
+  return err;
+}
+
+UError_t Profiler_Switch(Profiler_t* ctx, ProfilerStage_t stage) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || (ProfilerNone != stage && !Profiler_IsStage(stage))) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    // 終了と開始に同じ時刻を使用し, 段階の間に隙間を作らない
+    const absolute_time_t now = get_absolute_time();
+    if (ProfilerNone != ctx->running) {
+      ctx->cur[ctx->running] += Profiler_Elapsed(ctx->begin[ctx->running], now);
+    }
+    if (ProfilerNone != stage) {
+      ctx->begin[stage] = now;
+    }
+    ctx->running = stage;
+  }
+
+  return err;
+}
+
+UError_t Profiler_Add(Profiler_t* ctx, ProfilerStage_t stage, uint32_t us) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || !Profiler_IsStage(stage)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cur[stage] += us;
+  }
+
+  return err;
+}
+
+UError_t Profiler_AddLCDTiming(Profiler_t* ctx, const LCDDrvTiming_t* timing) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == timing) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cur[ProfilerWaitDMA] += (uint32_t)timing->waitUs;
+    ctx->cur[ProfilerSetWindow] += (uint32_t)timing->windowUs;
+    ctx->cur[ProfilerDMA] += (uint32_t)timing->dmaUs;
+    ctx->curBytes += (uint32_t)timing->bytes;
+  }
+
+  return err;
+}
+
+UError_t Profiler_EndFrame(Profiler_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const absolute_time_t now = get_absolute_time();
+    ctx->cur[ProfilerFrame] = Profiler_Elapsed(ctx->frameBegin, now);
+    ctx->frameBegin = now;
+
+    for (uint32_t s = 0; s < ProfilerStageNum; ++s) {
+      ctx->samples[s][ctx->head] = ctx->cur[s];
+      ctx->cur[s] = 0;
+    }
+    ctx->bytes[ctx->head] = ctx->curBytes;
+    ctx->curBytes = 0;
+    ctx->head = (ctx->head + 1) % PROFILER_WINDOW;
+    ctx->count += (ctx->count < PROFILER_WINDOW) ? 1 : 0;
+  }
+
+  return err;
+}
+
+UError_t Profiler_GetStat(const Profiler_t* ctx, ProfilerStage_t stage, ProfilerStat_t* stat) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == stat || !Profiler_IsStage(stage)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(stat, 0, sizeof(*stat));
+  }
+
+  if (uSuccess == err && 0 < ctx->count) {
+    // 99パーセンタイルは並べ替えた値の上から (1% + 1) 番目. 挿入ソートで十分な個数
+    uint32_t sorted[PROFILER_WINDOW];
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < ctx->count; ++i) {
+      const uint32_t v = ctx->samples[stage][i];
+      uint32_t j = i;
+      for (; 0 < j && v < sorted[j - 1]; --j) {
+        sorted[j] = sorted[j - 1];
+      }
+      sorted[j] = v;
+      sum += v;
+    }
+    stat->min = sorted[0];
+    stat->max = sorted[ctx->count - 1];
+    stat->avg = (uint32_t)(sum / ctx->count);
+    stat->p99 = sorted[((ctx->count * 99) + 99) / 100 - 1];
+  }
+
+  return err;
+}
+
+UError_t Profiler_GetSpiStat(const Profiler_t* ctx, ProfilerSpiStat_t* stat) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == stat) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    uint64_t bytes = 0;
+    uint64_t frameUs = 0;
+    uint64_t dmaUs = 0;
+    uint64_t cpuUs = 0;
+    for (uint32_t i = 0; i < ctx->count; ++i) {
+      bytes += ctx->bytes[i];
+      frameUs += ctx->samples[ProfilerFrame][i];
+      dmaUs += ctx->samples[ProfilerDMA][i];
+      cpuUs += (uint64_t)ctx->samples[ProfilerClear][i] + ctx->samples[ProfilerRender][i] + ctx->samples[ProfilerText][i] +
+               ctx->samples[ProfilerSetWindow][i];
+    }
+
+    memset(stat, 0, sizeof(*stat));
+    if (0 < frameUs) {
+      const uint64_t bps = (bytes * 1000000u) / frameUs;
+      stat->bytesPerSec = (bps < UINT32_MAX) ? (uint32_t)bps : UINT32_MAX;
+      stat->dmaBusy = (uint32_t)((dmaUs * 1000u) / frameUs);
+    }
+    if (0 < ctx->baudrate) {
+      stat->utilization = (uint32_t)(((uint64_t)stat->bytesPerSec * 8u * 1000u) / ctx->baudrate);
+    }
+    stat->wireBound = (cpuUs < dmaUs);
+  }
+
+  return err;
+}
+
+UError_t Profiler_DrawHUD(const Profiler_t* ctx, const Canvas_t* canvas, size_t x, size_t y) {
+  UError_t err = uSuccess;
+  ProfilerStat_t frame;
+  ProfilerSpiStat_t spi;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = Profiler_GetStat(ctx, ProfilerFrame, &frame);
+  }
+  if (uSuccess == err) {
+    err = Profiler_GetSpiStat(ctx, &spi);
+  }
+
+  if (uSuccess == err) {
+    (void)Canvas_FillRect(canvas, x, y, PROFILER_HUD_W, PROFILER_HUD_H, RGB888toRGB565(0x10, 0x10, 0x20));
+
+    // 1行目: "nnnnnus nnn% C"
+    char sz[24];
+    size_t len = 0;
+    size_t n = 0;
+    (void)NumFmt_U32(&sz[len], sizeof(sz) - len, frame.avg, 6, ' ', &n);
+    len += n;
+    strncpy(&sz[len], "us ", sizeof(sz) - len);
+    len += 3;
+    (void)NumFmt_U32(&sz[len], sizeof(sz) - len, (spi.utilization + 5) / 10, 3, ' ', &n);
+    len += n;
+    strncpy(&sz[len], spi.wireBound ? "% W" : "% C", sizeof(sz) - len);
+
+    ProfilerText_t text = {
+        .canvas = canvas,
+        .x = x,
+        .y = y,
+        .color = RGB888toRGB565(0xff, 0xff, 0xff),
+    };
+    (void)Font_Print(sz, &Profiler_DrawGlyph, &text);  // フォント未登録でも棒は描画する
+
+    // 段階ごとの平均時間 (最大フレーム時間を全幅) と 99パーセンタイルの目盛り
+    const size_t bw = PROFILER_HUD_W - (PROFILER_HUD_MARGIN * 2);
+    const uint32_t scale = (0 < frame.max) ? frame.max : 1u;
+    size_t by = y + PROFILER_HUD_TEXT_H;
+    for (uint32_t s = 0; s < ProfilerFrame; ++s) {
+      ProfilerStat_t st;
+      (void)Profiler_GetStat(ctx, (ProfilerStage_t)s, &st);
+      const size_t avg = (size_t)(((uint64_t)((st.avg < scale) ? st.avg : scale) * bw) / scale);
+      const size_t p99 = (size_t)(((uint64_t)((st.p99 < scale) ? st.p99 : scale) * (bw - 1)) / scale);
+      if (0 < avg) {
+        (void)Canvas_FillRect(canvas, x + PROFILER_HUD_MARGIN, by, avg, PROFILER_HUD_BAR_H, Profiler_StageColor[s]);
+      }
+      (void)Canvas_FillRect(canvas, x + PROFILER_HUD_MARGIN + p99, by, 1, PROFILER_HUD_BAR_H, RGB888toRGB565(0xff, 0xff, 0xff));
+      by += PROFILER_HUD_BAR_H + PROFILER_HUD_BAR_GAP;
+    }
+
+    // SPI 使用率 (ボーレートに対する割合)
+    by += PROFILER_HUD_BAR_GAP;
+    const uint32_t util = (spi.utilization < 1000u) ? spi.utilization : 1000u;
+    (void)Canvas_FillRect(canvas, x + PROFILER_HUD_MARGIN, by, bw, PROFILER_HUD_BAR_H, RGB888toRGB565(0x30, 0x30, 0x30));
+    if (0 < util) {
+      (void)Canvas_FillRect(canvas, x + PROFILER_HUD_MARGIN, by, (bw * util) / 1000u, PROFILER_HUD_BAR_H,
+                            spi.wireBound ? RGB888toRGB565(0xe0, 0x40, 0x40) : RGB888toRGB565(0x40, 0x80, 0xff));
+    }
+  }
+
+  return err;
+}
@@ -16,8 +16,10 @@
 #include <hardware/pwm.h>
 #include <hardware/spi.h>
 
+#include <user/apiprof.h>
 #include <user/macros.h>
 #include <user/spidrv.h>
+#include <user/tracering.h>
 #include <user/types.h>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -42,10 +44,34 @@
  */
 static inline void SPIDrv_CS(const SPIDrvContext_t* ctx, uint32_t value);
 
+/**
+ * @brief SPI ハードウェアによる同期送信 (SPIDrv_HardwareTransport)
+ */
+static UError_t SPIDrv_HwSend(SPIDrvContext_t* ctx, const void* data, size_t size);
+/**
+ * @brief DMA による非同期送信の開始 (SPIDrv_HardwareTransport)
+ */
+static UError_t SPIDrv_HwAsyncSend(SPIDrvContext_t* ctx, const void* tx, size_t size);
+/**
+ * @brief DMA による非同期送信の完了待ち (SPIDrv_HardwareTransport)
+ */
+static UError_t SPIDrv_HwWait(SPIDrvContext_t* ctx);
+/**
+ * @brief GPIO による D/C 信号の設定 (SPIDrv_HardwareTransport)
+ */
+static void SPIDrv_HwSetDC(SPIDrvContext_t* ctx, bool level);
+
 //////////////////////////////////////////////////////////////////////////////
 // variable
 //////////////////////////////////////////////////////////////////////////////
 
+const SPIDrvTransport_t SPIDrv_HardwareTransport = {
+    .send = SPIDrv_HwSend,
+    .asyncSend = SPIDrv_HwAsyncSend,
+    .wait = SPIDrv_HwWait,
+    .setDC = SPIDrv_HwSetDC,
+};
+
 //////////////////////////////////////////////////////////////////////////////
 // function
 //////////////////////////////////////////////////////////////////////////////
@@ -71,6 +97,9 @@ UError_t SPIDrv_Create(SPIDrvContext_t* ctx) {
     ctx->tx = SPI_TX_PIN;
     ctx->sck = SPI_SCK_PIN;
     ctx->csn = SPI_CSN_PIN;
+    ctx->dc = SPIDRV_PIN_NONE;
+    ctx->transport = &SPIDrv_HardwareTransport;
+    ctx->transportArg = NULL;
   }
 
   return err;
@@ -101,6 +130,7 @@ UError_t SPIDrv_Init(SPIDrvHandle_t handle, uint32_t baudrate) {
 }
 
 UError_t SPIDrv_SendByte(const SPIDrvHandle_t handle, const uint8_t data) {
+  APIPROF_BEGIN(ApiProfSPIDrvSendByte);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -110,16 +140,16 @@ UError_t SPIDrv_SendByte(const SPIDrvHandle_t handle, const uint8_t data) {
   }
 
   if (uSuccess == err) {
-    const SPIDrvContext_t* const ctx = (const SPIDrvContext_t*)handle;
-    SPIDrv_CS(ctx, 0);
-    spi_write_blocking(ctx->hw, &data, 1);
-    SPIDrv_CS(ctx, 1);
+    SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    err = ctx->transport->send(ctx, &data, 1);
   }
 
+  APIPROF_END(ApiProfSPIDrvSendByte);
   return err;
 }
 
 UError_t SPIDrv_RecvByte(const SPIDrvHandle_t handle, uint8_t* data) {
+  APIPROF_BEGIN(ApiProfSPIDrvRecvByte);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -135,10 +165,12 @@ UError_t SPIDrv_RecvByte(const SPIDrvHandle_t handle, uint8_t* data) {
     SPIDrv_CS(ctx, 1);
   }
 
+  APIPROF_END(ApiProfSPIDrvRecvByte);
   return err;
 }
 
 UError_t SPIDrv_TransferByte(const SPIDrvHandle_t handle, const uint8_t tx, uint8_t* rx) {
+  APIPROF_BEGIN(ApiProfSPIDrvTransferByte);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -157,10 +189,12 @@ UError_t SPIDrv_TransferByte(const SPIDrvHandle_t handle, const uint8_t tx, uint
     }
   }
 
+  APIPROF_END(ApiProfSPIDrvTransferByte);
   return err;
 }
 
 UError_t SPIDrv_SendNBytes(const SPIDrvHandle_t handle, const void* data, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvSendNBytes);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -170,16 +204,16 @@ UError_t SPIDrv_SendNBytes(const SPIDrvHandle_t handle, const void* data, size_t
   }
 
   if (uSuccess == err) {
-    const SPIDrvContext_t* const ctx = (const SPIDrvContext_t*)handle;
-    SPIDrv_CS(ctx, 0);
-    spi_write_blocking(ctx->hw, data, size);
-    SPIDrv_CS(ctx, 1);
+    SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    err = ctx->transport->send(ctx, data, size);
   }
 
+  APIPROF_END(ApiProfSPIDrvSendNBytes);
   return err;
 }
 
 UError_t SPIDrv_RecvNBytes(const SPIDrvHandle_t handle, void* data, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvRecvNBytes);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -195,12 +229,13 @@ UError_t SPIDrv_RecvNBytes(const SPIDrvHandle_t handle, void* data, size_t size)
     SPIDrv_CS(ctx, 1);
   }
 
+  APIPROF_END(ApiProfSPIDrvRecvNBytes);
   return err;
 }
 
 UError_t SPIDrv_AsyncSend(SPIDrvHandle_t handle, const void* tx, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvAsyncSend);
   UError_t err = uSuccess;
-  static uint8_t null = 0u;
 
   if (uSuccess == err) {
     if (NULL == handle || NULL == tx || 0 == size) {
@@ -210,49 +245,18 @@ UError_t SPIDrv_AsyncSend(SPIDrvHandle_t handle, const void* tx, size_t size) {
 
   if (uSuccess == err) {
     SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
-
-    const uint32_t dma_tx = dma_claim_unused_channel(true);
-    dma_channel_config config = dma_channel_get_default_config(dma_tx);
-
-    // DMAC 書き込み側設定
-    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
-    channel_config_set_dreq(&config, spi_get_dreq(spi_default, true));  // 出力(送信)側のDMAトリガー取得
-    channel_config_set_read_increment(&config,
-                                      true);             // 読込位置をインクリメント
-    channel_config_set_write_increment(&config, false);  // 書き込み位置は固定
-    dma_channel_configure(dma_tx, &config,
-                          &spi_get_hw(ctx->hw)->dr,  // write addr
-                          tx,                        // read addr
-                          size, false);
-
-    // DMAC 読み出し側設定
-    const uint32_t dma_rx = dma_claim_unused_channel(true);
-    config = dma_channel_get_default_config(dma_rx);
-    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
-    channel_config_set_dreq(&config, spi_get_dreq(ctx->hw, false));  // 入力(受信)側のDMAトリガー取得
-    channel_config_set_read_increment(&config,
-                                      false);  // 読込位置を固定
-    channel_config_set_write_increment(&config,
-                                       false);  // 受信データは捨てるため, 書き込み位置を固定
-
-    dma_channel_configure(dma_rx, &config,
-                          &null,                  // write addr
-                          &spi_get_hw(spi0)->dr,  // read addr
-                          size, false);
-
-    SPIDrv_CS(ctx, 0);
-
+    ctx->async.size = size;
     ctx->async.begin = get_absolute_time();
-    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
-
-    ctx->async.tx = dma_tx;
-    ctx->async.rx = dma_rx;
+    TRACE_BEGIN_ON(TRACE_TRACK_DMA, TraceIdDMA, size, 0);
+    err = ctx->transport->asyncSend(ctx, tx, size);
   }
 
+  APIPROF_END(ApiProfSPIDrvAsyncSend);
   return err;
 }
 
 UError_t SPIDrv_AsyncRecv(SPIDrvHandle_t handle, void* rx, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvAsyncRecv);
   UError_t err = uSuccess;
   static uint8_t null = 0u;
 
@@ -270,7 +274,7 @@ UError_t SPIDrv_AsyncRecv(SPIDrvHandle_t handle, void* rx, size_t size) {
 
     // DMAC 書き込み側設定
     channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
-    channel_config_set_dreq(&config, spi_get_dreq(spi_default, true));  // 出力(送信)側のDMAトリガー取得
+    channel_config_set_dreq(&config, spi_get_dreq(ctx->hw, true));  // 出力(送信)側のDMAトリガー取得
     channel_config_set_read_increment(&config,
                                       false);            // 読込位置を固定
     channel_config_set_write_increment(&config, false);  // 出力を変更しないため, 書き込み位置は固定
@@ -290,8 +294,8 @@ UError_t SPIDrv_AsyncRecv(SPIDrvHandle_t handle, void* rx, size_t size) {
                                        true);  // 書き込み位置はインクリメント
 
     dma_channel_configure(dma_rx, &config,
-                          rx,                     // write addr
-                          &spi_get_hw(spi0)->dr,  // read addr
+                          rx,                        // write addr
+                          &spi_get_hw(ctx->hw)->dr,  // read addr
                           size, false);
 
     SPIDrv_CS(ctx, 0);
@@ -303,10 +307,12 @@ UError_t SPIDrv_AsyncRecv(SPIDrvHandle_t handle, void* rx, size_t size) {
     ctx->async.rx = dma_rx;
   }
 
+  APIPROF_END(ApiProfSPIDrvAsyncRecv);
   return err;
 }
 
 UError_t SPIDrv_AsyncTransfer(SPIDrvHandle_t handle, const void* tx, void* rx, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvAsyncTransfer);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -323,7 +329,7 @@ UError_t SPIDrv_AsyncTransfer(SPIDrvHandle_t handle, const void* tx, void* rx, s
 
     // DMAC 書き込み側設定
     channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
-    channel_config_set_dreq(&config, spi_get_dreq(spi_default, true));  // 出力(送信)側のDMAトリガー取得
+    channel_config_set_dreq(&config, spi_get_dreq(ctx->hw, true));  // 出力(送信)側のDMAトリガー取得
     channel_config_set_read_increment(&config,
                                       true);             // 読込位置をインクリメント
     channel_config_set_write_increment(&config, false);  // 書き込み位置は固定
@@ -343,8 +349,8 @@ UError_t SPIDrv_AsyncTransfer(SPIDrvHandle_t handle, const void* tx, void* rx, s
                                        true);  // 書き込み位置はインクリメント
 
     dma_channel_configure(dma_rx, &config,
-                          rx,                     // write addr
-                          &spi_get_hw(spi0)->dr,  // read addr
+                          rx,                        // write addr
+                          &spi_get_hw(ctx->hw)->dr,  // read addr
                           size, false);
 
     SPIDrv_CS(ctx, 0);
@@ -356,10 +362,12 @@ UError_t SPIDrv_AsyncTransfer(SPIDrvHandle_t handle, const void* tx, void* rx, s
     ctx->async.rx = dma_rx;
   }
 
+  APIPROF_END(ApiProfSPIDrvAsyncTransfer);
   return err;
 }
 
 UError_t SPIDrv_WaitForAsync(SPIDrvHandle_t handle) {
+  APIPROF_BEGIN(ApiProfSPIDrvWaitForAsync);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -370,21 +378,44 @@ UError_t SPIDrv_WaitForAsync(SPIDrvHandle_t handle) {
 
   if (uSuccess == err) {
     SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    ctx->async.busyOnWait = false;
+    err = ctx->transport->wait(ctx);
+    ctx->async.end = get_absolute_time();
+    TRACE_END_ON(TRACE_TRACK_DMA, TraceIdDMA, ctx->async.size, ctx->async.busyOnWait);  // 完了を確認した時刻 (対応する開始がない場合は変換時に除く)
+  }
 
-    dma_channel_wait_for_finish_blocking(ctx->async.rx);
-    if (dma_channel_is_busy(ctx->async.tx)) {
-      panic("RX complete before TX");
+  APIPROF_END(ApiProfSPIDrvWaitForAsync);
+  return err;
+}
+
+UError_t SPIDrv_GetAsyncTime(SPIDrvHandle_t handle, uint32_t* us, size_t* size) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle || NULL == us) {
+      err = uFailure;
     }
+  }
 
-    SPIDrv_CS(ctx, 1);
-    dma_channel_unclaim(ctx->async.rx);
-    dma_channel_unclaim(ctx->async.tx);
+  if (uSuccess == err) {
+    const SPIDrvContext_t* const ctx = (const SPIDrvContext_t*)handle;
+    const int64_t elapsed = absolute_time_diff_us(ctx->async.begin, ctx->async.end);
+    uint64_t t = (0 < elapsed) ? (uint64_t)elapsed : 0u;
+    if (!ctx->async.busyOnWait && 0 < ctx->baudrate) {
+      const uint64_t wire = ((uint64_t)ctx->async.size * 8u * 1000000u) / ctx->baudrate;
+      t = (wire < t) ? wire : t;
+    }
+    *us = (uint32_t)t;
+    if (NULL != size) {
+      *size = ctx->async.size;
+    }
   }
 
   return err;
 }
 
 UError_t SPIDrv_TransferNBytes(SPIDrvHandle_t handle, const void* tx, void* rx, size_t size) {
+  APIPROF_BEGIN(ApiProfSPIDrvTransferNBytes);
   UError_t err = uSuccess;
 
   if (uSuccess == err) {
@@ -401,5 +432,139 @@ UError_t SPIDrv_TransferNBytes(SPIDrvHandle_t handle, const void* tx, void* rx,
     err = SPIDrv_WaitForAsync(handle);
   }
 
+  APIPROF_END(ApiProfSPIDrvTransferNBytes);
+  return err;
+}
+
+UError_t SPIDrv_SetTransport(SPIDrvHandle_t handle, const SPIDrvTransport_t* transport, void* arg) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    ctx->transport = (NULL != transport) ? transport : &SPIDrv_HardwareTransport;
+    ctx->transportArg = arg;
+  }
+
   return err;
 }
+
+UError_t SPIDrv_SetDCPin(SPIDrvHandle_t handle, uint32_t dc) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    ctx->dc = dc;
+  }
+
+  return err;
+}
+
+UError_t SPIDrv_SetDC(SPIDrvHandle_t handle, bool level) {
+  APIPROF_BEGIN(ApiProfSPIDrvSetDC);
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == handle) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    SPIDrvContext_t* const ctx = (SPIDrvContext_t*)handle;
+    ctx->transport->setDC(ctx, level);
+  }
+
+  APIPROF_END(ApiProfSPIDrvSetDC);
+  return err;
+}
+
+static UError_t SPIDrv_HwSend(SPIDrvContext_t* ctx, const void* data, size_t size) {
+  SPIDrv_CS(ctx, 0);
+  spi_write_blocking(ctx->hw, data, size);
+  SPIDrv_CS(ctx, 1);
+
+  return uSuccess;
+}
+
+static UError_t SPIDrv_HwAsyncSend(SPIDrvContext_t* ctx, const void* tx, size_t size) {
+  UError_t err = uSuccess;
+  static uint8_t null = 0u;
+
+  if (uSuccess == err) {
+    const uint32_t dma_tx = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(dma_tx);
+
+    // DMAC 書き込み側設定
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_dreq(&config, spi_get_dreq(ctx->hw, true));  // 出力(送信)側のDMAトリガー取得
+    channel_config_set_read_increment(&config,
+                                      true);             // 読込位置をインクリメント
+    channel_config_set_write_increment(&config, false);  // 書き込み位置は固定
+    dma_channel_configure(dma_tx, &config,
+                          &spi_get_hw(ctx->hw)->dr,  // write addr
+                          tx,                        // read addr
+                          size, false);
+
+    // DMAC 読み出し側設定
+    const uint32_t dma_rx = dma_claim_unused_channel(true);
+    config = dma_channel_get_default_config(dma_rx);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_dreq(&config, spi_get_dreq(ctx->hw, false));  // 入力(受信)側のDMAトリガー取得
+    channel_config_set_read_increment(&config,
+                                      false);  // 読込位置を固定
+    channel_config_set_write_increment(&config,
+                                       false);  // 受信データは捨てるため, 書き込み位置を固定
+
+    dma_channel_configure(dma_rx, &config,
+                          &null,                     // write addr
+                          &spi_get_hw(ctx->hw)->dr,  // read addr
+                          size, false);
+
+    SPIDrv_CS(ctx, 0);
+
+    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
+
+    ctx->async.tx = dma_tx;
+    ctx->async.rx = dma_rx;
+  }
+
+  return err;
+}
+
+static UError_t SPIDrv_HwWait(SPIDrvContext_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    ctx->async.busyOnWait = dma_channel_is_busy(ctx->async.rx);
+    dma_channel_wait_for_finish_blocking(ctx->async.rx);
+    if (dma_channel_is_busy(ctx->async.tx)) {
+      panic("RX complete before TX");
+    }
+
+    SPIDrv_CS(ctx, 1);
+    dma_channel_unclaim(ctx->async.rx);
+    dma_channel_unclaim(ctx->async.tx);
+  }
+
+  return err;
+}
+
+static void SPIDrv_HwSetDC(SPIDrvContext_t* ctx, bool level) {
+  if (SPIDRV_PIN_NONE != ctx->dc) {
+    NOP3();
+    gpio_put(ctx->dc, level);
+    NOP3();
+  }
+}
@@ -0,0 +1,325 @@
+/**
+ * @file prog01/app/src/spitrace.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pico/stdlib.h>
+
+#include <user/spidrv.h>
+#include <user/spitrace.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SPITRACE_HEADER_MAX (1 + 10 + 10)  //< レコードの先頭部分の最大長 (種別 + 時刻 + 値)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 数値を LEB128 で書き込む
+ * @return 書き込んだバイト数
+ */
+static size_t SPITrace_PutVar(uint8_t* dst, uint64_t value);
+
+/**
+ * @brief LEB128 の数値を読み出す
+ * @param [inout] pos : 読み出し位置 (読み出した分だけ進める)
+ * @return 処理結果 (uSuccess 以外: データが途切れている)
+ */
+static UError_t SPITrace_GetVar(const uint8_t* data, size_t size, size_t* pos, uint64_t* value);
+
+/**
+ * @brief レコードを書き出す
+ * @param [in] value : SPITraceDC, SPITraceMark の値. 送信レコードではサイズ
+ * @param [in] data : 送信データ (送信レコード以外は NULL)
+ */
+static void SPITrace_Put(SPITrace_t* ctx, SPITraceEvent_t type, uint64_t value, const void* data);
+
+/**
+ * @brief SPITrace_Transport の各処理. 記録してから元のトランスポートを呼び出す
+ */
+static UError_t SPITrace_Send(SPIDrvContext_t* spi, const void* data, size_t size);
+static UError_t SPITrace_AsyncSend(SPIDrvContext_t* spi, const void* data, size_t size);
+static UError_t SPITrace_Wait(SPIDrvContext_t* spi);
+static void SPITrace_SetDC(SPIDrvContext_t* spi, bool level);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static const SPIDrvTransport_t SPITrace_Transport = {
+    .send = SPITrace_Send,
+    .asyncSend = SPITrace_AsyncSend,
+    .wait = SPITrace_Wait,
+    .setDC = SPITrace_SetDC,
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static size_t SPITrace_PutVar(uint8_t* dst, uint64_t value) {
+  size_t n = 0;
+
+  do {
+    const uint8_t b = (uint8_t)(value & 0x7fu);
+    value >>= 7;
+    dst[n++] = (uint8_t)(b | ((0 != value) ? 0x80u : 0x00u));
+  } while (0 != value);
+
+  return n;
+}
+
+static UError_t SPITrace_GetVar(const uint8_t* data, size_t size, size_t* pos, uint64_t* value) {
+  uint64_t v = 0;
+
+  for (uint32_t shift = 0; shift < 64; shift += 7) {
+    if (*pos >= size) {
+      break;
+    }
+    const uint8_t b = data[(*pos)++];
+    v |= (uint64_t)(b & 0x7fu) << shift;
+    if (0 == (b & 0x80u)) {
+      *value = v;
+      return uSuccess;
+    }
+  }
+
+  return uFailure;
+}
+
+static void SPITrace_Put(SPITrace_t* ctx, SPITraceEvent_t type, uint64_t value, const void* data) {
+  if (uSuccess == ctx->err) {
+    uint8_t head[SPITRACE_HEADER_MAX];
+    size_t n = 0;
+
+    const absolute_time_t now = get_absolute_time();
+    const int64_t delta = absolute_time_diff_us(ctx->last, now);
+    ctx->last = now;
+
+    head[n++] = (uint8_t)type;
+    n += SPITrace_PutVar(&head[n], (0 < delta) ? (uint64_t)delta : 0u);
+    if (SPITraceDC == type) {
+      head[n++] = (uint8_t)value;
+    } else if (SPITraceWait != type) {
+      n += SPITrace_PutVar(&head[n], value);
+    }
+
+    ctx->err = ctx->write(ctx->arg, head, n);
+    if (uSuccess == ctx->err && NULL != data && 0 < value) {
+      ctx->err = ctx->write(ctx->arg, data, (size_t)value);
+    }
+    ++ctx->records;
+  }
+}
+
+static UError_t SPITrace_Send(SPIDrvContext_t* spi, const void* data, size_t size) {
+  SPITrace_t* const ctx = (SPITrace_t*)spi->transportArg;
+
+  SPITrace_Put(ctx, SPITraceSend, size, data);
+
+  spi->transportArg = ctx->transportArg;
+  const UError_t err = ctx->transport->send(spi, data, size);
+  spi->transportArg = ctx;
+
+  return err;
+}
+
+static UError_t SPITrace_AsyncSend(SPIDrvContext_t* spi, const void* data, size_t size) {
+  SPITrace_t* const ctx = (SPITrace_t*)spi->transportArg;
+
+  SPITrace_Put(ctx, SPITraceAsyncSend, size, data);
+
+  spi->transportArg = ctx->transportArg;
+  const UError_t err = ctx->transport->asyncSend(spi, data, size);
+  spi->transportArg = ctx;
+
+  return err;
+}
+
+static UError_t SPITrace_Wait(SPIDrvContext_t* spi) {
+  SPITrace_t* const ctx = (SPITrace_t*)spi->transportArg;
+
+  spi->transportArg = ctx->transportArg;
+  const UError_t err = ctx->transport->wait(spi);
+  spi->transportArg = ctx;
+
+  // 完了 (CS の解除) した時刻を記録する
+  SPITrace_Put(ctx, SPITraceWait, 0, NULL);
+
+  return err;
+}
+
+static void SPITrace_SetDC(SPIDrvContext_t* spi, bool level) {
+  SPITrace_t* const ctx = (SPITrace_t*)spi->transportArg;
+
+  if (ctx->dc != (level ? 1 : 0)) {
+    ctx->dc = level ? 1 : 0;
+    SPITrace_Put(ctx, SPITraceDC, (uint64_t)ctx->dc, NULL);
+  }
+
+  spi->transportArg = ctx->transportArg;
+  ctx->transport->setDC(spi, level);
+  spi->transportArg = ctx;
+}
+
+UError_t SPITrace_Create(SPITrace_t* ctx, SPITraceWriteFn_t write, void* arg) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == write) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->write = write;
+    ctx->arg = arg;
+    ctx->last = get_absolute_time();
+    ctx->dc = -1;
+    err = ctx->write(ctx->arg, SPITRACE_MAGIC, SPITRACE_MAGIC_SIZE);
+    ctx->err = err;
+  }
+
+  return err;
+}
+
+UError_t SPITrace_Attach(SPITrace_t* ctx, SPIDrvHandle_t spi) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == spi || NULL != ctx->spi) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    SPIDrvContext_t* const drv = (SPIDrvContext_t*)spi;
+    ctx->spi = drv;
+    ctx->transport = drv->transport;
+    ctx->transportArg = drv->transportArg;
+    err = SPIDrv_SetTransport(drv, &SPITrace_Transport, ctx);
+  }
+
+  return err;
+}
+
+UError_t SPITrace_Detach(SPITrace_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->spi) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    err = SPIDrv_SetTransport(ctx->spi, ctx->transport, ctx->transportArg);
+    ctx->spi = NULL;
+  }
+
+  return err;
+}
+
+UError_t SPITrace_Mark(SPITrace_t* ctx, uint32_t id) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    SPITrace_Put(ctx, SPITraceMark, id, NULL);
+    err = ctx->err;
+  }
+
+  return err;
+}
+
+UError_t SPITrace_Decode(const void* data, size_t size, SPITraceVisitFn_t fn, void* arg) {
+  UError_t err = uSuccess;
+  const uint8_t* const src = (const uint8_t*)data;
+
+  if (uSuccess == err) {
+    if (NULL == data || NULL == fn || size < SPITRACE_MAGIC_SIZE) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (0 != memcmp(src, SPITRACE_MAGIC, SPITRACE_MAGIC_SIZE)) {
+      err = uFailure;
+    }
+  }
+
+  SPITraceRecord_t rec = {0};
+  size_t pos = SPITRACE_MAGIC_SIZE;
+  while (uSuccess == err && pos < size) {
+    uint64_t delta = 0;
+    uint64_t value = 0;
+
+    rec.type = (SPITraceEvent_t)src[pos++];
+    rec.value = 0;
+    rec.data = NULL;
+    rec.size = 0;
+    err = SPITrace_GetVar(src, size, &pos, &delta);
+    rec.time += delta;
+
+    if (uSuccess == err) {
+      switch (rec.type) {
+        case SPITraceDC:
+          if (pos < size) {
+            rec.value = src[pos++];
+          } else {
+            err = uFailure;
+          }
+          break;
+        case SPITraceSend:
+        case SPITraceAsyncSend:
+          err = SPITrace_GetVar(src, size, &pos, &value);
+          if (uSuccess == err && value <= size - pos) {
+            rec.data = &src[pos];
+            rec.size = (size_t)value;
+            pos += (size_t)value;
+          } else {
+            err = uFailure;
+          }
+          break;
+        case SPITraceWait:
+          break;
+        case SPITraceMark:
+          err = SPITrace_GetVar(src, size, &pos, &value);
+          rec.value = (uint32_t)value;
+          break;
+        default:
+          err = uFailure;
+          break;
+      }
+    }
+
+    if (uSuccess == err) {
+      err = fn(arg, &rec);
+    }
+  }
+
+  return err;
+}
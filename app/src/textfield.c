@@ -0,0 +1,311 @@
+/**
+ * @file prog01/app/src/textfield.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/canvas.h>
+#include <user/font.h>
+#include <user/glyphcache.h>
+#include <user/textfield.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 再描画した領域を dirty に追加する. 同じ行で隣接する場合は連結する.
+ */
+static void addDirty(TextField_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * @brief グリフを背景色付きで描画する
+ * @param [in] fw : グリフの幅 (1ラインあたりのバイト数はこの幅から求める)
+ * @param [in] fh : グリフの高さ
+ * @param [in] cw : 描画する幅 (セルの幅. fw より小さい場合は右側を切り捨てる)
+ * @param [in] ch : 描画する高さ (セルの高さ. fh より小さい場合は下側を切り捨てる)
+ */
+static void drawGlyph(TextField_t* ctx, uint32_t x, uint32_t y, const uint8_t* graph, uint32_t fw, uint32_t fh, uint32_t cw, uint32_t ch);
+
+/**
+ * @brief Font_PrintWith() から呼び出されるセル更新処理
+ */
+static UError_t updateCell(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void addDirty(TextField_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  if (NULL == ctx->dirty || 0 == ctx->maxDirty) {
+    return;
+  }
+
+  if (0 < ctx->nDirty) {
+    CanvasRect_t* const last = &ctx->dirty[ctx->nDirty - 1];
+    if (last->y == y && last->h == h && (uint32_t)(last->x + last->w) == x) {
+      last->w += w;
+      return;
+    }
+    if (ctx->maxDirty <= ctx->nDirty) {
+      // 格納先が不足する場合は最後の矩形を拡張する
+      const uint32_t x0 = (last->x < x) ? last->x : x;
+      const uint32_t y0 = (last->y < y) ? last->y : y;
+      const uint32_t x1 = ((uint32_t)(last->x + last->w) > x + w) ? (uint32_t)(last->x + last->w) : x + w;
+      const uint32_t y1 = ((uint32_t)(last->y + last->h) > y + h) ? (uint32_t)(last->y + last->h) : y + h;
+      last->x = x0;
+      last->y = y0;
+      last->w = x1 - x0;
+      last->h = y1 - y0;
+      return;
+    }
+  }
+
+  CanvasRect_t* const r = &ctx->dirty[ctx->nDirty++];
+  r->x = x;
+  r->y = y;
+  r->w = w;
+  r->h = h;
+}
+
+static void drawGlyph(TextField_t* ctx, uint32_t x, uint32_t y, const uint8_t* graph, uint32_t fw, uint32_t fh, uint32_t cw, uint32_t ch) {
+  const uint32_t dw = (fw < cw) ? fw : cw;
+  const uint32_t dh = (fh < ch) ? fh : ch;
+
+  // キャッシュはグリフ全体を描画するため, セルに収まる場合のみ使用する
+  if (NULL != ctx->cache && dw == fw && dh == fh) {
+    if (uSuccess == GlyphCache_Draw(ctx->cache, ctx->canvas, x, y, graph, fw, fh, ctx->fg, ctx->bg, 1)) {
+      return;
+    }
+  }
+
+  const size_t bpr = (fw + 7) / 8;  // 1ラインあたりのバイト数 (切り捨て前の幅で求める)
+  for (uint32_t h = 0; h < dh; ++h) {
+    for (uint32_t w = 0; w < dw; ++w) {
+      const uint16_t c = (graph[w / 8] & (0x80u >> (w % 8))) ? ctx->fg : ctx->bg;
+      (void)Canvas_DrawPixel(ctx->canvas, x + w, y + h, c);
+    }
+    graph += bpr;
+  }
+}
+
+static UError_t updateCell(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  TextField_t* const ctx = (TextField_t*)arg;
+  (void)fsz;
+
+  const uint32_t ncell = (0xff < c) ? 2 : 1;  // 全角文字は 2セル
+  if (ctx->rows <= y || ctx->cols < x + ncell) {
+    return uSuccess;
+  }
+
+  TextFieldCell_t* const cell = &ctx->cells[(y * ctx->cols) + x];
+  bool changed = (cell->graph != graph || cell->code != c);
+  if (2 == ncell) {
+    changed = changed || (cell[1].graph != graph || TEXTFIELD_CODE_CONT != cell[1].code);
+  }
+
+  if (changed) {
+    const uint32_t px = ctx->x + (x * ctx->cw);
+    const uint32_t py = ctx->y + (y * ctx->ch);
+    const uint32_t w = ncell * ctx->cw;
+#if CANVAS_OVERDRAW
+    const CanvasPrim_t prev = Canvas_BeginOverdraw(ctx->canvas, CanvasPrimText);
+#endif
+    // グリフがセルより小さい場合に備えて先に背景を塗る
+    if (fw < w || fh < ctx->ch) {
+      (void)Canvas_FillRect(ctx->canvas, px, py, w, ctx->ch, ctx->bg);
+    }
+    drawGlyph(ctx, px, py, (const uint8_t*)graph, fw, fh, w, ctx->ch);
+#if CANVAS_OVERDRAW
+    Canvas_EndOverdraw(ctx->canvas, prev);
+#endif
+    addDirty(ctx, px, py, w, ctx->ch);
+  }
+
+  cell->graph = graph;
+  cell->code = c;
+  cell->gen = ctx->gen;
+  if (2 == ncell) {
+    cell[1].graph = graph;
+    cell[1].code = TEXTFIELD_CODE_CONT;
+    cell[1].gen = ctx->gen;
+  }
+
+  return uSuccess;
+}
+
+UError_t TextField_Create(TextField_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t cols, uint32_t rows, TextFieldCell_t* cells) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas || NULL == cells || 0 == cols || 0 == rows) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->canvas = canvas;
+    ctx->x = x;
+    ctx->y = y;
+    ctx->cols = cols;
+    ctx->rows = rows;
+    ctx->cells = cells;
+    ctx->fg = 0xffff;
+    ctx->bg = 0x0000;
+    ctx->gen = 0;
+    ctx->cache = NULL;
+    ctx->dirty = NULL;
+    ctx->maxDirty = 0;
+    ctx->nDirty = 0;
+    err = TextField_SetFont(ctx, FONT_ID_ANK, FONT_ID_NONE);
+  }
+
+  return err;
+}
+
+UError_t TextField_SetFont(TextField_t* ctx, FontId_t ank, FontId_t kanji) {
+  UError_t err = uSuccess;
+  const FontIndex_t* font = NULL;
+
+  if (uSuccess == err) {
+    font = Font_Get(ank);
+    if (NULL == ctx || NULL == font) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->ank = ank;
+    ctx->kanji = kanji;
+    ctx->cw = font->fw;
+    ctx->ch = font->fh;
+    err = TextField_Invalidate(ctx);
+  }
+
+  return err;
+}
+
+UError_t TextField_SetColor(TextField_t* ctx, uint16_t fg, uint16_t bg) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->fg = fg;
+    ctx->bg = bg;
+    err = TextField_Invalidate(ctx);
+  }
+
+  return err;
+}
+
+UError_t TextField_SetGlyphCache(TextField_t* ctx, GlyphCache_t* cache) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->cache = cache;
+  }
+
+  return err;
+}
+
+UError_t TextField_Invalidate(TextField_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->cells) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t n = (size_t)ctx->cols * ctx->rows;
+    for (size_t i = 0; i < n; ++i) {
+      ctx->cells[i].graph = NULL;
+      ctx->cells[i].code = TEXTFIELD_CODE_UNKNOWN;
+      ctx->cells[i].gen = 0;
+    }
+    ctx->gen = 0;
+  }
+
+  return err;
+}
+
+UError_t TextField_Update(TextField_t* ctx, const char* sz, CanvasRect_t* dirty, size_t maxDirty, size_t* nDirty) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == ctx->cells || NULL == sz) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const size_t n = (size_t)ctx->cols * ctx->rows;
+    ctx->gen++;
+    if (0 == ctx->gen) {
+      // 世代の周回 : 全セルを旧世代に戻す
+      for (size_t i = 0; i < n; ++i) {
+        ctx->cells[i].gen = 0;
+      }
+      ctx->gen = 1;
+    }
+    ctx->dirty = dirty;
+    ctx->maxDirty = maxDirty;
+    ctx->nDirty = 0;
+
+    err = Font_PrintWith(ctx->ank, ctx->kanji, sz, &updateCell, ctx);
+
+    if (uSuccess == err) {
+      // 今回の文字列で参照されなかったセルは空白にする
+      for (size_t i = 0; i < n; ++i) {
+        TextFieldCell_t* const cell = &ctx->cells[i];
+        if (ctx->gen != cell->gen && (NULL != cell->graph || 0 != cell->code)) {
+          const uint32_t px = ctx->x + ((i % ctx->cols) * ctx->cw);
+          const uint32_t py = ctx->y + ((i / ctx->cols) * ctx->ch);
+          (void)Canvas_FillRect(ctx->canvas, px, py, ctx->cw, ctx->ch, ctx->bg);
+          addDirty(ctx, px, py, ctx->cw, ctx->ch);
+          cell->graph = NULL;
+          cell->code = 0;
+        }
+      }
+    }
+
+    if (NULL != nDirty) {
+      *nDirty = ctx->nDirty;
+    }
+    ctx->dirty = NULL;
+    ctx->maxDirty = 0;
+  }
+
+  return err;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file prog01/app/src/tilemap.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <user/canvas.h>
+#include <user/tilemap.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define TILE_PIXELS (TILEMAP_TILE_SIZE * TILEMAP_TILE_SIZE)
+#define TILE_4BPP_BYTES (TILE_PIXELS / 2)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief マップ上の (wx, wy) から右へ n pixel を dst へ生成する
+ * @param [in] ctx : 操作対象
+ * @param [out] dst : 格納先
+ * @param [in] wx : マップ上の x座標 (周回済み)
+ * @param [in] wy : マップ上の y座標 (周回済み)
+ * @param [in] n : pixel数
+ */
+static void rasterRow(const Tilemap_t* ctx, uint16_t* dst, uint32_t wx, uint32_t wy, uint32_t n);
+
+/**
+ * @brief 表示領域内の矩形を dst (ストライド ds) へ生成する
+ */
+static void rasterRect(const Tilemap_t* ctx, uint16_t* dst, size_t ds, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * @brief キャンバスが RGB565 形式で, 表示領域が収まるか判定する
+ */
+inline static bool fitsCanvas(const Tilemap_t* ctx, const Canvas_t* canvas);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void rasterRow(const Tilemap_t* ctx, uint16_t* dst, uint32_t wx, uint32_t wy, uint32_t n) {
+  const uint32_t mapw = ctx->mw * TILEMAP_TILE_SIZE;
+  const uint16_t* const mrow = ctx->map + ((wy / TILEMAP_TILE_SIZE) * ctx->mw);
+  const uint32_t fy = wy % TILEMAP_TILE_SIZE;
+
+  while (0 < n) {
+    const uint16_t e = mrow[wx / TILEMAP_TILE_SIZE];
+    const uint32_t fx = wx % TILEMAP_TILE_SIZE;
+    const uint32_t span = (TILEMAP_TILE_SIZE - fx < n) ? TILEMAP_TILE_SIZE - fx : n;  // このタイル内で生成する pixel数
+    uint32_t tile = e & TILEMAP_TILE_MASK;
+    tile = (tile < ctx->ntiles) ? tile : 0;
+    const uint32_t ty = (e & TILEMAP_VFLIP) ? (TILEMAP_TILE_SIZE - 1) - fy : fy;
+
+    if (TilemapRGB565 == ctx->fmt) {
+      const uint16_t* const src = (const uint16_t*)ctx->tiles + (tile * TILE_PIXELS) + (ty * TILEMAP_TILE_SIZE);
+      if (0 == (e & TILEMAP_HFLIP)) {
+        memcpy(dst, src + fx, span * sizeof(uint16_t));
+      } else {
+        for (uint32_t i = 0; i < span; ++i) {
+          dst[i] = src[(TILEMAP_TILE_SIZE - 1) - (fx + i)];
+        }
+      }
+    } else {
+      const uint8_t* const src = (const uint8_t*)ctx->tiles + (tile * TILE_4BPP_BYTES) + (ty * (TILEMAP_TILE_SIZE / 2));
+      uint32_t pal = e >> TILEMAP_PALETTE_SHIFT;
+      pal = (pal < ctx->npalette) ? pal : 0;
+      const uint16_t* const colors = ctx->palette + (pal * TILEMAP_PALETTE_COLORS);
+      for (uint32_t i = 0; i < span; ++i) {
+        const uint32_t px = (e & TILEMAP_HFLIP) ? (TILEMAP_TILE_SIZE - 1) - (fx + i) : fx + i;
+        const uint8_t b = src[px / 2];
+        dst[i] = colors[(px & 1) ? (b & 0x0f) : (b >> 4)];
+      }
+    }
+
+    dst += span;
+    n -= span;
+    wx += span;
+    if (mapw <= wx) {
+      wx = 0;
+    }
+  }
+}
+
+static void rasterRect(const Tilemap_t* ctx, uint16_t* dst, size_t ds, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  const uint32_t mapw = ctx->mw * TILEMAP_TILE_SIZE;
+  const uint32_t maph = ctx->mh * TILEMAP_TILE_SIZE;
+  const uint32_t wx = (ctx->sx + x) % mapw;
+  uint32_t wy = (ctx->sy + y) % maph;
+
+  for (uint32_t j = 0; j < h; ++j) {
+    rasterRow(ctx, dst, wx, wy, w);
+    dst += ds;
+    wy = (wy + 1 < maph) ? wy + 1 : 0;
+  }
+}
+
+inline static bool fitsCanvas(const Tilemap_t* ctx, const Canvas_t* canvas) {
+  return (NULL != canvas->buf) && (CanvasRGB565 == canvas->fmt) && (ctx->vx + ctx->vw <= canvas->w) && (ctx->vy + ctx->vh <= canvas->h);
+}
+
+UError_t Tilemap_Create(Tilemap_t* ctx, const uint16_t* map, uint32_t mw, uint32_t mh, const void* tiles, uint32_t ntiles, TilemapFormat_t fmt) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == map || NULL == tiles || 0 == mw || 0 == mh || 0 == ntiles) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (TilemapRGB565 != fmt && Tilemap4bpp != fmt) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->map = map;
+    ctx->mw = mw;
+    ctx->mh = mh;
+    ctx->tiles = tiles;
+    ctx->ntiles = ntiles;
+    ctx->fmt = fmt;
+    ctx->palette = NULL;
+    ctx->npalette = 0;
+    ctx->vx = 0;
+    ctx->vy = 0;
+    ctx->vw = mw * TILEMAP_TILE_SIZE;
+    ctx->vh = mh * TILEMAP_TILE_SIZE;
+    ctx->sx = 0;
+    ctx->sy = 0;
+  }
+
+  return err;
+}
+
+UError_t Tilemap_SetPalette(Tilemap_t* ctx, const uint16_t* palette, uint32_t npalette) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == palette || 0 == npalette) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->palette = palette;
+    ctx->npalette = npalette;
+  }
+
+  return err;
+}
+
+UError_t Tilemap_SetViewport(Tilemap_t* ctx, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || 0 == w || 0 == h) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->vx = x;
+    ctx->vy = y;
+    ctx->vw = w;
+    ctx->vh = h;
+  }
+
+  return err;
+}
+
+UError_t Tilemap_SetScroll(Tilemap_t* ctx, uint32_t sx, uint32_t sy) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->sx = sx % (ctx->mw * TILEMAP_TILE_SIZE);
+    ctx->sy = sy % (ctx->mh * TILEMAP_TILE_SIZE);
+  }
+
+  return err;
+}
+
+UError_t Tilemap_Render(const Tilemap_t* ctx, const Canvas_t* canvas) {
+  if (NULL == ctx) {
+    return uFailure;
+  }
+  return Tilemap_RenderRect(ctx, canvas, 0, 0, ctx->vw, ctx->vh);
+}
+
+UError_t Tilemap_RenderRect(const Tilemap_t* ctx, const Canvas_t* canvas, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas || !fitsCanvas(ctx, canvas)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (Tilemap4bpp == ctx->fmt && NULL == ctx->palette) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (ctx->vw <= x || ctx->vh <= y) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const uint32_t cw = (ctx->vw - x < w) ? ctx->vw - x : w;
+    const uint32_t ch = (ctx->vh - y < h) ? ctx->vh - y : h;
+    uint16_t* const dst = (uint16_t*)canvas->buf + ((ctx->vy + y) * canvas->s) + ctx->vx + x;
+    rasterRect(ctx, dst, canvas->s, x, y, cw, ch);
+#if CANVAS_OVERDRAW
+    const CanvasPrim_t prev = Canvas_BeginOverdraw(canvas, CanvasPrimTilemap);
+    Canvas_CountOverdraw(canvas, ctx->vx + x, ctx->vy + y, cw, ch);
+    Canvas_EndOverdraw(canvas, prev);
+#endif
+  }
+
+  return err;
+}
+
+UError_t Tilemap_RenderLines(const Tilemap_t* ctx, uint32_t line, uint32_t n, uint16_t* out) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == out || ctx->vh < line + n) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    if (Tilemap4bpp == ctx->fmt && NULL == ctx->palette) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    rasterRect(ctx, out, ctx->vw, 0, line, ctx->vw, n);
+  }
+
+  return err;
+}
+
+UError_t Tilemap_Scroll(Tilemap_t* ctx, const Canvas_t* canvas, int32_t dx, int32_t dy) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == canvas || !fitsCanvas(ctx, canvas)) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const int32_t mapw = (int32_t)(ctx->mw * TILEMAP_TILE_SIZE);
+    const int32_t maph = (int32_t)(ctx->mh * TILEMAP_TILE_SIZE);
+    const uint32_t ax = (0 > dx) ? (uint32_t)-dx : (uint32_t)dx;
+    const uint32_t ay = (0 > dy) ? (uint32_t)-dy : (uint32_t)dy;
+
+    ctx->sx = (uint32_t)((((int32_t)ctx->sx + (dx % mapw)) % mapw + mapw) % mapw);
+    ctx->sy = (uint32_t)((((int32_t)ctx->sy + (dy % maph)) % maph + maph) % maph);
+
+    if (ctx->vw <= ax || ctx->vh <= ay) {
+      err = Tilemap_Render(ctx, canvas);
+    } else {
+      // 描画済みの画像を移動し, 空いた端だけを描画する
+      err = Canvas_Scroll(canvas, ctx->vx, ctx->vy, ctx->vw, ctx->vh, -dx, -dy, 0);
+      if (uSuccess == err && 0 < ay) {
+        err = Tilemap_RenderRect(ctx, canvas, 0, (0 < dy) ? ctx->vh - ay : 0, ctx->vw, ay);
+      }
+      if (uSuccess == err && 0 < ax) {
+        err = Tilemap_RenderRect(ctx, canvas, (0 < dx) ? ctx->vw - ax : 0, (0 < dy) ? 0 : ay, ax, ctx->vh - ay);
+      }
+    }
+  }
+
+  return err;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file prog01/app/src/tracering.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <user/tracering.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief チャンクを書き出す
+ */
+static UError_t TraceRing_WriteChunk(TraceRingWriteFn_t write, void* arg, const TraceEvent_t* events, uint16_t count, uint32_t lost);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#if TRACERING_ENABLE
+TraceRing_t TraceRing_Default;  // 0 で初期化された状態は空のリング
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t TraceRing_WriteChunk(TraceRingWriteFn_t write, void* arg, const TraceEvent_t* events, uint16_t count, uint32_t lost) {
+  TraceRingChunk_t chunk;
+  UError_t err = uSuccess;
+
+  memcpy(chunk.magic, TRACERING_MAGIC, sizeof(chunk.magic));
+  chunk.version = TRACERING_VERSION;
+  chunk.count = count;
+  chunk.lost = lost;
+
+  err = write(arg, &chunk, sizeof(chunk));
+  if (uSuccess == err && 0 < count) {
+    err = write(arg, events, sizeof(TraceEvent_t) * count);
+  }
+
+  return err;
+}
+
+UError_t TraceRing_Init(TraceRing_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    for (uint32_t i = 0; i < TRACERING_CAPACITY; ++i) {
+      atomic_store_explicit(&ctx->commit[i], 0u, memory_order_relaxed);
+    }
+    ctx->tail = 0;
+    atomic_store_explicit(&ctx->head, 0u, memory_order_release);
+  }
+
+  return err;
+}
+
+UError_t TraceRing_Drain(TraceRing_t* ctx, TraceRingWriteFn_t write, void* arg, size_t* count) {
+  UError_t err = uSuccess;
+  size_t total = 0;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == write) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    TraceEvent_t buf[TRACERING_CHUNK];
+    uint32_t lost = 0;
+    const uint32_t head = atomic_load_explicit(&ctx->head, memory_order_acquire);
+
+    // 1周以上遅れている場合, 上書きされた分を読み飛ばす
+    if (TRACERING_CAPACITY < head - ctx->tail) {
+      lost += head - ctx->tail - TRACERING_CAPACITY;
+      ctx->tail = head - TRACERING_CAPACITY;
+    }
+
+    bool pending = false;  // 書き込み中の要素に達した
+    while (uSuccess == err && ctx->tail != head && !pending) {
+      uint16_t n = 0;
+      while (n < TRACERING_CHUNK && ctx->tail != head) {
+        const uint32_t slot = ctx->tail & (TRACERING_CAPACITY - 1u);
+        const uint32_t expect = ctx->tail + 1u;
+        const uint32_t before = atomic_load_explicit(&ctx->commit[slot], memory_order_acquire);
+        if (before != expect && (0u == before || (int32_t)(before - expect) < 0)) {
+          pending = true;  // まだ書き込まれていない
+          break;
+        }
+        if (before == expect) {
+          buf[n] = ctx->events[slot];
+          atomic_thread_fence(memory_order_acquire);
+        }
+        // 読み出し中に上書きが始まった場合も失ったものとして扱う
+        if (before == expect && expect == atomic_load_explicit(&ctx->commit[slot], memory_order_relaxed)) {
+          ++n;
+        } else {
+          ++lost;
+        }
+        ++ctx->tail;
+      }
+      if (0 < n || 0 < lost) {
+        err = TraceRing_WriteChunk(write, arg, buf, n, lost);
+        total += n;
+        lost = 0;
+      }
+    }
+  }
+
+  if (NULL != count) {
+    *count = total;
+  }
+
+  return err;
+}
@@ -0,0 +1,899 @@
+/**
+ * @file prog01/host/bench/bench.c
+ * 描画処理のマイクロベンチマーク (ホストビルド)
+ *
+ * Canvas_* / Font_* の公開関数と, それらを使用するモジュールの処理時間を計測します.
+ * 各項目は約 0.2 秒 (-t で変更) 実行できる回数を求めてから 3回計測し, 最も速い結果を表示します.
+ *   bench [-t ミリ秒] [項目名の一部 ...]
+ * スタブ HAL の SPI/DMA は転送を行わないため, LCDDrv_* は CPU 側の処理時間のみを計測します.
+ * APIPROF_ENABLE を有効にしたビルド (cmake -DAPIPROF_ENABLE=ON) では, 最後に公開関数ごとのヒストグラムを表示します.
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <user/apiprof.h>
+#include <user/bandrender.h>
+#include <user/canvas.h>
+#include <user/chart.h>
+#include <user/console.h>
+#include <user/drawlist.h>
+#include <user/font.h>
+#include <user/glyphcache.h>
+#include <user/lcddrv.h>
+#include <user/numfmt.h>
+#include <user/profiler.h>
+#include <user/spidrv.h>
+#include <user/textfield.h>
+#include <user/tilemap.h>
+#include <user/tracering.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SCREEN_W (240)
+#define SCREEN_H (320)
+#define MAX_RESULTS (128)  //< 記録できる計測結果の数
+#define REPEAT (3)         //< 計測の繰り返し回数 (最速値を採用)
+
+#define KANJI_W (16)  //< 合成する全角フォントの幅
+#define KANJI_H (16)  //< 合成する全角フォントの高さ
+#define KANJI_FSZ ((KANJI_W + 7) / 8 * KANJI_H)
+#define KANJI_BLOCKS (94)  //< 0x81-0x9f, 0xe0-0xef の各上位バイトを 0x40-0x7e, 0x80-0xfc に分割
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 計測対象の処理 (1回分)
+ */
+typedef void (*BenchFn_t)(void* arg);
+
+typedef struct tagBenchResult_t {
+  const char* name;  //< 項目名
+  uint64_t iters;    //< 1回の計測での実行回数
+  double ns;         //< 1回あたりの処理時間 (単位: ns)
+  double items;      //< 1回あたりの処理量
+  const char* unit;  //< 処理量の単位
+} BenchResult_t;
+
+/**
+ * Font_Print() の描画先
+ */
+typedef struct tagPrintContext_t {
+  const Canvas_t* canvas;
+  uint32_t x;
+  uint32_t y;
+  uint16_t color;
+  GlyphCache_t* cache;  //< NULL: 1ピクセルずつ描画する
+} PrintContext_t;
+
+typedef struct tagPrintArg_t {
+  const char* sz;
+  FontId_t ank;
+  FontId_t kanji;
+  Font_DrawFontFn_t fn;
+  PrintContext_t* ctx;
+} PrintArg_t;
+
+typedef struct tagFindArg_t {
+  const FontIndex_t* idx;
+  const uint16_t* codes;
+  size_t n;
+} FindArg_t;
+
+typedef struct tagGlyphCacheArg_t {
+  GlyphCache_t* cache;
+  const Canvas_t* canvas;
+  const uint8_t* const* graphs;
+  const uint32_t* order;  //< 描画するグリフの順序 (乱数)
+  size_t n;
+  size_t pos;
+} GlyphCacheArg_t;
+
+typedef struct tagBandArg_t {
+  BandRender_t* bands;
+  const DrawList_t* list;
+} BandArg_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 単調増加する時刻を取得する (単位: ns)
+ */
+static uint64_t nowNs(void);
+
+/**
+ * @brief 再現性のある疑似乱数 (xorshift32)
+ */
+static uint32_t nextRandom(void);
+
+/**
+ * @brief fn を iters 回実行した時間を計測する (単位: ns)
+ */
+static uint64_t measure(BenchFn_t fn, void* arg, uint64_t iters);
+
+/**
+ * @brief 1項目を計測して結果を表示する. 項目名がフィルタに一致しない場合は何もしない
+ * @param [in] name : 項目名 ("グループ/処理")
+ * @param [in] fn : 計測対象
+ * @param [in] arg : fn へ渡す引数
+ * @param [in] items : 1回あたりの処理量 (0: 処理量を表示しない)
+ * @param [in] unit : 処理量の単位
+ */
+static void run(const char* name, BenchFn_t fn, void* arg, double items, const char* unit);
+
+/**
+ * @brief 項目名がコマンドラインのフィルタに一致するか判定する
+ */
+static bool selected(const char* name);
+
+/**
+ * @brief 全角フォント (FONTX2, 2バイトコード) を合成する
+ * @param [out] size : 合成したデータのサイズ (単位: byte)
+ * @return 合成したデータ (malloc で確保)
+ */
+static uint8_t* makeKanjiFont(size_t* size);
+
+/**
+ * @brief 索引を使わずにコードブロックを先頭から走査する (Font_BuildIndex() 導入前の検索)
+ */
+static const uint8_t* findGlyphLinear(const uint8_t* font, uint16_t code);
+
+/**
+ * @brief Font_Print() の描画関数. 1ピクセルずつ Canvas_DrawPixel() で描画する
+ */
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief Font_Print() の描画関数. グリフキャッシュを通して描画する
+ */
+static UError_t drawGlyphCached(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief Font_Print() の描画関数. 何も描画しない (文字コードの解析と検索のみを計測する)
+ */
+static UError_t drawNothing(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief 各グループの計測
+ */
+static void benchCanvas(void);
+static void benchFont(void);
+static void benchGlyphCache(void);
+static void benchWidgets(void);
+static void benchTilemap(void);
+static void benchLCDDrv(void);
+static void benchBandRender(void);
+
+#if APIPROF_ENABLE
+/**
+ * @brief ApiProf_Dump() の書き出し先 (標準出力)
+ */
+static UError_t writeStdout(void* arg, const void* data, size_t size);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t targetNs = 200000000u;  //< 1回の計測の目標時間
+static char** filters = NULL;
+static int nFilters = 0;
+
+static BenchResult_t results[MAX_RESULTS];
+static size_t nResults = 0;
+
+static uint32_t randomState = 0x12345678u;
+static volatile uintptr_t sink = 0;  //< 最適化による処理の削除を防ぐ
+
+static uint16_t fb565[SCREEN_W * SCREEN_H];
+static uint8_t fb8[SCREEN_W * SCREEN_H];
+static uint8_t fb4[SCREEN_W * SCREEN_H / 2];
+static uint16_t sprite[64 * 64];
+static uint16_t line[SCREEN_W];
+static uint16_t palette[256];
+
+static Canvas_t canvas565;
+static Canvas_t canvas8;
+static Canvas_t canvas4;
+
+static FontId_t kanjiId = FONT_ID_NONE;
+static FontIndexBlock_t kanjiBlocks[KANJI_BLOCKS];
+
+static const char textAscii[] = "The quick brown fox jumps over the lazy dog 0123456789";
+static const char textKanji[] = "漢字の描画速度を計測します。東京都千代田区丸の内一丁目";
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t nextRandom(void) {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+static uint64_t measure(BenchFn_t fn, void* arg, uint64_t iters) {
+  const uint64_t start = nowNs();
+  for (uint64_t i = 0; i < iters; ++i) {
+    fn(arg);
+  }
+  return nowNs() - start;
+}
+
+static bool selected(const char* name) {
+  bool match = (0 == nFilters);
+  for (int i = 0; i < nFilters && !match; ++i) {
+    match = (NULL != strstr(name, filters[i]));
+  }
+  return match;
+}
+
+static void run(const char* name, BenchFn_t fn, void* arg, double items, const char* unit) {
+  if (!selected(name) || MAX_RESULTS <= nResults) {
+    return;
+  }
+
+  // 目標時間の 1/10 を超えるまで回数を倍にして, 1回あたりの時間を見積もる
+  uint64_t iters = 1;
+  uint64_t t = measure(fn, arg, iters);
+  while (t < targetNs / 10) {
+    iters *= 2;
+    t = measure(fn, arg, iters);
+  }
+  iters = (uint64_t)((double)iters * (double)targetNs / (double)((0 < t) ? t : 1));
+  iters = (0 < iters) ? iters : 1;
+
+  double best = 0;
+  for (int r = 0; r < REPEAT; ++r) {
+    const double ns = (double)measure(fn, arg, iters) / (double)iters;
+    best = (0 == r || ns < best) ? ns : best;
+  }
+
+  BenchResult_t* const res = &results[nResults++];
+  res->name = name;
+  res->iters = iters;
+  res->ns = best;
+  res->items = items;
+  res->unit = unit;
+
+  if (0 < items) {
+    printf("%-40s %14.1f ns/op %12.2f M%s/s\n", name, best, items * 1000.0 / best, unit);
+  } else {
+    printf("%-40s %14.1f ns/op\n", name, best);
+  }
+  fflush(stdout);
+}
+
+static uint8_t* makeKanjiFont(size_t* size) {
+  static const uint8_t leads[][2] = {{0x81, 0x9f}, {0xe0, 0xef}};
+  const size_t nglyphs = (KANJI_BLOCKS / 2) * ((0x7e - 0x40 + 1) + (0xfc - 0x80 + 1));
+  const size_t header = 18 + (4 * KANJI_BLOCKS);
+  uint8_t* const f = (uint8_t*)malloc(header + (nglyphs * KANJI_FSZ));
+
+  if (NULL != f) {
+    memcpy(&f[0], "FONTX2", 6);
+    memcpy(&f[6], "BENCH16 ", 8);
+    f[14] = KANJI_W;
+    f[15] = KANJI_H;
+    f[16] = 1;
+    f[17] = KANJI_BLOCKS;
+    uint8_t* cblk = &f[18];
+    for (size_t r = 0; r < 2; ++r) {
+      for (uint32_t lead = leads[r][0]; lead <= leads[r][1]; ++lead) {
+        const uint16_t ranges[2][2] = {{0x40, 0x7e}, {0x80, 0xfc}};
+        for (size_t k = 0; k < 2; ++k) {
+          const uint16_t sb = (uint16_t)((lead << 8) | ranges[k][0]);
+          const uint16_t eb = (uint16_t)((lead << 8) | ranges[k][1]);
+          cblk[0] = (uint8_t)(sb & 0xff);
+          cblk[1] = (uint8_t)(sb >> 8);
+          cblk[2] = (uint8_t)(eb & 0xff);
+          cblk[3] = (uint8_t)(eb >> 8);
+          cblk += 4;
+        }
+      }
+    }
+    // グリフは描画量が実際の漢字に近くなるよう, 約半分のビットを立てる
+    for (size_t i = 0; i < nglyphs * KANJI_FSZ; ++i) {
+      f[header + i] = (uint8_t)(nextRandom() & 0xff);
+    }
+    *size = header + (nglyphs * KANJI_FSZ);
+  }
+
+  return f;
+}
+
+static const uint8_t* findGlyphLinear(const uint8_t* font, uint16_t code) {
+  const size_t fsz = (font[14] + 7) / 8 * font[15];
+  const uint8_t* cblk = &font[18];
+  size_t nc = 0;
+  for (size_t bc = font[17]; 0 < bc; --bc) {
+    const size_t sb = cblk[0] + cblk[1] * 0x100;
+    const size_t eb = cblk[2] + cblk[3] * 0x100;
+    if (code >= sb && code <= eb) {
+      return &font[18 + (4 * font[17]) + ((nc + code - sb) * fsz)];
+    }
+    nc += eb - sb + 1;
+    cblk += 4;
+  }
+  return NULL;
+}
+
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  (void)fsz;
+  PrintContext_t* const ctx = (PrintContext_t*)arg;
+  if (NULL != graph) {
+    const uint8_t* addr = (const uint8_t*)graph;
+    const uint32_t cw = (0xff < c) ? (fw / 2) : fw;
+    const uint32_t posx = ctx->x + (x * cw);
+    const uint32_t posy = ctx->y + (y * fh);
+    const size_t bpr = (fw + 7) / 8;
+    for (uint32_t h = 0; h < fh; ++h) {
+      for (uint32_t w = 0; w < fw; ++w) {
+        if (addr[w / 8] & (0x80 >> (w % 8))) {
+          (void)Canvas_DrawPixel(ctx->canvas, posx + w, posy + h, ctx->color);
+        }
+      }
+      addr += bpr;
+    }
+  }
+  return uSuccess;
+}
+
+static UError_t drawGlyphCached(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  (void)fsz;
+  PrintContext_t* const ctx = (PrintContext_t*)arg;
+  if (NULL != graph) {
+    const uint32_t cw = (0xff < c) ? (fw / 2) : fw;
+    (void)GlyphCache_Draw(ctx->cache, ctx->canvas, ctx->x + (x * cw), ctx->y + (y * fh), graph, fw, fh, ctx->color, 0x0000, 1);
+  }
+  return uSuccess;
+}
+
+static UError_t drawNothing(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  (void)arg;
+  (void)x;
+  (void)y;
+  (void)fw;
+  (void)fh;
+  (void)fsz;
+  sink += (uintptr_t)graph + c;
+  return uSuccess;
+}
+
+// Canvas ////////////////////////////////////////////////////////////////////
+
+static void doClear(void* arg) { (void)Canvas_Clear((const Canvas_t*)arg, 0x1234); }
+
+static void doDrawPixel(void* arg) {
+  static size_t p = 0;
+  p = (p + 7919) % (SCREEN_W * SCREEN_H);
+  (void)Canvas_DrawPixel((const Canvas_t*)arg, p % SCREEN_W, p / SCREEN_W, 0xffff);
+}
+
+static void doDrawLineDiag(void* arg) { (void)Canvas_DrawLine((const Canvas_t*)arg, 0, 0, SCREEN_W - 1, SCREEN_H - 1, 0xf800); }
+
+static void doDrawLineH(void* arg) { (void)Canvas_DrawLine((const Canvas_t*)arg, 0, 100, SCREEN_W - 1, 100, 0x07e0); }
+
+static void doDrawLineV(void* arg) { (void)Canvas_DrawLine((const Canvas_t*)arg, 100, 0, 100, SCREEN_H - 1, 0x001f); }
+
+static void doDrawCircle(void* arg) { (void)Canvas_DrawCircle((const Canvas_t*)arg, SCREEN_W / 2, SCREEN_H / 2, 100, 0xffe0); }
+
+static void doDrawFillCircle(void* arg) { (void)Canvas_DrawFillCircle((const Canvas_t*)arg, SCREEN_W / 2, SCREEN_H / 2, 100, 0x07ff); }
+
+static void doFillRect(void* arg) { (void)Canvas_FillRect((const Canvas_t*)arg, 20, 20, 100, 100, 0xf81f); }
+
+static void doBlit(void* arg) { (void)Canvas_Blit((const Canvas_t*)arg, 30, 40, 64, 64, sprite, 64); }
+
+static void doScroll(void* arg) { (void)Canvas_Scroll((const Canvas_t*)arg, 0, 0, SCREEN_W, SCREEN_H, 0, -8, 0x0000); }
+
+static void doExpandLine(void* arg) {
+  static size_t y = 0;
+  y = (y + 1) % SCREEN_H;
+  (void)Canvas_ExpandLine((const Canvas_t*)arg, 0, y, SCREEN_W, line);
+}
+
+static void doSetClip(void* arg) {
+  Canvas_t* const canvas = (Canvas_t*)arg;
+  (void)Canvas_SetClip(canvas, 10, 20, 200, 280);
+  (void)Canvas_SetClip(canvas, 0, 0, SCREEN_W, SCREEN_H);
+}
+
+static void doGetBuf(void* arg) { sink += (uintptr_t)Canvas_GetBuf((const Canvas_t*)arg); }
+
+static void doGetRowBytes(void* arg) { sink += Canvas_GetRowBytes((const Canvas_t*)arg); }
+
+static void doCreate(void* arg) {
+  Canvas_t c;
+  (void)arg;
+  (void)Canvas_Create(&c, SCREEN_W, SCREEN_H, SCREEN_W, fb565);
+  sink += c.w;
+}
+
+static void doCreateIndexed(void* arg) {
+  Canvas_t c;
+  (void)arg;
+  (void)Canvas_CreateIndexed(&c, SCREEN_W, SCREEN_H, SCREEN_W, fb4, CanvasIndexed4, palette);
+  sink += c.w;
+}
+
+static void benchCanvas(void) {
+  static const struct {
+    const char* suffix;
+    Canvas_t* canvas;
+  } formats[] = {{"rgb565", &canvas565}, {"i8", &canvas8}, {"i4", &canvas4}};
+  static char names[3][16][48];
+  const double diag = (SCREEN_H > SCREEN_W) ? SCREEN_H : SCREEN_W;  // Bresenham の描画ピクセル数
+  const double r = 100;
+
+  for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+    Canvas_t* const c = formats[i].canvas;
+    const char* const s = formats[i].suffix;
+    size_t k = 0;
+#define CANVAS_CASE(NAME, FN, ITEMS)                                       \
+  do {                                                                     \
+    snprintf(names[i][k], sizeof(names[i][k]), "canvas/%s_%s", NAME, s);   \
+    run(names[i][k], FN, c, ITEMS, "pix");                                 \
+    ++k;                                                                   \
+  } while (0)
+    CANVAS_CASE("clear", doClear, SCREEN_W * SCREEN_H);
+    CANVAS_CASE("draw_pixel", doDrawPixel, 1);
+    CANVAS_CASE("draw_line_diag", doDrawLineDiag, diag);
+    CANVAS_CASE("draw_line_h", doDrawLineH, SCREEN_W);
+    CANVAS_CASE("draw_line_v", doDrawLineV, SCREEN_H);
+    CANVAS_CASE("draw_circle_r100", doDrawCircle, 8 * r * 0.7071);
+    CANVAS_CASE("draw_fill_circle_r100", doDrawFillCircle, 3.14159 * r * r);
+    CANVAS_CASE("fill_rect_100x100", doFillRect, 100 * 100);
+    CANVAS_CASE("scroll_full", doScroll, SCREEN_W * SCREEN_H);
+    CANVAS_CASE("expand_line", doExpandLine, SCREEN_W);
+    CANVAS_CASE("set_clip", doSetClip, 0);
+#undef CANVAS_CASE
+  }
+
+  run("canvas/blit_64x64_rgb565", doBlit, &canvas565, 64 * 64, "pix");
+  run("canvas/create", doCreate, NULL, 0, "");
+  run("canvas/create_indexed_i4", doCreateIndexed, NULL, 0, "");
+  run("canvas/get_buf", doGetBuf, &canvas565, 0, "");
+  run("canvas/get_row_bytes", doGetRowBytes, &canvas4, 0, "");
+}
+
+// Font //////////////////////////////////////////////////////////////////////
+
+static void doPrint(void* arg) {
+  const PrintArg_t* const p = (const PrintArg_t*)arg;
+  if (FONT_ID_NONE == p->ank && FONT_ID_NONE == p->kanji) {
+    (void)Font_Print(p->sz, p->fn, p->ctx);
+  } else {
+    (void)Font_PrintWith(p->ank, p->kanji, p->sz, p->fn, p->ctx);
+  }
+}
+
+static void doUnicodeToSJIS(void* arg) {
+  static uint32_t cp = 0x4e00;
+  (void)arg;
+  cp = (0x9fff <= cp) ? 0x4e00 : cp + 37;
+  sink += Font_UnicodeToSJIS(cp);
+}
+
+static void doFindGlyph(void* arg) {
+  FindArg_t* const f = (FindArg_t*)arg;
+  for (size_t i = 0; i < f->n; ++i) {
+    sink += (uintptr_t)Font_FindGlyph(f->idx, f->codes[i], NULL, NULL, NULL);
+  }
+}
+
+static void doFindGlyphLinear(void* arg) {
+  FindArg_t* const f = (FindArg_t*)arg;
+  for (size_t i = 0; i < f->n; ++i) {
+    sink += (uintptr_t)findGlyphLinear(f->idx->font, f->codes[i]);
+  }
+}
+
+static void doGet(void* arg) {
+  (void)arg;
+  // 登録済みの識別子と範囲外の識別子を交互に引く
+  for (FontId_t id = FONT_ID_NONE; id <= kanjiId + 1; ++id) {
+    sink += (uintptr_t)Font_Get(id);
+  }
+}
+
+static void doSetDefault(void* arg) {
+  (void)arg;
+  (void)Font_SetDefault(FONT_ID_ANK, kanjiId);
+  (void)Font_SetDefault(FONT_ID_ANK, FONT_ID_NONE);
+}
+
+static void doBuildIndex(void* arg) {
+  static FontIndexBlock_t blocks[KANJI_BLOCKS];
+  FontIndex_t idx;
+  const FontIndex_t* const src = (const FontIndex_t*)arg;
+  (void)Font_BuildIndex(&idx, src->font, SIZE_MAX, blocks, KANJI_BLOCKS);
+  sink += idx.nblk;
+}
+
+static void benchFont(void) {
+  static uint16_t ankCodes[256];
+  static uint16_t kanjiCodes[1024];
+  PrintContext_t ctx = {.canvas = &canvas565, .x = 0, .y = 8, .color = 0xffff, .cache = NULL};
+  const size_t nAscii = strlen(textAscii);
+  const size_t nKanji = strlen(textKanji) / 3;  // UTF-8 で 3byte の文字のみ
+  const size_t arenaSize = 64 * (sizeof(GlyphCacheEntry_t) + (KANJI_W * KANJI_H * sizeof(uint16_t)) + (2 * sizeof(uint16_t)));
+  void* const arena = malloc(arenaSize);
+  GlyphCache_t cache;
+
+  PrintArg_t ascii = {.sz = textAscii, .ank = FONT_ID_NONE, .kanji = FONT_ID_NONE, .fn = drawGlyph, .ctx = &ctx};
+  run("font/print_ascii", doPrint, &ascii, nAscii, "char");
+  ascii.fn = drawNothing;
+  run("font/print_ascii_nodraw", doPrint, &ascii, nAscii, "char");
+  ascii.ank = FONT_ID_ANK;
+  run("font/print_with_ascii_nodraw", doPrint, &ascii, nAscii, "char");
+
+  PrintArg_t kanji = {.sz = textKanji, .ank = FONT_ID_ANK, .kanji = kanjiId, .fn = drawGlyph, .ctx = &ctx};
+  run("font/print_with_kanji", doPrint, &kanji, nKanji, "char");
+  if (NULL != arena && uSuccess == GlyphCache_Create(&cache, arena, arenaSize, KANJI_W * KANJI_H)) {
+    ctx.cache = &cache;
+    kanji.fn = drawGlyphCached;
+    run("font/print_with_kanji_cached", doPrint, &kanji, nKanji, "char");
+    ctx.cache = NULL;
+  }
+  kanji.fn = drawNothing;
+  run("font/print_with_kanji_nodraw", doPrint, &kanji, nKanji, "char");
+
+  run("font/unicode_to_sjis", doUnicodeToSJIS, NULL, 1, "char");
+  run("font/get", doGet, NULL, (double)(kanjiId + 3), "id");
+  run("font/set_default", doSetDefault, NULL, 2, "call");
+
+  // 検索する文字コードは乱数で選び, 分岐予測が効きすぎないようにする
+  for (size_t i = 0; i < sizeof(ankCodes) / sizeof(ankCodes[0]); ++i) {
+    ankCodes[i] = (uint16_t)(nextRandom() & 0xff);
+  }
+  const FontIndex_t* const kidx = Font_Get(kanjiId);
+  for (size_t i = 0; i < sizeof(kanjiCodes) / sizeof(kanjiCodes[0]); ++i) {
+    const FontIndexBlock_t* const b = &kanjiBlocks[nextRandom() % KANJI_BLOCKS];
+    kanjiCodes[i] = (uint16_t)(b->sb + (nextRandom() % (b->eb - b->sb + 1u)));
+  }
+  FindArg_t ank = {.idx = Font_Get(FONT_ID_ANK), .codes = ankCodes, .n = sizeof(ankCodes) / sizeof(ankCodes[0])};
+  run("font/find_glyph_ank", doFindGlyph, &ank, (double)ank.n, "glyph");
+  if (NULL != kidx) {
+    FindArg_t dbcs = {.idx = kidx, .codes = kanjiCodes, .n = sizeof(kanjiCodes) / sizeof(kanjiCodes[0])};
+    run("font/find_glyph_dbcs_index", doFindGlyph, &dbcs, (double)dbcs.n, "glyph");
+    run("font/find_glyph_dbcs_linear", doFindGlyphLinear, &dbcs, (double)dbcs.n, "glyph");
+    // Font_Register() は登録を取り消せず, 上限 (FONT_REGISTRY_MAX) に達するため計測しない. 処理時間は Font_BuildIndex() とほぼ同じ
+    run("font/build_index_dbcs", doBuildIndex, (void*)kidx, KANJI_BLOCKS, "block");
+  }
+  free(arena);
+}
+
+// GlyphCache ////////////////////////////////////////////////////////////////
+
+static void doGlyphCacheDraw(void* arg) {
+  GlyphCacheArg_t* const g = (GlyphCacheArg_t*)arg;
+  const uint8_t* const graph = g->graphs[g->order[g->pos]];
+  g->pos = (g->pos + 1) % g->n;
+  (void)GlyphCache_Draw(g->cache, g->canvas, 16, 16, graph, KANJI_W, KANJI_H, 0xffff, 0x0000, 1);
+}
+
+static void benchGlyphCache(void) {
+  static const size_t slots[] = {16, 64, 256, 1024};
+  enum { WORKING_SET = 300, ORDER = 4096 };
+  static const uint8_t* graphs[WORKING_SET];
+  static uint32_t order[ORDER];
+  static char names[sizeof(slots) / sizeof(slots[0])][48];
+  const FontIndex_t* const kidx = Font_Get(kanjiId);
+
+  if (NULL == kidx) {
+    return;
+  }
+
+  // 画面に表示される文字の種類 (WORKING_SET 文字) を一様に参照する
+  for (size_t i = 0; i < WORKING_SET; ++i) {
+    const FontIndexBlock_t* const b = &kanjiBlocks[i % KANJI_BLOCKS];
+    graphs[i] = Font_FindGlyph(kidx, (uint16_t)(b->sb + (i / KANJI_BLOCKS)), NULL, NULL, NULL);
+  }
+  for (size_t i = 0; i < ORDER; ++i) {
+    order[i] = nextRandom() % WORKING_SET;
+  }
+
+  for (size_t i = 0; i < sizeof(slots) / sizeof(slots[0]); ++i) {
+    const size_t size = slots[i] * (sizeof(GlyphCacheEntry_t) + (KANJI_W * KANJI_H * sizeof(uint16_t)) + (2 * sizeof(uint16_t)));
+    void* const arena = malloc(size);
+    GlyphCache_t cache;
+    GlyphCacheStats_t stats = {0};
+    GlyphCacheArg_t g = {.cache = &cache, .canvas = &canvas565, .graphs = graphs, .order = order, .n = ORDER, .pos = 0};
+
+    snprintf(names[i], sizeof(names[i]), "glyphcache/draw_16x16_slots%zu", slots[i]);
+    if (NULL != arena && uSuccess == GlyphCache_Create(&cache, arena, size, KANJI_W * KANJI_H) && selected(names[i])) {
+      run(names[i], doGlyphCacheDraw, &g, KANJI_W * KANJI_H, "pix");
+      (void)GlyphCache_GetStats(&cache, &stats);
+      const double total = (double)stats.hit + (double)stats.miss;
+      printf("%-40s %14zu entries %9.1f %% hit\n", "", cache.nEntries, (0 < total) ? (100.0 * stats.hit / total) : 0.0);
+    }
+    free(arena);
+  }
+}
+
+// Chart / Console / TextField / NumFmt //////////////////////////////////////
+
+static void doChartPush(void* arg) {
+  static int32_t samples[1000];
+  static bool init = false;
+  if (!init) {
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i) {
+      samples[i] = (int32_t)(nextRandom() % 2000) - 1000;
+    }
+    init = true;
+  }
+  (void)Chart_PushN((Chart_t*)arg, samples, sizeof(samples) / sizeof(samples[0]));
+}
+
+static void doChartRender(void* arg) {
+  CanvasRect_t dirty[4];
+  size_t n = 0;
+  Chart_t* const chart = (Chart_t*)arg;
+  (void)Chart_Invalidate(chart);
+  (void)Chart_Render(chart, &canvas565, dirty, 4, &n);
+}
+
+static void doConsole(void* arg) {
+  CanvasRect_t dirty[64];
+  size_t n = 0;
+  static const char text[] = "The quick brown fox jumps over the lazy dog\r\n";
+  Console_t* const con = (Console_t*)arg;
+  (void)Console_Write(con, text, sizeof(text) - 1);
+  (void)Console_Render(con, dirty, 64, &n);
+}
+
+static void doTextField(void* arg) {
+  static uint32_t count = 0;
+  char sz[32];
+  CanvasRect_t dirty[8];
+  size_t n = 0;
+  snprintf(sz, sizeof(sz), "FPS %5u.%02u", (unsigned)(count / 100), (unsigned)(count % 100));
+  ++count;
+  (void)TextField_Update((TextField_t*)arg, sz, dirty, 8, &n);
+}
+
+static void doNumFmt(void* arg) {
+  static int32_t v = -123456;
+  char buf[16];
+  size_t len = 0;
+  (void)arg;
+  v += 7;
+  (void)NumFmt_I32(buf, sizeof(buf), v, 8, ' ', &len);
+  sink += len;
+}
+
+static void doProfilerFrame(void* arg) {
+  Profiler_t* const prof = (Profiler_t*)arg;
+  (void)Profiler_Switch(prof, ProfilerClear);
+  (void)Profiler_Switch(prof, ProfilerRender);
+  (void)Profiler_Switch(prof, ProfilerText);
+  (void)Profiler_Switch(prof, ProfilerNone);
+  (void)Profiler_EndFrame(prof);
+}
+
+static void doTraceBeginEnd(void* arg) {
+  (void)arg;
+  TRACE_BEGIN(TraceIdUser, 1, 2);
+  TRACE_END(TraceIdUser, 1, 2);
+}
+
+static UError_t discardTrace(void* arg, const void* data, size_t size) {
+  (void)arg;
+  (void)data;
+  (void)size;
+  return uSuccess;
+}
+
+static void doTraceDrain(void* arg) {
+  for (uint32_t i = 0; i < TRACERING_CHUNK; ++i) {
+    TRACE_INSTANT(TraceIdUser, i, 0);
+  }
+  (void)TraceRing_Drain((TraceRing_t*)arg, discardTrace, NULL, NULL);
+}
+
+static void doProfilerHUD(void* arg) { (void)Profiler_DrawHUD((const Profiler_t*)arg, &canvas565, SCREEN_W - PROFILER_HUD_W, SCREEN_H - PROFILER_HUD_H); }
+
+static void benchWidgets(void) {
+  static Profiler_t prof;
+  static ChartColumn_t columns[SCREEN_W];
+  static ConsoleCell_t conCells[60 * 40];
+  static TextFieldCell_t tfCells[16];
+  Chart_t chart;
+  Console_t con;
+  TextField_t tf;
+
+  if (uSuccess == Chart_Create(&chart, 0, 0, SCREEN_W, 100, columns)) {
+    (void)Chart_SetRange(&chart, -1000, 1000);
+    run("chart/push_n_1000", doChartPush, &chart, 1000, "sample");
+    run("chart/render_full", doChartRender, &chart, SCREEN_W * 100, "pix");
+  }
+  if (uSuccess == Console_Create(&con, &canvas565, 0, 0, 60, 40, conCells)) {
+    run("console/write_render_line", doConsole, &con, 45, "char");
+  }
+  if (uSuccess == TextField_Create(&tf, &canvas565, 0, 0, 16, 1, tfCells)) {
+    run("textfield/update_counter", doTextField, &tf, 12, "char");
+  }
+  run("numfmt/i32", doNumFmt, NULL, 1, "value");
+  if (uSuccess == Profiler_Create(&prof, 25 * 1000 * 1000)) {
+    run("profiler/switch4_end_frame", doProfilerFrame, &prof, 1, "frame");
+    run("profiler/draw_hud", doProfilerHUD, &prof, 1, "frame");
+  }
+  run("tracering/begin_end", doTraceBeginEnd, NULL, 2, "event");
+  run("tracering/put32_drain", doTraceDrain, &TraceRing_Default, TRACERING_CHUNK, "event");
+}
+
+// Tilemap ///////////////////////////////////////////////////////////////////
+
+static void doTilemapRender(void* arg) { (void)Tilemap_Render((const Tilemap_t*)arg, &canvas565); }
+
+static void doTilemapScroll(void* arg) { (void)Tilemap_Scroll((Tilemap_t*)arg, &canvas565, 1, 1); }
+
+static void benchTilemap(void) {
+  enum { MW = 64, MH = 64, NTILES = 64 };
+  static uint16_t map[MW * MH];
+  static uint16_t tiles565[NTILES * 64];
+  static uint8_t tiles4[NTILES * 32];
+  Tilemap_t tm;
+
+  for (size_t i = 0; i < MW * MH; ++i) {
+    const uint32_t r = nextRandom();
+    map[i] = TILEMAP_ENTRY(r % NTILES, (r >> 8) % 4, r & (TILEMAP_HFLIP | TILEMAP_VFLIP));
+  }
+  for (size_t i = 0; i < sizeof(tiles565) / sizeof(tiles565[0]); ++i) {
+    tiles565[i] = (uint16_t)nextRandom();
+  }
+  for (size_t i = 0; i < sizeof(tiles4); ++i) {
+    tiles4[i] = (uint8_t)nextRandom();
+  }
+
+  if (uSuccess == Tilemap_Create(&tm, map, MW, MH, tiles565, NTILES, TilemapRGB565)) {
+    (void)Tilemap_SetViewport(&tm, 0, 0, SCREEN_W, SCREEN_H);
+    (void)Tilemap_SetScroll(&tm, 3, 5);
+    run("tilemap/render_rgb565", doTilemapRender, &tm, SCREEN_W * SCREEN_H, "pix");
+    run("tilemap/scroll_1x1_rgb565", doTilemapScroll, &tm, SCREEN_W + SCREEN_H, "pix");
+  }
+  if (uSuccess == Tilemap_Create(&tm, map, MW, MH, tiles4, NTILES, Tilemap4bpp)) {
+    (void)Tilemap_SetPalette(&tm, palette, 4);
+    (void)Tilemap_SetViewport(&tm, 0, 0, SCREEN_W, SCREEN_H);
+    (void)Tilemap_SetScroll(&tm, 3, 5);
+    run("tilemap/render_4bpp", doTilemapRender, &tm, SCREEN_W * SCREEN_H, "pix");
+  }
+}
+
+// LCDDrv ////////////////////////////////////////////////////////////////////
+
+static void doSwapBuff(void* arg) { (void)LCDDrv_SwapBuff((LCDDrvHandle_t)arg, fb565, 0, 0, SCREEN_W, SCREEN_H); }
+
+static void doSwapCanvas4(void* arg) { (void)LCDDrv_SwapCanvas((LCDDrvHandle_t)arg, &canvas4, 0, 0, SCREEN_W, SCREEN_H); }
+
+static void doSwapCanvas565(void* arg) { (void)LCDDrv_SwapCanvas((LCDDrvHandle_t)arg, &canvas565, 0, 0, SCREEN_W, SCREEN_H); }
+
+static void doPackRGB444(void* arg) {
+  static uint8_t out[SCREEN_W * 3 / 2];
+  (void)arg;
+  sink += LCDDrv_PackRGB444(fb565, SCREEN_W, out);
+}
+
+static void benchLCDDrv(void) {
+  static SPIDrvContext_t spi;
+  static LCDDrvContext_t lcd;
+
+  if (uSuccess == SPIDrv_Create(&spi) && uSuccess == LCDDrv_Create(&lcd, &spi) && uSuccess == LCDDrv_Init(&lcd)) {
+    run("lcddrv/swap_buff_rgb565", doSwapBuff, &lcd, SCREEN_W * SCREEN_H, "pix");
+    run("lcddrv/swap_canvas_rgb565", doSwapCanvas565, &lcd, SCREEN_W * SCREEN_H, "pix");
+    run("lcddrv/swap_canvas_i4", doSwapCanvas4, &lcd, SCREEN_W * SCREEN_H, "pix");
+    (void)LCDDrv_SetPixelFormat(&lcd, LCDDrvRGB444);
+    run("lcddrv/swap_buff_rgb444", doSwapBuff, &lcd, SCREEN_W * SCREEN_H, "pix");
+    (void)LCDDrv_SetPixelFormat(&lcd, LCDDrvRGB565);
+  }
+  run("lcddrv/pack_rgb444_line", doPackRGB444, NULL, SCREEN_W, "pix");
+}
+
+// DrawList / BandRender /////////////////////////////////////////////////////
+
+static void doDrawListExecute(void* arg) { (void)DrawList_Execute((const DrawList_t*)arg, &canvas565); }
+
+static void doBandRender(void* arg) {
+  BandArg_t* const b = (BandArg_t*)arg;
+  (void)BandRender_Execute(b->bands, b->list, &canvas565);
+}
+
+static void benchBandRender(void) {
+  enum { NCMDS = 256 };
+  static DrawCmd_t cmds[NCMDS];
+  DrawList_t list;
+  BandRender_t bands;
+  BandArg_t args = {.bands = &bands, .list = &list};
+
+  if (uSuccess != DrawList_Create(&list, cmds, NCMDS) || uSuccess != BandRender_Create(&bands)) {
+    return;
+  }
+
+  // main.c の描画と同程度の負荷 (塗りつぶし + 図形)
+  (void)DrawList_Clear(&list, 0x0000);
+  while (uSuccess == DrawList_DrawFillCircle(&list, nextRandom() % SCREEN_W, nextRandom() % SCREEN_H, 4 + (nextRandom() % 40), (uint16_t)nextRandom())) {
+    (void)DrawList_DrawLine(&list, nextRandom() % SCREEN_W, nextRandom() % SCREEN_H, nextRandom() % SCREEN_W, nextRandom() % SCREEN_H,
+                            (uint16_t)nextRandom());
+  }
+
+  run("drawlist/execute", doDrawListExecute, &list, SCREEN_W * SCREEN_H, "pix");
+  run("bandrender/serial", doBandRender, &args, SCREEN_W * SCREEN_H, "pix");
+  if (selected("bandrender/threads") && uSuccess == BandRender_Start(&bands)) {
+    run("bandrender/threads", doBandRender, &args, SCREEN_W * SCREEN_H, "pix");
+    (void)BandRender_Stop(&bands);
+  }
+}
+
+#if APIPROF_ENABLE
+static UError_t writeStdout(void* arg, const void* data, size_t size) {
+  (void)arg;
+  return (size == fwrite(data, 1, size, stdout)) ? uSuccess : uFailure;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  int argi = 1;
+
+  if (argi + 1 < argc && 0 == strcmp(argv[argi], "-t")) {
+    targetNs = (uint64_t)strtoul(argv[argi + 1], NULL, 10) * 1000000u;
+    targetNs = (0 < targetNs) ? targetNs : 1000000u;
+    argi += 2;
+  }
+  filters = &argv[argi];
+  nFilters = argc - argi;
+
+  for (size_t i = 0; i < sizeof(sprite) / sizeof(sprite[0]); ++i) {
+    sprite[i] = (uint16_t)nextRandom();
+  }
+  for (size_t i = 0; i < sizeof(palette) / sizeof(palette[0]); ++i) {
+    palette[i] = (uint16_t)nextRandom();
+  }
+  (void)Canvas_Create(&canvas565, SCREEN_W, SCREEN_H, SCREEN_W, fb565);
+  (void)Canvas_CreateIndexed(&canvas8, SCREEN_W, SCREEN_H, SCREEN_W, fb8, CanvasIndexed8, palette);
+  (void)Canvas_CreateIndexed(&canvas4, SCREEN_W, SCREEN_H, SCREEN_W, fb4, CanvasIndexed4, palette);
+
+  size_t size = 0;
+  uint8_t* const kanji = makeKanjiFont(&size);
+  if (NULL == kanji || uSuccess != Font_Register(kanji, size, kanjiBlocks, KANJI_BLOCKS, &kanjiId)) {
+    fprintf(stderr, "failed to build the kanji font\n");
+    kanjiId = FONT_ID_NONE;
+  }
+
+  printf("%-40s %17s %16s\n", "benchmark", "time", "throughput");
+  benchCanvas();
+  benchFont();
+  benchGlyphCache();
+  benchWidgets();
+  benchTilemap();
+  benchLCDDrv();
+  benchBandRender();
+#if APIPROF_ENABLE
+  (void)ApiProf_Dump(writeStdout, NULL);
+#endif
+
+  free(kanji);
+  return 0;
+}
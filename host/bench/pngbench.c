@@ -0,0 +1,618 @@
+/**
+ * @file prog01/host/bench/pngbench.c
+ * PNG の逐次デコード (PngStream) の検査とベンチマーク (ホストビルド)
+ *
+ * 形式 (色の種類, ビット深度, tRNS, 行ごとに異なるフィルタ, 複数の IDAT) の異なる PNG をメモリ上で生成してデコードし,
+ * RGB565 の結果を参照実装と比較します. 帯状のキャンバスへの分割デコード, ディザ, 不正な入力も検査します.
+ * 続けて 320x240 の画像ごとに 1回のデコード時間を計測し, 次の値を表示します.
+ *   in_mb_s   : PNG のバイト数 / 時間 (単位: MB/s)
+ *   raw_mb_s  : 展開後 (フィルタ種別を含む) のバイト数 / 時間 (単位: MB/s)
+ *   mpix_s    : ピクセル数 / 時間 (単位: Mpixel/s)
+ *   work      : 使用した作業領域 (単位: byte)
+ * ファイルを指定すると, そのファイルも計測します.
+ *   pngbench [-t ミリ秒] [-c] [file.png ...]
+ * -c は検査のみ行い (計測しない), 不一致があれば終了コード 1 を返します (ctest から実行).
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#include <user/canvas.h>
+#include <user/macros.h>
+#include <user/pngstream.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CHECK_W (37)  //< 検査用の画像の大きさ (1行が byte 境界で終わらない幅)
+#define CHECK_H (23)
+#define BENCH_W (320)  //< 計測用の画像の大きさ
+#define BENCH_H (240)
+#define IDAT_SIZE (1000)  //< 生成する IDAT 1つあたりの大きさ (複数の IDAT に分ける)
+#define STRIP_H (64)      //< 帯状のキャンバスの高さ
+
+#define BG_R (0x20)  //< アルファと合成する背景色
+#define BG_G (0x80)
+#define BG_B (0xe0)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 生成する画像の形式
+ */
+typedef struct tagCase_t {
+  const char* name;
+  uint8_t colorType;
+  uint8_t depth;
+  bool trns;  //< tRNS を付ける (パレット: 一部のアルファ, グレースケール / RGB: 透過色)
+} Case_t;
+
+/**
+ * 生成した PNG と期待する結果
+ */
+typedef struct tagImage_t {
+  uint8_t* png;
+  size_t size;
+  uint32_t w;
+  uint32_t h;
+  size_t rawBytes;     //< 展開後のバイト数 (フィルタ種別を含む)
+  uint16_t* expected;  //< ディザなしの RGB565 (RGB888toRGB565() の格納順)
+  uint8_t* rgb;        //< 背景色と合成した 8bit の RGB (ディザの検査用)
+} Image_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 単調増加する時刻を取得する (単位: ns)
+ */
+static uint64_t nowNs(void);
+
+/**
+ * @brief 再現性のある疑似乱数 (xorshift32)
+ */
+static uint32_t nextRandom(uint32_t* state);
+
+/**
+ * @brief ビッグエンディアンで書き込む
+ */
+static void putBE32(uint8_t* p, uint32_t v);
+
+/**
+ * @brief チャンク (長さ, 種類, データ, CRC) を追加する
+ */
+static void putChunk(uint8_t* png, size_t* size, const char* type, const uint8_t* data, uint32_t len);
+
+/**
+ * @brief 行にフィルタをかける (デコーダと独立した実装)
+ */
+static void filterRow(uint8_t type, const uint8_t* cur, const uint8_t* prev, uint8_t* out, size_t rowBytes, uint32_t bpp);
+
+/**
+ * @brief 形式 c の w x h の画像を生成する. smooth が true の場合は写真に近い緩やかな変化にする
+ */
+static bool makeImage(const Case_t* c, uint32_t w, uint32_t h, bool smooth, Image_t* img);
+
+static void freeImage(Image_t* img);
+
+/**
+ * @brief メモリ上の PNG をキャンバスへデコードする
+ * @param [out] workUsed : 使用した作業領域 (NULL 可)
+ */
+static UError_t decodeTo(const uint8_t* png, size_t size, size_t maxW, bool dither, Canvas_t* canvas, int32_t x, int32_t y, size_t* workUsed);
+
+/**
+ * @brief 生成した画像の検査
+ * @return 不一致の数
+ */
+static uint32_t checkCases(void);
+
+/**
+ * @brief 1つの PNG の計測結果を表示する
+ */
+static void measure(const char* name, const uint8_t* png, size_t size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t targetNs = 200000000u;  //< 1項目あたりの計測時間の目標
+
+static const Case_t checks[] = {
+    {"gray1", 0, 1, false},
+    {"gray2", 0, 2, false},
+    {"gray4", 0, 4, true},
+    {"gray8", 0, 8, true},
+    {"gray16", 0, 16, true},
+    {"rgb8", 2, 8, false},
+    {"rgb8-key", 2, 8, true},
+    {"rgb16", 2, 16, true},
+    {"pal1", 3, 1, false},
+    {"pal2", 3, 2, true},
+    {"pal4", 3, 4, true},
+    {"pal8", 3, 8, true},
+    {"graya8", 4, 8, false},
+    {"graya16", 4, 16, false},
+    {"rgba8", 6, 8, false},
+    {"rgba16", 6, 16, false},
+};
+#define CHECKS (sizeof(checks) / sizeof(checks[0]))
+
+static const Case_t benches[] = {
+    {"rgb8", 2, 8, false},
+    {"rgba8", 6, 8, false},
+    {"pal8", 3, 8, false},
+    {"gray8", 0, 8, false},
+};
+#define BENCHES (sizeof(benches) / sizeof(benches[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t nextRandom(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void putBE32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void putChunk(uint8_t* png, size_t* size, const char* type, const uint8_t* data, uint32_t len) {
+  uint8_t* const p = png + *size;
+  putBE32(p, len);
+  memcpy(p + 4, type, 4);
+  if (0 < len) {
+    memcpy(p + 8, data, len);
+  }
+  putBE32(p + 8 + len, (uint32_t)crc32(0, p + 4, 4 + len));
+  *size += 12 + len;
+}
+
+static void filterRow(uint8_t type, const uint8_t* cur, const uint8_t* prev, uint8_t* out, size_t rowBytes, uint32_t bpp) {
+  out[0] = type;
+  for (size_t i = 0; i < rowBytes; ++i) {
+    const int a = (i < bpp) ? 0 : cur[i - bpp];
+    const int b = prev[i];
+    const int c = (i < bpp) ? 0 : prev[i - bpp];
+    int pred = 0;
+    switch (type) {
+      case 1:
+        pred = a;
+        break;
+      case 2:
+        pred = b;
+        break;
+      case 3:
+        pred = (a + b) / 2;
+        break;
+      case 4: {
+        const int p = a + b - c;
+        const int pa = abs(p - a);
+        const int pb = abs(p - b);
+        const int pc = abs(p - c);
+        pred = (pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c);
+      } break;
+      default:
+        break;
+    }
+    out[1 + i] = (uint8_t)(cur[i] - pred);
+  }
+}
+
+static bool makeImage(const Case_t* c, uint32_t w, uint32_t h, bool smooth, Image_t* img) {
+  static const uint8_t channelsOf[] = {1, 0, 3, 1, 2, 0, 4};
+  const uint32_t channels = channelsOf[c->colorType];
+  const uint32_t depth = c->depth;
+  const uint32_t maxv = (1u << depth) - 1u;
+  const size_t rowBytes = (((size_t)w * channels * depth) + 7) / 8;
+  const uint32_t bpp = ((channels * depth) / 8 == 0) ? 1 : (channels * depth) / 8;
+  const uint32_t paletteSize = (3 == c->colorType) ? (1u << depth) : 0;
+  uint32_t seed = 0x12345678u ^ ((uint32_t)c->colorType << 8) ^ depth;
+
+  memset(img, 0, sizeof(Image_t));
+  img->w = w;
+  img->h = h;
+  img->rawBytes = (rowBytes + 1) * h;
+  img->expected = (uint16_t*)malloc(sizeof(uint16_t) * w * h);
+  img->rgb = (uint8_t*)malloc((size_t)3 * w * h);
+  uint8_t* const raw = (uint8_t*)calloc(rowBytes + 1, h);
+  uint8_t* const cur = (uint8_t*)calloc(rowBytes, 1);
+  uint8_t* const prev = (uint8_t*)calloc(rowBytes, 1);
+  const uLong bound = compressBound((uLong)img->rawBytes);
+  uint8_t* const z = (uint8_t*)malloc(bound);
+  if (NULL == img->expected || NULL == img->rgb || NULL == raw || NULL == cur || NULL == prev || NULL == z) {
+    return false;
+  }
+
+  // パレット (tRNS では前半の項目に段階的なアルファを付ける) と透過色
+  uint8_t palette[256][4];
+  for (uint32_t i = 0; i < paletteSize; ++i) {
+    palette[i][0] = (uint8_t)(i * 37);
+    palette[i][1] = (uint8_t)(255 - (i * 11));
+    palette[i][2] = (uint8_t)(i * 91 + 13);
+    palette[i][3] = (c->trns && i < paletteSize / 2) ? (uint8_t)(i * 255 / (paletteSize / 2)) : 0xff;
+  }
+  const uint32_t key[3] = {maxv / 3, maxv / 2, maxv / 5};
+
+  for (uint32_t y = 0; y < h; ++y) {
+    memset(cur, 0, rowBytes);
+    for (uint32_t x = 0; x < w; ++x) {
+      uint32_t s[4];
+      for (uint32_t ch = 0; ch < channels; ++ch) {
+        if (smooth) {
+          // 緩やかなグラデーションに小さな揺らぎを加える
+          const uint32_t base = ((x * (ch + 1) * 255u) / w + (y * 255u) / h) / 2;
+          s[ch] = ((base + (nextRandom(&seed) & 3u)) * maxv / 258u);
+        } else {
+          s[ch] = nextRandom(&seed) & maxv;
+        }
+      }
+      if (c->trns && 0 == (x + y) % 5 && (0 == c->colorType || 2 == c->colorType)) {
+        // 透過色を一定の割合で含める
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+          s[ch] = key[ch];
+        }
+      }
+      if (3 == c->colorType) {
+        s[0] %= paletteSize;
+      }
+
+      // サンプルを詰める
+      for (uint32_t ch = 0; ch < channels; ++ch) {
+        const uint32_t i = (x * channels) + ch;
+        if (16 == depth) {
+          cur[i * 2] = (uint8_t)(s[ch] >> 8);
+          cur[(i * 2) + 1] = (uint8_t)s[ch];
+        } else {
+          const uint32_t bit = i * depth;
+          cur[bit >> 3] |= (uint8_t)(s[ch] << (8 - depth - (bit & 7)));
+        }
+      }
+
+      // 参照: 8bit の RGBA にしてから背景色と合成する
+      uint32_t rgba[4] = {0, 0, 0, 255};
+      const uint32_t to8 = (16 == depth) ? 0 : 255 / maxv;
+#define TO8(v) ((16 == depth) ? ((v) >> 8) : ((v) * to8))
+      switch (c->colorType) {
+        case 0:
+          rgba[0] = rgba[1] = rgba[2] = TO8(s[0]);
+          rgba[3] = (c->trns && s[0] == key[0]) ? 0 : 255;
+          break;
+        case 2:
+          rgba[0] = TO8(s[0]);
+          rgba[1] = TO8(s[1]);
+          rgba[2] = TO8(s[2]);
+          rgba[3] = (c->trns && s[0] == key[0] && s[1] == key[1] && s[2] == key[2]) ? 0 : 255;
+          break;
+        case 3:
+          for (uint32_t ch = 0; ch < 4; ++ch) {
+            rgba[ch] = palette[s[0]][ch];
+          }
+          break;
+        case 4:
+          rgba[0] = rgba[1] = rgba[2] = TO8(s[0]);
+          rgba[3] = TO8(s[1]);
+          break;
+        case 6:
+          rgba[0] = TO8(s[0]);
+          rgba[1] = TO8(s[1]);
+          rgba[2] = TO8(s[2]);
+          rgba[3] = TO8(s[3]);
+          break;
+        default:
+          break;
+      }
+#undef TO8
+      const uint32_t bg[3] = {BG_R, BG_G, BG_B};
+      for (uint32_t ch = 0; ch < 3; ++ch) {
+        rgba[ch] = ((rgba[ch] * rgba[3]) + (bg[ch] * (255 - rgba[3])) + 127) / 255;
+      }
+      const uint8_t r = (uint8_t)rgba[0];
+      const uint8_t g = (uint8_t)rgba[1];
+      const uint8_t b = (uint8_t)rgba[2];
+      img->expected[((size_t)y * w) + x] = RGB888toRGB565(r, g, b);
+      memcpy(&img->rgb[(((size_t)y * w) + x) * 3], (const uint8_t[]){r, g, b}, 3);
+    }
+
+    // 行ごとにフィルタの種類を変える
+    filterRow((uint8_t)(y % 5), cur, prev, raw + ((rowBytes + 1) * y), rowBytes, bpp);
+    memcpy(prev, cur, rowBytes);
+  }
+
+  uLongf zSize = bound;
+  const bool ok = (Z_OK == compress2(z, &zSize, raw, (uLong)img->rawBytes, 6));
+  img->png = (uint8_t*)malloc(64 + (256 * 3) + 256 + zSize + ((zSize / IDAT_SIZE) + 1) * 12 + 12);
+  if (ok && NULL != img->png) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    memcpy(img->png, signature, sizeof(signature));
+    img->size = sizeof(signature);
+
+    uint8_t ihdr[13];
+    putBE32(&ihdr[0], w);
+    putBE32(&ihdr[4], h);
+    ihdr[8] = c->depth;
+    ihdr[9] = c->colorType;
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    putChunk(img->png, &img->size, "IHDR", ihdr, sizeof(ihdr));
+
+    if (3 == c->colorType) {
+      uint8_t plte[256 * 3];
+      uint8_t trns[256];
+      for (uint32_t i = 0; i < paletteSize; ++i) {
+        plte[(i * 3) + 0] = palette[i][0];
+        plte[(i * 3) + 1] = palette[i][1];
+        plte[(i * 3) + 2] = palette[i][2];
+        trns[i] = palette[i][3];
+      }
+      putChunk(img->png, &img->size, "PLTE", plte, paletteSize * 3);
+      if (c->trns) {
+        putChunk(img->png, &img->size, "tRNS", trns, paletteSize / 2);
+      }
+    } else if (c->trns) {
+      uint8_t trns[6];
+      for (uint32_t ch = 0; ch < channels; ++ch) {
+        trns[ch * 2] = (uint8_t)(key[ch] >> 8);
+        trns[(ch * 2) + 1] = (uint8_t)key[ch];
+      }
+      putChunk(img->png, &img->size, "tRNS", trns, channels * 2);
+    }
+
+    for (uLongf pos = 0; pos < zSize; pos += IDAT_SIZE) {
+      const uint32_t len = (uint32_t)((zSize - pos < IDAT_SIZE) ? zSize - pos : IDAT_SIZE);
+      putChunk(img->png, &img->size, "IDAT", z + pos, len);
+    }
+    putChunk(img->png, &img->size, "IEND", NULL, 0);
+  }
+
+  free(raw);
+  free(cur);
+  free(prev);
+  free(z);
+  return ok && NULL != img->png;
+}
+
+static void freeImage(Image_t* img) {
+  free(img->png);
+  free(img->expected);
+  free(img->rgb);
+  memset(img, 0, sizeof(Image_t));
+}
+
+static UError_t decodeTo(const uint8_t* png, size_t size, size_t maxW, bool dither, Canvas_t* canvas, int32_t x, int32_t y, size_t* workUsed) {
+  const size_t workSize = PNGSTREAM_WORK_SIZE(maxW);
+  void* const work = malloc(workSize);
+  PngStream_t ctx;
+  PngStreamMemory_t src = {png, size, 0};
+  PngStreamCanvas_t dst = {canvas, x, y};
+
+  UError_t err = (NULL == work) ? uFailure : PngStream_Create(&ctx, work, workSize);
+  if (uSuccess == err) {
+    err = PngStream_SetBackground(&ctx, BG_R, BG_G, BG_B);
+  }
+  if (uSuccess == err) {
+    err = PngStream_SetDither(&ctx, dither);
+  }
+  if (uSuccess == err) {
+    err = PngStream_Decode(&ctx, PngStream_ReadMemory, &src, PngStream_RowToCanvas, &dst);
+  }
+  if (NULL != workUsed) {
+    *workUsed = (uSuccess == err) ? ctx.workUsed : 0;
+  }
+  free(work);
+  return err;
+}
+
+static uint32_t checkCases(void) {
+  uint32_t failures = 0;
+  static uint16_t fb[BENCH_W * BENCH_H];
+  Canvas_t canvas;
+
+  // 形式ごとの結果 (ディザなし) を参照実装と比較する
+  for (size_t i = 0; i < CHECKS; ++i) {
+    Image_t img;
+    if (!makeImage(&checks[i], CHECK_W, CHECK_H, false, &img)) {
+      printf("%-10s generate failed\n", checks[i].name);
+      ++failures;
+      continue;
+    }
+    memset(fb, 0, sizeof(fb));
+    (void)Canvas_Create(&canvas, CHECK_W, CHECK_H, CHECK_W, fb);
+    const UError_t err = decodeTo(img.png, img.size, CHECK_W, false, &canvas, 0, 0, NULL);
+    uint32_t diff = 0;
+    for (size_t p = 0; p < (size_t)CHECK_W * CHECK_H; ++p) {
+      diff += (fb[p] != img.expected[p]) ? 1 : 0;
+    }
+    if (uSuccess != err || 0 < diff) {
+      printf("%-10s FAIL (err %d, %u pixels differ)\n", checks[i].name, (int)err, diff);
+      ++failures;
+    }
+    freeImage(&img);
+  }
+
+  // 帯状のキャンバスへ分割してデコードした結果は, 全体へデコードした結果と一致する
+  Image_t img;
+  if (makeImage(&benches[0], BENCH_W, BENCH_H, true, &img)) {
+    static uint16_t strip[BENCH_W * STRIP_H];
+    uint32_t diff = 0;
+    for (uint32_t top = 0; top < BENCH_H; top += STRIP_H) {
+      Canvas_t band;
+      memset(strip, 0, sizeof(strip));
+      (void)Canvas_Create(&band, BENCH_W, STRIP_H, BENCH_W, strip);
+      if (uSuccess != decodeTo(img.png, img.size, BENCH_W, false, &band, 0, -(int32_t)top, NULL)) {
+        ++diff;
+        continue;
+      }
+      for (uint32_t j = 0; j < STRIP_H && top + j < BENCH_H; ++j) {
+        diff += (0 != memcmp(&strip[j * BENCH_W], &img.expected[(top + j) * BENCH_W], BENCH_W * sizeof(uint16_t))) ? 1 : 0;
+      }
+    }
+    if (0 < diff) {
+      printf("%-10s FAIL (%u strip rows differ)\n", "strips", diff);
+      ++failures;
+    }
+
+    // ディザありの各チャンネルは v * (2^n - 1) / 255 の切り捨てか切り上げ
+    (void)Canvas_Create(&canvas, BENCH_W, BENCH_H, BENCH_W, fb);
+    diff = (uSuccess == decodeTo(img.png, img.size, BENCH_W, true, &canvas, 0, 0, NULL)) ? 0 : 1;
+    for (size_t p = 0; p < (size_t)BENCH_W * BENCH_H; ++p) {
+      const uint32_t v = (uint16_t)((fb[p] << 8) | (fb[p] >> 8));
+      const uint32_t q[3] = {v >> 11, (v >> 5) & 0x3fu, v & 0x1fu};
+      const uint32_t levels[3] = {31, 63, 31};
+      for (uint32_t ch = 0; ch < 3; ++ch) {
+        const uint32_t lo = (img.rgb[(p * 3) + ch] * levels[ch]) / 255;
+        diff += (q[ch] < lo || lo + 1 < q[ch]) ? 1 : 0;
+      }
+    }
+    if (0 < diff) {
+      printf("%-10s FAIL (%u pixels out of range)\n", "dither", diff);
+      ++failures;
+    }
+
+    // 途中で終わる入力, 壊れた圧縮データ, 不足する作業領域は失敗する
+    (void)Canvas_Create(&canvas, BENCH_W, BENCH_H, BENCH_W, fb);
+    if (uSuccess == decodeTo(img.png, img.size / 2, BENCH_W, false, &canvas, 0, 0, NULL)) {
+      printf("%-10s FAIL (truncated input accepted)\n", "errors");
+      ++failures;
+    }
+    img.png[img.size - 40] ^= 0x55;
+    if (uSuccess == decodeTo(img.png, img.size, BENCH_W, false, &canvas, 0, 0, NULL)) {
+      printf("%-10s FAIL (corrupt data accepted)\n", "errors");
+      ++failures;
+    }
+    img.png[img.size - 40] ^= 0x55;
+    if (uSuccess == decodeTo(img.png, img.size, BENCH_W / 8, false, &canvas, 0, 0, NULL)) {
+      printf("%-10s FAIL (small work area accepted)\n", "errors");
+      ++failures;
+    }
+    freeImage(&img);
+  } else {
+    ++failures;
+  }
+
+  printf("check: %zu formats, strips, dither, errors: %s\n", CHECKS, (0 == failures) ? "ok" : "FAILED");
+  return failures;
+}
+
+static void measure(const char* name, const uint8_t* png, size_t size) {
+  // IHDR から大きさを取り出してキャンバスを用意する
+  if (size < 33) {
+    printf("%-16s too short\n", name);
+    return;
+  }
+  const uint32_t w = ((uint32_t)png[16] << 24) | ((uint32_t)png[17] << 16) | ((uint32_t)png[18] << 8) | png[19];
+  const uint32_t h = ((uint32_t)png[20] << 24) | ((uint32_t)png[21] << 16) | ((uint32_t)png[22] << 8) | png[23];
+  uint16_t* const fb = (uint16_t*)malloc(sizeof(uint16_t) * (size_t)w * h);
+  Canvas_t canvas;
+  if (NULL == fb || 0 == w || 0 == h || uSuccess != Canvas_Create(&canvas, w, h, w, fb)) {
+    printf("%-16s cannot allocate %ux%u\n", name, w, h);
+    free(fb);
+    return;
+  }
+
+  for (int dither = 0; dither < 2; ++dither) {
+    size_t workUsed = 0;
+    uint64_t best = UINT64_MAX;
+    uint64_t total = 0;
+    UError_t err = uSuccess;
+    for (uint32_t n = 0; uSuccess == err && (n < 3 || total < targetNs); ++n) {
+      const uint64_t t0 = nowNs();
+      err = decodeTo(png, size, w, (0 != dither), &canvas, 0, 0, &workUsed);
+      const uint64_t dt = nowNs() - t0;
+      total += dt;
+      best = (dt < best) ? dt : best;
+    }
+    if (uSuccess != err) {
+      printf("%-16s decode failed\n", name);
+      break;
+    }
+    // 展開後のバイト数は 1行のバイト数から求める (IHDR の深度と色の種類)
+    static const uint8_t channelsOf[] = {1, 0, 3, 1, 2, 0, 4};
+    const uint8_t ct = png[25];
+    const size_t rawBytes = ((((size_t)w * ((ct < 7) ? channelsOf[ct] : 0) * png[24]) + 7) / 8 + 1) * h;
+    const double s = (double)best / 1e9;
+    printf("%-16s %-6s %9zu %10.1f %10.1f %8.2f %8zu\n", name, dither ? "dither" : "-", size, (double)size / s / 1e6, (double)rawBytes / s / 1e6,
+           (double)w * h / s / 1e6, workUsed);
+  }
+  free(fb);
+}
+
+int main(int argc, char* argv[]) {
+  bool checkOnly = false;
+  int argi = 1;
+
+  while (argi < argc && '-' == argv[argi][0]) {
+    if (0 == strcmp(argv[argi], "-c")) {
+      checkOnly = true;
+      argi += 1;
+    } else if (0 == strcmp(argv[argi], "-t") && argi + 1 < argc) {
+      targetNs = (uint64_t)strtoul(argv[argi + 1], NULL, 10) * 1000000u;
+      targetNs = (0 < targetNs) ? targetNs : 1000000u;
+      argi += 2;
+    } else {
+      break;
+    }
+  }
+
+  const uint32_t failures = checkCases();
+  if (checkOnly) {
+    return (0 == failures) ? 0 : 1;
+  }
+
+  printf("%-16s %-6s %9s %10s %10s %8s %8s\n", "image", "mode", "png_bytes", "in_mb_s", "raw_mb_s", "mpix_s", "work");
+  for (size_t i = 0; i < BENCHES; ++i) {
+    Image_t img;
+    if (makeImage(&benches[i], BENCH_W, BENCH_H, true, &img)) {
+      measure(benches[i].name, img.png, img.size);
+      freeImage(&img);
+    }
+  }
+
+  // 指定されたファイル
+  for (; argi < argc; ++argi) {
+    FILE* fp = fopen(argv[argi], "rb");
+    if (NULL == fp) {
+      printf("%-16s cannot open\n", argv[argi]);
+      continue;
+    }
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t* const png = (0 < size) ? (uint8_t*)malloc((size_t)size) : NULL;
+    if (NULL != png && (size_t)size == fread(png, 1, (size_t)size, fp)) {
+      measure(argv[argi], png, (size_t)size);
+    }
+    free(png);
+    fclose(fp);
+  }
+
+  return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,626 @@
+/**
+ * @file prog01/host/bench/scenes.c
+ * 代表的な画面 (シーン) の描画ベンチマーク (ホストビルド)
+ *
+ * 決まった内容の 64フレームを Canvas / Font 等で描画し, シーンごとに次の値を求めます.
+ *   frame_ns   : 1フレームの描画時間 (繰り返し計測した最速値)
+ *   pixels     : 1フレームに書き込んだピクセル数 (CANVAS_OVERDRAW で計数. 重ね描きを含む)
+ *   wire_bytes : 1フレームに LCD へ送信するバイト数 (更新矩形ごとに ウィンドウ設定 11byte + RGB565)
+ * -w で結果を基準値 (JSON) として書き出し, -c で基準値と比較します.
+ * 基準値より 許容範囲 (%) を超えて悪化した値があれば終了コード 1 を返します (ctest から実行).
+ *   scenes [-t ミリ秒] [-p 時間の許容範囲%] [-q 計数の許容範囲%] [-w 出力先.json | -c 基準値.json] [シーン名 ...]
+ * 比較するのは決定的な pixels と wire_bytes のみで, 描画時間は差を表示するだけです.
+ * 描画時間は計測する環境と実行ごとに大きくばらつくため, -p を指定した場合のみ比較します.
+ * その場合は基準値を比較する環境で -w を使って記録し直してください.
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <user/canvas.h>
+#include <user/console.h>
+#include <user/font.h>
+#include <user/macros.h>
+#include <user/numfmt.h>
+#include <user/textfield.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#if !CANVAS_OVERDRAW
+#error "scenes counts pixel writes with CANVAS_OVERDRAW=1"
+#endif
+
+#define SCREEN_W (240)
+#define SCREEN_H (320)
+#define FRAMES (64)  //< 1回の計測で描画するフレーム数
+#define REPEAT (5)   //< 計測の繰り返し回数 (最速値を採用)
+
+#define WINDOW_BYTES (11)  //< LCDDrv_SetWindow() の送信バイト数 (0x2A + 4byte, 0x2B + 4byte, 0x2C)
+#define SCROLL_BYTES (3)   //< LCDDrv_Scroll() の送信バイト数 (0x37 + 2byte)
+
+#define DASH_FIELDS (32)  //< ダッシュボードの値の数
+#define DASH_COLS (14)    //< 値 1つあたりの桁数
+#define SPRITES (24)      //< スプライトの数
+#define SPRITE_SIZE (16)  //< スプライトの幅と高さ
+#define LOG_COLS (SCREEN_W / 4)
+#define LOG_ROWS (SCREEN_H / 8)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * シーン (setup で初期状態にし, frame で 1フレームを描画して送信バイト数を返す)
+ */
+typedef struct tagScene_t {
+  const char* name;
+  void (*setup)(void);
+  uint64_t (*frame)(uint32_t f);
+} Scene_t;
+
+typedef struct tagSceneResult_t {
+  double ns;            //< 1フレームの描画時間 (単位: ns)
+  uint64_t pixels;      //< 1フレームの書き込みピクセル数
+  uint64_t wireBytes;   //< 1フレームの送信バイト数
+  bool found;           //< 基準値がある
+  double baseNs;        //< 基準値
+  uint64_t basePixels;  //< 基準値
+  uint64_t baseWire;    //< 基準値
+} SceneResult_t;
+
+/**
+ * Font_Print() の描画先
+ */
+typedef struct tagPrintContext_t {
+  uint32_t x;
+  uint32_t y;
+  uint16_t color;
+} PrintContext_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 単調増加する時刻を取得する (単位: ns)
+ */
+static uint64_t nowNs(void);
+
+/**
+ * @brief 再現性のある疑似乱数 (xorshift32)
+ */
+static uint32_t nextRandom(uint32_t* state);
+
+/**
+ * @brief 矩形 1つを LCD へ送信する場合のバイト数
+ */
+static uint64_t wireBytes(const CanvasRect_t* r);
+
+/**
+ * @brief Font_Print() の描画関数. 前景のピクセルのみ Canvas_DrawPixel() で描画する (main.c の drawCharactor() と同じ)
+ */
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief シーンを初期状態にしてから 1回分 (FRAMES フレーム) 描画する. 初期化は計測に含めない
+ * @param [out] ns : FRAMES フレームの描画時間 (単位: ns)
+ * @return 送信バイト数の合計
+ */
+static uint64_t playScene(const Scene_t* scene, uint64_t* ns);
+
+/**
+ * @brief シーンを計測する
+ */
+static void measureScene(const Scene_t* scene, SceneResult_t* result);
+
+/**
+ * @brief 基準値を読み込む. 見つからないシーンは found = false とする
+ */
+static UError_t loadBaseline(const char* path, SceneResult_t* results);
+
+/**
+ * @brief 計測結果を基準値として書き出す
+ */
+static UError_t writeBaseline(const char* path, const SceneResult_t* results);
+
+/**
+ * @brief シーン名がコマンドラインのフィルタに一致するか判定する
+ */
+static bool selected(const char* name);
+
+/**
+ * @brief 各シーン
+ */
+static void setupGrid(void);
+static uint64_t frameGrid(uint32_t f);
+static void setupCircles(void);
+static uint64_t frameCircles(uint32_t f);
+static void setupDashboard(void);
+static uint64_t frameDashboard(uint32_t f);
+static void setupSprites(void);
+static uint64_t frameSprites(uint32_t f);
+static void setupLog(void);
+static uint64_t frameLog(uint32_t f);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t targetNs = 200000000u;  //< 1シーンあたりの計測時間の目標
+static char** filters = NULL;
+static int nFilters = 0;
+
+static uint16_t fb[SCREEN_W * SCREEN_H];
+static uint16_t background[SCREEN_W * SCREEN_H];  //< スプライトの背景
+static uint16_t spriteImage[SPRITE_SIZE * SPRITE_SIZE];
+static uint8_t counts[SCREEN_W * SCREEN_H];
+static Canvas_t canvas;
+static CanvasOverdraw_t overdraw;
+
+static TextField_t dashFields[DASH_FIELDS + 1];  //< 末尾は見出し
+static TextFieldCell_t dashCells[(DASH_FIELDS + 1) * DASH_COLS * 2];
+static CanvasRect_t spritePos[SPRITES];
+static Console_t logConsole;
+static uint32_t logScroll;  //< LCD の垂直スクロールの表示開始位置 (単位: pixel)
+static ConsoleCell_t logCells[LOG_COLS * LOG_ROWS];
+
+static const Scene_t scenes[] = {
+    {"grid", setupGrid, frameGrid},                 //< main.c の Render() と同じ罫線, 円, 文字
+    {"circles", setupCircles, frameCircles},        //< 多数の円と塗り潰し円
+    {"dashboard", setupDashboard, frameDashboard},  //< 数値の並ぶ画面 (TextField で変化した桁のみ更新)
+    {"sprites", setupSprites, frameSprites},        //< 背景の上を動くスプライト (移動前後の矩形のみ更新)
+    {"log", setupLog, frameLog},                    //< スクロールするログ (Console. LCD の垂直スクロールで送る)
+};
+#define SCENES (sizeof(scenes) / sizeof(scenes[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t nextRandom(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static uint64_t wireBytes(const CanvasRect_t* r) { return WINDOW_BYTES + ((uint64_t)r->w * r->h * 2); }
+
+static bool selected(const char* name) {
+  bool match = (0 == nFilters);
+  for (int i = 0; i < nFilters && !match; ++i) {
+    match = (NULL != strstr(name, filters[i]));
+  }
+  return match;
+}
+
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  (void)fsz;
+  const PrintContext_t* const ctx = (const PrintContext_t*)arg;
+  if (NULL != graph) {
+    const uint8_t* addr = (const uint8_t*)graph;
+    const uint32_t cw = (0xff < c) ? (fw / 2) : fw;
+    const uint32_t posx = ctx->x + (x * cw);
+    const uint32_t posy = ctx->y + (y * fh);
+    const size_t bpr = (fw + 7) / 8;
+    for (uint32_t h = 0; h < fh; ++h) {
+      for (uint32_t w = 0; w < fw; ++w) {
+        if (addr[w / 8] & (0x80 >> (w % 8))) {
+          (void)Canvas_DrawPixel(&canvas, posx + w, posy + h, ctx->color);
+        }
+      }
+      addr += bpr;
+    }
+  }
+  return uSuccess;
+}
+
+// grid //////////////////////////////////////////////////////////////////////
+
+static void setupGrid(void) {}
+
+static uint64_t frameGrid(uint32_t f) {
+  const uint16_t red = RGB888toRGB565(0xff, 0, 0);
+  const CanvasRect_t full = {0, 0, SCREEN_W, SCREEN_H};
+
+  (void)Canvas_Clear(&canvas, RGB888toRGB565(0x90, 0x90, 0x90));
+  (void)Canvas_DrawLine(&canvas, 0, 0, 239, 319, red);
+  (void)Canvas_DrawLine(&canvas, 239, 0, 0, 319, red);
+  (void)Canvas_DrawLine(&canvas, 0, 0, 0, 319, red);
+  (void)Canvas_DrawLine(&canvas, 100, 0, 100, 319, red);
+  (void)Canvas_DrawLine(&canvas, 200, 0, 200, 319, red);
+  (void)Canvas_DrawLine(&canvas, 0, 0, 239, 0, red);
+  (void)Canvas_DrawLine(&canvas, 0, 100, 239, 100, red);
+  (void)Canvas_DrawLine(&canvas, 0, 200, 239, 200, red);
+  (void)Canvas_DrawLine(&canvas, 0, 300, 239, 300, red);
+  (void)Canvas_DrawCircle(&canvas, 100, 100, (f % 30) + 1, RGB888toRGB565(0, 0xff, 0));
+  (void)Canvas_DrawFillCircle(&canvas, 200, 200, (f % 20) + 1, RGB888toRGB565(0x0f, 0x0f, 0xff));
+
+  char sz[32] = "Frametime: ";
+  size_t len = strlen(sz);
+  size_t n = 0;
+  (void)NumFmt_I32(&sz[len], sizeof(sz) - len, (int32_t)(16000 + (f * 37)), 9, ' ', &n);
+  strncpy(&sz[len + n], " us\n", sizeof(sz) - len - n);
+  PrintContext_t print = {.x = 10, .y = 10, .color = 0xffff};
+  const CanvasPrim_t prev = Canvas_BeginOverdraw(&canvas, CanvasPrimText);
+  (void)Font_Print(sz, drawGlyph, &print);
+  Canvas_EndOverdraw(&canvas, prev);
+
+  return wireBytes(&full);
+}
+
+// circles ///////////////////////////////////////////////////////////////////
+
+static void setupCircles(void) {}
+
+static uint64_t frameCircles(uint32_t f) {
+  const CanvasRect_t full = {0, 0, SCREEN_W, SCREEN_H};
+  uint32_t state = 0x9e3779b9u;
+
+  (void)Canvas_Clear(&canvas, RGB888toRGB565(0x10, 0x10, 0x30));
+  for (uint32_t i = 0; i < 64; ++i) {
+    // 位置はフレームごとに一定量ずつ動かす (画面外へはみ出す円を含む)
+    const uint32_t x = (nextRandom(&state) + (f * (i + 1))) % (SCREEN_W + 40);
+    const uint32_t y = (nextRandom(&state) + (f * 3)) % (SCREEN_H + 40);
+    const uint32_t r = 4 + (nextRandom(&state) % 28);
+    const uint16_t c = (uint16_t)nextRandom(&state);
+    if (0 == (i % 4)) {
+      (void)Canvas_DrawFillCircle(&canvas, x, y, r, c);
+    } else {
+      (void)Canvas_DrawCircle(&canvas, x, y, r, c);
+    }
+  }
+
+  return wireBytes(&full);
+}
+
+// dashboard /////////////////////////////////////////////////////////////////
+
+static void setupDashboard(void) {
+  (void)Canvas_Clear(&canvas, RGB888toRGB565(0x00, 0x00, 0x00));
+  (void)Canvas_FillRect(&canvas, 0, 0, SCREEN_W, 16, RGB888toRGB565(0x20, 0x40, 0x80));
+  (void)Canvas_FillRect(&canvas, 4, 20, (SCREEN_W / 2) - 6, SCREEN_H - 24, RGB888toRGB565(0x18, 0x18, 0x18));
+  (void)Canvas_FillRect(&canvas, (SCREEN_W / 2) + 2, 20, (SCREEN_W / 2) - 6, SCREEN_H - 24, RGB888toRGB565(0x18, 0x18, 0x18));
+
+  for (uint32_t i = 0; i < DASH_FIELDS; ++i) {
+    const uint32_t x = 8 + ((i % 2) * (SCREEN_W / 2));
+    const uint32_t y = 28 + ((i / 2) * 18);
+    (void)TextField_Create(&dashFields[i], &canvas, x, y, DASH_COLS, 2, &dashCells[i * DASH_COLS * 2]);
+    (void)TextField_SetColor(&dashFields[i], (0 == (i % 3)) ? RGB888toRGB565(0xff, 0xc0, 0x40) : 0xffff, RGB888toRGB565(0x18, 0x18, 0x18));
+  }
+  (void)TextField_Create(&dashFields[DASH_FIELDS], &canvas, 4, 4, DASH_COLS * 2, 1, &dashCells[DASH_FIELDS * DASH_COLS * 2]);
+  (void)TextField_SetColor(&dashFields[DASH_FIELDS], 0xffff, RGB888toRGB565(0x20, 0x40, 0x80));
+}
+
+static uint64_t frameDashboard(uint32_t f) {
+  CanvasRect_t dirty[DASH_COLS * 2];
+  size_t n = 0;
+  uint64_t bytes = 0;
+  char sz[40];
+  size_t len = 0;
+
+  // 1行目: 名前, 2行目: 値 (チャネルごとに変化の速さを変え, 下位の桁ほど頻繁に変わるようにする)
+  for (uint32_t i = 0; i <= DASH_FIELDS; ++i) {
+    if (DASH_FIELDS == i) {
+      memcpy(sz, "DASHBOARD frame ", 16);
+      (void)NumFmt_U32(&sz[16], sizeof(sz) - 16, f, 6, '0', &len);
+    } else {
+      memcpy(sz, "CH", 2);
+      (void)NumFmt_U32(&sz[2], sizeof(sz) - 2, i, 2, '0', &len);
+      sz[4] = '\n';
+      (void)NumFmt_Fixed(&sz[5], sizeof(sz) - 5, (int32_t)((f * (i + 1) * 7) % 200000) - 100000, 2, 10, ' ', &len);
+      memcpy(&sz[5 + len], " V", 3);
+    }
+    if (uSuccess == TextField_Update(&dashFields[i], sz, dirty, sizeof(dirty) / sizeof(dirty[0]), &n)) {
+      for (size_t k = 0; k < n; ++k) {
+        bytes += wireBytes(&dirty[k]);
+      }
+    }
+  }
+
+  return bytes;
+}
+
+// sprites ///////////////////////////////////////////////////////////////////
+
+static void setupSprites(void) {
+  // 背景は 16x16 の市松模様. スプライトは円形の模様
+  for (size_t y = 0; y < SCREEN_H; ++y) {
+    for (size_t x = 0; x < SCREEN_W; ++x) {
+      background[(y * SCREEN_W) + x] = (((x / 16) + (y / 16)) & 1) ? RGB888toRGB565(0x30, 0x60, 0x30) : RGB888toRGB565(0x20, 0x40, 0x20);
+    }
+  }
+  for (int32_t y = 0; y < SPRITE_SIZE; ++y) {
+    for (int32_t x = 0; x < SPRITE_SIZE; ++x) {
+      const int32_t dx = (2 * x) - (SPRITE_SIZE - 1);
+      const int32_t dy = (2 * y) - (SPRITE_SIZE - 1);
+      spriteImage[(y * SPRITE_SIZE) + x] = ((dx * dx) + (dy * dy) < (SPRITE_SIZE * SPRITE_SIZE)) ? RGB888toRGB565(0xff, 0x80, 0x00) : 0x0000;
+    }
+  }
+  (void)Canvas_Blit(&canvas, 0, 0, SCREEN_W, SCREEN_H, background, SCREEN_W);
+  for (uint32_t i = 0; i < SPRITES; ++i) {
+    spritePos[i].x = (uint16_t)((i * 37) % (SCREEN_W - SPRITE_SIZE));
+    spritePos[i].y = (uint16_t)((i * 53) % (SCREEN_H - SPRITE_SIZE));
+    spritePos[i].w = SPRITE_SIZE;
+    spritePos[i].h = SPRITE_SIZE;
+  }
+}
+
+static uint64_t frameSprites(uint32_t f) {
+  uint64_t bytes = 0;
+
+  for (uint32_t i = 0; i < SPRITES; ++i) {
+    CanvasRect_t* const p = &spritePos[i];
+    const uint16_t nx = (uint16_t)((p->x + 1 + (i % 3)) % (SCREEN_W - SPRITE_SIZE));
+    const uint16_t ny = (uint16_t)((p->y + 1 + ((i + f) % 2)) % (SCREEN_H - SPRITE_SIZE));
+
+    // 移動前の位置を背景で消してから新しい位置へ描画し, 両方を含む矩形を送信する
+    (void)Canvas_Blit(&canvas, p->x, p->y, SPRITE_SIZE, SPRITE_SIZE, &background[(p->y * SCREEN_W) + p->x], SCREEN_W);
+    (void)Canvas_Blit(&canvas, nx, ny, SPRITE_SIZE, SPRITE_SIZE, spriteImage, SPRITE_SIZE);
+
+    const uint16_t x0 = (p->x < nx) ? p->x : nx;
+    const uint16_t y0 = (p->y < ny) ? p->y : ny;
+    const uint16_t x1 = ((p->x < nx) ? nx : p->x) + SPRITE_SIZE;
+    const uint16_t y1 = ((p->y < ny) ? ny : p->y) + SPRITE_SIZE;
+    // 画面端で折り返した場合は 2つの矩形に分ける
+    if ((uint32_t)(x1 - x0) > 2 * SPRITE_SIZE || (uint32_t)(y1 - y0) > 2 * SPRITE_SIZE) {
+      const CanvasRect_t r = {0, 0, SPRITE_SIZE, SPRITE_SIZE};
+      bytes += 2 * wireBytes(&r);
+    } else {
+      const CanvasRect_t r = {x0, y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+      bytes += wireBytes(&r);
+    }
+    p->x = nx;
+    p->y = ny;
+  }
+
+  return bytes;
+}
+
+// log ///////////////////////////////////////////////////////////////////////
+
+static void setupLog(void) {
+  (void)Canvas_Clear(&canvas, 0x0000);
+  (void)Console_Create(&logConsole, &canvas, 0, 0, LOG_COLS, LOG_ROWS, logCells);
+  logScroll = 0;
+}
+
+static uint64_t frameLog(uint32_t f) {
+  CanvasRect_t dirty[LOG_ROWS];
+  size_t n = 0;
+  uint32_t scroll = 0;
+  uint64_t bytes = 0;
+  char sz[LOG_COLS + 2];
+  size_t len = 0;
+  size_t pos = 0;
+
+  // 1フレームに 2行追記する. 警告行は色を変える
+  for (uint32_t k = 0; k < 2; ++k) {
+    const uint32_t seq = (f * 2) + k;
+    pos = 0;
+    sz[pos++] = '[';
+    (void)NumFmt_U32(&sz[pos], sizeof(sz) - pos, seq, 6, '0', &len);
+    pos += len;
+    memcpy(&sz[pos], "] sensor ", 9);
+    pos += 9;
+    (void)NumFmt_U32(&sz[pos], sizeof(sz) - pos, seq % 8, 1, '0', &len);
+    pos += len;
+    memcpy(&sz[pos], " value=", 7);
+    pos += 7;
+    (void)NumFmt_Fixed(&sz[pos], sizeof(sz) - pos, (int32_t)((seq * 7919) % 100000) - 50000, 3, 9, ' ', &len);
+    pos += len;
+    sz[pos++] = '\n';
+    (void)Console_SetAttr(&logConsole, (0 == (seq % 5)) ? CONSOLE_ATTR(11, 0) : CONSOLE_ATTR(15, 0));
+    (void)Console_Write(&logConsole, sz, pos);
+  }
+  // 表示は LCDDrv_Scroll() で送り, 再描画した行のみ LCDDrv_ScrollMapRow() の行へ転送する (メモリ行が周回する矩形は 2回に分ける)
+  if (uSuccess == Console_RenderScroll(&logConsole, &scroll, dirty, LOG_ROWS, &n)) {
+    if (0 < scroll) {
+      logScroll = (logScroll + scroll) % SCREEN_H;
+      bytes += SCROLL_BYTES;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      bytes += wireBytes(&dirty[i]);
+      if (SCREEN_H < ((dirty[i].y + logScroll) % SCREEN_H) + dirty[i].h) {
+        bytes += WINDOW_BYTES;
+      }
+    }
+  }
+
+  return bytes;
+}
+
+// 計測 //////////////////////////////////////////////////////////////////////
+
+static uint64_t playScene(const Scene_t* scene, uint64_t* ns) {
+  uint64_t bytes = 0;
+  scene->setup();
+  (void)Canvas_ResetOverdraw(&canvas);
+  const uint64_t start = nowNs();
+  for (uint32_t f = 0; f < FRAMES; ++f) {
+    bytes += scene->frame(f);
+  }
+  *ns = nowNs() - start;
+  return bytes;
+}
+
+static void measureScene(const Scene_t* scene, SceneResult_t* result) {
+  CanvasOverdrawStat_t st;
+  uint64_t t = 0;
+
+  // 書き込み数と送信バイト数は 1回目に計数する (決まった内容のため毎回同じ)
+  (void)Canvas_AttachOverdraw(&canvas, &overdraw, counts);
+  result->wireBytes = playScene(scene, &t) / FRAMES;
+  (void)Canvas_GetOverdrawStat(&canvas, CanvasPrimNone, &st);
+  result->pixels = st.written / FRAMES;
+  (void)Canvas_AttachOverdraw(&canvas, NULL, NULL);
+
+  // 目標時間に収まる回数を見積もってから, REPEAT 回計測して最速値を採用する
+  (void)playScene(scene, &t);
+  uint64_t passes = targetNs / REPEAT / ((0 < t) ? t : 1);
+  passes = (0 < passes) ? passes : 1;
+
+  double best = 0;
+  for (int r = 0; r < REPEAT; ++r) {
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < passes; ++i) {
+      (void)playScene(scene, &t);
+      total += t;
+    }
+    const double ns = (double)total / (double)(passes * FRAMES);
+    best = (0 == r || ns < best) ? ns : best;
+  }
+  result->ns = best;
+}
+
+static UError_t loadBaseline(const char* path, SceneResult_t* results) {
+  FILE* const fp = fopen(path, "rb");
+  if (NULL == fp) {
+    return uFailure;
+  }
+
+  static char text[16 * 1024];
+  const size_t size = fread(text, 1, sizeof(text) - 1, fp);
+  fclose(fp);
+  text[size] = '\0';
+
+  // writeBaseline() の出力形式 (シーンごとに 1つのオブジェクト) のみを読み込む
+  for (size_t i = 0; i < SCENES; ++i) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", scenes[i].name);
+    const char* const top = strstr(text, key);
+    const char* const end = (NULL != top) ? strchr(top, '}') : NULL;
+    const char* const ns = (NULL != top) ? strstr(top, "\"frame_ns\":") : NULL;
+    const char* const px = (NULL != top) ? strstr(top, "\"pixels\":") : NULL;
+    const char* const wb = (NULL != top) ? strstr(top, "\"wire_bytes\":") : NULL;
+    results[i].found = (NULL != end && NULL != ns && NULL != px && NULL != wb && ns < end && px < end && wb < end);
+    if (results[i].found) {
+      results[i].baseNs = strtod(ns + 11, NULL);
+      results[i].basePixels = strtoull(px + 9, NULL, 10);
+      results[i].baseWire = strtoull(wb + 13, NULL, 10);
+    }
+  }
+
+  return uSuccess;
+}
+
+static UError_t writeBaseline(const char* path, const SceneResult_t* results) {
+  FILE* const fp = fopen(path, "wb");
+  if (NULL == fp) {
+    return uFailure;
+  }
+
+  fprintf(fp, "{\n  \"frames\": %u,\n  \"scenes\": [\n", FRAMES);
+  bool first = true;
+  for (size_t i = 0; i < SCENES; ++i) {
+    if (!selected(scenes[i].name)) {
+      continue;
+    }
+    fprintf(fp, "%s    {\"name\": \"%s\", \"frame_ns\": %.0f, \"pixels\": %llu, \"wire_bytes\": %llu}", first ? "" : ",\n", scenes[i].name, results[i].ns,
+            (unsigned long long)results[i].pixels, (unsigned long long)results[i].wireBytes);
+    first = false;
+  }
+  fprintf(fp, "\n  ]\n}\n");
+  fclose(fp);
+
+  return uSuccess;
+}
+
+int main(int argc, char* argv[]) {
+  const char* writePath = NULL;
+  const char* checkPath = NULL;
+  double timeTolerance = -1.0;  //< 描画時間の許容範囲 (単位: %. 負の値: 比較しない)
+  double countTolerance = 0.0;  //< 書き込み数, 送信バイト数の許容範囲 (単位: %)
+  static SceneResult_t results[SCENES];
+  int argi = 1;
+
+  while (argi + 1 < argc && '-' == argv[argi][0]) {
+    if (0 == strcmp(argv[argi], "-t")) {
+      targetNs = (uint64_t)strtoul(argv[argi + 1], NULL, 10) * 1000000u;
+      targetNs = (0 < targetNs) ? targetNs : 1000000u;
+    } else if (0 == strcmp(argv[argi], "-p")) {
+      timeTolerance = strtod(argv[argi + 1], NULL);
+    } else if (0 == strcmp(argv[argi], "-q")) {
+      countTolerance = strtod(argv[argi + 1], NULL);
+    } else if (0 == strcmp(argv[argi], "-w")) {
+      writePath = argv[argi + 1];
+    } else if (0 == strcmp(argv[argi], "-c")) {
+      checkPath = argv[argi + 1];
+    } else {
+      break;
+    }
+    argi += 2;
+  }
+  filters = &argv[argi];
+  nFilters = argc - argi;
+
+  if (NULL != checkPath && uSuccess != loadBaseline(checkPath, results)) {
+    fprintf(stderr, "failed to read %s\n", checkPath);
+    return 1;
+  }
+  (void)Canvas_Create(&canvas, SCREEN_W, SCREEN_H, SCREEN_W, fb);
+
+  bool regressed = false;
+  printf("%-10s %12s %10s %11s  %s\n", "scene", "frame_ns", "pixels", "wire_bytes", (NULL != checkPath) ? "vs baseline" : "");
+  for (size_t i = 0; i < SCENES; ++i) {
+    if (!selected(scenes[i].name)) {
+      continue;
+    }
+    SceneResult_t* const r = &results[i];
+    measureScene(&scenes[i], r);
+    printf("%-10s %12.0f %10llu %11llu", scenes[i].name, r->ns, (unsigned long long)r->pixels, (unsigned long long)r->wireBytes);
+
+    if (NULL != checkPath && !r->found) {
+      printf("  no baseline\n");
+      regressed = true;
+    } else if (NULL != checkPath) {
+      // 悪化のみを失敗とする. 改善した場合は基準値の更新を促す
+      const double dt = (0 < r->baseNs) ? ((r->ns / r->baseNs) - 1.0) * 100.0 : 0.0;
+      const bool timed = (0.0 <= timeTolerance);
+      const bool slow = timed && (dt > timeTolerance);
+      const bool morePixels = ((double)r->pixels > (double)r->basePixels * (1.0 + (countTolerance / 100.0)));
+      const bool moreBytes = ((double)r->wireBytes > (double)r->baseWire * (1.0 + (countTolerance / 100.0)));
+      const bool better = (timed && dt < -timeTolerance) || (r->pixels < r->basePixels) || (r->wireBytes < r->baseWire);
+      printf("  time %+6.1f%% pixels %+lld wire %+lld%s%s%s%s\n", dt, (long long)r->pixels - (long long)r->basePixels,
+             (long long)r->wireBytes - (long long)r->baseWire, slow ? " SLOWER" : "", morePixels ? " MORE-PIXELS" : "", moreBytes ? " MORE-BYTES" : "",
+             (!slow && !morePixels && !moreBytes && better) ? " (improved: update the baseline with -w)" : "");
+      regressed = regressed || slow || morePixels || moreBytes;
+    } else {
+      printf("\n");
+    }
+    fflush(stdout);
+  }
+
+  if (NULL != writePath && uSuccess != writeBaseline(writePath, results)) {
+    fprintf(stderr, "failed to write %s\n", writePath);
+    return 1;
+  }
+  if (regressed) {
+    if (0.0 <= timeTolerance) {
+      fprintf(stderr, "performance regression (time tolerance %.1f%%, count tolerance %.1f%%)\n", timeTolerance, countTolerance);
+    } else {
+      fprintf(stderr, "performance regression (count tolerance %.1f%%, time is not compared)\n", countTolerance);
+    }
+    return 1;
+  }
+
+  return 0;
+}
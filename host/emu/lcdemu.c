@@ -0,0 +1,575 @@
+/**
+ * @file prog01/host/emu/lcdemu.c
+ * LCD 更新方法の比較 (ホストビルド)
+ *
+ * LCDDrv の出力を ST7789 エミュレータで受け取り, 更新方法ごとに 1フレームあたりの転送量,
+ * CS のアサート回数, 推定転送時間と推定 fps を表示します. 各方法の最後に GRAM と描画元の
+ * キャンバスを比較し, ピクセルが正しい位置に書き込まれたかを確認します.
+ * -t を指定すると, SPIDrv の送信内容を記録します (spireplay で解析できます).
+ * -e を指定すると, フレームごとにトレースリング (tracering.h) の内容を書き出します (trace2chrome で変換できます).
+ *   lcdemu [-b ボーレート] [-c CS固定時間(ns)] [-o PPM出力先ディレクトリ] [-t 記録ファイル] [-e トレース出力先]
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <emu/st7789.h>
+#include <user/canvas.h>
+#include <user/console.h>
+#include <user/lcddrv.h>
+#include <user/macros.h>
+#include <user/spidrv.h>
+#include <user/spitrace.h>
+#include <user/tracering.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SCREEN_W (240)
+#define SCREEN_H (320)
+#define FRAMES (60)       //< アニメーションする方法のフレーム数
+#define SPRITE_SIZE (32)  //< 移動するスプライトの大きさ (単位: pixel)
+#define TILE_COUNT (64)   //< 散在する更新領域の数
+#define TILE_SIZE (8)     //< 散在する更新領域の大きさ (単位: pixel)
+#define CONSOLE_COLS (SCREEN_W / 4)
+#define CONSOLE_ROWS (SCREEN_H / 8)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 更新方法. frames に送信したフレーム数, check に比較するキャンバスを返す
+ */
+typedef UError_t (*ScenarioFn_t)(uint32_t* frames, const Canvas_t** check);
+
+typedef struct tagScenario_t {
+  const char* name;
+  ScenarioFn_t fn;
+  LCDDrvPixelFormat_t pixfmt;  //< 転送時のピクセル形式
+  LCDDrvRotation_t rotation;   //< 画面の向き
+} Scenario_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 背景の模様を描画する
+ */
+static void drawBackground(const Canvas_t* canvas);
+
+/**
+ * @brief スプライト (塗りつぶした円) を描画する
+ */
+static void drawSprite(const Canvas_t* canvas, size_t x, size_t y);
+
+/**
+ * @brief f フレーム目のスプライトの位置
+ */
+static void spritePos(uint32_t f, size_t* x, size_t* y);
+
+/**
+ * @brief 散在する更新領域の位置 (フレームによらず同じ)
+ */
+static void tilePos(uint32_t i, size_t* x, size_t* y);
+
+/**
+ * @brief GRAM と canvas を比較する
+ * @param [in] canvas : 比較対象 (画面全体)
+ * @param [in] rotation : 画面の向き (LCDDrvRotate0, LCDDrvRotate90, LCDDrvRotate180 のみ)
+ * @param [in] rgb444 : 12bit 形式で転送した場合 true (比較前に量子化する)
+ * @return 一致しないピクセル数
+ */
+static size_t compare(const Canvas_t* canvas, LCDDrvRotation_t rotation, bool rgb444);
+
+/**
+ * @brief 各更新方法
+ */
+static UError_t runFullSwapBuff(uint32_t* frames, const Canvas_t** check);
+static UError_t runFullSwapCanvas(uint32_t* frames, const Canvas_t** check);
+static UError_t runFullIndexed4(uint32_t* frames, const Canvas_t** check);
+static UError_t runSpriteFull(uint32_t* frames, const Canvas_t** check);
+static UError_t runSpriteDirty(uint32_t* frames, const Canvas_t** check);
+static UError_t runTilesEach(uint32_t* frames, const Canvas_t** check);
+static UError_t runTilesBounds(uint32_t* frames, const Canvas_t** check);
+static UError_t runRotate90(uint32_t* frames, const Canvas_t** check);
+static UError_t runScroll(uint32_t* frames, const Canvas_t** check);
+static UError_t runConsoleScroll(uint32_t* frames, const Canvas_t** check);
+
+/**
+ * @brief 記録の書き出し先 (arg: FILE*)
+ */
+static UError_t traceWrite(void* arg, const void* data, size_t size);
+
+/**
+ * @brief 記録中であれば, 実行中の方法のフレームの区切りを記録し, トレースリングを書き出す
+ */
+static void traceFrame(uint32_t frame);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static SPIDrvContext_t spi;
+static LCDDrvContext_t lcd;
+static ST7789Emu_t emu;
+static SPITrace_t trace;
+static bool tracing = false;
+static uint32_t scenarioNo = 0;  //< 実行中の方法 (区切りのグループ)
+static FILE* eventsFile = NULL;  //< トレースリングの書き出し先
+
+static uint16_t fb565[SCREEN_W * SCREEN_H];
+static uint8_t fb4[SCREEN_W * SCREEN_H / 2];
+static uint16_t palette[16];
+static Canvas_t canvas565;
+static Canvas_t canvas4;
+static Canvas_t canvasWide;  //< 横向き (320x240). fb565 を共有する
+static Console_t console;
+static ConsoleCell_t consoleCells[CONSOLE_COLS * CONSOLE_ROWS];
+
+static const Scenario_t scenarios[] = {
+    {"full/swap_buff", runFullSwapBuff, LCDDrvRGB565, LCDDrvRotate0},
+    {"full/swap_canvas", runFullSwapCanvas, LCDDrvRGB565, LCDDrvRotate0},
+    {"full/swap_buff_rgb444", runFullSwapBuff, LCDDrvRGB444, LCDDrvRotate0},
+    {"full/swap_canvas_i4", runFullIndexed4, LCDDrvRGB565, LCDDrvRotate0},
+    {"full/swap_canvas_i4_rgb444", runFullIndexed4, LCDDrvRGB444, LCDDrvRotate0},
+    {"sprite/full_frame", runSpriteFull, LCDDrvRGB565, LCDDrvRotate0},
+    {"sprite/dirty_rect", runSpriteDirty, LCDDrvRGB565, LCDDrvRotate0},
+    {"tiles/each_rect", runTilesEach, LCDDrvRGB565, LCDDrvRotate0},
+    {"tiles/bounding_rect", runTilesBounds, LCDDrvRGB565, LCDDrvRotate0},
+    {"rotate90/swap_canvas", runRotate90, LCDDrvRGB565, LCDDrvRotate90},
+    {"scroll/40_lines", runScroll, LCDDrvRGB565, LCDDrvRotate0},
+    {"scroll/console", runConsoleScroll, LCDDrvRGB565, LCDDrvRotate0},
+    {"scroll/console_rotate180", runConsoleScroll, LCDDrvRGB565, LCDDrvRotate180},
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void drawBackground(const Canvas_t* canvas) {
+  // 位置の取り違えが分かるよう, 行と列で色が変わる模様にする
+  for (size_t y = 0; y < canvas->h; y += 8) {
+    for (size_t x = 0; x < canvas->w; x += 8) {
+      const uint16_t c = RGB888toRGB565((uint8_t)(x * 255 / canvas->w), (uint8_t)(y * 255 / canvas->h), (uint8_t)(((x ^ y) & 8) ? 0xc0 : 0x40));
+      (void)Canvas_FillRect(canvas, x, y, 8, 8, (CanvasRGB565 == canvas->fmt) ? c : (uint16_t)(((x / 8) + (y / 8)) & 0x0f));
+    }
+  }
+  (void)Canvas_DrawLine(canvas, 0, 0, canvas->w - 1, canvas->h - 1, (CanvasRGB565 == canvas->fmt) ? 0xffff : 15);
+}
+
+static void drawSprite(const Canvas_t* canvas, size_t x, size_t y) {
+  (void)Canvas_DrawFillCircle(canvas, x + (SPRITE_SIZE / 2), y + (SPRITE_SIZE / 2), (SPRITE_SIZE / 2) - 1, RGB888toRGB565(255, 255, 0));
+}
+
+static void spritePos(uint32_t f, size_t* x, size_t* y) {
+  *x = 10 + ((f * 3) % (SCREEN_W - SPRITE_SIZE - 20));
+  *y = 20 + ((f * 5) % (SCREEN_H - SPRITE_SIZE - 40));
+}
+
+static size_t compare(const Canvas_t* canvas, LCDDrvRotation_t rotation, bool rgb444) {
+  static uint16_t line[SCREEN_H];
+  size_t diff = 0;
+
+  for (size_t y = 0; y < canvas->h; ++y) {
+    (void)Canvas_ExpandLine(canvas, 0, y, canvas->w, line);
+    for (size_t x = 0; x < canvas->w; ++x) {
+      // キャンバスはバイトを入れ替えて格納しているため, 送信順 (上位バイトが先) の値に戻す
+      uint16_t c = (uint16_t)((line[x] << 8) | (line[x] >> 8));
+      if (rgb444) {
+        const uint32_t r = (c >> 12) & 0x0f;
+        const uint32_t g = (c >> 7) & 0x0f;
+        const uint32_t b = (c >> 1) & 0x0f;
+        c = (uint16_t)((((r << 1) | (r >> 3)) << 11) | (((g << 2) | (g >> 2)) << 5) | ((b << 1) | (b >> 3)));
+      }
+      // 時計回りに 90度: 論理座標 (x, y) は物理座標 (239 - y, x). 180度: (239 - x, 319 - y)
+      size_t px = x;
+      size_t py = y;
+      if (LCDDrvRotate90 == rotation) {
+        px = (ST7789EMU_WIDTH - 1) - y;
+        py = x;
+      } else if (LCDDrvRotate180 == rotation) {
+        px = (ST7789EMU_WIDTH - 1) - x;
+        py = (ST7789EMU_LINES - 1) - y;
+      }
+      // 垂直スクロール中は表示上の行に見えているメモリ行と比較する
+      diff += (emu.gram[ST7789Emu_MapLine(&emu, (uint16_t)py)][px] != c) ? 1 : 0;
+    }
+  }
+
+  return diff;
+}
+
+static UError_t runFullSwapBuff(uint32_t* frames, const Canvas_t** check) {
+  drawBackground(&canvas565);
+  traceFrame(0);
+  *frames = 1;
+  *check = &canvas565;
+  return LCDDrv_SwapBuff(&lcd, fb565, 0, 0, SCREEN_W, SCREEN_H);
+}
+
+static UError_t runFullSwapCanvas(uint32_t* frames, const Canvas_t** check) {
+  drawBackground(&canvas565);
+  traceFrame(0);
+  *frames = 1;
+  *check = &canvas565;
+  return LCDDrv_SwapCanvas(&lcd, &canvas565, 0, 0, SCREEN_W, SCREEN_H);
+}
+
+static UError_t runFullIndexed4(uint32_t* frames, const Canvas_t** check) {
+  drawBackground(&canvas4);
+  traceFrame(0);
+  *frames = 1;
+  *check = &canvas4;
+  return LCDDrv_SwapCanvas(&lcd, &canvas4, 0, 0, SCREEN_W, SCREEN_H);
+}
+
+static UError_t runSpriteFull(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+  size_t x = 0;
+  size_t y = 0;
+
+  for (uint32_t f = 0; f < FRAMES && uSuccess == err; ++f) {
+    drawBackground(&canvas565);
+    spritePos(f, &x, &y);
+    drawSprite(&canvas565, x, y);
+    traceFrame(f);
+    err = LCDDrv_SwapBuff(&lcd, fb565, 0, 0, SCREEN_W, SCREEN_H);
+  }
+
+  *frames = FRAMES;
+  *check = &canvas565;
+  return err;
+}
+
+static UError_t runSpriteDirty(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+  size_t px = 0;
+  size_t py = 0;
+
+  // 背景は最初に 1回だけ送り, 以降はスプライトの移動前後を囲む領域だけを送る
+  drawBackground(&canvas565);
+  spritePos(0, &px, &py);
+  drawSprite(&canvas565, px, py);
+  err = LCDDrv_SwapCanvas(&lcd, &canvas565, 0, 0, SCREEN_W, SCREEN_H);
+  (void)ST7789Emu_ResetStats(&emu);
+
+  for (uint32_t f = 1; f < FRAMES && uSuccess == err; ++f) {
+    size_t x = 0;
+    size_t y = 0;
+    spritePos(f, &x, &y);
+    drawBackground(&canvas565);
+    drawSprite(&canvas565, x, y);
+
+    const size_t x0 = (x < px) ? x : px;
+    const size_t y0 = (y < py) ? y : py;
+    const size_t x1 = ((x > px) ? x : px) + SPRITE_SIZE;
+    const size_t y1 = ((y > py) ? y : py) + SPRITE_SIZE;
+    traceFrame(f);
+    err = LCDDrv_SwapCanvas(&lcd, &canvas565, (uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0));
+    px = x;
+    py = y;
+  }
+
+  *frames = FRAMES - 1;
+  *check = &canvas565;
+  return err;
+}
+
+static void tilePos(uint32_t i, size_t* x, size_t* y) {
+  *x = 16 + ((i * 37) % (SCREEN_W - 32)) / TILE_SIZE * TILE_SIZE;
+  *y = 16 + ((i * 101) % (SCREEN_H - 32)) / TILE_SIZE * TILE_SIZE;
+}
+
+static UError_t runTilesEach(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+
+  drawBackground(&canvas565);
+  err = LCDDrv_SwapCanvas(&lcd, &canvas565, 0, 0, SCREEN_W, SCREEN_H);
+  (void)ST7789Emu_ResetStats(&emu);
+
+  for (uint32_t f = 0; f < FRAMES && uSuccess == err; ++f) {
+    traceFrame(f);
+    for (uint32_t i = 0; i < TILE_COUNT && uSuccess == err; ++i) {
+      size_t x = 0;
+      size_t y = 0;
+      tilePos(i, &x, &y);
+      (void)Canvas_FillRect(&canvas565, x, y, TILE_SIZE, TILE_SIZE, (uint16_t)((f * 2654435761u) >> 16));
+      err = LCDDrv_SwapCanvas(&lcd, &canvas565, (uint16_t)x, (uint16_t)y, TILE_SIZE, TILE_SIZE);
+    }
+  }
+
+  *frames = FRAMES;
+  *check = &canvas565;
+  return err;
+}
+
+static UError_t runTilesBounds(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+
+  drawBackground(&canvas565);
+  err = LCDDrv_SwapCanvas(&lcd, &canvas565, 0, 0, SCREEN_W, SCREEN_H);
+  (void)ST7789Emu_ResetStats(&emu);
+
+  for (uint32_t f = 0; f < FRAMES && uSuccess == err; ++f) {
+    size_t x0 = SCREEN_W;
+    size_t y0 = SCREEN_H;
+    size_t x1 = 0;
+    size_t y1 = 0;
+    for (uint32_t i = 0; i < TILE_COUNT; ++i) {
+      size_t x = 0;
+      size_t y = 0;
+      tilePos(i, &x, &y);
+      (void)Canvas_FillRect(&canvas565, x, y, TILE_SIZE, TILE_SIZE, (uint16_t)((f * 2654435761u) >> 16));
+      x0 = (x < x0) ? x : x0;
+      y0 = (y < y0) ? y : y0;
+      x1 = (x + TILE_SIZE > x1) ? x + TILE_SIZE : x1;
+      y1 = (y + TILE_SIZE > y1) ? y + TILE_SIZE : y1;
+    }
+    traceFrame(f);
+    err = LCDDrv_SwapCanvas(&lcd, &canvas565, (uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0));
+  }
+
+  *frames = FRAMES;
+  *check = &canvas565;
+  return err;
+}
+
+static UError_t runRotate90(uint32_t* frames, const Canvas_t** check) {
+  drawBackground(&canvasWide);
+  traceFrame(0);
+  *frames = 1;
+  *check = &canvasWide;
+  return LCDDrv_SwapCanvas(&lcd, &canvasWide, 0, 0, SCREEN_H, SCREEN_W);
+}
+
+static UError_t runScroll(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+
+  // フレームメモリを 40行スクロールし, 表示上の 40行目以降にキャンバスの先頭が来るよう書き込む
+  drawBackground(&canvas565);
+  traceFrame(0);
+  err = LCDDrv_SetScrollArea(&lcd, 0, SCREEN_H);
+  if (uSuccess == err) {
+    err = LCDDrv_Scroll(&lcd, 40);
+  }
+  for (uint16_t y = 0; y < SCREEN_H && uSuccess == err; ++y) {
+    const uint16_t line = (uint16_t)((y + SCREEN_H - 40) % SCREEN_H);
+    err = LCDDrv_SwapBuff(&lcd, &fb565[line * SCREEN_W], 0, LCDDrv_ScrollMapRow(&lcd, y), SCREEN_W, 1);
+  }
+
+  *frames = 1;
+  *check = NULL;  // 表示上の位置で確認する
+  return err;
+}
+
+static UError_t runConsoleScroll(uint32_t* frames, const Canvas_t** check) {
+  UError_t err = uSuccess;
+  CanvasRect_t dirty[CONSOLE_ROWS];
+  size_t n = 0;
+  uint32_t scroll = 0;
+  char sz[32];
+
+  // 1フレームに 3行追記し, 表示は LCDDrv_Scroll() で送り, 再描画した行のみを転送する
+  (void)Canvas_Clear(&canvas565, 0x0000);
+  err = Console_Create(&console, &canvas565, 0, 0, CONSOLE_COLS, CONSOLE_ROWS, consoleCells);
+  for (uint32_t f = 0; f < FRAMES && uSuccess == err; ++f) {
+    for (uint32_t k = 0; k < 3; ++k) {
+      const int len = snprintf(sz, sizeof(sz), "frame %u line %u\n", (unsigned)f, (unsigned)k);
+      (void)Console_SetAttr(&console, CONSOLE_ATTR((uint8_t)(9 + k), 0));
+      (void)Console_Write(&console, sz, (size_t)len);
+    }
+    traceFrame(f);
+    err = Console_RenderScroll(&console, &scroll, dirty, CONSOLE_ROWS, &n);
+    if (uSuccess == err && 0 < scroll) {
+      err = LCDDrv_Scroll(&lcd, (int32_t)scroll);
+    }
+    for (size_t i = 0; i < n && uSuccess == err; ++i) {
+      // メモリ行が連続する範囲ごとに転送する (スクロール領域の終端で周回する)
+      uint32_t y = dirty[i].y;
+      const uint32_t end = dirty[i].y + dirty[i].h;
+      while (y < end && uSuccess == err) {
+        const uint16_t mem = LCDDrv_ScrollMapRow(&lcd, (uint16_t)y);
+        uint32_t h = 1;
+        while (y + h < end && LCDDrv_ScrollMapRow(&lcd, (uint16_t)(y + h)) == mem + h) {
+          ++h;
+        }
+        err = LCDDrv_SwapBuff(&lcd, &fb565[(y * SCREEN_W) + dirty[i].x], (uint16_t)dirty[i].x, mem, (uint16_t)dirty[i].w, (uint16_t)h);
+        y += h;
+      }
+    }
+  }
+
+  *frames = FRAMES;
+  *check = &canvas565;
+  return err;
+}
+
+static UError_t traceWrite(void* arg, const void* data, size_t size) {
+  return (size == fwrite(data, 1, size, (FILE*)arg)) ? uSuccess : uFailure;
+}
+
+static void traceFrame(uint32_t frame) {
+  if (tracing) {
+    (void)SPITrace_Mark(&trace, SPITRACE_MARK(scenarioNo, frame));
+  }
+  if (NULL != eventsFile) {
+    TRACE_INSTANT(TraceIdUser, scenarioNo, frame);
+    (void)TraceRing_Drain(&TraceRing_Default, traceWrite, eventsFile, NULL);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  UError_t err = uSuccess;
+  const char* outdir = NULL;
+  const char* tracePath = NULL;
+  const char* eventsPath = NULL;
+  FILE* traceFile = NULL;
+  uint32_t baudrate = 25 * 1000 * 1000;
+  uint32_t csNs = ST7789EMU_DEFAULT_CS_NS;
+  int failed = 0;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (0 == strcmp(argv[i], "-b")) {
+      baudrate = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-c")) {
+      csNs = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-o")) {
+      outdir = argv[i + 1];
+    } else if (0 == strcmp(argv[i], "-t")) {
+      tracePath = argv[i + 1];
+    } else if (0 == strcmp(argv[i], "-e")) {
+      eventsPath = argv[i + 1];
+    }
+  }
+
+  for (size_t i = 0; i < 16; ++i) {
+    palette[i] = (uint16_t)RGB888toRGB565((uint8_t)(i * 17), (uint8_t)(255 - (i * 17)), (uint8_t)((i & 1) ? 0xff : 0x00));
+  }
+  (void)Canvas_Create(&canvas565, SCREEN_W, SCREEN_H, SCREEN_W, fb565);
+  (void)Canvas_Create(&canvasWide, SCREEN_H, SCREEN_W, SCREEN_H, fb565);
+  (void)Canvas_CreateIndexed(&canvas4, SCREEN_W, SCREEN_H, SCREEN_W, fb4, CanvasIndexed4, palette);
+
+  if (uSuccess == err) {
+    err = SPIDrv_Create(&spi);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Create(&lcd, &spi);
+  }
+  if (uSuccess == err && NULL != tracePath) {
+    traceFile = fopen(tracePath, "wb");
+    err = (NULL != traceFile) ? SPITrace_Create(&trace, traceWrite, traceFile) : uFailure;
+    if (uSuccess == err) {
+      err = SPITrace_Attach(&trace, &spi);
+      tracing = (uSuccess == err);
+    }
+  }
+  if (uSuccess == err && NULL != eventsPath) {
+    eventsFile = fopen(eventsPath, "wb");
+    err = (NULL != eventsFile) ? TraceRing_Init(&TraceRing_Default) : uFailure;
+  }
+  if (uSuccess == err) {
+    err = ST7789Emu_Create(&emu, lcd.dc, spi.csn, lcd.rst);
+  }
+  if (uSuccess == err) {
+    err = ST7789Emu_Attach(&emu);
+  }
+  if (uSuccess == err) {
+    // spi_init() の結果 (分周後のボーレート) はエミュレータへ通知される
+    err = SPIDrv_Init(&spi, baudrate);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Init(&lcd);
+  }
+  if (uSuccess == err) {
+    (void)ST7789Emu_SetTiming(&emu, 0, csNs);
+    err = LCDDrv_InitalizeHW(&lcd);
+  }
+  if (uSuccess != err) {
+    fprintf(stderr, "failed to initialize the LCD driver\n");
+    return 1;
+  }
+
+  printf("baudrate %u Hz, %u ns/transaction, init %llu bytes\n", (unsigned)emu.baudrate, (unsigned)emu.csNs, (unsigned long long)emu.stats.bytes);
+  printf("%-28s %6s %10s %8s %8s %10s %8s %s\n", "scenario", "frames", "bytes/f", "cs/f", "win/f", "wire ms/f", "fps", "check");
+
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+    const Scenario_t* const s = &scenarios[i];
+    uint32_t frames = 0;
+    const Canvas_t* check = NULL;
+    ST7789EmuStats_t st;
+
+    scenarioNo = (uint32_t)i;
+    traceFrame(SPITRACE_FRAME_SETUP);
+    (void)LCDDrv_SetRotation(&lcd, s->rotation, false);
+    (void)LCDDrv_SetPixelFormat(&lcd, s->pixfmt);
+    (void)ST7789Emu_ResetStats(&emu);
+
+    err = s->fn(&frames, &check);
+    (void)ST7789Emu_GetStats(&emu, &st);
+    frames = (0 < frames) ? frames : 1;
+
+    size_t diff = 0;
+    if (NULL != check) {
+      diff = compare(check, s->rotation, LCDDrvRGB444 == s->pixfmt);
+    } else {
+      // スクロール: 表示上の y 行目にはキャンバスの (y - 40) 行目が見える
+      for (uint16_t y = 0; y < SCREEN_H; ++y) {
+        const uint16_t* const shown = emu.gram[ST7789Emu_MapLine(&emu, y)];
+        const uint16_t* const src = &fb565[((y + SCREEN_H - 40) % SCREEN_H) * SCREEN_W];
+        for (size_t x = 0; x < SCREEN_W; ++x) {
+          diff += (shown[x] != (uint16_t)((src[x] << 8) | (src[x] >> 8))) ? 1 : 0;
+        }
+      }
+    }
+
+    const double ms = (double)st.wireNs / 1e6 / frames;
+    printf("%-28s %6u %10llu %8u %8u %10.3f %8.1f %s", s->name, (unsigned)frames, (unsigned long long)(st.bytes / frames),
+           (unsigned)(st.transactions / frames), (unsigned)(st.windows / frames), ms, (0 < ms) ? 1000.0 / ms : 0.0,
+           (uSuccess == err && 0 == diff) ? "OK" : "NG");
+    if (0 < diff) {
+      printf(" (%zu pixels differ)", diff);
+    }
+    printf("\n");
+    failed += (uSuccess == err && 0 == diff) ? 0 : 1;
+
+    if (NULL != outdir) {
+      char path[256];
+      char name[64];
+      snprintf(name, sizeof(name), "%s", s->name);
+      for (char* p = name; '\0' != *p; ++p) {
+        *p = ('/' == *p) ? '_' : *p;
+      }
+      snprintf(path, sizeof(path), "%s/%s.ppm", outdir, name);
+      if (uSuccess != ST7789Emu_WritePPM(&emu, path)) {
+        fprintf(stderr, "failed to write %s\n", path);
+      }
+    }
+  }
+
+  if (tracing) {
+    (void)SPITrace_Detach(&trace);
+    printf("trace: %llu records -> %s\n", (unsigned long long)trace.records, tracePath);
+  }
+  if (NULL != traceFile) {
+    fclose(traceFile);
+  }
+  if (NULL != eventsFile) {
+    (void)TraceRing_Drain(&TraceRing_Default, traceWrite, eventsFile, NULL);
+    printf("events -> %s\n", eventsPath);
+    fclose(eventsFile);
+  }
+  ST7789Emu_Detach();
+  return (0 == failed) ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file prog01/host/emu/spireplay.c
+ * SPIDrv の記録 (spitrace.h) の再生と解析 (ホストビルド)
+ *
+ * 記録を ST7789 エミュレータへ入力し直し, 区切り (SPITRACE_MARK()) のグループごとに
+ * 1フレームあたりの送信バイト数, CS のアサート回数, D/C の切り替え回数, 推定転送時間を表示します.
+ * 準備 (SPITRACE_FRAME_SETUP) と最初の区切りより前の送信はフレームに含めず, 別の行に表示します.
+ *   spireplay [-b ボーレート] [-c CS固定時間(ns)] [-v] [-o PPM出力先] 記録ファイル
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <emu/st7789.h>
+#include <user/spitrace.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define PIN_DC (0)   //< エミュレータへ入力する D/C の番号
+#define PIN_CSN (1)  //< エミュレータへ入力する CS の番号
+#define PIN_RST (2)  //< エミュレータへ入力する RST の番号 (記録には含まれない)
+
+#define MAX_GROUPS (256)  //< 集計するグループ数の上限
+
+#define GROUP_NONE (0xffffffffu)  //< 最初の区切りより前
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagReplayCount_t {
+  uint64_t bytes;         //< 送信バイト数
+  uint32_t transactions;  //< CS のアサート回数
+  uint32_t asyncs;        //< 非同期送信の回数
+  uint32_t dcToggles;     //< D/C の切り替え回数
+  uint32_t windows;       //< CASET/RASET の回数 (エミュレータ)
+  uint64_t wireNs;        //< 推定転送時間 (エミュレータ)
+  uint64_t recordedUs;    //< 記録された経過時間
+} ReplayCount_t;
+
+typedef struct tagReplayGroup_t {
+  uint32_t group;
+  uint32_t frames;      //< フレーム数
+  ReplayCount_t setup;  //< 準備
+  ReplayCount_t frame;  //< フレームの合計
+} ReplayGroup_t;
+
+typedef struct tagReplay_t {
+  ST7789Emu_t emu;
+  bool verbose;
+  // 集計中の区間
+  uint32_t mark;      //< 区間の区切りの番号 (GROUP_NONE: 最初の区切りより前)
+  uint64_t begin;     //< 区間の開始時刻 (単位: us)
+  uint64_t now;       //< 最後のレコードの時刻 (単位: us)
+  ReplayCount_t cur;  //< 区間の送信内容 (エミュレータの値を除く)
+  // 集計結果
+  ReplayCount_t init;  //< 最初の区切りより前
+  ReplayGroup_t groups[MAX_GROUPS];
+  size_t ngroups;
+  ReplayCount_t total;
+  uint64_t records;
+} Replay_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief レコードをエミュレータへ入力して集計する (SPITraceVisitFn_t)
+ */
+static UError_t visit(void* arg, const SPITraceRecord_t* rec);
+
+/**
+ * @brief 集計中の区間を閉じて, グループへ加算する
+ */
+static void closeSection(Replay_t* ctx);
+
+/**
+ * @brief a に b を加算する
+ */
+static void addCount(ReplayCount_t* a, const ReplayCount_t* b);
+
+/**
+ * @brief 1行表示する (frames で割った値)
+ */
+static void printCount(const char* name, uint32_t frames, const ReplayCount_t* c);
+
+/**
+ * @brief ファイル全体を読み込む
+ * @return 読み込んだデータ (呼び出し側で free する. NULL: 失敗)
+ */
+static uint8_t* loadFile(const char* path, size_t* size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static Replay_t replay;
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void addCount(ReplayCount_t* a, const ReplayCount_t* b) {
+  a->bytes += b->bytes;
+  a->transactions += b->transactions;
+  a->asyncs += b->asyncs;
+  a->dcToggles += b->dcToggles;
+  a->windows += b->windows;
+  a->wireNs += b->wireNs;
+  a->recordedUs += b->recordedUs;
+}
+
+static void closeSection(Replay_t* ctx) {
+  ST7789EmuStats_t st;
+
+  (void)ST7789Emu_GetStats(&ctx->emu, &st);
+  (void)ST7789Emu_ResetStats(&ctx->emu);
+  ctx->cur.windows = st.windows;
+  ctx->cur.wireNs = st.wireNs;
+  ctx->cur.recordedUs = ctx->now - ctx->begin;
+  addCount(&ctx->total, &ctx->cur);
+
+  if (GROUP_NONE == ctx->mark) {
+    addCount(&ctx->init, &ctx->cur);
+  } else {
+    const uint32_t group = SPITRACE_MARK_GROUP(ctx->mark);
+    const uint32_t frame = SPITRACE_MARK_FRAME(ctx->mark);
+    ReplayGroup_t* g = NULL;
+
+    for (size_t i = 0; i < ctx->ngroups && NULL == g; ++i) {
+      g = (ctx->groups[i].group == group) ? &ctx->groups[i] : NULL;
+    }
+    if (NULL == g && ctx->ngroups < MAX_GROUPS) {
+      g = &ctx->groups[ctx->ngroups++];
+      memset(g, 0, sizeof(*g));
+      g->group = group;
+    }
+    if (NULL != g) {
+      if (SPITRACE_FRAME_SETUP == frame) {
+        addCount(&g->setup, &ctx->cur);
+      } else {
+        addCount(&g->frame, &ctx->cur);
+        ++g->frames;
+      }
+    }
+    if (ctx->verbose) {
+      char name[32];
+      snprintf(name, sizeof(name), "  %u/%u", (unsigned)group, (unsigned)frame);
+      printCount(name, 1, &ctx->cur);
+    }
+  }
+
+  memset(&ctx->cur, 0, sizeof(ctx->cur));
+  ctx->begin = ctx->now;
+}
+
+static UError_t visit(void* arg, const SPITraceRecord_t* rec) {
+  Replay_t* const ctx = (Replay_t*)arg;
+
+  ctx->now = rec->time;
+  ++ctx->records;
+
+  switch (rec->type) {
+    case SPITraceDC:
+      ST7789Emu_SetPin(&ctx->emu, PIN_DC, 0 != rec->value);
+      ++ctx->cur.dcToggles;
+      break;
+    case SPITraceSend:
+      ST7789Emu_SetPin(&ctx->emu, PIN_CSN, false);
+      ST7789Emu_Write(&ctx->emu, rec->data, rec->size);
+      ST7789Emu_SetPin(&ctx->emu, PIN_CSN, true);
+      ctx->cur.bytes += rec->size;
+      ++ctx->cur.transactions;
+      break;
+    case SPITraceAsyncSend:
+      // 完了 (SPITraceWait) まで CS をアサートしたままにする
+      ST7789Emu_SetPin(&ctx->emu, PIN_CSN, false);
+      ST7789Emu_Write(&ctx->emu, rec->data, rec->size);
+      ctx->cur.bytes += rec->size;
+      ++ctx->cur.transactions;
+      ++ctx->cur.asyncs;
+      break;
+    case SPITraceWait:
+      ST7789Emu_SetPin(&ctx->emu, PIN_CSN, true);
+      break;
+    case SPITraceMark:
+      closeSection(ctx);
+      ctx->mark = rec->value;
+      break;
+    default:
+      break;
+  }
+
+  return uSuccess;
+}
+
+static void printCount(const char* name, uint32_t frames, const ReplayCount_t* c) {
+  const uint32_t n = (0 < frames) ? frames : 1;
+  const double ms = (double)c->wireNs / 1e6 / n;
+
+  printf("%-16s %6u %10llu %8u %8u %8u %8u %10.3f %8.1f %12.3f\n", name, (unsigned)frames, (unsigned long long)(c->bytes / n),
+         (unsigned)(c->transactions / n), (unsigned)(c->asyncs / n), (unsigned)(c->dcToggles / n), (unsigned)(c->windows / n), ms,
+         (0 < ms) ? 1000.0 / ms : 0.0, (double)c->recordedUs / 1e3 / n);
+}
+
+static uint8_t* loadFile(const char* path, size_t* size) {
+  uint8_t* data = NULL;
+  FILE* const fp = fopen(path, "rb");
+
+  if (NULL != fp) {
+    if (0 == fseek(fp, 0, SEEK_END)) {
+      const long len = ftell(fp);
+      if (0 <= len && 0 == fseek(fp, 0, SEEK_SET)) {
+        data = (uint8_t*)malloc((0 < len) ? (size_t)len : 1u);
+        if (NULL != data && (size_t)len != fread(data, 1, (size_t)len, fp)) {
+          free(data);
+          data = NULL;
+        }
+        *size = (size_t)len;
+      }
+    }
+    fclose(fp);
+  }
+
+  return data;
+}
+
+int main(int argc, char* argv[]) {
+  UError_t err = uSuccess;
+  const char* path = NULL;
+  const char* ppm = NULL;
+  uint32_t baudrate = ST7789EMU_DEFAULT_BAUDRATE;
+  uint32_t csNs = ST7789EMU_DEFAULT_CS_NS;
+
+  for (int i = 1; i < argc; ++i) {
+    if (0 == strcmp(argv[i], "-b") && i + 1 < argc) {
+      baudrate = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-c") && i + 1 < argc) {
+      csNs = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-o") && i + 1 < argc) {
+      ppm = argv[++i];
+    } else if (0 == strcmp(argv[i], "-v")) {
+      replay.verbose = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (NULL == path) {
+    fprintf(stderr, "usage: %s [-b baudrate] [-c cs_ns] [-v] [-o out.ppm] trace.bin\n", argv[0]);
+    return 2;
+  }
+
+  size_t size = 0;
+  uint8_t* const data = loadFile(path, &size);
+  if (NULL == data) {
+    fprintf(stderr, "failed to read %s\n", path);
+    return 1;
+  }
+
+  if (uSuccess == err) {
+    err = ST7789Emu_Create(&replay.emu, PIN_DC, PIN_CSN, PIN_RST);
+  }
+  if (uSuccess == err) {
+    err = ST7789Emu_SetTiming(&replay.emu, baudrate, csNs);
+  }
+  if (uSuccess == err) {
+    replay.mark = GROUP_NONE;
+    printf("%-16s %6s %10s %8s %8s %8s %8s %10s %8s %12s\n", "group", "frames", "bytes/f", "cs/f", "async/f", "dc/f", "win/f", "wire ms/f", "fps",
+           "recorded ms/f");
+    err = SPITrace_Decode(data, size, visit, &replay);
+    closeSection(&replay);
+  }
+  if (uSuccess != err) {
+    fprintf(stderr, "%s: broken trace (decoded %llu records)\n", path, (unsigned long long)replay.records);
+  }
+
+  printCount("(before marks)", 0, &replay.init);
+  for (size_t i = 0; i < replay.ngroups; ++i) {
+    const ReplayGroup_t* const g = &replay.groups[i];
+    char name[32];
+    snprintf(name, sizeof(name), "%u", (unsigned)g->group);
+    printCount(name, g->frames, &g->frame);
+    snprintf(name, sizeof(name), "%u (setup)", (unsigned)g->group);
+    printCount(name, 0, &g->setup);
+  }
+  printf("total: %llu records, %llu bytes, %u transactions, %u dc toggles, wire %.3f ms\n", (unsigned long long)replay.records,
+         (unsigned long long)replay.total.bytes, (unsigned)replay.total.transactions, (unsigned)replay.total.dcToggles,
+         (double)replay.total.wireNs / 1e6);
+
+  if (NULL != ppm && uSuccess != ST7789Emu_WritePPM(&replay.emu, ppm)) {
+    fprintf(stderr, "failed to write %s\n", ppm);
+    err = uFailure;
+  }
+
+  free(data);
+  return (uSuccess == err) ? 0 : 1;
+}
@@ -0,0 +1,494 @@
+/**
+ * @file prog01/host/emu/st7789.c
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <emu/st7789.h>
+#include <hosthal.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define MADCTL_MY (0x80)  //< 行アドレス順 反転
+#define MADCTL_MX (0x40)  //< 列アドレス順 反転
+#define MADCTL_MV (0x20)  //< 行/列 交換
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief レジスタをリセット後の値にする (GRAM は保持する)
+ */
+static void resetRegisters(ST7789Emu_t* ctx);
+
+/**
+ * @brief コマンドバイトを処理する
+ */
+static void command(ST7789Emu_t* ctx, uint8_t cmd);
+
+/**
+ * @brief データバイト (パラメータまたはピクセル) を処理する
+ */
+static void dataByte(ST7789Emu_t* ctx, uint8_t b);
+
+/**
+ * @brief コマンドのパラメータを処理する. 必要な数が揃った時点でレジスタへ反映する
+ */
+static void paramByte(ST7789Emu_t* ctx, uint8_t b);
+
+/**
+ * @brief 受信したピクセルデータのバイトを処理する. COLMOD に応じて 1ピクセル分揃った時点で書き込む
+ */
+static void pixelByte(ST7789Emu_t* ctx, uint8_t b);
+
+/**
+ * @brief ピクセルに満たないデータを書き込む (12bit 形式の奇数ピクセル)
+ */
+static void flushPending(ST7789Emu_t* ctx);
+
+/**
+ * @brief 書き込み位置へ 1ピクセル書き込み, 書き込み位置を進める
+ */
+static void putPixel(ST7789Emu_t* ctx, uint16_t c);
+
+/**
+ * @brief 4bit の色成分から RGB565 を作る
+ */
+static uint16_t fromRGB444(uint32_t r, uint32_t g, uint32_t b);
+
+/**
+ * @brief スタブ HAL から呼び出される関数
+ */
+static void hookSpiInit(void* arg, spi_inst_t* spi, uint32_t baudrate);
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len);
+static void hookGpioPut(void* arg, uint32_t gpio, bool value);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void resetRegisters(ST7789Emu_t* ctx) {
+  ctx->cmd = 0x00;
+  ctx->nparam = 0;
+  ctx->writing = false;
+  ctx->npend = 0;
+  ctx->madctl = 0x00;
+  ctx->colmod = 0x66;  // 18bit/pixel
+  ctx->xs = 0;
+  ctx->xe = ST7789EMU_WIDTH - 1;
+  ctx->ys = 0;
+  ctx->ye = ST7789EMU_LINES - 1;
+  ctx->col = 0;
+  ctx->row = 0;
+  ctx->tfa = 0;
+  ctx->vsa = ST7789EMU_LINES;
+  ctx->vsp = 0;
+  ctx->sleep = true;
+  ctx->displayOn = false;
+  ctx->inverted = false;
+}
+
+static uint16_t fromRGB444(uint32_t r, uint32_t g, uint32_t b) {
+  const uint32_t r5 = (r << 1) | (r >> 3);
+  const uint32_t g6 = (g << 2) | (g >> 2);
+  const uint32_t b5 = (b << 1) | (b >> 3);
+  return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+}
+
+static void putPixel(ST7789Emu_t* ctx, uint16_t c) {
+  const bool mv = (0 != (ctx->madctl & MADCTL_MV));
+  const uint32_t cols = mv ? ST7789EMU_LINES : ST7789EMU_WIDTH;
+  const uint32_t rows = mv ? ST7789EMU_WIDTH : ST7789EMU_LINES;
+
+  if (ctx->col < cols && ctx->row < rows) {
+    uint32_t px = mv ? ctx->row : ctx->col;
+    uint32_t py = mv ? ctx->col : ctx->row;
+    if (ctx->madctl & MADCTL_MX) {
+      px = (ST7789EMU_WIDTH - 1) - px;
+    }
+    if (ctx->madctl & MADCTL_MY) {
+      py = (ST7789EMU_LINES - 1) - py;
+    }
+    ctx->gram[py][px] = c;
+    ctx->stats.pixels++;
+  }
+
+  // 列 -> 行 の順に進め, 終了アドレスを超えたら開始アドレスへ戻る
+  if (ctx->xe <= ctx->col) {
+    ctx->col = ctx->xs;
+    ctx->row = (ctx->ye <= ctx->row) ? ctx->ys : ctx->row + 1;
+  } else {
+    ctx->col++;
+  }
+}
+
+static void pixelByte(ST7789Emu_t* ctx, uint8_t b) {
+  uint8_t* const p = ctx->pend;
+
+  ctx->stats.pixelBytes++;
+  p[ctx->npend++] = b;
+
+  switch (ctx->colmod & 0x07) {
+    case 0x05:  // 16bit/pixel : RRRRRGGG GGGBBBBB
+      if (2 == ctx->npend) {
+        putPixel(ctx, (uint16_t)((p[0] << 8) | p[1]));
+        ctx->npend = 0;
+      }
+      break;
+    case 0x03:  // 12bit/pixel : RRRRGGGG BBBBRRRR GGGGBBBB (2pixel)
+      if (3 == ctx->npend) {
+        putPixel(ctx, fromRGB444(p[0] >> 4, p[0] & 0x0f, p[1] >> 4));
+        putPixel(ctx, fromRGB444(p[1] & 0x0f, p[2] >> 4, p[2] & 0x0f));
+        ctx->npend = 0;
+      }
+      break;
+    default:  // 18bit/pixel : RRRRRR-- GGGGGG-- BBBBBB--
+      if (3 == ctx->npend) {
+        putPixel(ctx, (uint16_t)(((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3)));
+        ctx->npend = 0;
+      }
+      break;
+  }
+}
+
+static void flushPending(ST7789Emu_t* ctx) {
+  if (0x03 == (ctx->colmod & 0x07) && 2 <= ctx->npend) {
+    putPixel(ctx, fromRGB444(ctx->pend[0] >> 4, ctx->pend[0] & 0x0f, ctx->pend[1] >> 4));
+  }
+  ctx->npend = 0;
+}
+
+static void command(ST7789Emu_t* ctx, uint8_t cmd) {
+  flushPending(ctx);
+  ctx->stats.commandBytes++;
+  ctx->cmd = cmd;
+  ctx->nparam = 0;
+  ctx->writing = false;
+
+  switch (cmd) {
+    case 0x01:  // SWRESET
+      resetRegisters(ctx);
+      break;
+    case 0x10:  // SLPIN
+      ctx->sleep = true;
+      break;
+    case 0x11:  // SLPOUT
+      ctx->sleep = false;
+      break;
+    case 0x20:  // INVOFF
+      ctx->inverted = false;
+      break;
+    case 0x21:  // INVON
+      ctx->inverted = true;
+      break;
+    case 0x28:  // DISPOFF
+      ctx->displayOn = false;
+      break;
+    case 0x29:  // DISPON
+      ctx->displayOn = true;
+      break;
+    case 0x2C:  // RAMWR : 開始アドレスから書き込む
+      ctx->col = ctx->xs;
+      ctx->row = ctx->ys;
+      ctx->writing = true;
+      break;
+    case 0x3C:  // RAMWRC : 直前の書き込み位置から続ける
+      ctx->writing = true;
+      break;
+    default:
+      break;
+  }
+}
+
+static void dataByte(ST7789Emu_t* ctx, uint8_t b) {
+  if (ctx->writing) {
+    pixelByte(ctx, b);
+  } else {
+    paramByte(ctx, b);
+  }
+}
+
+static void paramByte(ST7789Emu_t* ctx, uint8_t b) {
+  const uint8_t* const p = ctx->param;
+
+  if (ctx->nparam < sizeof(ctx->param)) {
+    ctx->param[ctx->nparam] = b;
+  }
+  ctx->nparam++;
+
+  switch (ctx->cmd) {
+    case 0x2A:  // CASET
+      if (4 == ctx->nparam) {
+        ctx->xs = (uint16_t)((p[0] << 8) | p[1]);
+        ctx->xe = (uint16_t)((p[2] << 8) | p[3]);
+        ctx->xe = (ctx->xe < ctx->xs) ? ctx->xs : ctx->xe;
+        ctx->stats.windows++;
+      }
+      break;
+    case 0x2B:  // RASET
+      if (4 == ctx->nparam) {
+        ctx->ys = (uint16_t)((p[0] << 8) | p[1]);
+        ctx->ye = (uint16_t)((p[2] << 8) | p[3]);
+        ctx->ye = (ctx->ye < ctx->ys) ? ctx->ys : ctx->ye;
+      }
+      break;
+    case 0x33:  // VSCRDEF : TFA, VSA, BFA
+      if (6 == ctx->nparam) {
+        ctx->tfa = (uint16_t)((p[0] << 8) | p[1]);
+        ctx->vsa = (uint16_t)((p[2] << 8) | p[3]);
+      }
+      break;
+    case 0x36:  // MADCTL
+      if (1 == ctx->nparam) {
+        ctx->madctl = b;
+      }
+      break;
+    case 0x37:  // VSCSAD
+      if (2 == ctx->nparam) {
+        ctx->vsp = (uint16_t)((p[0] << 8) | p[1]);
+      }
+      break;
+    case 0x3A:  // COLMOD
+      if (1 == ctx->nparam) {
+        ctx->colmod = b;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void hookSpiInit(void* arg, spi_inst_t* spi, uint32_t baudrate) {
+  (void)spi;
+  ((ST7789Emu_t*)arg)->baudrate = baudrate;
+}
+
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len) {
+  (void)spi;
+  ST7789Emu_Write((ST7789Emu_t*)arg, src, len);
+}
+
+static void hookGpioPut(void* arg, uint32_t gpio, bool value) { ST7789Emu_SetPin((ST7789Emu_t*)arg, gpio, value); }
+
+UError_t ST7789Emu_Create(ST7789Emu_t* ctx, uint32_t dc, uint32_t csn, uint32_t rst) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->dc = dc;
+    ctx->csn = csn;
+    ctx->rst = rst;
+    ctx->baudrate = ST7789EMU_DEFAULT_BAUDRATE;
+    ctx->csNs = ST7789EMU_DEFAULT_CS_NS;
+    ctx->csLevel = true;
+    ctx->dcLevel = true;
+    ctx->rstLevel = true;
+    resetRegisters(ctx);
+    memset(ctx->gram, 0, sizeof(ctx->gram));
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+  }
+
+  return err;
+}
+
+UError_t ST7789Emu_Attach(ST7789Emu_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    const HostHalHooks_t hooks = {
+        .spiInit = hookSpiInit,
+        .spiWrite = hookSpiWrite,
+        .gpioPut = hookGpioPut,
+        .arg = ctx,
+    };
+    HostHal_SetHooks(&hooks);
+  }
+
+  return err;
+}
+
+void ST7789Emu_Detach(void) { HostHal_SetHooks(NULL); }
+
+UError_t ST7789Emu_SetTiming(ST7789Emu_t* ctx, uint32_t baudrate, uint32_t csNs) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    ctx->baudrate = (0 < baudrate) ? baudrate : ctx->baudrate;
+    ctx->csNs = csNs;
+  }
+
+  return err;
+}
+
+void ST7789Emu_SetPin(ST7789Emu_t* ctx, uint32_t gpio, bool value) {
+  if (NULL == ctx) {
+    return;
+  }
+
+  if (gpio == ctx->csn) {
+    if (ctx->csLevel && !value) {
+      ctx->stats.transactions++;
+      ctx->stats.wireNs += ctx->csNs;
+    }
+    ctx->csLevel = value;
+  } else if (gpio == ctx->dc) {
+    ctx->dcLevel = value;
+  } else if (gpio == ctx->rst) {
+    if (!ctx->rstLevel && value) {
+      // ハードウェアリセット解除. GRAM の内容は保持される
+      resetRegisters(ctx);
+    }
+    ctx->rstLevel = value;
+  }
+}
+
+void ST7789Emu_Write(ST7789Emu_t* ctx, const uint8_t* data, size_t len) {
+  if (NULL == ctx || NULL == data || ctx->csLevel) {
+    return;
+  }
+
+  ctx->stats.bytes += len;
+  ctx->stats.wireNs += (len * 8u * 1000000000u) / ((0 < ctx->baudrate) ? ctx->baudrate : 1u);
+
+  for (size_t i = 0; i < len; ++i) {
+    if (ctx->dcLevel) {
+      dataByte(ctx, data[i]);
+    } else {
+      command(ctx, data[i]);
+    }
+  }
+}
+
+UError_t ST7789Emu_GetStats(const ST7789Emu_t* ctx, ST7789EmuStats_t* stats) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == stats) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    *stats = ctx->stats;
+  }
+
+  return err;
+}
+
+UError_t ST7789Emu_ResetStats(ST7789Emu_t* ctx) {
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    if (NULL == ctx) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+  }
+
+  return err;
+}
+
+uint16_t ST7789Emu_MapLine(const ST7789Emu_t* ctx, uint16_t line) {
+  if (NULL == ctx) {
+    return line;
+  }
+
+  const uint32_t top = ctx->tfa;
+  const uint32_t height = ctx->vsa;
+  if (line < top || top + height <= line || top + height > ST7789EMU_LINES || ctx->vsp < top || top + height <= ctx->vsp) {
+    return line;
+  }
+
+  uint32_t mem = line + (ctx->vsp - top);
+  if (top + height <= mem) {
+    mem -= height;
+  }
+  return (uint16_t)mem;
+}
+
+UError_t ST7789Emu_WritePPM(const ST7789Emu_t* ctx, const char* path) {
+  UError_t err = uSuccess;
+  FILE* fp = NULL;
+
+  if (uSuccess == err) {
+    if (NULL == ctx || NULL == path) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    fp = fopen(path, "wb");
+    if (NULL == fp) {
+      err = uFailure;
+    }
+  }
+
+  if (uSuccess == err) {
+    uint8_t rgb[ST7789EMU_WIDTH * 3];
+    fprintf(fp, "P6\n%d %d\n255\n", ST7789EMU_WIDTH, ST7789EMU_LINES);
+    for (uint16_t y = 0; y < ST7789EMU_LINES; ++y) {
+      const uint16_t* const line = ctx->gram[ST7789Emu_MapLine(ctx, y)];
+      for (size_t x = 0; x < ST7789EMU_WIDTH; ++x) {
+        const uint32_t c = line[x];
+        const uint32_t r = (c >> 11) & 0x1f;
+        const uint32_t g = (c >> 5) & 0x3f;
+        const uint32_t b = c & 0x1f;
+        rgb[(x * 3) + 0] = (uint8_t)((r << 3) | (r >> 2));
+        rgb[(x * 3) + 1] = (uint8_t)((g << 2) | (g >> 4));
+        rgb[(x * 3) + 2] = (uint8_t)((b << 3) | (b >> 2));
+      }
+      if (sizeof(rgb) != fwrite(rgb, 1, sizeof(rgb), fp)) {
+        err = uFailure;
+        break;
+      }
+    }
+  }
+
+  if (NULL != fp) {
+    if (0 != fclose(fp)) {
+      err = uFailure;
+    }
+  }
+
+  return err;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file prog01/host/emu/st7789.h
+ * ST7789 (240x320) の SPI プロトコルエミュレータ (ホストビルド)
+ *
+ * スタブ HAL の SPI 送信と GPIO (D/C, CS, RST) を監視し, LCDDrv が送信したバイト列を
+ * ST7789 のコマンドとして解釈して GRAM を再現します. 同時に, 送信バイト数と CS のアサート回数から
+ * SPI の転送時間を見積もります.
+ *
+ * 解釈するコマンド
+ *   0x01 SWRESET, 0x10/0x11 SLPIN/SLPOUT, 0x28/0x29 DISPOFF/DISPON, 0x20/0x21 INVOFF/INVON,
+ *   0x2A CASET, 0x2B RASET, 0x2C RAMWR, 0x3C RAMWRC, 0x33 VSCRDEF, 0x36 MADCTL, 0x37 VSCSAD, 0x3A COLMOD
+ * その他のコマンドはパラメータを読み飛ばします.
+ *
+ * MADCTL は 行/列 交換 (MV) の後に, MX を物理 x方向 (240), MY を物理 y方向 (320) の反転として適用します.
+ * 表示反転 (INVON) と RGB/BGR の順序はパネルの特性を補正するものとして扱い, GRAM の色は変換しません.
+ **/
+
+#if !defined(EMU_ST7789_H__)
+#define EMU_ST7789_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define ST7789EMU_WIDTH (240)  //< GRAM の幅 (物理 x方向)
+#define ST7789EMU_LINES (320)  //< GRAM の行数 (物理 y方向)
+
+#define ST7789EMU_DEFAULT_BAUDRATE (25000000u)  //< spi_init() が呼ばれるまでのボーレート
+#define ST7789EMU_DEFAULT_CS_NS (1000u)         //< 1トランザクションあたりの固定時間の初期値
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagST7789EmuStats_t {
+  uint64_t bytes;         //< 送信バイト数 (コマンド + パラメータ + ピクセル)
+  uint64_t commandBytes;  //< コマンドバイト数 (D/C = 0)
+  uint64_t pixelBytes;    //< RAMWR のデータバイト数
+  uint64_t pixels;        //< GRAM へ書き込んだピクセル数
+  uint32_t transactions;  //< CS のアサート回数
+  uint32_t windows;       //< CASET/RASET の回数
+  uint64_t wireNs;        //< 推定転送時間 (単位: ns)
+} ST7789EmuStats_t;
+
+typedef struct tagST7789Emu_t {
+  // 接続 (GPIO 番号)
+  uint32_t dc;
+  uint32_t csn;
+  uint32_t rst;
+  // 転送時間の見積もり
+  uint32_t baudrate;  //< SPI のボーレート (spi_init() で更新)
+  uint32_t csNs;      //< 1トランザクションあたりの固定時間 (CS の setup/hold, DMA 設定等. 単位: ns)
+  // 信号線の状態
+  bool csLevel;
+  bool dcLevel;
+  bool rstLevel;
+  // コマンドの解析
+  uint8_t cmd;       //< 実行中のコマンド
+  uint32_t nparam;   //< 受信済みのパラメータ数
+  uint8_t param[8];  //< パラメータ
+  bool writing;      //< RAMWR/RAMWRC のデータ受信中
+  uint8_t pend[3];   //< ピクセルに満たないデータ
+  uint32_t npend;    //< pend のバイト数
+  // レジスタ
+  uint8_t madctl;
+  uint8_t colmod;
+  uint16_t xs;   //< 列アドレス 開始
+  uint16_t xe;   //< 列アドレス 終了
+  uint16_t ys;   //< 行アドレス 開始
+  uint16_t ye;   //< 行アドレス 終了
+  uint16_t col;  //< 書き込み位置 (列アドレス)
+  uint16_t row;  //< 書き込み位置 (行アドレス)
+  uint16_t tfa;  //< 固定領域(上端)の行数
+  uint16_t vsa;  //< スクロール領域の行数
+  uint16_t vsp;  //< スクロール領域の先頭に表示するメモリ行
+  bool sleep;
+  bool displayOn;
+  bool inverted;
+  uint16_t gram[ST7789EMU_LINES][ST7789EMU_WIDTH];  //< フレームメモリ (RGB565, ホストのバイト順)
+  ST7789EmuStats_t stats;
+} ST7789Emu_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief エミュレータを初期化します. GRAM は 0 (黒), レジスタはリセット後の値になります.
+ * @param [out] ctx : 初期化対象
+ * @param [in] dc : D/C の GPIO 番号
+ * @param [in] csn : CS の GPIO 番号
+ * @param [in] rst : RST の GPIO 番号
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗
+ */
+UError_t ST7789Emu_Create(ST7789Emu_t* ctx, uint32_t dc, uint32_t csn, uint32_t rst);
+
+/**
+ * @brief スタブ HAL へ登録し, 以降の SPI 送信と GPIO 出力を受け取ります.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t ST7789Emu_Attach(ST7789Emu_t* ctx);
+
+/**
+ * @brief スタブ HAL への登録を解除します.
+ */
+void ST7789Emu_Detach(void);
+
+/**
+ * @brief 転送時間の見積もりに使用する値を設定します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] baudrate : SPI のボーレート (0: 変更しない)
+ * @param [in] csNs : 1トランザクションあたりの固定時間 (単位: ns)
+ * @return 処理結果
+ */
+UError_t ST7789Emu_SetTiming(ST7789Emu_t* ctx, uint32_t baudrate, uint32_t csNs);
+
+/**
+ * @brief 信号線の変化を入力します (ST7789Emu_Attach() 時はスタブ HAL から呼び出されます).
+ * @param [inout] ctx : 操作対象
+ * @param [in] gpio : GPIO 番号 (dc, csn, rst 以外は無視)
+ * @param [in] value : 出力値
+ */
+void ST7789Emu_SetPin(ST7789Emu_t* ctx, uint32_t gpio, bool value);
+
+/**
+ * @brief 送信データを入力します (ST7789Emu_Attach() 時はスタブ HAL から呼び出されます).
+ *
+ * CS が非アクティブ (High) の間のデータは無視します.
+ * @param [inout] ctx : 操作対象
+ * @param [in] data : 送信データ
+ * @param [in] len : データ長 (単位: byte)
+ */
+void ST7789Emu_Write(ST7789Emu_t* ctx, const uint8_t* data, size_t len);
+
+/**
+ * @brief 統計情報を取得します.
+ * @param [in] ctx : 操作対象
+ * @param [out] stats : 統計情報
+ * @return 処理結果
+ */
+UError_t ST7789Emu_GetStats(const ST7789Emu_t* ctx, ST7789EmuStats_t* stats);
+
+/**
+ * @brief 統計情報を 0 にします.
+ * @param [inout] ctx : 操作対象
+ * @return 処理結果
+ */
+UError_t ST7789Emu_ResetStats(ST7789Emu_t* ctx);
+
+/**
+ * @brief 表示される行に対応するフレームメモリの行を求めます (垂直スクロールを反映).
+ * @param [in] ctx : 操作対象
+ * @param [in] line : 表示上の行 (物理 y座標)
+ * @return フレームメモリの行
+ */
+uint16_t ST7789Emu_MapLine(const ST7789Emu_t* ctx, uint16_t line);
+
+/**
+ * @brief 表示されている画像を PPM (P6) 形式で保存します.
+ * @param [in] ctx : 操作対象
+ * @param [in] path : 保存先
+ * @return 処理結果
+ * @retval uSuccess : 処理成功
+ * @retval uSuccess 以外 : 処理失敗 (ファイルの書き込み失敗)
+ */
+UError_t ST7789Emu_WritePPM(const ST7789Emu_t* ctx, const char* path);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+#endif  // !defined(EMU_ST7789_H__)
@@ -0,0 +1,317 @@
+/**
+ * @file prog01/host/stub/hal.c
+ * ホストビルド用 pico-sdk スタブの実装
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/spi.h>
+#include <hosthal.h>
+#include <pico/multicore.h>
+#include <pico/stdlib.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define FIFO_DEPTH (8)  //< コア間 FIFO の段数 (RP2350 と同じ)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagHostDmaChannel_t {
+  bool claimed;
+  dma_channel_config config;
+  volatile void* write;
+  const volatile void* read;
+  uint32_t count;
+} HostDmaChannel_t;
+
+/**
+ * コア間 FIFO (一方向)
+ */
+typedef struct tagHostFifo_t {
+  uint32_t data[FIFO_DEPTH];
+  uint32_t head;
+  uint32_t count;
+} HostFifo_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief core1 のスレッドの入口
+ */
+static void* core1Thread(void* arg);
+
+/**
+ * @brief FIFO の待ち中に core1 が停止された場合の後始末
+ */
+static void unlockFifo(void* arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+spi_hw_t host_spi_hw[2];
+
+static HostHalHooks_t hooks = {NULL, NULL, NULL, NULL};
+
+static bool gpioLevel[HOST_GPIO_COUNT];
+static HostDmaChannel_t dmaChannels[HOST_DMA_CHANNELS];
+
+static pthread_t core1;
+static bool core1Running = false;
+static __thread uint32_t coreNum = 0;  //< 呼び出し元のコア番号
+static pthread_mutex_t fifoLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fifoCond = PTHREAD_COND_INITIALIZER;
+static HostFifo_t fifo[2];  //< [n] は core n が受信する FIFO
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+void HostHal_SetHooks(const HostHalHooks_t* h) {
+  const HostHalHooks_t none = {NULL, NULL, NULL, NULL};
+  hooks = (NULL != h) ? *h : none;
+}
+
+absolute_time_t get_absolute_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((absolute_time_t)ts.tv_sec * 1000000u) + ((absolute_time_t)ts.tv_nsec / 1000u);
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+
+uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+
+uint32_t time_us_32(void) { return (uint32_t)get_absolute_time(); }
+
+void sleep_ms(uint32_t ms) { (void)ms; }
+
+void sleep_us(uint64_t us) { (void)us; }
+
+bool stdio_init_all(void) { return true; }
+
+void tight_loop_contents(void) {
+  // 待ち続けるループでも multicore_reset_core1() で停止でき, 他のスレッドへ CPU を譲れるようにする
+  pthread_testcancel();
+  sched_yield();
+}
+
+void gpio_init(uint32_t gpio) {
+  if (gpio < HOST_GPIO_COUNT) {
+    gpioLevel[gpio] = false;
+  }
+}
+
+void gpio_put(uint32_t gpio, bool value) {
+  if (gpio < HOST_GPIO_COUNT) {
+    gpioLevel[gpio] = value;
+  }
+  if (NULL != hooks.gpioPut) {
+    hooks.gpioPut(hooks.arg, gpio, value);
+  }
+}
+
+bool gpio_get(uint32_t gpio) { return (gpio < HOST_GPIO_COUNT) ? gpioLevel[gpio] : false; }
+
+void gpio_set_dir(uint32_t gpio, bool out) {
+  (void)gpio;
+  (void)out;
+}
+
+void gpio_set_function(uint32_t gpio, enum gpio_function fn) {
+  (void)gpio;
+  (void)fn;
+}
+
+uint32_t spi_init(spi_inst_t* spi, uint32_t baudrate) {
+  // pico-sdk の spi_set_baudrate() と同じ分周比を求め, 実際のボーレートを返す
+  uint32_t prescale = 2;
+  uint32_t postdiv = 256;
+  for (; prescale <= 254; prescale += 2) {
+    if ((uint64_t)HOST_CLK_PERI_HZ < (uint64_t)(prescale + 2) * 256 * baudrate) {
+      break;
+    }
+  }
+  for (; postdiv > 1; --postdiv) {
+    if (HOST_CLK_PERI_HZ / (prescale * (postdiv - 1)) > baudrate) {
+      break;
+    }
+  }
+  const uint32_t actual = HOST_CLK_PERI_HZ / (prescale * postdiv);
+  if (NULL != hooks.spiInit) {
+    hooks.spiInit(hooks.arg, spi, actual);
+  }
+  return actual;
+}
+
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len) {
+  if (NULL != hooks.spiWrite) {
+    hooks.spiWrite(hooks.arg, spi, src, len);
+  }
+  return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t* spi, uint8_t repeated_tx_data, uint8_t* dst, size_t len) {
+  (void)spi;
+  (void)repeated_tx_data;
+  memset(dst, 0, len);
+  return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len) {
+  memset(dst, 0, len);
+  return spi_write_blocking(spi, src, len);
+}
+
+int dma_claim_unused_channel(bool required) {
+  for (uint32_t i = 0; i < HOST_DMA_CHANNELS; ++i) {
+    if (!dmaChannels[i].claimed) {
+      dmaChannels[i].claimed = true;
+      return (int)i;
+    }
+  }
+  if (required) {
+    panic("no DMA channel");
+  }
+  return -1;
+}
+
+void dma_channel_unclaim(uint32_t channel) {
+  if (channel < HOST_DMA_CHANNELS) {
+    dmaChannels[channel].claimed = false;
+  }
+}
+
+dma_channel_config dma_channel_get_default_config(uint32_t channel) {
+  (void)channel;
+  const dma_channel_config c = {.size = DMA_SIZE_32, .readIncrement = true, .writeIncrement = false, .dreq = 0x3f};
+  return c;
+}
+
+void dma_channel_configure(uint32_t channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr,
+                           uint32_t transfer_count, bool trigger) {
+  if (HOST_DMA_CHANNELS <= channel) {
+    return;
+  }
+  HostDmaChannel_t* const ch = &dmaChannels[channel];
+  ch->config = *config;
+  ch->write = write_addr;
+  ch->read = read_addr;
+  ch->count = transfer_count;
+  if (trigger) {
+    dma_start_channel_mask(1u << channel);
+  }
+}
+
+void dma_start_channel_mask(uint32_t mask) {
+  for (uint32_t i = 0; i < HOST_DMA_CHANNELS; ++i) {
+    if (0 == (mask & (1u << i))) {
+      continue;
+    }
+    // SPI のデータレジスタへ 1byte ずつ書き込む転送は, 送信データとして扱う
+    HostDmaChannel_t* const ch = &dmaChannels[i];
+    for (uint32_t s = 0; s < 2; ++s) {
+      if (ch->write == (volatile void*)&host_spi_hw[s].dr && DMA_SIZE_8 == ch->config.size) {
+        if (ch->config.readIncrement) {
+          (void)spi_write_blocking((spi_inst_t*)&host_spi_hw[s], (const uint8_t*)ch->read, ch->count);
+        } else {
+          // 同じ値の繰り返し (塗りつぶし)
+          for (uint32_t n = 0; n < ch->count; ++n) {
+            (void)spi_write_blocking((spi_inst_t*)&host_spi_hw[s], (const uint8_t*)ch->read, 1);
+          }
+        }
+      }
+    }
+  }
+}
+
+void dma_channel_wait_for_finish_blocking(uint32_t channel) { (void)channel; }
+
+bool dma_channel_is_busy(uint32_t channel) {
+  (void)channel;
+  return false;
+}
+
+static void* core1Thread(void* arg) {
+  coreNum = 1;
+  void (*entry)(void) = NULL;
+  memcpy(&entry, &arg, sizeof(entry));
+  entry();
+  return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+  if (core1Running) {
+    return;
+  }
+  pthread_mutex_lock(&fifoLock);
+  memset(fifo, 0, sizeof(fifo));
+  pthread_mutex_unlock(&fifoLock);
+  // pthread_create() の引数は void* のため, 関数ポインタを経由して渡す
+  void* arg = NULL;
+  memcpy(&arg, &entry, sizeof(arg));
+  if (0 == pthread_create(&core1, NULL, core1Thread, arg)) {
+    core1Running = true;
+  }
+}
+
+void multicore_reset_core1(void) {
+  if (core1Running) {
+    pthread_cancel(core1);
+    pthread_join(core1, NULL);
+    core1Running = false;
+  }
+}
+
+static void unlockFifo(void* arg) { pthread_mutex_unlock((pthread_mutex_t*)arg); }
+
+void multicore_fifo_push_blocking(uint32_t data) {
+  HostFifo_t* const f = &fifo[coreNum ^ 1];
+  pthread_mutex_lock(&fifoLock);
+  pthread_cleanup_push(unlockFifo, &fifoLock);
+  while (FIFO_DEPTH <= f->count) {
+    pthread_cond_wait(&fifoCond, &fifoLock);
+  }
+  f->data[(f->head + f->count) % FIFO_DEPTH] = data;
+  f->count++;
+  pthread_cond_broadcast(&fifoCond);
+  pthread_cleanup_pop(1);
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+  HostFifo_t* const f = &fifo[coreNum];
+  uint32_t data = 0;
+  pthread_mutex_lock(&fifoLock);
+  pthread_cleanup_push(unlockFifo, &fifoLock);
+  while (0 == f->count) {
+    pthread_cond_wait(&fifoCond, &fifoLock);
+  }
+  data = f->data[f->head];
+  f->head = (f->head + 1) % FIFO_DEPTH;
+  f->count--;
+  pthread_cond_broadcast(&fifoCond);
+  pthread_cleanup_pop(1);
+  return data;
+}
+
+uint32_t get_core_num(void) { return coreNum; }
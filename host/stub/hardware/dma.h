@@ -0,0 +1,48 @@
+/**
+ * @file prog01/host/stub/hardware/dma.h
+ * ホストビルド用 pico-sdk スタブ
+ *
+ * 転送は dma_start_channel_mask() の時点で完了したものとして扱います.
+ * SPI のデータレジスタへの転送は spi_write_blocking() と同じ経路で処理します.
+ **/
+
+#if !defined(HOST_STUB_HARDWARE_DMA_H__)
+#define HOST_STUB_HARDWARE_DMA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_DMA_CHANNELS (16)  //< DMA チャネル数
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+  uint32_t size;  //< enum dma_channel_transfer_size
+  bool readIncrement;
+  bool writeIncrement;
+  uint32_t dreq;
+} dma_channel_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint32_t channel);
+dma_channel_config dma_channel_get_default_config(uint32_t channel);
+void dma_channel_configure(uint32_t channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr,
+                           uint32_t transfer_count, bool trigger);
+void dma_start_channel_mask(uint32_t mask);
+void dma_channel_wait_for_finish_blocking(uint32_t channel);
+bool dma_channel_is_busy(uint32_t channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) { c->size = (uint32_t)size; }
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) { c->readIncrement = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) { c->writeIncrement = incr; }
+static inline void channel_config_set_dreq(dma_channel_config* c, uint32_t dreq) { c->dreq = dreq; }
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_HARDWARE_DMA_H__)
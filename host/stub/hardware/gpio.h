@@ -0,0 +1,33 @@
+/**
+ * @file prog01/host/stub/hardware/gpio.h
+ * ホストビルド用 pico-sdk スタブ
+ **/
+
+#if !defined(HOST_STUB_HARDWARE_GPIO_H__)
+#define HOST_STUB_HARDWARE_GPIO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_OUT (1)
+#define GPIO_IN (0)
+
+#define HOST_GPIO_COUNT (48)  //< スタブが保持する GPIO の数
+
+enum gpio_function { GPIO_FUNC_SPI = 1, GPIO_FUNC_UART = 2, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5, GPIO_FUNC_NULL = 0x1f };
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+void gpio_init(uint32_t gpio);
+void gpio_put(uint32_t gpio, bool value);
+bool gpio_get(uint32_t gpio);
+void gpio_set_dir(uint32_t gpio, bool out);
+void gpio_set_function(uint32_t gpio, enum gpio_function fn);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_HARDWARE_GPIO_H__)
@@ -0,0 +1,45 @@
+/**
+ * @file prog01/host/stub/hardware/pwm.h
+ * ホストビルド用 pico-sdk スタブ
+ **/
+
+#if !defined(HOST_STUB_HARDWARE_PWM_H__)
+#define HOST_STUB_HARDWARE_PWM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t csr;
+  uint32_t div;
+  uint32_t top;
+} pwm_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+static inline uint32_t pwm_gpio_to_slice_num(uint32_t gpio) { return (gpio >> 1) & 7u; }
+static inline pwm_config pwm_get_default_config(void) {
+  pwm_config c = {0, 1, 0xffff};
+  return c;
+}
+static inline void pwm_init(uint32_t slice, pwm_config* c, bool start) {
+  (void)slice;
+  (void)c;
+  (void)start;
+}
+static inline void pwm_set_gpio_level(uint32_t gpio, uint16_t level) {
+  (void)gpio;
+  (void)level;
+}
+static inline void pwm_set_enabled(uint32_t slice, bool enabled) {
+  (void)slice;
+  (void)enabled;
+}
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_HARDWARE_PWM_H__)
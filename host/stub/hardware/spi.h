@@ -0,0 +1,45 @@
+/**
+ * @file prog01/host/stub/hardware/spi.h
+ * ホストビルド用 pico-sdk スタブ
+ *
+ * 送信データは HostHal_SetHooks() で登録した関数へ渡し, 破棄します. 受信データは 0 です.
+ **/
+
+#if !defined(HOST_STUB_HARDWARE_SPI_H__)
+#define HOST_STUB_HARDWARE_SPI_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/types.h>
+
+typedef struct {
+  volatile uint32_t dr;
+} spi_hw_t;
+
+typedef struct spi_inst spi_inst_t;
+
+#define spi0 ((spi_inst_t*)&host_spi_hw[0])
+#define spi1 ((spi_inst_t*)&host_spi_hw[1])
+#define spi_default spi0
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+extern spi_hw_t host_spi_hw[2];  //< SPI のレジスタ (DMA の転送先アドレスの判定に使用)
+
+static inline spi_hw_t* spi_get_hw(spi_inst_t* spi) { return (spi_hw_t*)spi; }
+static inline uint32_t spi_get_dreq(spi_inst_t* spi, bool tx) { return ((spi == spi1) ? 18u : 16u) + (tx ? 0u : 1u); }
+
+uint32_t spi_init(spi_inst_t* spi, uint32_t baudrate);
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len);
+int spi_read_blocking(spi_inst_t* spi, uint8_t repeated_tx_data, uint8_t* dst, size_t len);
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_HARDWARE_SPI_H__)
@@ -0,0 +1,44 @@
+/**
+ * @file prog01/host/stub/hosthal.h
+ * ホストビルド用 pico-sdk スタブの拡張
+ *
+ * スタブの SPI 送信と GPIO 出力を監視する関数を登録します.
+ * LCD コントローラのエミュレータ等, 送信データを解析する処理から使用します.
+ **/
+
+#if !defined(HOST_STUB_HOSTHAL_H__)
+#define HOST_STUB_HOSTHAL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hardware/spi.h>
+
+/**
+ * RP2350 の clk_peri (単位: Hz). spi_init() が返すボーレートの計算に使用します.
+ */
+#define HOST_CLK_PERI_HZ (150000000u)
+
+typedef struct tagHostHalHooks_t {
+  void (*spiInit)(void* arg, spi_inst_t* spi, uint32_t baudrate);                //< spi_init() (設定されたボーレート)
+  void (*spiWrite)(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len);  //< 送信データ (DMA 転送を含む)
+  void (*gpioPut)(void* arg, uint32_t gpio, bool value);                         //< GPIO 出力の変化
+  void* arg;                                                                     //< 各関数へ渡す引数
+} HostHalHooks_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+/**
+ * @brief 監視する関数を登録します. 登録できるのは 1組だけです.
+ * @param [in] hooks : 登録する関数 (NULL: 登録解除. 各関数は NULL 可)
+ */
+void HostHal_SetHooks(const HostHalHooks_t* hooks);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_HOSTHAL_H__)
@@ -0,0 +1,11 @@
+/**
+ * @file prog01/host/stub/pico/binary_info.h
+ * ホストビルド用 pico-sdk スタブ
+ **/
+
+#if !defined(HOST_STUB_PICO_BINARY_INFO_H__)
+#define HOST_STUB_PICO_BINARY_INFO_H__
+
+#define bi_decl(...)
+
+#endif  // !defined(HOST_STUB_PICO_BINARY_INFO_H__)
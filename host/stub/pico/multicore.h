@@ -0,0 +1,27 @@
+/**
+ * @file prog01/host/stub/pico/multicore.h
+ * ホストビルド用 pico-sdk スタブ
+ *
+ * core1 は pthread のスレッドで, FIFO は条件変数付きのキューで代用します.
+ **/
+
+#if !defined(HOST_STUB_PICO_MULTICORE_H__)
+#define HOST_STUB_PICO_MULTICORE_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+uint32_t get_core_num(void);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_PICO_MULTICORE_H__)
@@ -0,0 +1,44 @@
+/**
+ * @file prog01/host/stub/pico/stdlib.h
+ * ホストビルド用 pico-sdk スタブ
+ *
+ * 時刻は CLOCK_MONOTONIC を基準にします. sleep_ms() / sleep_us() は待たずに戻ります
+ * (LCD の初期化待ちでベンチマークが遅くならないようにするため).
+ * tight_loop_contents() は他のスレッドへ CPU を譲ります.
+ **/
+
+#if !defined(HOST_STUB_PICO_STDLIB_H__)
+#define HOST_STUB_PICO_STDLIB_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <hardware/gpio.h>
+#include <pico/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+absolute_time_t get_absolute_time(void);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+uint32_t time_us_32(void);
+uint32_t get_core_num(void);  //< pico/platform.h (実装は multicore のスタブ)
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+bool stdio_init_all(void);
+
+void tight_loop_contents(void);
+
+#define panic(...) abort()
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // !defined(HOST_STUB_PICO_STDLIB_H__)
@@ -0,0 +1,14 @@
+/**
+ * @file prog01/host/stub/pico/types.h
+ * ホストビルド用 pico-sdk スタブ
+ **/
+
+#if !defined(HOST_STUB_PICO_TYPES_H__)
+#define HOST_STUB_PICO_TYPES_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint64_t absolute_time_t;  //< 起動からの経過時間 (単位: us)
+
+#endif  // !defined(HOST_STUB_PICO_TYPES_H__)
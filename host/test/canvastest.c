@@ -0,0 +1,199 @@
+/**
+ * @file prog01/host/test/canvastest.c
+ * インデックスカラーのキャンバスの展開 (Canvas_ExpandLine()) の検査 (ホストビルド)
+ *
+ * 同じ画面をインデックスカラーのキャンバスにはパレット番号で, RGB565 のキャンバスにはパレットの色で描画し,
+ * Canvas_ExpandLine() で展開した行がバイト単位で一致するかを確かめます (ctest から実行).
+ * 1/2/4/8bit の各形式について, 奇数幅とストライドが幅より大きい場合, 行の途中から始まる部分的な展開を検査します.
+ * 描画バッファはちょうどの大きさを malloc し, 範囲外の読み出しを ASan で検出します.
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <user/canvas.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define MAX_W (80)  //< 検査するキャンバスの最大幅
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * キャンバスの大きさ
+ */
+typedef struct tagSize_t {
+  const char* name;
+  size_t w;
+  size_t h;
+  size_t s;  //< ストライド (単位: pixel)
+} Size_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 同じ画面を描画する
+ * @param [in] canvas : 描画先
+ * @param [in] mask : パレット番号のマスク (2^bpp - 1)
+ * @param [in] color : パレット番号を描画する値へ変換する表 (NULL: パレット番号をそのまま描画する)
+ * @return 処理結果
+ */
+static UError_t drawScene(const Canvas_t* canvas, uint32_t mask, const uint16_t* color);
+
+/**
+ * @brief 1つの形式と大きさを検査する
+ * @return 不一致の数
+ */
+static uint32_t checkFormat(CanvasFormat_t fmt, const Size_t* size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static const Size_t sizes[] = {
+    {"61x23", 61, 23, 61},        //< 奇数幅 (行の終端がバイトの途中)
+    {"64x17/s67", 64, 17, 67},    //< ストライドが幅より大きい
+    {"1x5", 1, 5, 1},             //< 1ピクセル幅
+    {"64x3", 64, 3, 64},          //< 行の終端がバッファの終端 (バイト境界)
+    {"79x9/s80", 79, 9, 80},      //< 奇数幅, ストライドが幅より大きい
+};
+
+static const CanvasFormat_t formats[] = {CanvasIndexed1, CanvasIndexed2, CanvasIndexed4, CanvasIndexed8};
+
+static uint16_t palette[256];
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t drawScene(const Canvas_t* canvas, uint32_t mask, const uint16_t* color) {
+  UError_t err = uSuccess;
+  const size_t w = canvas->w;
+  const size_t h = canvas->h;
+#define C(INDEX) ((NULL != color) ? color[(INDEX) & mask] : (uint16_t)((INDEX) & mask))
+
+  if (uSuccess == err) {
+    err = Canvas_Clear(canvas, C(0));
+  }
+  if (uSuccess == err && 2 < w) {
+    err = Canvas_FillRect(canvas, 1, 2, w - 2, (h / 3) + 1, C(1));
+  }
+  if (uSuccess == err) {
+    err = Canvas_DrawLine(canvas, 0, 0, w - 1, h - 1, C(2));
+  }
+  if (uSuccess == err) {
+    err = Canvas_DrawLine(canvas, w - 1, 0, 0, h - 1, C(3));
+  }
+  if (uSuccess == err) {
+    err = Canvas_DrawCircle(canvas, w / 2, h / 2, h / 3, C(4));
+  }
+  if (uSuccess == err) {
+    err = Canvas_DrawFillCircle(canvas, w / 3, (h * 2) / 3, h / 4, C(5));
+  }
+  // 全てのパレット番号を散らして置く
+  for (uint32_t i = 0; i < 256 && uSuccess == err; ++i) {
+    err = Canvas_DrawPixel(canvas, (i * 7) % w, (i * 13) % h, C(i));
+  }
+  // 1ピクセル単位の移動 (バイト境界に揃わない)
+  if (uSuccess == err && 2 < w && 2 < h) {
+    err = Canvas_Scroll(canvas, 1, 1, w - 2, h - 2, 3, -2, C(6));
+  }
+  if (uSuccess == err) {
+    err = Canvas_Scroll(canvas, 0, 0, w, h, -5, 1, C(7));
+  }
+#undef C
+
+  return err;
+}
+
+static uint32_t checkFormat(CanvasFormat_t fmt, const Size_t* size) {
+  uint32_t failures = 0;
+  const uint32_t bpp = Canvas_GetBitsPerPixel(fmt);
+  const uint32_t mask = (1u << bpp) - 1;
+  Canvas_t indexed;
+  Canvas_t rgb;
+  uint16_t* const buf565 = (uint16_t*)malloc(size->s * size->h * sizeof(uint16_t));
+  uint8_t* bufIndexed = NULL;
+  uint16_t a[MAX_W];
+  uint16_t b[MAX_W];
+
+  (void)Canvas_Create(&rgb, size->w, size->h, size->s, buf565);
+  // 1行あたりのバイト数 x 行数 ちょうどの大きさにする
+  const size_t bytes = (((size->s * bpp) + 7) / 8) * size->h;
+  bufIndexed = (uint8_t*)malloc(bytes);
+  memset(bufIndexed, 0xa5, bytes);
+  if (uSuccess != Canvas_CreateIndexed(&indexed, size->w, size->h, size->s, bufIndexed, fmt, palette)) {
+    printf("%u bpp %-10s FAIL (Canvas_CreateIndexed)\n", bpp, size->name);
+    ++failures;
+  }
+
+  if (0 == failures && (uSuccess != drawScene(&indexed, mask, NULL) || uSuccess != drawScene(&rgb, mask, palette))) {
+    printf("%u bpp %-10s FAIL (draw)\n", bpp, size->name);
+    ++failures;
+  }
+
+  // 全ての開始位置と幅の組み合わせで展開する (開始位置, 終了位置がバイトの途中になる場合を含む)
+  uint32_t spans = 0;
+  for (size_t y = 0; y < size->h && 0 == failures; ++y) {
+    for (size_t x = 0; x < size->w; ++x) {
+      for (size_t w = 1; x + w <= size->w; ++w) {
+        memset(a, 0, sizeof(a));
+        memset(b, 0, sizeof(b));
+        const UError_t ea = Canvas_ExpandLine(&indexed, x, y, w, a);
+        const UError_t eb = Canvas_ExpandLine(&rgb, x, y, w, b);
+        ++spans;
+        if (uSuccess != ea || uSuccess != eb || 0 != memcmp(a, b, w * sizeof(uint16_t))) {
+          if (failures < 8) {
+            printf("%u bpp %-10s y %zu x %zu w %zu differ\n", bpp, size->name, y, x, w);
+          }
+          ++failures;
+        }
+      }
+    }
+  }
+
+  // 範囲外は失敗する
+  if (0 == failures) {
+    if (uSuccess == Canvas_ExpandLine(&indexed, 1, 0, size->w, a) || uSuccess == Canvas_ExpandLine(&indexed, 0, size->h, 1, a)) {
+      printf("%u bpp %-10s FAIL (out of range is accepted)\n", bpp, size->name);
+      ++failures;
+    }
+  }
+
+  printf("%u bpp %-10s %u spans, %u mismatches\n", bpp, size->name, spans, failures);
+  free(bufIndexed);
+  free(buf565);
+  return failures;
+}
+
+int main(void) {
+  uint32_t failures = 0;
+
+  // 奇数を掛けると 65536 を法として全単射になるため, 256色は全て異なる
+  for (uint32_t i = 0; i < 256; ++i) {
+    palette[i] = (uint16_t)((i * 40503u) + 0x1357);
+  }
+
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+      failures += checkFormat(formats[f], &sizes[i]);
+    }
+  }
+  printf("canvastest: %s\n", (0 == failures) ? "ok" : "FAILED");
+  return (0 == failures) ? 0 : 1;
+}
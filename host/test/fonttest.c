@@ -0,0 +1,280 @@
+/**
+ * @file prog01/host/test/fonttest.c
+ * UTF-8 の復号と Unicode -> SJIS 変換の検査 (ホストビルド)
+ *
+ * 次の項目を検査し, 不一致があれば終了コード 1 を返します (ctest から実行).
+ *   jis0208   : JIS X 0208 の全文字 (SJIS の 2バイトコード) を iconv で Unicode にし, Font_UnicodeToSJIS() で元に戻るか
+ *   kana      : 半角カナ (U+FF61 - U+FF9F) が 1バイトコード (0xa1 - 0xdf) になるか
+ *   unmapped  : ASCII, サロゲート, BMP 外, JIS X 0208 にない文字が 0 になるか
+ *   builtin   : 静的に初期化した組み込み ANK フォントの索引が Font_BuildIndex() の結果と一致するか
+ *   utf8      : 冗長表現, 途中で終わるシーケンス, 先頭になれないバイト等を Font_PrintWith() が
+ *               1バイト 1キャラクタとして読み飛ばし, 終端より先を読まないか (文字列は malloc した領域に置き, ASan で検出する)
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iconv.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <user/font.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define JIS0208_CHARS (6879)  //< JIS X 0208 の文字数 (非漢字 524 + 第1水準 2965 + 第2水準 3390)
+#define MAX_DRAWS (16)        //< 1つの文字列で記録する描画の数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Font_PrintWith() の描画の記録
+ */
+typedef struct tagDraws_t {
+  uint32_t n;
+  uint32_t x[MAX_DRAWS];
+  uint16_t code[MAX_DRAWS];
+} Draws_t;
+
+/**
+ * UTF-8 の検査項目. 末尾に 'A' を付けたものは, 'A' の位置で読み飛ばしたキャラクタ数を確かめる
+ */
+typedef struct tagUtf8Case_t {
+  const char* name;
+  const char* sz;
+  int32_t markerX;  //< 'A' の x位置 (-1: 'A' なし)
+  uint16_t code;    //< 'A' より前に描画する文字 (0: なし)
+} Utf8Case_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief SJIS の文字コードを iconv で Unicode へ変換する
+ * @return コードポイント (変換できない, または 1文字にならない場合は 0)
+ */
+static uint32_t sjisToUnicode(iconv_t cd, uint16_t code);
+
+/**
+ * @brief 描画を記録する (Font_DrawFontFn_t)
+ */
+static UError_t record(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+static uint32_t checkJis0208(void);
+static uint32_t checkKana(void);
+static uint32_t checkUnmapped(void);
+static uint32_t checkBuiltin(void);
+static uint32_t checkUtf8(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static const Utf8Case_t utf8Cases[] = {
+    {"valid-kanji", "\xe3\x81\x82" "A", 2, 0},             //< U+3042 (全角は 2キャラクタ. 全角フォントなしでは描画しない)
+    {"valid-kana", "\xef\xbd\xb1" "A", 1, 0xb1},           //< U+FF71 (半角カナは ANK フォント)
+    {"continuation", "\x80" "A", 1, 0},                    //< 先頭になれないバイト
+    {"continuation-end", "\x80", -1, 0},                   //< 終端の直前
+    {"lead-c0", "\xc0\xaf" "A", 2, 0},                     //< 2バイトの冗長表現 ('/')
+    {"overlong-3", "\xe0\x80\xaf" "A", 3, 0},              //< 3バイトの冗長表現
+    {"overlong-4", "\xf0\x80\x80\xaf" "A", 4, 0},          //< 4バイトの冗長表現
+    {"surrogate", "\xed\xa0\x80" "A", 3, 0},               //< U+D800
+    {"out-of-range", "\xf4\x90\x80\x80" "A", 4, 0},        //< U+110000
+    {"lead-f5", "\xf5" "A", 1, 0},                         //< 先頭になれないバイト
+    {"lead-ff", "\xff", -1, 0},                            //< 終端の直前
+    {"truncated-2", "\xc3", -1, 0},                        //< 2バイトの途中で終端
+    {"truncated-3", "\xe3\x81", -1, 0},                    //< 3バイトの途中で終端
+    {"truncated-4", "\xf0\x9f\x98", -1, 0},                //< 4バイトの途中で終端
+    {"truncated-mid", "\xe3\x81" "A", 2, 0},               //< 3バイトの途中に ASCII
+    {"bad-then-valid", "\x80\xe3\x81\x82" "A", 3, 0},      //< 不正なバイトの後の正しい文字
+};
+#define UTF8_CASES (sizeof(utf8Cases) / sizeof(utf8Cases[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint32_t sjisToUnicode(iconv_t cd, uint16_t code) {
+  char in[2] = {(char)(code >> 8), (char)(code & 0xff)};
+  uint8_t out[8];
+  char* pin = in;
+  char* pout = (char*)out;
+  size_t nin = sizeof(in);
+  size_t nout = sizeof(out);
+
+  (void)iconv(cd, NULL, NULL, NULL, NULL);
+  if ((size_t)-1 == iconv(cd, &pin, &nin, &pout, &nout) || 0 != nin || 4 != sizeof(out) - nout) {
+    return 0;
+  }
+  return (uint32_t)out[0] | ((uint32_t)out[1] << 8) | ((uint32_t)out[2] << 16) | ((uint32_t)out[3] << 24);
+}
+
+static UError_t record(void* arg, uint32_t x, uint32_t y, const void* graph, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  Draws_t* const d = (Draws_t*)arg;
+  (void)y;
+  (void)graph;
+  (void)fw;
+  (void)fh;
+  (void)fsz;
+  if (MAX_DRAWS <= d->n) {
+    return uFailure;
+  }
+  d->x[d->n] = x;
+  d->code[d->n] = c;
+  ++d->n;
+  return uSuccess;
+}
+
+static uint32_t checkJis0208(void) {
+  uint32_t failures = 0;
+  uint32_t chars = 0;
+  const iconv_t cd = iconv_open("UCS-4LE", "SHIFT_JIS");
+  if ((iconv_t)-1 == cd) {
+    printf("jis0208   FAIL (iconv SHIFT_JIS is not available)\n");
+    return 1;
+  }
+
+  // 上位バイト 0x81 - 0x9f, 0xe0 - 0xef, 下位バイト 0x40 - 0x7e, 0x80 - 0xfc が JIS X 0208 の範囲
+  for (uint32_t lead = 0x81; lead <= 0xef; ++lead) {
+    if (0xa0 <= lead && 0xdf >= lead) {
+      continue;
+    }
+    for (uint32_t trail = 0x40; trail <= 0xfc; ++trail) {
+      if (0x7f == trail) {
+        continue;
+      }
+      const uint16_t code = (uint16_t)((lead << 8) | trail);
+      const uint32_t cp = sjisToUnicode(cd, code);
+      if (0 == cp) {
+        // 未定義の位置
+        continue;
+      }
+      ++chars;
+
+      // 同じ文字に複数の符号位置がある場合もあるため, 変換結果が同じ文字に戻ることを確かめる
+      const uint16_t back = Font_UnicodeToSJIS(cp);
+      const uint32_t again = (0x100 <= back) ? sjisToUnicode(cd, back) : 0;
+      if (again != cp) {
+        if (failures < 8) {
+          printf("jis0208   0x%04x -> U+%04X -> 0x%04x\n", code, cp, back);
+        }
+        ++failures;
+      }
+    }
+  }
+  iconv_close(cd);
+
+  if (chars < JIS0208_CHARS) {
+    printf("jis0208   FAIL (%u characters, expected %u)\n", chars, JIS0208_CHARS);
+    ++failures;
+  }
+  printf("jis0208   %u characters, %u mismatches\n", chars, failures);
+  return failures;
+}
+
+static uint32_t checkKana(void) {
+  uint32_t failures = 0;
+  for (uint32_t i = 0; i < 0x3f; ++i) {
+    const uint16_t code = Font_UnicodeToSJIS(0xff61 + i);
+    if (0xa1 + i != code) {
+      printf("kana      U+%04X -> 0x%04x (expected 0x%02x)\n", 0xff61 + i, code, 0xa1 + i);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+static uint32_t checkUnmapped(void) {
+  static const uint32_t cps[] = {
+      0x0000, 0x0041, 0x007f,   //< ASCII は表に含めない (Font_PrintWith() が直接描画する)
+      0x00e9, 0x20ac, 0xac00,   //< JIS X 0208 にない文字 (é, €, 한)
+      0xd800, 0xdbff, 0xdc00,   //< サロゲート
+      0xdfff, 0xfffe, 0xffff,   //< 非文字
+      0x10000, 0x1f600, 0x10ffff, 0x110000, 0xffffffff,  //< BMP 外, 範囲外
+  };
+  uint32_t failures = 0;
+  for (size_t i = 0; i < sizeof(cps) / sizeof(cps[0]); ++i) {
+    const uint16_t code = Font_UnicodeToSJIS(cps[i]);
+    if (0 != code) {
+      printf("unmapped  U+%04X -> 0x%04x (expected 0)\n", cps[i], code);
+      ++failures;
+    }
+  }
+  // サロゲートの範囲は全て 0
+  for (uint32_t cp = 0xd800; cp <= 0xdfff; ++cp) {
+    if (0 != Font_UnicodeToSJIS(cp)) {
+      printf("unmapped  U+%04X is mapped\n", cp);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+static uint32_t checkBuiltin(void) {
+  const FontIndex_t* const builtin = Font_Get(FONT_ID_ANK);
+  FontIndex_t idx;
+  // 1バイトコードのフォントはヘッダ (17) + 256文字分のグリフ
+  if (NULL == builtin || uSuccess != Font_BuildIndex(&idx, builtin->font, 17 + (0x100 * builtin->fsz), NULL, 0)) {
+    printf("builtin   FAIL (index)\n");
+    return 1;
+  }
+  if (idx.glyphs != builtin->glyphs || idx.fw != builtin->fw || idx.fh != builtin->fh || idx.fsz != builtin->fsz || idx.type != builtin->type ||
+      0 != builtin->nblk) {
+    printf("builtin   FAIL (%ux%u fsz %zu, expected %ux%u fsz %zu)\n", builtin->fw, builtin->fh, builtin->fsz, idx.fw, idx.fh, idx.fsz);
+    return 1;
+  }
+  return 0;
+}
+
+static uint32_t checkUtf8(void) {
+  uint32_t failures = 0;
+  for (size_t i = 0; i < UTF8_CASES; ++i) {
+    const Utf8Case_t* const t = &utf8Cases[i];
+    // 終端の直後を読むと ASan が検出できるよう, ちょうどの大きさの領域へ置く
+    const size_t len = strlen(t->sz);
+    char* const sz = (char*)malloc(len + 1);
+    memcpy(sz, t->sz, len + 1);
+
+    Draws_t d;
+    memset(&d, 0, sizeof(d));
+    const UError_t err = Font_PrintWith(FONT_ID_ANK, FONT_ID_NONE, sz, record, &d);
+    free(sz);
+
+    // 'A' の前に描画した文字と 'A' の位置を確かめる
+    const uint32_t expectDraws = ((0 != t->code) ? 1u : 0u) + ((0 <= t->markerX) ? 1u : 0u);
+    bool ok = (uSuccess == err) && (expectDraws == d.n);
+    if (ok && 0 != t->code) {
+      ok = (t->code == d.code[0]) && (0 == d.x[0]);
+    }
+    if (ok && 0 <= t->markerX) {
+      ok = ('A' == d.code[d.n - 1]) && ((uint32_t)t->markerX == d.x[d.n - 1]);
+    }
+    if (!ok) {
+      printf("utf8      %-16s FAIL (err %d, %u draws, last x %d)\n", t->name, (int)err, d.n, (0 < d.n) ? (int)d.x[d.n - 1] : -1);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+int main(void) {
+  uint32_t failures = 0;
+  failures += checkJis0208();
+  failures += checkKana();
+  failures += checkUnmapped();
+  failures += checkBuiltin();
+  failures += checkUtf8();
+  printf("fonttest: %s\n", (0 == failures) ? "ok" : "FAILED");
+  return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file prog01/host/test/frameqtest.c
+ * SPSC キュー (frameq.h) と転送パイプライン (lcdpipe.h) のスレッド間の検査 (ホストビルド)
+ *
+ * 次の項目を検査し, 不一致があれば終了コード 1 を返します (ctest から ThreadSanitizer / AddressSanitizer 版を実行).
+ *   frameq  : 生産者スレッドが連番を付けた要素を FrameQueue_Push() し, 消費者スレッドが FrameQueue_Pop() で
+ *             順番どおりに同じ内容を受け取るか (満杯/空の状態を繰り返し通過する)
+ *   lcdpipe : 生産者スレッドが面に連番の色を描画して LCDPipe_Submit() し, 消費者スレッドの LCDPipe_Service() が
+ *             順番どおりに転送するか. 転送内容はスタブ HAL の監視関数で受け取り, 転送前に面が再利用されていないかを確かめる
+ *   core1   : core1 を他の処理が使用中の場合に LCDPipe_Start() と Core1_Launch() が失敗するか
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hosthal.h>
+#include <pico/stdlib.h>
+#include <user/canvas.h>
+#include <user/core1.h>
+#include <user/frameq.h>
+#include <user/lcddrv.h>
+#include <user/lcdpipe.h>
+#include <user/spidrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define QUEUE_ITEMS (200000u)  //< frameq で受け渡す要素数
+#define PIPE_FRAMES (5000u)    //< lcdpipe で転送するフレーム数
+#define PIPE_W (8)             //< 面の幅
+#define PIPE_H (4)             //< 面の高さ (上下 2つの領域に分けて転送する)
+#define PIPE_BUFFERS (3)       //< 面の数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * lcdpipe の転送内容の確認 (監視関数は消費者スレッドから呼び出される)
+ */
+typedef struct tagPipeCheck_t {
+  uint32_t dcPin;
+  bool dc;           //< D/C 信号 (true: データ)
+  bool writing;      //< RAMWR の後
+  uint32_t windows;  //< RAMWR の回数 (転送した領域の数)
+  uint32_t bytes;    //< 現在の領域で受け取ったバイト数
+  uint32_t errors;
+} PipeCheck_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief seq 番目の要素の内容
+ */
+static void makeItem(uint32_t seq, FrameQueueItem_t* item);
+
+/**
+ * @brief f フレーム目の面の色 (上位/下位バイトが同じ値)
+ */
+static uint16_t frameColor(uint32_t f);
+
+static void* queueProducer(void* arg);
+static void* pipeConsumer(void* arg);
+
+/**
+ * @brief core1 を専有する他の処理の代わり
+ */
+static void otherCore1Entry(void);
+
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len);
+static void hookGpioPut(void* arg, uint32_t gpio, bool value);
+
+static uint32_t checkQueue(void);
+static uint32_t checkPipe(void);
+static uint32_t checkCore1(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static FrameQueue_t queue;
+static _Atomic bool pipeDone;  //< 生産者が全てのフレームを投入し終えた
+static SPIDrvContext_t spi;
+static LCDDrvContext_t lcd;
+static LCDPipe_t pipe;
+static PipeCheck_t pipeCheck;
+static uint16_t pipeFb[PIPE_BUFFERS][PIPE_W * PIPE_H];
+static Canvas_t pipeCanvas[PIPE_BUFFERS];
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void makeItem(uint32_t seq, FrameQueueItem_t* item) {
+  item->buffer = (uint16_t)seq;
+  item->flags = (uint16_t)(seq >> 16);
+  item->rect.x = (uint16_t)(seq * 3);
+  item->rect.y = (uint16_t)~seq;
+  item->rect.w = (uint16_t)(seq ^ 0x5a5a);
+  item->rect.h = (uint16_t)((seq >> 8) + seq);
+}
+
+static uint16_t frameColor(uint32_t f) { return (uint16_t)((f & 0xff) * 0x0101u); }
+
+static void* queueProducer(void* arg) {
+  (void)arg;
+  FrameQueueItem_t item;
+  for (uint32_t seq = 0; seq < QUEUE_ITEMS; ++seq) {
+    makeItem(seq, &item);
+    while (uSuccess != FrameQueue_Push(&queue, &item)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static uint32_t checkQueue(void) {
+  uint32_t failures = 0;
+  pthread_t producer;
+  FrameQueueItem_t item;
+  FrameQueueItem_t expect;
+  uint32_t maxCount = 0;
+
+  (void)FrameQueue_Init(&queue);
+  if (0 != pthread_create(&producer, NULL, queueProducer, NULL)) {
+    printf("frameq    FAIL (pthread_create)\n");
+    return 1;
+  }
+
+  for (uint32_t seq = 0; seq < QUEUE_ITEMS; ++seq) {
+    while (uSuccess != FrameQueue_Pop(&queue, &item)) {
+      sched_yield();
+    }
+    const uint32_t count = FrameQueue_Count(&queue);
+    maxCount = (count > maxCount) ? count : maxCount;
+    makeItem(seq, &expect);
+    if (0 != memcmp(&item, &expect, sizeof(item))) {
+      if (failures < 8) {
+        printf("frameq    item %u: buffer %u flags %u (expected %u %u)\n", seq, item.buffer, item.flags, expect.buffer, expect.flags);
+      }
+      ++failures;
+    }
+  }
+  (void)pthread_join(producer, NULL);
+
+  if (uSuccess == FrameQueue_Pop(&queue, &item) || FRAMEQ_CAPACITY < maxCount) {
+    printf("frameq    FAIL (queue is not empty, or count %u exceeds the capacity)\n", maxCount);
+    ++failures;
+  }
+  printf("frameq    %u items, max count %u, %u mismatches\n", QUEUE_ITEMS, maxCount, failures);
+  return failures;
+}
+
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len) {
+  PipeCheck_t* const c = (PipeCheck_t*)arg;
+  (void)spi;
+  if (!c->dc) {
+    c->writing = (1 == len && 0x2c == src[0]);
+    if (c->writing) {
+      c->windows++;
+      c->bytes = 0;
+    }
+    return;
+  }
+  if (c->writing) {
+    // 1フレームは上下 2つの領域. 領域の全ピクセルがそのフレームの色であること
+    const uint8_t expect = (uint8_t)frameColor((c->windows - 1) / 2);
+    for (size_t i = 0; i < len; ++i) {
+      if (expect != src[i]) {
+        if (c->errors < 8) {
+          printf("lcdpipe   window %u byte %u: 0x%02x (expected 0x%02x)\n", c->windows - 1, c->bytes + (uint32_t)i, src[i], expect);
+        }
+        c->errors++;
+      }
+    }
+    c->bytes += (uint32_t)len;
+  }
+}
+
+static void hookGpioPut(void* arg, uint32_t gpio, bool value) {
+  PipeCheck_t* const c = (PipeCheck_t*)arg;
+  if (gpio == c->dcPin) {
+    c->dc = value;
+  }
+}
+
+static void* pipeConsumer(void* arg) {
+  (void)arg;
+  // 投入し終えた後に残った領域も転送する
+  while (true) {
+    const bool done = atomic_load_explicit(&pipeDone, memory_order_acquire);
+    (void)LCDPipe_Service(&pipe, NULL);
+    if (done) {
+      break;
+    }
+    sched_yield();
+  }
+  (void)LCDDrv_WaitForTransfer(&lcd);
+  return NULL;
+}
+
+static uint32_t checkPipe(void) {
+  uint32_t failures = 0;
+  UError_t err = uSuccess;
+  pthread_t consumer;
+  const Canvas_t* canvases[PIPE_BUFFERS];
+  const CanvasRect_t rects[2] = {{0, 0, PIPE_W, PIPE_H / 2}, {0, PIPE_H / 2, PIPE_W, PIPE_H / 2}};
+
+  for (uint32_t i = 0; i < PIPE_BUFFERS; ++i) {
+    (void)Canvas_Create(&pipeCanvas[i], PIPE_W, PIPE_H, PIPE_W, pipeFb[i]);
+    canvases[i] = &pipeCanvas[i];
+  }
+  if (uSuccess == err) {
+    err = SPIDrv_Create(&spi);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Create(&lcd, &spi);
+  }
+  if (uSuccess == err) {
+    const HostHalHooks_t hooks = {
+        .spiWrite = hookSpiWrite,
+        .gpioPut = hookGpioPut,
+        .arg = &pipeCheck,
+    };
+    memset(&pipeCheck, 0, sizeof(pipeCheck));
+    pipeCheck.dcPin = lcd.dc;
+    pipeCheck.dc = true;
+    HostHal_SetHooks(&hooks);
+    err = SPIDrv_Init(&spi, 25000000);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Init(&lcd);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_InitalizeHW(&lcd);
+  }
+  if (uSuccess == err) {
+    // 初期化で送った RAMWR (全画面の消去) は数えない
+    pipeCheck.windows = 0;
+    pipeCheck.writing = false;
+    err = LCDPipe_Create(&pipe, &lcd, canvases, PIPE_BUFFERS);
+  }
+  if (uSuccess != err) {
+    printf("lcdpipe   FAIL (initialize)\n");
+    HostHal_SetHooks(NULL);
+    return 1;
+  }
+
+  // このスレッドが生産者 (描画側), consumer が転送側
+  atomic_init(&pipeDone, false);
+  if (0 != pthread_create(&consumer, NULL, pipeConsumer, NULL)) {
+    printf("lcdpipe   FAIL (pthread_create)\n");
+    HostHal_SetHooks(NULL);
+    return 1;
+  }
+  for (uint32_t f = 0; f < PIPE_FRAMES; ++f) {
+    uint32_t index = 0;
+    while (uSuccess != LCDPipe_Acquire(&pipe, &index)) {
+      sched_yield();
+    }
+    (void)Canvas_Clear(&pipeCanvas[index], frameColor(f));
+    while (uSuccess != LCDPipe_Submit(&pipe, index, rects, 2)) {
+      sched_yield();
+    }
+  }
+  atomic_store_explicit(&pipeDone, true, memory_order_release);
+  (void)pthread_join(consumer, NULL);
+  HostHal_SetHooks(NULL);
+
+  failures += pipeCheck.errors;
+  if (PIPE_FRAMES * 2 != pipeCheck.windows) {
+    printf("lcdpipe   FAIL (%u windows, expected %u)\n", pipeCheck.windows, PIPE_FRAMES * 2);
+    ++failures;
+  }
+  printf("lcdpipe   %u frames, %u windows, %u mismatches\n", PIPE_FRAMES, pipeCheck.windows, failures);
+  return failures;
+}
+
+static void otherCore1Entry(void) {
+  while (true) {
+    tight_loop_contents();
+  }
+}
+
+static uint32_t checkCore1(void) {
+  uint32_t failures = 0;
+  // checkPipe() で初期化したパイプラインを core1 で起動する
+  const bool launched = (uSuccess == Core1_Launch(otherCore1Entry));
+  const bool launchedTwice = (uSuccess == Core1_Launch(otherCore1Entry));
+  const bool pipeWhileUsed = (uSuccess == LCDPipe_Start(&pipe));
+  const bool reset = (uSuccess == Core1_Reset());
+  const bool pipeStarted = (uSuccess == LCDPipe_Start(&pipe));
+  const bool launchedAfterPipe = (uSuccess == Core1_Launch(otherCore1Entry));
+  (void)Core1_Reset();
+
+  if (!launched || launchedTwice || pipeWhileUsed || !reset || !pipeStarted || launchedAfterPipe) {
+    printf("core1     FAIL (launch %d, twice %d, pipe while used %d, reset %d, pipe %d, launch after pipe %d)\n", launched, launchedTwice,
+           pipeWhileUsed, reset, pipeStarted, launchedAfterPipe);
+    ++failures;
+  }
+  printf("core1     %u mismatches\n", failures);
+  return failures;
+}
+
+int main(void) {
+  uint32_t failures = 0;
+  failures += checkQueue();
+  failures += checkPipe();
+  failures += checkCore1();
+  printf("frameqtest: %s\n", (0 == failures) ? "ok" : "FAILED");
+  return (0 == failures) ? 0 : 1;
+}
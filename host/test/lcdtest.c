@@ -0,0 +1,297 @@
+/**
+ * @file prog01/host/test/lcdtest.c
+ * 12bit/pixel (RGB444) 転送の検査 (ホストビルド)
+ *
+ * 次の項目を検査し, 不一致があれば終了コード 1 を返します (ctest から実行).
+ *   pack   : LCDDrv_PackRGB444() の出力が 1ピクセルずつ手で詰めた参照と一致するか (0 - 9 pixel, 同じ領域への変換を含む)
+ *   swap   : LCDDrv_SwapBuff() / LCDDrv_SwapCanvas() が RAMWR の後に送るデータ全体が参照と一致するか.
+ *            偶数幅, 奇数幅 (最後の 2pixel が半分だけ), 展開バッファ 2面の切り替えをまたぐ大きさを検査し,
+ *            続けて行う転送が展開バッファの 2面を交互に使用するかを確かめる
+ * 送信データはスタブ HAL (hosthal.h) の監視関数で受け取ります.
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hosthal.h>
+#include <user/canvas.h>
+#include <user/lcddrv.h>
+#include <user/spidrv.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CAPTURE_SIZE (320 * 240 * 2)  //< 受け取るデータの最大サイズ (単位: byte)
+#define MAX_SENDS (256)               //< 記録する送信の数
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 監視関数で受け取った送信内容 (最後の RAMWR 以降のデータ)
+ */
+typedef struct tagCapture_t {
+  uint32_t dcPin;
+  bool dc;         //< D/C 信号 (true: データ)
+  bool writing;    //< RAMWR の後
+  size_t size;     //< data のサイズ
+  uint32_t sends;  //< RAMWR の後のデータ送信の回数
+  const uint8_t* src[MAX_SENDS];
+  uint8_t data[CAPTURE_SIZE];
+} Capture_t;
+
+/**
+ * 転送の検査項目
+ */
+typedef struct tagSwapCase_t {
+  const char* name;
+  bool canvas;  //< true: LCDDrv_SwapCanvas(), false: LCDDrv_SwapBuff()
+  uint16_t w;
+  uint16_t h;
+} SwapCase_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len);
+static void hookGpioPut(void* arg, uint32_t gpio, bool value);
+
+/**
+ * @brief 参照: RGB565 (キャンバスと同じ格納順) を 1ピクセルずつ R, G, B の上位 4bit に分け, 4bit 単位で上位から詰める
+ * @return 格納したバイト数
+ */
+static size_t referenceRGB444(const uint16_t* src, size_t n, uint8_t* dst);
+
+static uint32_t checkLiteral(void);
+static uint32_t checkPack(void);
+static uint32_t checkSwap(void);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static const SwapCase_t swapCases[] = {
+    {"buff/1x1", false, 1, 1},          //< 半分の 2pixel のみ
+    {"buff/240x1", false, 240, 1},      //< 偶数幅
+    {"buff/61x33", false, 61, 33},      //< 奇数幅. 展開バッファ 3面分 (最後は奇数ピクセル)
+    {"buff/240x12", false, 240, 12},    //< 展開バッファ 3面ちょうど
+    {"canvas/1x1", true, 1, 1},         //< 半分の 2pixel のみ
+    {"canvas/240x13", true, 240, 13},   //< 偶数幅. 4行ずつ 4面 (最後は 1行)
+    {"canvas/61x40", true, 61, 40},     //< 奇数幅. 14行ずつ 3面 (途中の面は偶数ピクセル)
+    {"canvas/239x9", true, 239, 9},     //< 奇数幅. 4行ずつ 3面 (最後は 1行の奇数ピクセル)
+    {"canvas/7x300", true, 7, 300},     //< 奇数幅. 136行ずつ 3面
+};
+
+static Capture_t capture;
+static SPIDrvContext_t spi;
+static LCDDrvContext_t lcd;
+static uint16_t frame[240 * 320];
+static uint8_t expect[CAPTURE_SIZE];
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static void hookSpiWrite(void* arg, spi_inst_t* spi, const uint8_t* src, size_t len) {
+  Capture_t* const c = (Capture_t*)arg;
+  (void)spi;
+  if (!c->dc) {
+    // コマンド: RAMWR (0x2C) から次のコマンドまでのデータを受け取る
+    c->writing = (1 == len && 0x2c == src[0]);
+    if (c->writing) {
+      c->size = 0;
+      c->sends = 0;
+    }
+    return;
+  }
+  if (c->writing) {
+    if (c->sends < MAX_SENDS) {
+      c->src[c->sends] = src;
+    }
+    ++c->sends;
+    if (c->size + len <= CAPTURE_SIZE) {
+      memcpy(&c->data[c->size], src, len);
+    }
+    c->size += len;
+  }
+}
+
+static void hookGpioPut(void* arg, uint32_t gpio, bool value) {
+  Capture_t* const c = (Capture_t*)arg;
+  if (gpio == c->dcPin) {
+    c->dc = value;
+  }
+}
+
+static size_t referenceRGB444(const uint16_t* src, size_t n, uint8_t* dst) {
+  size_t nibbles = 0;
+  memset(dst, 0, ((n * 3) + 1) / 2);
+  for (size_t i = 0; i < n; ++i) {
+    // 格納順を戻すと RRRRRGGG GGGBBBBB
+    const uint32_t c = (uint32_t)((src[i] << 8) | (src[i] >> 8)) & 0xffff;
+    const uint32_t rgb[3] = {(c >> 12) & 0x0f, (c >> 7) & 0x0f, (c >> 1) & 0x0f};
+    for (size_t k = 0; k < 3; ++k) {
+      dst[nibbles / 2] |= (uint8_t)((0 == (nibbles & 1)) ? (rgb[k] << 4) : rgb[k]);
+      ++nibbles;
+    }
+  }
+  // 奇数ピクセルの場合, 最後の 4bit は 0 で埋める
+  return (nibbles + 1) / 2;
+}
+
+static uint32_t checkLiteral(void) {
+  // 赤, 緑, 青 (RGB565 0xF800, 0x07E0, 0x001F をキャンバスの格納順にしたもの)
+  static const uint16_t src[3] = {0x00f8, 0xe007, 0x1f00};
+  static const uint8_t bytes[5] = {0xf0, 0x00, 0xf0, 0x00, 0xf0};
+  uint8_t out[8];
+  memset(out, 0xcc, sizeof(out));
+  const size_t size = LCDDrv_PackRGB444(src, 3, out);
+  if (sizeof(bytes) != size || 0 != memcmp(out, bytes, sizeof(bytes)) || 0xcc != out[sizeof(bytes)]) {
+    printf("literal   FAIL (%zu bytes: %02x %02x %02x %02x %02x)\n", size, out[0], out[1], out[2], out[3], out[4]);
+    return 1;
+  }
+  return 0;
+}
+
+static uint32_t checkPack(void) {
+  uint32_t failures = 0;
+  uint16_t src[16];
+  uint16_t inplace[16];
+  uint8_t out[32];
+  uint8_t ref[32];
+
+  for (uint32_t seed = 0; seed < 64; ++seed) {
+    for (size_t i = 0; i < 16; ++i) {
+      src[i] = (uint16_t)((seed * 0x9e37u) ^ (i * 0x79b9u) ^ (i << 11));
+    }
+    for (size_t n = 0; n <= 9; ++n) {
+      memset(out, 0xcc, sizeof(out));
+      const size_t size = LCDDrv_PackRGB444(src, n, out);
+      const size_t refSize = referenceRGB444(src, n, ref);
+      // 格納したバイト数より先は書き換えない
+      bool ok = (refSize == size) && (0 == memcmp(out, ref, size)) && (0xcc == out[size]);
+
+      // 同じ領域への変換 (LCDDrv_Clear(), LCDDrv_SwapCanvas() の使い方)
+      memcpy(inplace, src, sizeof(inplace));
+      const size_t sizeInPlace = LCDDrv_PackRGB444(inplace, n, (uint8_t*)inplace);
+      ok = ok && (refSize == sizeInPlace) && (0 == memcmp(inplace, ref, refSize));
+      if (!ok) {
+        if (failures < 8) {
+          printf("pack      seed %u n %zu FAIL\n", seed, n);
+        }
+        ++failures;
+      }
+    }
+  }
+  return failures;
+}
+
+static uint32_t checkSwap(void) {
+  uint32_t failures = 0;
+  Canvas_t canvas;
+
+  for (size_t i = 0; i < sizeof(frame) / sizeof(frame[0]); ++i) {
+    frame[i] = (uint16_t)((i * 0x9e37u) ^ (i >> 3));
+  }
+  (void)Canvas_Create(&canvas, 240, 320, 240, frame);
+
+  for (size_t k = 0; k < sizeof(swapCases) / sizeof(swapCases[0]); ++k) {
+    const SwapCase_t* const t = &swapCases[k];
+    // SwapCanvas はキャンバスの (3, 5) から (幅が足りない場合は右端に揃える), SwapBuff は frame の先頭から連続した w * h pixel を送る
+    const uint16_t x = t->canvas ? (uint16_t)((240 - t->w < 3) ? 240 - t->w : 3) : 0;
+    const uint16_t y = t->canvas ? 5 : 0;
+    size_t refSize = 0;
+    if (t->canvas) {
+      static uint16_t rows[240 * 320];
+      for (uint16_t j = 0; j < t->h; ++j) {
+        memcpy(&rows[(size_t)j * t->w], &frame[((size_t)(y + j) * 240) + x], t->w * sizeof(uint16_t));
+      }
+      refSize = referenceRGB444(rows, (size_t)t->w * t->h, expect);
+    } else {
+      refSize = referenceRGB444(frame, (size_t)t->w * t->h, expect);
+    }
+
+    capture.writing = false;
+    capture.size = 0;
+    const UError_t err = t->canvas ? LCDDrv_SwapCanvas(&lcd, &canvas, x, y, t->w, t->h) : LCDDrv_SwapBuff(&lcd, frame, x, y, t->w, t->h);
+    (void)LCDDrv_WaitForTransfer(&lcd);
+
+    const bool ok = (uSuccess == err) && (refSize == capture.size) && (0 == memcmp(capture.data, expect, refSize));
+    printf("swap      %-14s %u sends, %zu bytes%s", t->name, capture.sends, capture.size, ok ? "\n" : "");
+    if (!ok) {
+      size_t at = 0;
+      while (at < refSize && at < capture.size && at < CAPTURE_SIZE && capture.data[at] == expect[at]) {
+        ++at;
+      }
+      printf(" FAIL (err %d, expected %zu bytes, first difference at %zu)\n", (int)err, refSize, at);
+      ++failures;
+    }
+
+    // 2回目以降の送信は直前と異なる展開バッファを使用する
+    bool alternate = true;
+    for (uint32_t s = 1; s < capture.sends && s < MAX_SENDS; ++s) {
+      const bool inExpand = (capture.src[s] >= (const uint8_t*)lcd.expand[0]) && (capture.src[s] < (const uint8_t*)lcd.expand[2]);
+      alternate = alternate && inExpand && (capture.src[s] != capture.src[s - 1]);
+    }
+    if (!alternate) {
+      printf("swap      %-14s FAIL (expand buffers are not used alternately)\n", t->name);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+int main(void) {
+  uint32_t failures = 0;
+  UError_t err = uSuccess;
+
+  if (uSuccess == err) {
+    err = SPIDrv_Create(&spi);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Create(&lcd, &spi);
+  }
+  if (uSuccess == err) {
+    const HostHalHooks_t hooks = {
+        .spiWrite = hookSpiWrite,
+        .gpioPut = hookGpioPut,
+        .arg = &capture,
+    };
+    capture.dcPin = lcd.dc;
+    capture.dc = true;
+    HostHal_SetHooks(&hooks);
+    err = SPIDrv_Init(&spi, 25000000);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_Init(&lcd);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_InitalizeHW(&lcd);
+  }
+  if (uSuccess == err) {
+    err = LCDDrv_SetPixelFormat(&lcd, LCDDrvRGB444);
+  }
+  if (uSuccess != err) {
+    printf("lcdtest: failed to initialize the LCD driver\n");
+    return 1;
+  }
+
+  failures += checkLiteral();
+  failures += checkPack();
+  failures += checkSwap();
+  HostHal_SetHooks(NULL);
+  printf("lcdtest: %s\n", (0 == failures) ? "ok" : "FAILED");
+  return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,640 @@
+/**
+ * @file prog01/host/tools/drawreplay.c
+ * 描画関数の記録 (drawrec.h) の再生と計測 (ホストビルド)
+ *
+ * 入力から magic "DRWR" を探してチャンクを読み出すため, UART のテキスト出力が混在したログもそのまま再生できます.
+ * 記録した Canvas_* の呼び出しを, リンクした Canvas の実装 (CMake の DRAWREPLAY_CANVAS_SRC) で順に再実行し,
+ * 全体の時間 (-n 回の最小値), フレームごとの時間, 描画関数の種類ごとの呼び出し回数と時間を表示します.
+ * キャンバスは記録したアドレスと大きさ・形式ごとに確保します. インデックスカラーのパレットと Canvas_Blit() の
+ * 転送元は記録されないため, 仮の内容を使用します. Font_PrintWith() は何も描画しない描画関数で呼び出し,
+ * 文字列の解釈とグリフの検索の時間を計測します (未登録のフォントは組み込みの ANK フォントで代用).
+ * -o を指定すると, 最も大きい RGB565 のキャンバスの再生結果を PPM で出力します.
+ *   drawreplay [-n 繰り返し回数] [-v] [-o PPM出力先] 入力ファイル
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <user/canvas.h>
+#include <user/drawrec.h>
+#include <user/font.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CHUNK_SIZE (16)  //< DrawRecChunk_t のバイト数
+
+#define CANVAS_MAX_SIDE (4096)  //< 再生するキャンバスの幅・高さ・ストライドの上限 (壊れた記録の読み飛ばし)
+#define REPLAY_CANVASES (64)    //< 全チャンクで区別できるキャンバスの数
+#define OPS (0x40)              //< 記録の種類の値の上限
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagReplayCmd_t {
+  uint8_t op;      //< DrawRecOp_t (キャンバスの定義は DrawRecOpClip として再生する)
+  uint8_t canvas;  //< 再生するキャンバスの番号 (ReplayCanvas_t)
+  uint32_t args[DRAWREC_MAX_ARGS];
+  char* text;  //< DrawRecOpText の文字列 (NUL 終端)
+} ReplayCmd_t;
+
+typedef struct tagReplayCanvas_t {
+  uint32_t addr;  //< 記録したバッファのアドレス
+  size_t w;
+  size_t h;
+  size_t s;
+  CanvasFormat_t fmt;
+  void* mem;
+  Canvas_t canvas;
+} ReplayCanvas_t;
+
+typedef struct tagReplay_t {
+  ReplayCmd_t* cmds;
+  size_t count;
+  size_t capacity;
+  ReplayCanvas_t canvases[REPLAY_CANVASES];
+  size_t nCanvases;
+  uint16_t* blitSrc;  //< Canvas_Blit() の仮の転送元
+  size_t blitSize;    //< 転送元に必要な要素数
+  // 集計
+  size_t chunks;
+  size_t frames;
+  uint64_t dropped;
+  size_t broken;  //< 解釈できなかったチャンク
+} Replay_t;
+
+typedef struct tagReplayStat_t {
+  uint64_t calls;
+  uint64_t ns;
+} ReplayStat_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 入力全体からチャンクを探して読み出す
+ */
+static UError_t parse(Replay_t* ctx, const uint8_t* data, size_t size);
+
+/**
+ * @brief 1チャンクの記録を命令へ展開する
+ * @return 解釈できた場合 true
+ */
+static bool parseChunk(Replay_t* ctx, const uint8_t* data, size_t size);
+
+/**
+ * @brief 命令を追加する
+ */
+static UError_t push(Replay_t* ctx, const ReplayCmd_t* cmd);
+
+/**
+ * @brief 記録したキャンバスに対応する再生用のキャンバスを返す (初出の場合は確保する)
+ * @return キャンバスの番号 (-1: 失敗)
+ */
+static int32_t defineCanvas(Replay_t* ctx, const uint32_t* def);
+
+/**
+ * @brief 全ての命令を再生する
+ * @param [in] frameNs : NULL 以外の場合, フレームごとの時間を格納する
+ * @param [in] stats : NULL 以外の場合, 種類ごとの呼び出し回数と時間を加算する (計測の分だけ遅くなる)
+ * @return 全体の時間 (単位: ns)
+ */
+static uint64_t replay(Replay_t* ctx, uint64_t* frameNs, ReplayStat_t* stats);
+
+/**
+ * @brief 1命令を実行する
+ */
+static void execute(Replay_t* ctx, const ReplayCmd_t* cmd);
+
+/**
+ * @brief 何も描画しない描画関数 (Font_DrawFontFn_t)
+ */
+static UError_t skipGlyph(void* arg, uint32_t x, uint32_t y, const void* fp, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief RGB565 (バイト入れ替え済み) のキャンバスを PPM で書き出す
+ */
+static UError_t writePPM(const Canvas_t* canvas, const char* path);
+
+static const char* opName(uint8_t op);
+static uint64_t nowNs(void);
+
+/**
+ * @brief リトルエンディアンの値を読み出す
+ */
+static uint16_t readU16(const uint8_t* p);
+static uint32_t readU32(const uint8_t* p);
+
+/**
+ * @brief 符号なし LEB128 を読み出す
+ * @return 読み出せた場合 true
+ */
+static bool readVarint(const uint8_t* data, size_t size, size_t* pos, uint32_t* v);
+
+/**
+ * @brief ファイル全体を読み込む
+ * @return 読み込んだデータ (呼び出し側で free する. NULL: 失敗)
+ */
+static uint8_t* loadFile(const char* path, size_t* size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 種類ごとの引数の数 (キャンバス番号を除く. -1: 未定義の種類)
+ */
+static int8_t opArgs[OPS];
+
+static uint16_t palette[256];  //< インデックスカラーの仮のパレット
+
+static Replay_t rec;
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t readU32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static bool readVarint(const uint8_t* data, size_t size, size_t* pos, uint32_t* v) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0; shift < 35 && *pos < size; shift += 7) {
+    const uint8_t b = data[(*pos)++];
+    value |= (uint32_t)(b & 0x7fu) << shift;
+    if (0 == (b & 0x80u)) {
+      *v = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static const char* opName(uint8_t op) {
+  switch (op) {
+    case DrawRecOpClip:
+      return "clip";
+    case DrawRecOpClear:
+      return "clear";
+    case DrawRecOpPixel:
+      return "pixel";
+    case DrawRecOpLine:
+      return "line";
+    case DrawRecOpCircle:
+      return "circle";
+    case DrawRecOpFillCircle:
+      return "fill_circle";
+    case DrawRecOpFillRect:
+      return "fill_rect";
+    case DrawRecOpBlit:
+      return "blit";
+    case DrawRecOpScroll:
+      return "scroll";
+    case DrawRecOpText:
+      return "text";
+    default:
+      return NULL;
+  }
+}
+
+static UError_t push(Replay_t* ctx, const ReplayCmd_t* cmd) {
+  if (ctx->count == ctx->capacity) {
+    const size_t capacity = (0 < ctx->capacity) ? ctx->capacity * 2 : 1024;
+    ReplayCmd_t* const cmds = (ReplayCmd_t*)realloc(ctx->cmds, sizeof(ReplayCmd_t) * capacity);
+    if (NULL == cmds) {
+      return uFailure;
+    }
+    ctx->cmds = cmds;
+    ctx->capacity = capacity;
+  }
+  ctx->cmds[ctx->count++] = *cmd;
+  return uSuccess;
+}
+
+static int32_t defineCanvas(Replay_t* ctx, const uint32_t* def) {
+  const uint32_t addr = def[0];
+  const size_t w = def[1];
+  const size_t h = def[2];
+  const size_t s = def[3];
+  const uint32_t fmt = def[4];
+
+  if (0 == w || 0 == h || CANVAS_MAX_SIDE < w || CANVAS_MAX_SIDE < h || CANVAS_MAX_SIDE < s || s < w || CanvasIndexed8 < fmt) {
+    return -1;
+  }
+  for (size_t i = 0; i < ctx->nCanvases; ++i) {
+    const ReplayCanvas_t* const rc = &ctx->canvases[i];
+    if (rc->addr == addr && rc->w == w && rc->h == h && rc->s == s && rc->fmt == (CanvasFormat_t)fmt) {
+      return (int32_t)i;
+    }
+  }
+  if (REPLAY_CANVASES <= ctx->nCanvases) {
+    return -1;
+  }
+
+  ReplayCanvas_t* const rc = &ctx->canvases[ctx->nCanvases];
+  rc->addr = addr;
+  rc->w = w;
+  rc->h = h;
+  rc->s = s;
+  rc->fmt = (CanvasFormat_t)fmt;
+  rc->mem = calloc(s * h, sizeof(uint16_t));  // インデックスカラーの 1行は s byte 以下
+  if (NULL == rc->mem) {
+    return -1;
+  }
+  const UError_t err = (CanvasRGB565 == rc->fmt) ? Canvas_Create(&rc->canvas, w, h, s, rc->mem)
+                                                 : Canvas_CreateIndexed(&rc->canvas, w, h, s, rc->mem, rc->fmt, palette);
+  if (uSuccess != err) {
+    free(rc->mem);
+    return -1;
+  }
+  return (int32_t)ctx->nCanvases++;
+}
+
+static bool parseChunk(Replay_t* ctx, const uint8_t* data, size_t size) {
+  int32_t ids[DRAWREC_CANVASES];  // チャンク内のキャンバス番号 -> 再生用のキャンバスの番号
+  size_t pos = 0;
+
+  for (size_t i = 0; i < DRAWREC_CANVASES; ++i) {
+    ids[i] = -1;
+  }
+
+  while (pos < size) {
+    ReplayCmd_t cmd = {.op = data[pos++]};
+
+    if (DrawRecOpFrame == cmd.op) {
+      if (uSuccess != push(ctx, &cmd)) {
+        return false;
+      }
+      ++ctx->frames;
+      continue;
+    }
+
+    if (DrawRecOpText == cmd.op) {
+      uint32_t len = 0;
+      if (!readVarint(data, size, &pos, &cmd.args[0]) || !readVarint(data, size, &pos, &cmd.args[1]) || !readVarint(data, size, &pos, &len) ||
+          size - pos < len) {
+        return false;
+      }
+      cmd.text = (char*)malloc((size_t)len + 1);
+      if (NULL == cmd.text) {
+        return false;
+      }
+      memcpy(cmd.text, data + pos, len);
+      cmd.text[len] = '\0';
+      pos += len;
+      if (uSuccess != push(ctx, &cmd)) {
+        free(cmd.text);
+        return false;
+      }
+      continue;
+    }
+
+    // キャンバスの操作
+    if (OPS <= cmd.op || 0 > opArgs[cmd.op] || size <= pos) {
+      return false;
+    }
+    const uint8_t id = data[pos++];
+    if (DRAWREC_CANVASES <= id) {
+      return false;
+    }
+    for (int8_t i = 0; i < opArgs[cmd.op]; ++i) {
+      if (!readVarint(data, size, &pos, &cmd.args[i])) {
+        return false;
+      }
+    }
+
+    if (DrawRecOpCanvas == cmd.op) {
+      ids[id] = defineCanvas(ctx, cmd.args);
+      if (0 > ids[id]) {
+        return false;
+      }
+      // 定義時の描画できる領域を設定する命令として再生する
+      cmd.op = DrawRecOpClip;
+      memmove(&cmd.args[0], &cmd.args[5], sizeof(uint32_t) * 4);
+    }
+    if (0 > ids[id]) {
+      return false;  // 定義のないキャンバス
+    }
+    cmd.canvas = (uint8_t)ids[id];
+
+    if (DrawRecOpBlit == cmd.op) {
+      // 転送元は 切り詰めた高さ - 1 行分のストライド + 幅 の要素が必要
+      const ReplayCanvas_t* const rc = &ctx->canvases[cmd.canvas];
+      const size_t w = (cmd.args[2] < rc->w) ? cmd.args[2] : rc->w;
+      const size_t h = (cmd.args[3] < rc->h) ? cmd.args[3] : rc->h;
+      const size_t need = (0 < h) ? ((h - 1) * (size_t)cmd.args[4]) + w : 0;
+      if (ctx->blitSize < need) {
+        ctx->blitSize = need;
+      }
+    }
+    if (uSuccess != push(ctx, &cmd)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static UError_t parse(Replay_t* ctx, const uint8_t* data, size_t size) {
+  size_t pos = 0;
+
+  while (CHUNK_SIZE <= size - pos) {
+    // magic を探す (テキスト出力の読み飛ばし)
+    if (0 != memcmp(data + pos, DRAWREC_MAGIC, 4)) {
+      ++pos;
+      continue;
+    }
+    const uint16_t version = readU16(data + pos + 4);
+    const uint32_t len = readU32(data + pos + 8);
+    if (DRAWREC_VERSION != version || size - pos - CHUNK_SIZE < len) {
+      ++pos;  // 偶然一致した, または途中で切れたチャンク
+      continue;
+    }
+    ctx->dropped += readU32(data + pos + 12);
+    ++ctx->chunks;
+
+    // 途中で解釈できなくなった場合も, それまでの命令は再生する
+    if (!parseChunk(ctx, data + pos + CHUNK_SIZE, len)) {
+      ++ctx->broken;
+    }
+    pos += CHUNK_SIZE + len;
+  }
+
+  if (0 < ctx->blitSize) {
+    ctx->blitSrc = (uint16_t*)malloc(sizeof(uint16_t) * ctx->blitSize);
+    if (NULL == ctx->blitSrc) {
+      return uFailure;
+    }
+    for (size_t i = 0; i < ctx->blitSize; ++i) {
+      ctx->blitSrc[i] = (uint16_t)(i * 0x9e37u);
+    }
+  }
+
+  return uSuccess;
+}
+
+static UError_t skipGlyph(void* arg, uint32_t x, uint32_t y, const void* fp, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  (void)arg;
+  (void)x;
+  (void)y;
+  (void)fp;
+  (void)c;
+  (void)fw;
+  (void)fh;
+  (void)fsz;
+  return uSuccess;
+}
+
+static void execute(Replay_t* ctx, const ReplayCmd_t* cmd) {
+  Canvas_t* const canvas = &ctx->canvases[cmd->canvas].canvas;
+  const uint32_t* const a = cmd->args;
+
+  switch (cmd->op) {
+    case DrawRecOpClip:
+      (void)Canvas_SetClip(canvas, a[0], a[1], a[2], a[3]);
+      break;
+    case DrawRecOpClear:
+      (void)Canvas_Clear(canvas, (uint16_t)a[0]);
+      break;
+    case DrawRecOpPixel:
+      (void)Canvas_DrawPixel(canvas, a[0], a[1], (uint16_t)a[2]);
+      break;
+    case DrawRecOpLine:
+      (void)Canvas_DrawLine(canvas, a[0], a[1], a[2], a[3], (uint16_t)a[4]);
+      break;
+    case DrawRecOpCircle:
+      (void)Canvas_DrawCircle(canvas, a[0], a[1], a[2], (uint16_t)a[3]);
+      break;
+    case DrawRecOpFillCircle:
+      (void)Canvas_DrawFillCircle(canvas, a[0], a[1], a[2], (uint16_t)a[3]);
+      break;
+    case DrawRecOpFillRect:
+      (void)Canvas_FillRect(canvas, a[0], a[1], a[2], a[3], (uint16_t)a[4]);
+      break;
+    case DrawRecOpBlit:
+      (void)Canvas_Blit(canvas, a[0], a[1], a[2], a[3], ctx->blitSrc, a[4]);
+      break;
+    case DrawRecOpScroll:
+      (void)Canvas_Scroll(canvas, a[0], a[1], a[2], a[3], (int32_t)a[4], (int32_t)a[5], (uint16_t)a[6]);
+      break;
+    case DrawRecOpText: {
+      // 未登録のフォントは組み込みの ANK フォントで代用する
+      const FontId_t ank = (NULL != Font_Get((FontId_t)a[0])) ? (FontId_t)a[0] : FONT_ID_ANK;
+      const FontId_t kanji = (NULL != Font_Get((FontId_t)a[1])) ? (FontId_t)a[1] : FONT_ID_NONE;
+      (void)Font_PrintWith(ank, kanji, cmd->text, skipGlyph, NULL);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+static uint64_t replay(Replay_t* ctx, uint64_t* frameNs, ReplayStat_t* stats) {
+  size_t frame = 0;
+  const uint64_t begin = nowNs();
+  uint64_t mark = begin;
+
+  for (size_t i = 0; i < ctx->count; ++i) {
+    const ReplayCmd_t* const cmd = &ctx->cmds[i];
+    if (DrawRecOpFrame == cmd->op) {
+      if (NULL != frameNs) {
+        const uint64_t now = nowNs();
+        frameNs[frame] = now - mark;
+        mark = now;
+      }
+      ++frame;
+    } else if (NULL != stats) {
+      const uint64_t t0 = nowNs();
+      execute(ctx, cmd);
+      stats[cmd->op].ns += nowNs() - t0;
+      ++stats[cmd->op].calls;
+    } else {
+      execute(ctx, cmd);
+    }
+  }
+
+  return nowNs() - begin;
+}
+
+static UError_t writePPM(const Canvas_t* canvas, const char* path) {
+  FILE* const fp = fopen(path, "wb");
+  if (NULL == fp) {
+    return uFailure;
+  }
+
+  fprintf(fp, "P6\n%u %u\n255\n", (unsigned)canvas->w, (unsigned)canvas->h);
+  for (size_t y = 0; y < canvas->h; ++y) {
+    const uint16_t* const row = (const uint16_t*)canvas->buf + (y * canvas->s);
+    for (size_t x = 0; x < canvas->w; ++x) {
+      const uint16_t c = (uint16_t)((row[x] << 8) | (row[x] >> 8));  // 格納順を戻す
+      const uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xf8), (uint8_t)((c >> 3) & 0xfc), (uint8_t)((c << 3) & 0xf8)};
+      fwrite(rgb, 1, sizeof(rgb), fp);
+    }
+  }
+  fclose(fp);
+
+  return uSuccess;
+}
+
+static uint8_t* loadFile(const char* path, size_t* size) {
+  uint8_t* data = NULL;
+  FILE* const fp = fopen(path, "rb");
+
+  if (NULL != fp) {
+    if (0 == fseek(fp, 0, SEEK_END)) {
+      const long len = ftell(fp);
+      if (0 <= len && 0 == fseek(fp, 0, SEEK_SET)) {
+        data = (uint8_t*)malloc((0 < len) ? (size_t)len : 1u);
+        if (NULL != data && (size_t)len != fread(data, 1, (size_t)len, fp)) {
+          free(data);
+          data = NULL;
+        }
+        *size = (size_t)len;
+      }
+    }
+    fclose(fp);
+  }
+
+  return data;
+}
+
+int main(int argc, char* argv[]) {
+  const char* path = NULL;
+  const char* ppm = NULL;
+  uint32_t repeats = 5;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+      repeats = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-o") && i + 1 < argc) {
+      ppm = argv[++i];
+    } else if (0 == strcmp(argv[i], "-v")) {
+      verbose = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (NULL == path || 0 == repeats) {
+    fprintf(stderr, "usage: %s [-n repeats] [-v] [-o out.ppm] dump.bin\n", argv[0]);
+    return 2;
+  }
+
+  for (uint32_t op = 0; op < OPS; ++op) {
+    opArgs[op] = -1;
+  }
+  opArgs[DrawRecOpCanvas] = 9;
+  opArgs[DrawRecOpClip] = 4;
+  opArgs[DrawRecOpClear] = 1;
+  opArgs[DrawRecOpPixel] = 3;
+  opArgs[DrawRecOpLine] = 5;
+  opArgs[DrawRecOpCircle] = 4;
+  opArgs[DrawRecOpFillCircle] = 4;
+  opArgs[DrawRecOpFillRect] = 5;
+  opArgs[DrawRecOpBlit] = 5;
+  opArgs[DrawRecOpScroll] = 7;
+  for (size_t i = 0; i < sizeof(palette) / sizeof(palette[0]); ++i) {
+    palette[i] = (uint16_t)(i * 0x0101u);
+  }
+
+  size_t size = 0;
+  uint8_t* const data = loadFile(path, &size);
+  if (NULL == data) {
+    fprintf(stderr, "failed to read %s\n", path);
+    return 1;
+  }
+  const UError_t err = parse(&rec, data, size);
+  free(data);
+  if (uSuccess != err) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  printf("%zu chunks, %zu frames, %zu commands, %zu canvases, %llu dropped, %zu broken\n", rec.chunks, rec.frames, rec.count, rec.nCanvases,
+         (unsigned long long)rec.dropped, rec.broken);
+  if (0 < rec.dropped || 0 < rec.broken) {
+    fprintf(stderr, "warning: the recording is incomplete (enlarge the record buffer or drain more often)\n");
+  }
+
+  // 全体の時間 (最小値) とフレームごとの時間
+  uint64_t* const frameNs = (uint64_t*)calloc(rec.frames + 1, sizeof(uint64_t));
+  uint64_t* const bestFrameNs = (uint64_t*)calloc(rec.frames + 1, sizeof(uint64_t));
+  if (NULL == frameNs || NULL == bestFrameNs) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  uint64_t best = UINT64_MAX;
+  for (uint32_t r = 0; r < repeats; ++r) {
+    const uint64_t ns = replay(&rec, frameNs, NULL);
+    if (ns < best) {
+      best = ns;
+      memcpy(bestFrameNs, frameNs, sizeof(uint64_t) * rec.frames);
+    }
+  }
+  uint64_t worst = 0;
+  for (size_t f = 0; f < rec.frames; ++f) {
+    worst = (worst < bestFrameNs[f]) ? bestFrameNs[f] : worst;
+    if (verbose) {
+      printf("frame %5zu %10.2f us\n", f, (double)bestFrameNs[f] / 1000.0);
+    }
+  }
+  printf("total %.3f ms (best of %u), %.2f us/frame avg, %.2f us/frame max\n", (double)best / 1e6, (unsigned)repeats,
+         (0 < rec.frames) ? (double)best / 1000.0 / (double)rec.frames : 0.0, (double)worst / 1000.0);
+
+  // 種類ごとの呼び出し回数と時間 (呼び出しごとに時刻を取得する分, 全体の時間より大きくなる)
+  ReplayStat_t stats[OPS] = {0};
+  (void)replay(&rec, NULL, stats);
+  printf("%-12s %8s %12s %10s\n", "op", "calls", "total_us", "ns/call");
+  for (uint32_t op = 0; op < OPS; ++op) {
+    if (0 < stats[op].calls) {
+      printf("%-12s %8llu %12.1f %10.1f\n", opName((uint8_t)op), (unsigned long long)stats[op].calls, (double)stats[op].ns / 1000.0,
+             (double)stats[op].ns / (double)stats[op].calls);
+    }
+  }
+
+  int ret = 0;
+  if (NULL != ppm) {
+    const Canvas_t* largest = NULL;
+    for (size_t i = 0; i < rec.nCanvases; ++i) {
+      const Canvas_t* const c = &rec.canvases[i].canvas;
+      if (CanvasRGB565 == c->fmt && (NULL == largest || largest->w * largest->h < c->w * c->h)) {
+        largest = c;
+      }
+    }
+    if (NULL == largest || uSuccess != writePPM(largest, ppm)) {
+      fprintf(stderr, "failed to write %s\n", ppm);
+      ret = 1;
+    }
+  }
+
+  for (size_t i = 0; i < rec.count; ++i) {
+    free(rec.cmds[i].text);
+  }
+  for (size_t i = 0; i < rec.nCanvases; ++i) {
+    free(rec.canvases[i].mem);
+  }
+  free(rec.cmds);
+  free(rec.blitSrc);
+  free(frameNs);
+  free(bestFrameNs);
+  return ret;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file prog01/host/tools/overdraw.c
+ * main.c の 1フレームの書き込み回数 (重ね描き) の集計 (ホストビルド)
+ *
+ * CANVAS_OVERDRAW を有効にした Canvas で main.c の Render() と同じ図形と文字を描画し,
+ * 描画の種類ごとの 呼び出し回数 / 書き込みピクセル数 / 初めて書き込んだピクセル数 を表示します.
+ * -o を指定すると, 書き込み回数のヒートマップを PPM で出力します.
+ *   overdraw [-f フレーム番号] [-o PPM出力先]
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <user/canvas.h>
+#include <user/font.h>
+#include <user/macros.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define SCREEN_W (240)
+#define SCREEN_H (320)
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagTextContext_t {
+  const Canvas_t* canvas;
+  uint16_t color;
+} TextContext_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 文字描画処理 (main.c の drawCharactor() と同じく, 前景のピクセルのみ描画する)
+ */
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* fp, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz);
+
+/**
+ * @brief main.c の 1フレーム (クリア, 罫線, 円, 文字) を描画する
+ */
+static void renderFrame(const Canvas_t* canvas, uint32_t f);
+
+/**
+ * @brief RGB565 (バイト入れ替え済み) のキャンバスを PPM で書き出す
+ */
+static UError_t writePPM(const Canvas_t* canvas, const char* path);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+static uint16_t fb[SCREEN_W * SCREEN_H];
+static uint16_t heat[SCREEN_W * SCREEN_H];
+static uint8_t counts[SCREEN_W * SCREEN_H];
+static CanvasOverdraw_t overdraw;
+
+static const char* const primNames[CanvasPrimNum] = {"clear", "pixel", "line", "circle", "fill_circle", "fill_rect", "blit", "scroll", "text", "tilemap"};
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static UError_t drawGlyph(void* arg, uint32_t x, uint32_t y, const void* fp, uint16_t c, uint32_t fw, uint32_t fh, size_t fsz) {
+  const TextContext_t* const ctx = (const TextContext_t*)arg;
+  const uint8_t* line = (const uint8_t*)fp;
+  const uint32_t cw = (0xff < c) ? (fw / 2) : fw;  // 全角文字は 2キャラクタ分の幅
+  const size_t bpr = (fw + 7) / 8;
+  (void)fsz;
+
+  for (uint32_t h = 0; h < fh && NULL != line; ++h) {
+    for (uint32_t w = 0; w < fw; ++w) {
+      if (line[w / 8] & (0x80u >> (w % 8))) {
+        (void)Canvas_DrawPixel(ctx->canvas, 10 + (x * cw) + w, 10 + (y * fh) + h, ctx->color);
+      }
+    }
+    line += bpr;
+  }
+
+  return uSuccess;
+}
+
+static void renderFrame(const Canvas_t* canvas, uint32_t f) {
+  const uint16_t red = RGB888toRGB565(0xff, 0, 0);
+
+  (void)Canvas_Clear(canvas, RGB888toRGB565(0x90, 0x90, 0x90));
+
+  (void)Canvas_DrawLine(canvas, 0, 0, 239, 319, red);
+  (void)Canvas_DrawLine(canvas, 239, 0, 0, 319, red);
+  (void)Canvas_DrawLine(canvas, 0, 0, 0, 319, red);
+  (void)Canvas_DrawLine(canvas, 100, 0, 100, 319, red);
+  (void)Canvas_DrawLine(canvas, 200, 0, 200, 319, red);
+  (void)Canvas_DrawLine(canvas, 0, 0, 239, 0, red);
+  (void)Canvas_DrawLine(canvas, 0, 100, 239, 100, red);
+  (void)Canvas_DrawLine(canvas, 0, 200, 239, 200, red);
+  (void)Canvas_DrawLine(canvas, 0, 300, 239, 300, red);
+
+  (void)Canvas_DrawCircle(canvas, 100, 100, (f % 30) + 1, RGB888toRGB565(0, 0xff, 0));
+  (void)Canvas_DrawFillCircle(canvas, 200, 200, (f % 20) + 1, RGB888toRGB565(0x0f, 0x0f, 0xff));
+
+  TextContext_t text = {.canvas = canvas, .color = 0xffff};
+  const CanvasPrim_t prev = Canvas_BeginOverdraw(canvas, CanvasPrimText);
+  (void)Font_Print("Frametime:     12345 us\n", drawGlyph, &text);
+  Canvas_EndOverdraw(canvas, prev);
+}
+
+static UError_t writePPM(const Canvas_t* canvas, const char* path) {
+  FILE* const fp = fopen(path, "wb");
+  if (NULL == fp) {
+    return uFailure;
+  }
+
+  fprintf(fp, "P6\n%u %u\n255\n", (unsigned)canvas->w, (unsigned)canvas->h);
+  for (size_t y = 0; y < canvas->h; ++y) {
+    const uint16_t* const row = (const uint16_t*)canvas->buf + (y * canvas->s);
+    for (size_t x = 0; x < canvas->w; ++x) {
+      const uint16_t c = (uint16_t)((row[x] << 8) | (row[x] >> 8));  // 格納順を戻す
+      const uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xf8), (uint8_t)((c >> 3) & 0xfc), (uint8_t)((c << 3) & 0xf8)};
+      fwrite(rgb, 1, sizeof(rgb), fp);
+    }
+  }
+  fclose(fp);
+
+  return uSuccess;
+}
+
+int main(int argc, char* argv[]) {
+  const char* ppm = NULL;
+  uint32_t frame = 29;  // 円が最大になるフレーム
+  Canvas_t canvas;
+  Canvas_t heatmap;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (0 == strcmp(argv[i], "-f")) {
+      frame = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+    } else if (0 == strcmp(argv[i], "-o")) {
+      ppm = argv[i + 1];
+    }
+  }
+
+  (void)Canvas_Create(&canvas, SCREEN_W, SCREEN_H, SCREEN_W, fb);
+  (void)Canvas_Create(&heatmap, SCREEN_W, SCREEN_H, SCREEN_W, heat);
+  if (uSuccess != Canvas_AttachOverdraw(&canvas, &overdraw, counts)) {
+    fprintf(stderr, "failed to attach the overdraw counter\n");
+    return 1;
+  }
+
+  renderFrame(&canvas, frame);
+
+  CanvasOverdrawStat_t st;
+  // rewritten: 既に書き込まれていたピクセルへの書き込み (重ね描きで無駄になった数)
+  printf("%-12s %6s %8s %8s %9s\n", "primitive", "calls", "written", "unique", "rewritten");
+  for (int32_t p = 0; p <= CanvasPrimNum; ++p) {
+    const CanvasPrim_t prim = (CanvasPrimNum == p) ? CanvasPrimNone : (CanvasPrim_t)p;
+    if (uSuccess == Canvas_GetOverdrawStat(&canvas, prim, &st) && 0 < st.calls) {
+      printf("%-12s %6u %8u %8u %9u\n", (CanvasPrimNone == prim) ? "total" : primNames[p], (unsigned)st.calls, (unsigned)st.written, (unsigned)st.unique,
+             (unsigned)(st.written - st.unique));
+    }
+  }
+  (void)Canvas_GetOverdrawStat(&canvas, CanvasPrimNone, &st);
+  printf("overdraw: x%.3f (written / unique)\n", (0 < st.unique) ? (double)st.written / st.unique : 0.0);
+
+  uint32_t most = 0;
+  (void)Canvas_DrawOverdrawHeatmap(&canvas, &heatmap, &most);
+  printf("max writes per pixel: %u (%u pixels)\n", (unsigned)most, (unsigned)(SCREEN_W * SCREEN_H));
+
+  if (NULL != ppm && uSuccess != writePPM(&heatmap, ppm)) {
+    fprintf(stderr, "failed to write %s\n", ppm);
+    return 1;
+  }
+
+  return 0;
+}
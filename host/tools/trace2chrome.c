@@ -0,0 +1,336 @@
+/**
+ * @file prog01/host/tools/trace2chrome.c
+ * トレースリング (tracering.h) の書き出し内容を Chrome のトレース形式 (JSON) へ変換 (ホストビルド)
+ *
+ * 入力から magic "TRCR" を探してチャンクを読み出すため, UART のテキスト出力が混在したログもそのまま変換できます.
+ * 32bit の時刻 (単位: us) は直前のイベントとの差分で 64bit へ展開し, 最初のイベントを 0 とします.
+ * 開始のない終了 (記録前に開始した区間, 上書きで失った開始) は出力しません.
+ * 出力は chrome://tracing または https://ui.perfetto.dev で表示できます.
+ *   trace2chrome [-o 出力先] 入力ファイル
+ */
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <user/tracering.h>
+#include <user/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+#define CHUNK_SIZE (12)  //< TraceRingChunk_t のバイト数
+#define EVENT_SIZE (16)  //< TraceEvent_t のバイト数
+
+#define TRACKS (256)  //< トラック番号の種類
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagChromeEvent_t {
+  int64_t ts;      //< 展開した時刻 (単位: us)
+  uint64_t order;  //< 入力順 (同時刻の並びを保つ)
+  uint32_t lost;   //< 0 以外: 上書きで失ったイベント数 (ev は未使用)
+  TraceEvent_t ev;
+} ChromeEvent_t;
+
+typedef struct tagChromeTrace_t {
+  ChromeEvent_t* events;
+  size_t count;
+  size_t capacity;
+  // 時刻の展開
+  bool started;
+  uint32_t lastRaw;
+  int64_t now;
+  // 集計
+  size_t chunks;
+  uint64_t lost;
+} ChromeTrace_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief 入力全体からチャンクを探して読み出す
+ */
+static UError_t parse(ChromeTrace_t* ctx, const uint8_t* data, size_t size);
+
+/**
+ * @brief イベントを追加する
+ */
+static UError_t push(ChromeTrace_t* ctx, const ChromeEvent_t* ce);
+
+/**
+ * @brief 時刻順 (同時刻は入力順) に比較する (qsort)
+ */
+static int compareEvent(const void* a, const void* b);
+
+/**
+ * @brief JSON を書き出す
+ */
+static void writeJson(const ChromeTrace_t* ctx, FILE* fp);
+
+/**
+ * @brief イベント番号の名前を返す. 表にない番号は buf に "id_N" を作る
+ */
+static const char* idName(uint16_t id, char* buf, size_t size);
+
+/**
+ * @brief リトルエンディアンの値を読み出す
+ */
+static uint16_t readU16(const uint8_t* p);
+static uint32_t readU32(const uint8_t* p);
+
+/**
+ * @brief ファイル全体を読み込む
+ * @return 読み込んだデータ (呼び出し側で free する. NULL: 失敗)
+ */
+static uint8_t* loadFile(const char* path, size_t* size);
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * イベント番号の名前 (TraceId_t と合わせる)
+ */
+static const char* const idNames[] = {
+    NULL, "frame", "render", "band", "lcd_swap", "lcd_wait", "set_window", "dma",
+};
+
+static ChromeTrace_t trace;
+
+//////////////////////////////////////////////////////////////////////////////
+// function
+//////////////////////////////////////////////////////////////////////////////
+
+static uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t readU32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static UError_t push(ChromeTrace_t* ctx, const ChromeEvent_t* ce) {
+  if (ctx->count == ctx->capacity) {
+    const size_t capacity = (0 < ctx->capacity) ? ctx->capacity * 2 : 4096;
+    ChromeEvent_t* const events = (ChromeEvent_t*)realloc(ctx->events, capacity * sizeof(ChromeEvent_t));
+    if (NULL == events) {
+      return uFailure;
+    }
+    ctx->events = events;
+    ctx->capacity = capacity;
+  }
+  ctx->events[ctx->count] = *ce;
+  ctx->events[ctx->count].order = ctx->count;
+  ++ctx->count;
+  return uSuccess;
+}
+
+static UError_t parse(ChromeTrace_t* ctx, const uint8_t* data, size_t size) {
+  UError_t err = uSuccess;
+  size_t pos = 0;
+
+  while (uSuccess == err && pos + CHUNK_SIZE <= size) {
+    if (0 != memcmp(&data[pos], TRACERING_MAGIC, 4) || TRACERING_VERSION != readU16(&data[pos + 4])) {
+      ++pos;  // テキスト等を読み飛ばして再同期する
+      continue;
+    }
+    const uint16_t count = readU16(&data[pos + 6]);
+    const uint32_t lost = readU32(&data[pos + 8]);
+    if (TRACERING_CHUNK < count || size < pos + CHUNK_SIZE + (size_t)count * EVENT_SIZE) {
+      ++pos;  // 途中で切れたチャンク, または偶然一致した magic
+      continue;
+    }
+    pos += CHUNK_SIZE;
+    ++ctx->chunks;
+
+    if (0 < lost) {
+      const ChromeEvent_t ce = {.ts = ctx->now, .lost = lost};
+      ctx->lost += lost;
+      err = push(ctx, &ce);
+    }
+    for (uint16_t i = 0; i < count && uSuccess == err; ++i, pos += EVENT_SIZE) {
+      const uint8_t* const p = &data[pos];
+      ChromeEvent_t ce = {0};
+      ce.ev.time = readU32(&p[0]);
+      ce.ev.id = readU16(&p[4]);
+      ce.ev.track = p[6];
+      ce.ev.phase = p[7];
+      ce.ev.arg0 = readU32(&p[8]);
+      ce.ev.arg1 = readU32(&p[12]);
+
+      // 両コアの記録は前後しうるため, 差分を符号付きで扱う
+      if (ctx->started) {
+        ctx->now += (int32_t)(ce.ev.time - ctx->lastRaw);
+      }
+      ctx->started = true;
+      ctx->lastRaw = ce.ev.time;
+      ce.ts = ctx->now;
+      err = push(ctx, &ce);
+    }
+  }
+
+  return err;
+}
+
+static int compareEvent(const void* a, const void* b) {
+  const ChromeEvent_t* const x = (const ChromeEvent_t*)a;
+  const ChromeEvent_t* const y = (const ChromeEvent_t*)b;
+
+  if (x->ts != y->ts) {
+    return (x->ts < y->ts) ? -1 : 1;
+  }
+  return (x->order < y->order) ? -1 : (x->order > y->order) ? 1 : 0;
+}
+
+static const char* idName(uint16_t id, char* buf, size_t size) {
+  if (id < sizeof(idNames) / sizeof(idNames[0]) && NULL != idNames[id]) {
+    return idNames[id];
+  }
+  if (TraceIdUser <= id) {
+    snprintf(buf, size, "user_%u", (unsigned)(id - TraceIdUser));
+  } else {
+    snprintf(buf, size, "id_%u", (unsigned)id);
+  }
+  return buf;
+}
+
+static void writeJson(const ChromeTrace_t* ctx, FILE* fp) {
+  static const char phases[] = {'B', 'E', 'i', 'C'};
+  uint32_t depth[TRACKS] = {0};  //< トラックごとの開いている区間の数
+  bool used[TRACKS] = {false};
+  const int64_t origin = (0 < ctx->count) ? ctx->events[0].ts : 0;
+  bool first = true;
+
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (size_t i = 0; i < ctx->count; ++i) {
+    const ChromeEvent_t* const ce = &ctx->events[i];
+    const long long ts = (long long)(ce->ts - origin);
+    char name[32];
+
+    if (0 < ce->lost) {
+      fprintf(fp, "%s{\"name\":\"lost\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lld,\"pid\":0,\"tid\":0,\"args\":{\"events\":%u}}", first ? "" : ",\n", ts,
+              (unsigned)ce->lost);
+      first = false;
+      continue;
+    }
+
+    const TraceEvent_t* const ev = &ce->ev;
+    if (sizeof(phases) <= ev->phase) {
+      continue;
+    }
+    if (TracePhaseBegin == ev->phase) {
+      ++depth[ev->track];
+    } else if (TracePhaseEnd == ev->phase) {
+      if (0 == depth[ev->track]) {
+        continue;  // 開始のない終了
+      }
+      --depth[ev->track];
+    }
+    used[ev->track] = true;
+
+    const char* const n = idName(ev->id, name, sizeof(name));
+    fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":0,\"tid\":%u,", first ? "" : ",\n", n, phases[ev->phase], ts, (unsigned)ev->track);
+    if (TracePhaseCounter == ev->phase) {
+      fprintf(fp, "\"args\":{\"value\":%u}}", (unsigned)ev->arg0);
+    } else if (TracePhaseInstant == ev->phase) {
+      fprintf(fp, "\"s\":\"t\",\"args\":{\"a0\":%u,\"a1\":%u}}", (unsigned)ev->arg0, (unsigned)ev->arg1);
+    } else {
+      fprintf(fp, "\"args\":{\"a0\":%u,\"a1\":%u}}", (unsigned)ev->arg0, (unsigned)ev->arg1);
+    }
+    first = false;
+  }
+
+  // トラックの名前
+  for (uint32_t t = 0; t < TRACKS; ++t) {
+    if (used[t]) {
+      char name[16];
+      if (TRACE_TRACK_DMA == t) {
+        snprintf(name, sizeof(name), "dma");
+      } else {
+        snprintf(name, sizeof(name), "core%u", (unsigned)t);
+      }
+      fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", (unsigned)t, name);
+      first = false;
+    }
+  }
+  fprintf(fp, "\n]}\n");
+}
+
+static uint8_t* loadFile(const char* path, size_t* size) {
+  uint8_t* data = NULL;
+  FILE* const fp = fopen(path, "rb");
+
+  if (NULL != fp) {
+    if (0 == fseek(fp, 0, SEEK_END)) {
+      const long len = ftell(fp);
+      if (0 <= len && 0 == fseek(fp, 0, SEEK_SET)) {
+        data = (uint8_t*)malloc((0 < len) ? (size_t)len : 1u);
+        if (NULL != data && (size_t)len != fread(data, 1, (size_t)len, fp)) {
+          free(data);
+          data = NULL;
+        }
+        *size = (size_t)len;
+      }
+    }
+    fclose(fp);
+  }
+
+  return data;
+}
+
+int main(int argc, char* argv[]) {
+  UError_t err = uSuccess;
+  const char* path = NULL;
+  const char* out = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (0 == strcmp(argv[i], "-o") && i + 1 < argc) {
+      out = argv[++i];
+    } else {
+      path = argv[i];
+    }
+  }
+  if (NULL == path) {
+    fprintf(stderr, "usage: %s [-o out.json] dump.bin\n", argv[0]);
+    return 2;
+  }
+
+  size_t size = 0;
+  uint8_t* const data = loadFile(path, &size);
+  if (NULL == data) {
+    fprintf(stderr, "failed to read %s\n", path);
+    return 1;
+  }
+
+  err = parse(&trace, data, size);
+  free(data);
+  if (uSuccess != err) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  qsort(trace.events, trace.count, sizeof(ChromeEvent_t), compareEvent);
+
+  FILE* const fp = (NULL != out) ? fopen(out, "w") : stdout;
+  if (NULL == fp) {
+    fprintf(stderr, "failed to write %s\n", out);
+    free(trace.events);
+    return 1;
+  }
+  writeJson(&trace, fp);
+  if (stdout != fp) {
+    fclose(fp);
+  }
+  fprintf(stderr, "%zu chunks, %zu events, %llu lost\n", trace.chunks, trace.count, (unsigned long long)trace.lost);
+
+  free(trace.events);
+  return 0;
+}
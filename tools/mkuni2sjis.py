@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Unicode -> SJIS 変換テーブル (app/src/font/uni2sjis.h) を生成します.
+
+JIS X 0208 の全文字 (Python の shift_jis コーデック) と
+半角カナ, および CP932 由来の代替コードポイントを収録します.
+
+  python3 tools/mkuni2sjis.py > app/src/font/uni2sjis.h
+"""
+
+import sys
+
+LEADS = list(range(0x81, 0xA0)) + list(range(0xE0, 0xF0))
+TRAILS = list(range(0x40, 0x7F)) + list(range(0x80, 0xFD))
+
+
+def build():
+    table = {}
+    for lead in LEADS:
+        for trail in TRAILS:
+            raw = bytes([lead, trail])
+            try:
+                u = raw.decode("shift_jis")
+            except UnicodeDecodeError:
+                continue
+            if len(u) != 1:
+                continue
+            table.setdefault(ord(u), (lead << 8) | trail)
+            # Windows 由来の文字列 (CP932) で使われる代替コードポイント
+            v = raw.decode("cp932")
+            if v != u:
+                table.setdefault(ord(v), (lead << 8) | trail)
+    # 半角カナ (1バイトコード)
+    for c in range(0xA1, 0xE0):
+        table.setdefault(ord(bytes([c]).decode("shift_jis")), c)
+    return table
+
+
+def main():
+    table = build()
+    pages = sorted(set(cp >> 8 for cp in table))
+    out = sys.stdout
+    out.write("""/**
+ * @file prog01/app/src/font/uni2sjis.h
+ * Unicode(BMP) -> SJIS 変換テーブル
+ * JIS X 0208 全文字 + 半角カナ (tools/mkuni2sjis.py で生成)
+ *
+ * 上位8bit でページを引き, ページ内は 256bit のビットマップと
+ * 32bit 毎の累計数でコード配列の位置を求める 2段構成.
+ */
+
+#if !defined(USER_FONT_UNI2SJIS_H__)
+#define USER_FONT_UNI2SJIS_H__
+
+//////////////////////////////////////////////////////////////////////////////
+// includes
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// defines
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// typedef
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct tagUni2SjisPage_t {
+  uint32_t bits[8];  //< 収録済みコードポイントのビットマップ
+  uint16_t base;     //< ページ先頭の uni2sjisCode 位置
+  uint8_t rank[8];   //< bits[n] より前の収録数
+} Uni2SjisPage_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// prototype
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// variable
+//////////////////////////////////////////////////////////////////////////////
+
+""")
+    # 1段目: 上位8bit -> ページ番号 + 1 (0: 収録なし)
+    index = [0] * 256
+    for n, p in enumerate(pages):
+        index[p] = n + 1
+    out.write("static const uint8_t uni2sjisIndex[256] = {\n")
+    for i in range(0, 256, 16):
+        out.write("    " + ", ".join("0x%02x" % v for v in index[i:i + 16]) + ",\n")
+    out.write("};\n\n")
+
+    codes = []
+    out.write("static const Uni2SjisPage_t uni2sjisPage[%d] = {\n" % len(pages))
+    for p in pages:
+        bits = [0] * 8
+        rank = [0] * 8
+        base = len(codes)
+        for lo in range(256):
+            cp = (p << 8) | lo
+            if cp in table:
+                bits[lo >> 5] |= 1 << (lo & 31)
+                codes.append(table[cp])
+        total = 0
+        for w in range(8):
+            rank[w] = total
+            total += bin(bits[w]).count("1")
+        out.write("    {{%s}, %d, {%s}},  // U+%02X00\n" % (", ".join("0x%08x" % b for b in bits), base, ", ".join(str(r) for r in rank), p))
+    out.write("};\n\n")
+
+    out.write("static const uint16_t uni2sjisCode[%d] = {\n" % len(codes))
+    for i in range(0, len(codes), 16):
+        out.write("    " + ", ".join("0x%04x" % v for v in codes[i:i + 16]) + ",\n")
+    out.write("};\n\n")
+    out.write("#endif  // !defined(USER_FONT_UNI2SJIS_H__)\n")
+
+
+if __name__ == "__main__":
+    main()